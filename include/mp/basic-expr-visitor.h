@@ -23,6 +23,9 @@
 #ifndef MP_BASIC_EXPR_VISITOR_H_
 #define MP_BASIC_EXPR_VISITOR_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "mp/common.h"
 #include "mp/error.h"
 
@@ -84,6 +87,10 @@ class BasicExprVisitor {
     return MP_DISPATCH(VisitUnhandledNumericExpr(v));
   }
 
+  Result VisitCommonExpr(CommonExpr e) {
+    return MP_DISPATCH(VisitUnhandledNumericExpr(e));
+  }
+
   // Visits a unary expression or a function taking one argument.
   Result VisitUnary(UnaryExpr e) {
     return MP_DISPATCH(VisitUnhandledNumericExpr(e));
@@ -396,6 +403,9 @@ Result BasicExprVisitor<Impl, Result, LResult, ET>::Visit(NumericExpr e) {
                          ET::template UncheckedCast<NumericConstant>(e)));
   case expr::VARIABLE:
     return MP_DISPATCH(VisitVariable(ET::template UncheckedCast<Variable>(e)));
+  case expr::COMMON_EXPR:
+    return MP_DISPATCH(VisitCommonExpr(
+                         ET::template UncheckedCast<CommonExpr>(e)));
 
   // Unary expressions.
   case expr::MINUS:
@@ -564,6 +574,276 @@ LResult BasicExprVisitor<Impl, Result, LResult, ET>::Visit(LogicalExpr e) {
                          ET::template UncheckedCast<PairwiseExpr>(e)));
   }
 }
+namespace internal {
+
+// A subexpression pending in a post-order traversal.
+template <typename Expr>
+struct PostOrderItem {
+  Expr expr;
+  bool logical;
+  // True if the arguments have been pushed to the stack.
+  bool expanded;
+  // Sizes of the result stacks when the arguments were pushed.
+  std::size_t num_results;
+  std::size_t num_lresults;
+};
+
+// Pushes the numeric and logical arguments of an expression to a
+// traversal stack in the order of arguments. Arguments of other types
+// such as string literals are skipped.
+template <typename ExprTypes>
+class ArgPusher :
+    public BasicExprVisitor<ArgPusher<ExprTypes>, void, void, ExprTypes> {
+ public:
+  MP_DEFINE_EXPR_TYPES(ExprTypes);
+
+  typedef PostOrderItem<Expr> Item;
+
+ private:
+  std::vector<Item> &stack_;
+
+  void Push(Expr e, bool logical) {
+    Item item = {e, logical, false, 0, 0};
+    stack_.push_back(item);
+  }
+
+  template <typename ExprType>
+  void PushArgs(ExprType e) {
+    for (typename ExprType::iterator
+         i = e.begin(), end = e.end(); i != end; ++i) {
+      Push(*i);
+    }
+  }
+
+  template <typename ExprType>
+  void PushExprArgs(ExprType e) {
+    for (typename ExprType::iterator
+         i = e.begin(), end = e.end(); i != end; ++i) {
+      if (NumericExpr arg = ExprTypes::template Cast<NumericExpr>(*i))
+        Push(arg);
+    }
+  }
+
+ public:
+  explicit ArgPusher(std::vector<Item> &stack) : stack_(stack) {}
+
+  void Push(NumericExpr e) { Push(e, false); }
+  void Push(LogicalExpr e) { Push(e, true); }
+
+  void VisitNumericConstant(NumericConstant) {}
+  void VisitVariable(Variable) {}
+  void VisitCommonExpr(CommonExpr) {}
+  void VisitUnary(UnaryExpr e) { Push(e.arg()); }
+
+  void VisitBinary(BinaryExpr e) {
+    Push(e.lhs());
+    Push(e.rhs());
+  }
+
+  void VisitIf(IfExpr e) {
+    Push(e.condition());
+    Push(e.true_expr());
+    if (NumericExpr false_expr = e.false_expr())
+      Push(false_expr);
+  }
+
+  void VisitPLTerm(PLTerm e) { Push(e.arg()); }
+  void VisitCall(CallExpr e) { PushExprArgs(e); }
+  void VisitVarArg(VarArgExpr e) { PushArgs(e); }
+  void VisitSum(SumExpr e) { PushArgs(e); }
+  void VisitCount(CountExpr e) { PushArgs(e); }
+  void VisitNumberOf(NumberOfExpr e) { PushArgs(e); }
+  void VisitNumberOfSym(SymbolicNumberOfExpr e) { PushExprArgs(e); }
+
+  void VisitLogicalConstant(LogicalConstant) {}
+  void VisitNot(NotExpr e) { Push(e.arg()); }
+
+  void VisitBinaryLogical(BinaryLogicalExpr e) {
+    Push(e.lhs());
+    Push(e.rhs());
+  }
+
+  void VisitRelational(RelationalExpr e) {
+    Push(e.lhs());
+    Push(e.rhs());
+  }
+
+  void VisitLogicalCount(LogicalCountExpr e) {
+    Push(e.lhs());
+    Push(e.rhs());
+  }
+
+  void VisitImplication(ImplicationExpr e) {
+    Push(e.condition());
+    Push(e.true_expr());
+    if (LogicalExpr false_expr = e.false_expr())
+      Push(false_expr);
+  }
+
+  void VisitIteratedLogical(IteratedLogicalExpr e) { PushArgs(e); }
+  void VisitAllDiff(PairwiseExpr e) { PushArgs(e); }
+  void VisitNotAllDiff(PairwiseExpr e) { PushArgs(e); }
+};
+}  // namespace internal
+
+// An expression visitor that traverses expression trees in post order
+// using an explicit stack so that the depth of recursion doesn't depend
+// on the depth of the trees.
+//
+// Visit* methods are written as for BasicExprVisitor. However, before an
+// expression is passed to its Visit* method, all its numeric and logical
+// arguments are visited and the results are kept on a stack. Calls to
+// Visit for these arguments from the Visit* method return the stored
+// results without recursion. Calls for other expressions, for example,
+// arguments of arguments, start a nested traversal.
+//
+// Because each argument is visited exactly once and before its parent,
+// this is only suitable for visitors that visit all arguments of every
+// expression, such as compilers or evaluators without short circuiting.
+// Result and LResult should be copyable and can't be void.
+template <typename Impl, typename Result, typename LResult, typename ExprTypes>
+class BasicPostOrderExprVisitor :
+    public BasicExprVisitor<Impl, Result, LResult, ExprTypes> {
+ private:
+  typedef BasicExprVisitor<Impl, Result, LResult, ExprTypes> Base;
+
+ public:
+  MP_DEFINE_EXPR_TYPES(ExprTypes);
+
+ private:
+  typedef internal::PostOrderItem<Expr> Item;
+  std::vector<Item> stack_;
+
+  template <typename T>
+  struct Value {
+    Expr expr;
+    T result;
+  };
+
+  // Results of visited expressions whose parents haven't been visited yet.
+  std::vector< Value<Result> > results_;
+  std::vector< Value<LResult> > lresults_;
+
+  // Positions in results_ and lresults_ of the results of the arguments
+  // of the expression being visited and of the next result to look up.
+  struct Args {
+    std::size_t start, pos;
+    std::size_t lstart, lpos;
+  };
+  Args args_;
+
+  // Finds the result of an argument of the expression being visited
+  // starting from the position after the previously found one.
+  // Returns the index of the result or -1 if not found.
+  template <typename T>
+  static int Find(const std::vector< Value<T> > &values,
+                  std::size_t start, std::size_t &pos, Expr e) {
+    std::size_t end = values.size();
+    for (std::size_t i = pos; i < end; ++i) {
+      if (values[i].expr == e) {
+        pos = i + 1;
+        return static_cast<int>(i);
+      }
+    }
+    for (std::size_t i = start; i < pos && i < end; ++i) {
+      if (values[i].expr == e) {
+        pos = i + 1;
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  // Visits the expression at the top of the stack after its arguments.
+  void VisitTop();
+
+  // Visits an expression and its subexpressions in post order leaving
+  // the result on top of results_ or lresults_.
+  void Traverse(Expr e, bool logical);
+
+ public:
+  BasicPostOrderExprVisitor() {
+    Args args = {0, 0, 0, 0};
+    args_ = args;
+  }
+
+  Result Visit(NumericExpr e) {
+    int index = Find(results_, args_.start, args_.pos, e);
+    if (index >= 0)
+      return results_[index].result;
+    Traverse(e, false);
+    Result result = results_.back().result;
+    results_.pop_back();
+    return result;
+  }
+
+  LResult Visit(LogicalExpr e) {
+    int index = Find(lresults_, args_.lstart, args_.lpos, e);
+    if (index >= 0)
+      return lresults_[index].result;
+    Traverse(e, true);
+    LResult result = lresults_.back().result;
+    lresults_.pop_back();
+    return result;
+  }
+};
+
+template <typename Impl, typename Result, typename LResult, typename ET>
+void BasicPostOrderExprVisitor<Impl, Result, LResult, ET>::VisitTop() {
+  Item item = stack_.back();
+  stack_.pop_back();
+  Args saved_args = args_;
+  Args args = {item.num_results, item.num_results,
+               item.num_lresults, item.num_lresults};
+  args_ = args;
+  if (item.logical) {
+    Value<LResult> value;
+    value.expr = item.expr;
+    value.result = Base::Visit(ET::template UncheckedCast<LogicalExpr>(
+                                 item.expr));
+    results_.resize(item.num_results);
+    lresults_.resize(item.num_lresults);
+    lresults_.push_back(value);
+  } else {
+    Value<Result> value;
+    value.expr = item.expr;
+    value.result = Base::Visit(ET::template UncheckedCast<NumericExpr>(
+                                 item.expr));
+    results_.resize(item.num_results);
+    lresults_.resize(item.num_lresults);
+    results_.push_back(value);
+  }
+  args_ = saved_args;
+}
+
+template <typename Impl, typename Result, typename LResult, typename ET>
+void BasicPostOrderExprVisitor<Impl, Result, LResult, ET>::Traverse(
+    Expr e, bool logical) {
+  std::size_t base = stack_.size();
+  internal::ArgPusher<ET> pusher(stack_);
+  if (logical)
+    pusher.Push(ET::template UncheckedCast<LogicalExpr>(e));
+  else
+    pusher.Push(ET::template UncheckedCast<NumericExpr>(e));
+  while (stack_.size() > base) {
+    std::size_t top = stack_.size() - 1;
+    if (stack_[top].expanded) {
+      VisitTop();
+      continue;
+    }
+    Item &item = stack_[top];
+    item.expanded = true;
+    item.num_results = results_.size();
+    item.num_lresults = lresults_.size();
+    Expr expr = item.expr;
+    if (item.logical)
+      pusher.Visit(ET::template UncheckedCast<LogicalExpr>(expr));
+    else
+      pusher.Visit(ET::template UncheckedCast<NumericExpr>(expr));
+    // Reverse the arguments so that the first one is visited first.
+    std::reverse(stack_.begin() + (top + 1), stack_.end());
+  }
+}
 }  // namespace mp
 
 #endif  // MP_BASIC_EXPR_VISITOR_H_
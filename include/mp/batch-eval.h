@@ -0,0 +1,96 @@
+/*
+ Vectorized evaluation of expressions at many points
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_BATCH_EVAL_H_
+#define MP_BATCH_EVAL_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "mp/tape.h"
+
+namespace mp {
+
+namespace internal {
+struct BatchTape;
+}
+
+// Evaluates objectives and constraints of a tape at many points at once,
+// for example, for multistart or sampling.
+//
+// Points are processed in blocks of BLOCK_SIZE. Registers are stored by
+// registers, so that values of a register at all points of a block are
+// contiguous, and each instruction is executed for the whole block in a
+// loop vectorized for the widest instruction set supported by the CPU
+// (AVX-512, AVX2 or the baseline one). Evaluation doesn't allocate memory
+// and gives the same results as TapeEvaluator.
+class BatchEvaluator {
+ public:
+  // Maximum number of points evaluated in one pass over the tape.
+  enum {BLOCK_SIZE = 32};
+
+  enum InstructionSet {
+    AUTO,     // The widest instruction set supported by the CPU.
+    GENERIC,  // The instruction set the library is compiled for.
+    AVX2,
+    AVX512
+  };
+
+ private:
+  const Tape &tape_;
+  InstructionSet isa_;
+
+  typedef void (*Kernel)(const internal::BatchTape &t, double *r,
+                         std::size_t stride, int num_points);
+  Kernel kernel_;
+
+  // registers_[reg * BLOCK_SIZE + p] is the value of the register reg
+  // at point p of the current block.
+  std::vector<double> registers_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(BatchEvaluator);
+
+ public:
+  // Constructs an evaluator using the specified instruction set.
+  // Throws Error if the instruction set is not supported.
+  explicit BatchEvaluator(const Tape &tape, InstructionSet isa = AUTO);
+
+  const Tape &tape() const { return tape_; }
+
+  // Returns the instruction set used for evaluation; never AUTO.
+  InstructionSet instruction_set() const { return isa_; }
+
+  // Returns true if the instruction set is supported by both the library
+  // build and the CPU.
+  static bool IsSupported(InstructionSet isa);
+
+  // Evaluates all expressions at num_points points.
+  // x[j * num_points + p] is the value of variable j at point p.
+  // The value of constraint i at point p is stored in
+  // con_values[p * tape().num_cons() + i] and, if obj_values is not null,
+  // the value of objective i in obj_values[p * tape().num_objs() + i].
+  void Evaluate(int num_points, const double *x,
+                double *con_values, double *obj_values = 0);
+};
+}  // namespace mp
+
+#endif  // MP_BATCH_EVAL_H_
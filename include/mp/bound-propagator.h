@@ -0,0 +1,225 @@
+/*
+ Interval evaluation of expressions and feasibility-based bound tightening
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_BOUND_PROPAGATOR_H_
+#define MP_BOUND_PROPAGATOR_H_
+
+#include <deque>
+#include <vector>
+
+#include "mp/expr-visitor.h"
+#include "mp/interval.h"
+#include "mp/problem.h"
+
+namespace mp {
+
+// Computes intervals containing values of expressions of a problem given
+// intervals of variables. Values of logical expressions are subintervals
+// of [0, 1] where 0 means false and 1 means true. Expressions without
+// interval extensions such as function calls evaluate to the whole line.
+//
+// Intervals of all subexpressions of the last evaluated expression are
+// recorded in preorder, so that they can be used for backward propagation.
+class IntervalEvaluator : public ExprVisitor<IntervalEvaluator, Interval> {
+ public:
+  // An interval of a subexpression. The subexpression occupies the
+  // recorded nodes [index, end) where index is the index of this node.
+  // The first argument of an expression, if any, is at index + 1 and
+  // each subsequent argument starts at the end of the previous one.
+  struct Node {
+    Interval value;
+    int end;
+  };
+
+ private:
+  typedef ExprVisitor<IntervalEvaluator, Interval> Base;
+
+  const Problem &problem_;
+  const Interval *var_bounds_;
+  std::vector<Node> nodes_;
+
+  // If not null, indices of visited variables are appended to this vector.
+  std::vector<int> *vars_;
+
+  template <typename Expr>
+  Interval Record(Expr e) {
+    int index = static_cast<int>(nodes_.size());
+    nodes_.push_back(Node());
+    Interval value = Base::Visit(e);
+    Node &node = nodes_[index];
+    node.value = value;
+    node.end = static_cast<int>(nodes_.size());
+    return value;
+  }
+
+  // Returns the interval of a comparison of lhs and rhs with the
+  // specified kind, e.g. expr::LT for lhs < rhs.
+  static Interval Compare(expr::Kind kind, Interval lhs, Interval rhs);
+
+ public:
+  // Constructs an evaluator for expressions of the problem. var_bounds
+  // should point to an array of num_vars intervals which must stay valid
+  // while the evaluator is used.
+  IntervalEvaluator(const Problem &p, const Interval *var_bounds)
+    : problem_(p), var_bounds_(var_bounds), vars_(0) {}
+
+  void set_var_bounds(const Interval *var_bounds) {
+    var_bounds_ = var_bounds;
+  }
+
+  // Makes the evaluator append indices of variables the evaluated
+  // expressions depend on to vars. Pass null to disable.
+  void set_var_collector(std::vector<int> *vars) { vars_ = vars; }
+
+  // Evaluates an expression discarding the previously recorded nodes.
+  template <typename Expr>
+  Interval Evaluate(Expr e) {
+    nodes_.clear();
+    return Visit(e);
+  }
+
+  // Returns the interval of a linear expression.
+  Interval Evaluate(const LinearExpr &linear);
+
+  const std::vector<Node> &nodes() const { return nodes_; }
+
+  Interval Visit(NumericExpr e) { return Record(e); }
+  Interval Visit(LogicalExpr e) { return Record(e); }
+
+  Interval VisitUnhandledNumericExpr(NumericExpr) { return Interval(); }
+  Interval VisitUnhandledLogicalExpr(LogicalExpr) { return Interval(0, 1); }
+
+  Interval VisitNumericConstant(NumericConstant c) {
+    return Interval(c.value());
+  }
+
+  Interval VisitVariable(Reference v);
+  Interval VisitCommonExpr(Reference e);
+  Interval VisitUnary(UnaryExpr e);
+  Interval VisitBinary(BinaryExpr e);
+
+  Interval VisitIf(IfExpr e);
+  Interval VisitPLTerm(PLTerm e);
+  Interval VisitMin(VarArgExpr e);
+  Interval VisitMax(VarArgExpr e);
+  Interval VisitSum(SumExpr e);
+  Interval VisitNumberOf(NumberOfExpr e);
+  Interval VisitCount(CountExpr e);
+
+  Interval VisitLogicalConstant(LogicalConstant c) {
+    return Interval(c.value() ? 1 : 0);
+  }
+
+  Interval VisitNot(NotExpr e) { return Interval(1) - Visit(e.arg()); }
+  Interval VisitBinaryLogical(BinaryLogicalExpr e);
+
+  Interval VisitRelational(RelationalExpr e) {
+    Interval lhs = Visit(e.lhs());
+    return Compare(e.kind(), lhs, Visit(e.rhs()));
+  }
+
+  Interval VisitLogicalCount(LogicalCountExpr e);
+  Interval VisitImplication(ImplicationExpr e);
+  Interval VisitIteratedLogical(IteratedLogicalExpr e);
+  Interval VisitAllDiff(PairwiseExpr e);
+  Interval VisitNotAllDiff(PairwiseExpr e) {
+    return Interval(1) - VisitAllDiff(e);
+  }
+};
+
+// Tightens bounds on variables of a problem by feasibility-based bound
+// tightening (FBBT). Each constraint is propagated by evaluating intervals
+// of its subexpressions bottom-up and then narrowing them top-down to the
+// constraint bounds, which tightens bounds on variables at the leaves.
+// Constraints depending on a variable whose bounds have changed are put
+// on a worklist and propagated again until no bound changes significantly.
+//
+// The problem is not modified: tightened bounds are available through
+// var_bounds(). Common expressions are propagated through, while bounds
+// of expressions without inverse interval functions such as function
+// calls, numberof, alldiff and logical count expressions are only
+// evaluated.
+class BoundPropagator {
+ private:
+  const Problem &problem_;
+  std::vector<Interval> var_bounds_;
+  IntervalEvaluator eval_;
+
+  // Constraints depending on variable i are
+  // var_cons_[var_con_starts_[i]:var_con_starts_[i + 1]]. Algebraic
+  // constraints are numbered first followed by logical constraints.
+  std::vector<int> var_con_starts_;
+  std::vector<int> var_cons_;
+
+  std::deque<int> queue_;
+  std::vector<bool> in_queue_;
+
+  int current_con_;
+  bool infeasible_;
+  int num_tightenings_;
+
+  class Narrower;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(BoundPropagator);
+
+  void Enqueue(int con) {
+    if (in_queue_[con])
+      return;
+    in_queue_[con] = true;
+    queue_.push_back(con);
+  }
+
+  // Propagates the constraint with the specified index.
+  void PropagateCon(int con);
+
+  // Intersects bounds of a variable with an interval and schedules
+  // dependent constraints if the bounds change significantly.
+  void Tighten(int var, Interval bounds);
+
+ public:
+  // Relative change of a bound considered significant.
+  static const double MIN_CHANGE;
+
+  // Relative tolerance by which tightened bounds are relaxed to account
+  // for rounding errors.
+  static const double TOLERANCE;
+
+  explicit BoundPropagator(const Problem &p);
+
+  // Returns the current bounds on a variable.
+  Interval var_bounds(int var) const { return var_bounds_[var]; }
+
+  // Sets bounds on a variable and schedules propagation of constraints
+  // depending on it.
+  void SetVarBounds(int var, Interval bounds);
+
+  // Returns the number of significant bound changes made so far.
+  int num_tightenings() const { return num_tightenings_; }
+
+  // Propagates constraints in the worklist, initially all constraints,
+  // until no bound changes or max_con_visits constraints are propagated.
+  // Returns false if the problem is proved infeasible.
+  bool Propagate(int max_con_visits = 100000);
+};
+}  // namespace mp
+
+#endif  // MP_BOUND_PROPAGATOR_H_
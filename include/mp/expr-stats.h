@@ -0,0 +1,345 @@
+/*
+ Expression tree statistics and visitor profiling
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_EXPR_STATS_H_
+#define MP_EXPR_STATS_H_
+
+#include <vector>
+
+#include "mp/basic-expr-visitor.h"
+#include "mp/clock.h"
+#include "mp/format.h"
+#include "mp/problem.h"
+#include "mp/stats.h"
+
+namespace mp {
+
+// Statistics of expression trees by expression kind.
+class ExprStats {
+ public:
+  enum {
+    // Expressions at depth MAX_DEPTH - 1 or deeper are counted together.
+    MAX_DEPTH = 32,
+    // Number of power-of-two buckets in argument count histograms.
+    NUM_ARG_BUCKETS = 24
+  };
+
+  struct KindStats {
+    // Number of expressions of this kind.
+    fmt::LongLong count;
+
+    // depths[d] is the number of expressions of this kind at depth d
+    // where the root of a tree has depth 0.
+    fmt::LongLong depths[MAX_DEPTH];
+
+    // Total and maximum number of arguments of expressions with variable
+    // number of arguments. For piecewise-linear terms these are numbers
+    // of breakpoints.
+    fmt::LongLong num_args;
+    int max_args;
+
+    // args[i] is the number of expressions with the number of arguments
+    // in [2^i, 2^(i + 1)). Expressions without arguments are counted
+    // in args[0].
+    fmt::LongLong args[NUM_ARG_BUCKETS];
+
+    KindStats();
+  };
+
+ private:
+  std::vector<KindStats> kinds_;
+  fmt::LongLong num_trees_;
+  int max_depth_;
+
+ public:
+  ExprStats()
+    : kinds_(expr::LAST_EXPR + 1), num_trees_(0), max_depth_(0) {}
+
+  const KindStats &operator[](expr::Kind kind) const { return kinds_[kind]; }
+
+  // Returns the number of expression trees.
+  fmt::LongLong num_trees() const { return num_trees_; }
+
+  // Returns the maximum depth of an expression.
+  int max_depth() const { return max_depth_; }
+
+  void AddTree() { ++num_trees_; }
+
+  // Adds an expression at the specified depth.
+  void Add(expr::Kind kind, int depth) {
+    KindStats &s = kinds_[kind];
+    ++s.count;
+    if (depth > max_depth_)
+      max_depth_ = depth;
+    ++s.depths[depth < MAX_DEPTH ? depth : MAX_DEPTH - 1];
+  }
+
+  // Adds the number of arguments of an expression.
+  void AddArgs(expr::Kind kind, int num_args);
+
+  // Writes statistics as a table.
+  void Write(fmt::Writer &w) const;
+
+  // Adds expression counts to stats as counters.
+  void AddTo(Stats &stats) const;
+};
+
+// Collects statistics of expression trees.
+template <typename ExprTypes>
+class BasicExprStatsCollector :
+    public BasicExprVisitor<BasicExprStatsCollector<ExprTypes>,
+                            void, void, ExprTypes> {
+ private:
+  typedef BasicExprVisitor<BasicExprStatsCollector<ExprTypes>,
+                           void, void, ExprTypes> Base;
+
+  ExprStats &stats_;
+  int depth_;
+
+ public:
+  MP_DEFINE_EXPR_TYPES(ExprTypes);
+
+ private:
+  template <typename ExprType>
+  void VisitArgs(ExprType e) {
+    int num_args = 0;
+    for (typename ExprType::iterator
+         i = e.begin(), end = e.end(); i != end; ++i, ++num_args) {
+      Visit(*i);
+    }
+    stats_.AddArgs(e.kind(), num_args);
+  }
+
+  // Visits arguments that can be string literals or symbolic
+  // if-then-else expressions.
+  template <typename ExprType>
+  void VisitSymbolicArgs(ExprType e) {
+    int num_args = 0;
+    for (typename ExprType::iterator
+         i = e.begin(), end = e.end(); i != end; ++i, ++num_args) {
+      Expr arg = *i;
+      if (NumericExpr n = ExprTypes::template Cast<NumericExpr>(arg))
+        Visit(n);
+      else
+        stats_.Add(arg.kind(), depth_);
+    }
+    stats_.AddArgs(e.kind(), num_args);
+  }
+
+ public:
+  explicit BasicExprStatsCollector(ExprStats &stats)
+    : stats_(stats), depth_(0) {}
+
+  // Collects statistics of an expression tree.
+  template <typename ExprType>
+  void Collect(ExprType e) {
+    stats_.AddTree();
+    depth_ = 0;
+    Visit(e);
+  }
+
+  void Visit(NumericExpr e) {
+    stats_.Add(e.kind(), depth_);
+    ++depth_;
+    Base::Visit(e);
+    --depth_;
+  }
+
+  void Visit(LogicalExpr e) {
+    stats_.Add(e.kind(), depth_);
+    ++depth_;
+    Base::Visit(e);
+    --depth_;
+  }
+
+  void VisitNumericConstant(NumericConstant) {}
+  void VisitVariable(Variable) {}
+  void VisitCommonExpr(CommonExpr) {}
+
+  void VisitUnary(UnaryExpr e) { Visit(e.arg()); }
+
+  void VisitBinary(BinaryExpr e) {
+    Visit(e.lhs());
+    Visit(e.rhs());
+  }
+
+  void VisitIf(IfExpr e) {
+    Visit(e.condition());
+    Visit(e.true_expr());
+    if (NumericExpr false_expr = e.false_expr())
+      Visit(false_expr);
+  }
+
+  void VisitPLTerm(PLTerm e) {
+    stats_.AddArgs(expr::PLTERM, e.num_breakpoints());
+    Visit(e.arg());
+  }
+
+  void VisitCall(CallExpr e) { VisitSymbolicArgs(e); }
+  void VisitVarArg(VarArgExpr e) { VisitArgs(e); }
+  void VisitSum(SumExpr e) { VisitArgs(e); }
+  void VisitCount(CountExpr e) { VisitArgs(e); }
+  void VisitNumberOf(NumberOfExpr e) { VisitArgs(e); }
+  void VisitNumberOfSym(SymbolicNumberOfExpr e) { VisitSymbolicArgs(e); }
+
+  void VisitLogicalConstant(LogicalConstant) {}
+
+  void VisitNot(NotExpr e) { Visit(e.arg()); }
+
+  void VisitBinaryLogical(BinaryLogicalExpr e) {
+    Visit(e.lhs());
+    Visit(e.rhs());
+  }
+
+  void VisitRelational(RelationalExpr e) {
+    Visit(e.lhs());
+    Visit(e.rhs());
+  }
+
+  void VisitLogicalCount(LogicalCountExpr e) {
+    Visit(e.lhs());
+    Visit(e.rhs());
+  }
+
+  void VisitImplication(ImplicationExpr e) {
+    Visit(e.condition());
+    Visit(e.true_expr());
+    if (LogicalExpr false_expr = e.false_expr())
+      Visit(false_expr);
+  }
+
+  void VisitIteratedLogical(IteratedLogicalExpr e) { VisitArgs(e); }
+  void VisitAllDiff(PairwiseExpr e) { VisitArgs(e); }
+  void VisitNotAllDiff(PairwiseExpr e) { VisitArgs(e); }
+};
+
+typedef BasicExprStatsCollector<internal::ExprTypes> ExprStatsCollector;
+
+// Collects statistics of nonlinear parts of objectives, algebraic
+// constraints and common expressions and of logical constraints.
+void CollectExprStats(const Problem &p, ExprStats &stats);
+
+// Time spent visiting expressions by expression kind.
+class ExprProfile {
+ public:
+  struct Entry {
+    // Number of visited expressions.
+    fmt::LongLong count;
+    // Time in seconds including and excluding subexpressions.
+    double time;
+    double self_time;
+
+    Entry() : count(0), time(0), self_time(0) {}
+  };
+
+ private:
+  std::vector<Entry> entries_;
+
+  // Time spent in subexpressions of the expressions being visited.
+  std::vector<double> child_times_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ExprProfile);
+
+ public:
+  ExprProfile() : entries_(expr::LAST_EXPR + 1) {}
+
+  const Entry &operator[](expr::Kind kind) const { return entries_[kind]; }
+
+  // Returns true if no expressions have been visited.
+  bool empty() const;
+
+  // Discards the recorded times.
+  void Clear() {
+    entries_.assign(entries_.size(), Entry());
+    child_times_.clear();
+  }
+
+  // Measures the time of visiting an expression.
+  class Scope {
+   private:
+    ExprProfile &profile_;
+    expr::Kind kind_;
+    steady_clock::time_point start_;
+
+    FMT_DISALLOW_COPY_AND_ASSIGN(Scope);
+
+   public:
+    Scope(ExprProfile &p, expr::Kind kind) : profile_(p), kind_(kind) {
+      p.child_times_.push_back(0);
+      start_ = steady_clock::now();
+    }
+
+    ~Scope() {
+      double time = GetTimeAndReset(start_);
+      Entry &e = profile_.entries_[kind_];
+      ++e.count;
+      e.time += time;
+      e.self_time += time - profile_.child_times_.back();
+      profile_.child_times_.pop_back();
+      if (!profile_.child_times_.empty())
+        profile_.child_times_.back() += time;
+    }
+  };
+
+  // Writes the profile as a table sorted by self time.
+  void Write(fmt::Writer &w) const;
+
+  // Adds times to stats as timers.
+  void AddTo(Stats &stats) const;
+};
+
+// An expression visitor that records the time spent in visitor methods
+// by expression kind when a profile is set.
+template <typename Impl, typename Result, typename LResult, typename ExprTypes>
+class BasicProfilingExprVisitor :
+    public BasicExprVisitor<Impl, Result, LResult, ExprTypes> {
+ private:
+  typedef BasicExprVisitor<Impl, Result, LResult, ExprTypes> Base;
+
+  ExprProfile *profile_;
+
+ public:
+  MP_DEFINE_EXPR_TYPES(ExprTypes);
+
+  BasicProfilingExprVisitor() : profile_(0) {}
+
+  // Sets the profile to record times to. Profiling is disabled if p is
+  // null which is the default.
+  void set_profile(ExprProfile *p) { profile_ = p; }
+
+  Result Visit(NumericExpr e) {
+    if (!profile_)
+      return Base::Visit(e);
+    ExprProfile::Scope scope(*profile_, e.kind());
+    return Base::Visit(e);
+  }
+
+  LResult Visit(LogicalExpr e) {
+    if (!profile_)
+      return Base::Visit(e);
+    ExprProfile::Scope scope(*profile_, e.kind());
+    return Base::Visit(e);
+  }
+};
+}  // namespace mp
+
+#endif  // MP_EXPR_STATS_H_
@@ -49,6 +49,13 @@ namespace mp {
 template <typename Impl, typename Result, typename LResult = Result>
 class ExprVisitor :
     public BasicExprVisitor<Impl, Result, LResult, internal::ExprTypes> {};
+
+// An expression visitor that visits arguments before their parents using
+// an explicit stack instead of recursion (see BasicPostOrderExprVisitor).
+template <typename Impl, typename Result, typename LResult = Result>
+class PostOrderExprVisitor :
+    public BasicPostOrderExprVisitor<Impl, Result, LResult,
+                                     internal::ExprTypes> {};
 }  // namespace mp
 
 #endif  // MP_EXPR_VISITOR_H_
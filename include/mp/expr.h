@@ -174,6 +174,10 @@ class Expr {
   //     // Do something if e is not null.
   //   }
   operator SafeBool() const { return impl_ != 0 ? &Expr::True : 0; }
+
+  // Returns true if this and other refer to the same expression.
+  bool operator==(Expr other) const { return impl_ == other.impl_; }
+  bool operator!=(Expr other) const { return impl_ != other.impl_; }
 };
 
 template <typename ExprType>
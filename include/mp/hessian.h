@@ -0,0 +1,132 @@
+/*
+ Sparse Hessian of the Lagrangian evaluation
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_HESSIAN_H_
+#define MP_HESSIAN_H_
+
+#include <vector>
+
+#include "mp/arrayref.h"
+#include "mp/tape.h"
+
+namespace mp {
+
+// Computes the Hessian of the Lagrangian
+//   sum(obj_weights[i] * obj[i]) + sum(con_multipliers[i] * con[i])
+// of a problem compiled into a tape.
+//
+// The sparsity pattern is determined and the variables are star colored
+// once on construction. Then the Hessian is recovered from the products
+// of the Hessian by sums of unit vectors of variables of the same color
+// which are computed by forward-over-reverse sweeps over the tape
+// BATCH_SIZE colors at a time. Evaluation doesn't allocate memory.
+class HessianEvaluator {
+ public:
+  // Maximum number of Hessian-vector products computed in one sweep.
+  enum {BATCH_SIZE = 8};
+
+ private:
+  TapeEvaluator eval_;
+
+  // Instructions that the Lagrangian depends on in increasing order.
+  std::vector<int> instrs_;
+
+  // Upper triangle of the Hessian stored by columns: column j has
+  // elements in rows rows_[col_starts_[j]:col_starts_[j + 1]] in
+  // increasing order.
+  std::vector<int> col_starts_;
+  std::vector<int> rows_;
+
+  // Variables that have nonzero elements in the Hessian in increasing
+  // order and their colors.
+  std::vector<int> hes_vars_;
+  std::vector<int> colors_;
+  int num_colors_;
+
+  // compressed_[i * num_colors_ + c] is the element of the product of
+  // the Hessian by the sum of unit vectors of color c in the row
+  // hes_vars_[i]. Element k of the Hessian is compressed_[recovery_[k]].
+  std::vector<double> compressed_;
+  std::vector<int> recovery_;
+
+  // Tangents and adjoint tangents of registers for BATCH_SIZE
+  // directions stored by registers, and adjoints of registers.
+  std::vector<double> tangents_;
+  std::vector<double> adjoints_;
+  std::vector<double> adjoint_tangents_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(HessianEvaluator);
+
+  // Finds the sparsity pattern of the upper triangle of the Hessian.
+  void FindSparsity();
+
+  // Star colors the adjacency graph of the Hessian and finds where in
+  // compressed_ each element of the Hessian can be recovered from.
+  void Color();
+
+  // Computes the products of the Hessian by the sums of unit vectors of
+  // colors [first_color, first_color + num_dirs).
+  void Multiply(const double *obj_weights, const double *con_multipliers,
+                int first_color, int num_dirs);
+
+ public:
+  explicit HessianEvaluator(const Tape &tape);
+
+  const Tape &tape() const { return eval_.tape(); }
+
+  // Returns the evaluator holding objective and constraint values
+  // computed by the last call to Evaluate.
+  const TapeEvaluator &evaluator() const { return eval_; }
+
+  // Evaluates all expressions at the point x. Should be called before
+  // computing the Hessian at x.
+  void Evaluate(const double *x) { eval_.Evaluate(x); }
+
+  // Returns the row indices of structurally nonzero elements in the
+  // upper triangle of the specified column in increasing order.
+  ArrayRef<int> col_rows(int col) const {
+    int start = col_starts_[col];
+    return ArrayRef<int>(rows_.empty() ? 0 : &rows_[0] + start,
+                         col_starts_[col + 1] - start);
+  }
+
+  // Returns the position of the first element of the column in the
+  // values computed by GetHessian. col_start(num_vars) is the number of
+  // structurally nonzero elements in the upper triangle.
+  int col_start(int col) const { return col_starts_[col]; }
+
+  int num_nonzeros() const { return col_starts_.back(); }
+
+  // Returns the number of colors, which is the number of Hessian-vector
+  // products needed to compute the Hessian.
+  int num_colors() const { return num_colors_; }
+
+  // Computes the upper triangle of the Hessian of the Lagrangian at the
+  // point passed to the last call to Evaluate. The values are stored by
+  // columns in the order of col_rows of each column. obj_weights and
+  // con_multipliers may be null in which case they are treated as zero.
+  void GetHessian(const double *obj_weights, const double *con_multipliers,
+                  double *values);
+};
+}  // namespace mp
+
+#endif  // MP_HESSIAN_H_
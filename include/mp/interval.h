@@ -0,0 +1,126 @@
+/*
+ Interval arithmetic
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_INTERVAL_H_
+#define MP_INTERVAL_H_
+
+#include <limits>
+
+namespace mp {
+
+// A closed interval [lb, ub] of extended real numbers. An interval with
+// lb > ub is empty.
+//
+// Operations round bounds outward, so their results enclose the exact
+// images of the arguments. Bounds of sums, products, quotients, square
+// roots, integer powers and roots are moved to the next double only if
+// the result is inexact. Bounds computed with other math library
+// functions such as exp and sin are moved outward by a few ulps to cover
+// the error of these functions.
+struct Interval {
+  double lb;
+  double ub;
+
+  // Constructs the interval containing all real numbers.
+  Interval()
+    : lb(-std::numeric_limits<double>::infinity()),
+      ub(std::numeric_limits<double>::infinity()) {}
+
+  Interval(double lb, double ub) : lb(lb), ub(ub) {}
+
+  // Constructs the interval containing a single value.
+  explicit Interval(double value) : lb(value), ub(value) {}
+
+  // Returns the empty interval.
+  static Interval Empty() {
+    double inf = std::numeric_limits<double>::infinity();
+    return Interval(inf, -inf);
+  }
+
+  bool empty() const { return !(lb <= ub); }
+
+  bool contains(double value) const { return lb <= value && value <= ub; }
+
+  // Returns true if the interval consists of a single value.
+  bool is_point() const { return lb == ub; }
+};
+
+inline bool operator==(Interval lhs, Interval rhs) {
+  return lhs.lb == rhs.lb && lhs.ub == rhs.ub;
+}
+
+inline bool operator!=(Interval lhs, Interval rhs) { return !(lhs == rhs); }
+
+// Returns the intersection of two intervals.
+inline Interval Intersect(Interval a, Interval b) {
+  return Interval(a.lb > b.lb ? a.lb : b.lb, a.ub < b.ub ? a.ub : b.ub);
+}
+
+// Returns the smallest interval containing both intervals.
+inline Interval Hull(Interval a, Interval b) {
+  if (a.empty()) return b;
+  if (b.empty()) return a;
+  return Interval(a.lb < b.lb ? a.lb : b.lb, a.ub > b.ub ? a.ub : b.ub);
+}
+
+inline Interval operator-(Interval a) { return Interval(-a.ub, -a.lb); }
+
+Interval operator+(Interval a, Interval b);
+Interval operator-(Interval a, Interval b);
+Interval operator*(Interval a, Interval b);
+
+// Returns an enclosure of {x / y : x in a, y in b, y != 0}. The result
+// is the whole line if b contains zero in its interior.
+Interval operator/(Interval a, Interval b);
+
+// Functions below return enclosures of the images of intervals under the
+// corresponding real functions restricted to their domains. The result
+// is empty if the argument doesn't intersect the domain.
+Interval Abs(Interval a);
+Interval Sqr(Interval a);
+Interval Sqrt(Interval a);
+Interval Exp(Interval a);
+Interval Log(Interval a);
+Interval Log10(Interval a);
+Interval Pow(Interval base, Interval exponent);
+Interval Sin(Interval a);
+Interval Cos(Interval a);
+Interval Tan(Interval a);
+Interval Sinh(Interval a);
+Interval Cosh(Interval a);
+Interval Tanh(Interval a);
+Interval Asin(Interval a);
+Interval Acos(Interval a);
+Interval Atan(Interval a);
+Interval Asinh(Interval a);
+Interval Acosh(Interval a);
+Interval Atanh(Interval a);
+Interval Floor(Interval a);
+Interval Ceil(Interval a);
+Interval Min(Interval a, Interval b);
+Interval Max(Interval a, Interval b);
+
+// Returns an enclosure of {x : x^n in a} for a positive integer n.
+Interval Root(Interval a, int n);
+}  // namespace mp
+
+#endif  // MP_INTERVAL_H_
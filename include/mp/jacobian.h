@@ -0,0 +1,135 @@
+/*
+ Sparse Jacobian and gradient evaluation by reverse-mode automatic
+ differentiation
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_JACOBIAN_H_
+#define MP_JACOBIAN_H_
+
+#include <vector>
+
+#include "mp/arrayref.h"
+#include "mp/tape.h"
+
+namespace mp {
+
+// Computes objective gradients and the constraint Jacobian of a problem
+// compiled into a tape by reverse-mode automatic differentiation.
+//
+// Sparsity patterns are computed once on construction, so a solver
+// normally creates a single JacobianEvaluator after the problem is built
+// and reuses it for all evaluations. The derivative of an output with
+// respect to a variable is structurally nonzero if the variable is
+// reachable from the output through differentiable operands, for example,
+// variables that only appear in conditions of if-then-else expressions
+// are not in the pattern.
+//
+// Evaluation doesn't allocate memory: adjoints are kept in a preallocated
+// buffer which is cleared as the reverse sweep proceeds.
+class JacobianEvaluator {
+ private:
+  TapeEvaluator eval_;
+
+  // Instructions and variables that outputs depend on. Outputs are
+  // objectives followed by algebraic constraints. Output k depends on
+  // instructions instrs_[instr_starts_[k]:instr_starts_[k + 1]] and
+  // variables vars_[var_starts_[k]:var_starts_[k + 1]] both given in
+  // increasing order.
+  std::vector<int> instr_starts_;
+  std::vector<int> instrs_;
+  std::vector<int> var_starts_;
+  std::vector<int> vars_;
+
+  // Adjoints of registers. All adjoints except those of constants are
+  // zero between calls to Differentiate.
+  std::vector<double> adjoints_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(JacobianEvaluator);
+
+  friend class ParallelEvaluator;
+
+  int GetOutputRegister(int output) const;
+
+  // Computes the derivatives of the output with respect to the variables
+  // it depends on and stores them in values. r contains register values
+  // and adj adjoints which are left zero except for those of constants.
+  void Differentiate(int output, const double *r, double *adj,
+                     double *values) const;
+
+  // Clears adjoints of constants accumulated by previous calls to
+  // Differentiate. They are never read, so this is only done to keep
+  // them bounded.
+  void ClearConstAdjoints(double *adj) const;
+
+  ArrayRef<int> GetVars(int output) const {
+    int start = var_starts_[output];
+    return ArrayRef<int>(vars_.empty() ? 0 : &vars_[0] + start,
+                         var_starts_[output + 1] - start);
+  }
+
+ public:
+  explicit JacobianEvaluator(const Tape &tape);
+
+  const Tape &tape() const { return eval_.tape(); }
+
+  // Returns the evaluator holding objective and constraint values
+  // computed by the last call to Evaluate.
+  const TapeEvaluator &evaluator() const { return eval_; }
+
+  // Evaluates all expressions at the point x. Should be called before
+  // computing derivatives at x.
+  void Evaluate(const double *x) { eval_.Evaluate(x); }
+
+  // Returns the indices of variables with structurally nonzero gradient
+  // components for the specified objective in increasing order.
+  ArrayRef<int> obj_grad_vars(int obj_index) const {
+    return GetVars(obj_index);
+  }
+
+  // Returns the indices of variables with structurally nonzero Jacobian
+  // elements in the specified constraint row in increasing order.
+  ArrayRef<int> jac_vars(int con_index) const {
+    return GetVars(tape().num_objs() + con_index);
+  }
+
+  // Returns the position of the first element of the constraint row in
+  // the values computed by GetJacobian. jac_start(num_cons) is the number
+  // of structurally nonzero Jacobian elements.
+  int jac_start(int con_index) const {
+    int num_objs = tape().num_objs();
+    return var_starts_[num_objs + con_index] - var_starts_[num_objs];
+  }
+
+  int num_jac_nonzeros() const { return jac_start(tape().num_cons()); }
+
+  // Computes the gradient of an objective at the point passed to the
+  // last call to Evaluate. The values are stored in the order of
+  // obj_grad_vars(obj_index).
+  void GetObjGradient(int obj_index, double *values);
+
+  // Computes the constraint Jacobian at the point passed to the last call
+  // to Evaluate. The values are stored by rows in the order of jac_vars
+  // of each constraint; the row of constraint i starts at jac_start(i).
+  void GetJacobian(double *values);
+};
+}  // namespace mp
+
+#endif  // MP_JACOBIAN_H_
@@ -0,0 +1,1122 @@
+/*
+ Pipelined .nl reading
+
+ A pipelined reader runs the .nl reader on a separate thread which records
+ handler notifications into chunks of compact events. The chunks are passed
+ through a bounded queue to the calling thread which replays them into the
+ real handler. This overlaps parsing of the input with problem construction.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_NL_PIPELINE_H_
+#define MP_NL_PIPELINE_H_
+
+#include "mp/clock.h"
+#include "mp/nl.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifdef MP_USE_THREAD
+# include <condition_variable>
+# include <exception>
+# include <functional>
+# include <mutex>
+# include <thread>
+#endif
+
+namespace mp {
+namespace internal {
+
+// A reference to an expression recorded by NLEventRecorder.
+// Expressions of each type are numbered consecutively in the order of
+// creation so that the replayer can map them to handler expressions.
+class RecordedExpr {
+ public:
+  enum Type { NONE, NUMERIC, LOGICAL, COUNT, REFERENCE, SYMBOLIC };
+
+ private:
+  Type type_;
+  int id_;
+
+ public:
+  RecordedExpr() : type_(NONE), id_(0) {}
+  RecordedExpr(Type type, int id) : type_(type), id_(id) {}
+
+  Type type() const { return type_; }
+  int id() const { return id_; }
+};
+
+// A recorded notification of an NLHandler.
+struct NLEvent {
+  // Event codes.
+  enum Code {
+    OBJ,                // args: index, type; exprs: expr
+    ALGEBRAIC_CON,      // args: index; exprs: expr
+    LOGICAL_CON,        // args: index; exprs: expr
+    BEGIN_COMMON_EXPR,  // args: index, num_linear_terms
+    END_COMMON_EXPR,    // args: position; exprs: expr
+    COMPLEMENT,         // args: con_index, var_index, flags
+    LINEAR_OBJ,         // args: index, num_linear_terms
+    LINEAR_CON,         // args: index, num_linear_terms
+    OBJ_TERM,           // args: var_index; values: coef
+    CON_TERM,           // args: var_index; values: coef
+    COMMON_EXPR_TERM,   // args: var_index; values: coef
+    VAR_BOUNDS,         // args: index; values: lb, ub
+    CON_BOUNDS,         // args: index; values: lb, ub
+    INITIAL_VALUE,      // args: index; values: value
+    INITIAL_DUAL_VALUE, // args: index; values: value
+    COLUMN_SIZES,
+    COLUMN_SIZE,        // args: size
+    FUNCTION,           // args: index, num_args, type; string: name
+    INT_SUFFIX,         // args: kind, num_values; string: name
+    INT_SUFFIX_VALUE,   // args: index, value
+    DBL_SUFFIX,         // args: kind, num_values; string: name
+    DBL_SUFFIX_VALUE,   // args: index; values: value
+    NUMERIC_CONSTANT,   // values: value
+    VARIABLE_REF,       // args: index
+    COMMON_EXPR_REF,    // args: index
+    UNARY,              // args: kind; exprs: arg
+    BINARY,             // args: kind; exprs: lhs, rhs
+    IF,                 // exprs: condition, true_expr, false_expr
+    BEGIN_PLTERM,       // args: num_breakpoints
+    PLTERM_SLOPE,       // values: slope
+    PLTERM_BREAKPOINT,  // values: breakpoint
+    END_PLTERM,         // exprs: arg
+    BEGIN_CALL,         // args: func_index, num_args
+    CALL_ARG,           // exprs: arg
+    END_CALL,
+    BEGIN_VARARG,       // args: kind, num_args
+    VARARG_ARG,         // exprs: arg
+    END_VARARG,
+    BEGIN_SUM,          // args: num_args
+    SUM_ARG,            // exprs: arg
+    END_SUM,
+    BEGIN_COUNT,        // args: num_args
+    COUNT_ARG,          // exprs: arg
+    END_COUNT,
+    BEGIN_NUMBEROF,     // args: num_args; exprs: arg0
+    NUMBEROF_ARG,       // exprs: arg
+    END_NUMBEROF,
+    BEGIN_SYMBOLIC_NUMBEROF,  // args: num_args; exprs: arg0
+    SYMBOLIC_NUMBEROF_ARG,    // exprs: arg
+    END_SYMBOLIC_NUMBEROF,
+    LOGICAL_CONSTANT,   // args: value
+    NOT,                // exprs: arg
+    BINARY_LOGICAL,     // args: kind; exprs: lhs, rhs
+    RELATIONAL,         // args: kind; exprs: lhs, rhs
+    LOGICAL_COUNT,      // args: kind; exprs: lhs, rhs
+    IMPLICATION,        // exprs: condition, true_expr, false_expr
+    BEGIN_ITERATED_LOGICAL,  // args: kind, num_args
+    ITERATED_LOGICAL_ARG,    // exprs: arg
+    END_ITERATED_LOGICAL,
+    BEGIN_PAIRWISE,     // args: kind, num_args
+    PAIRWISE_ARG,       // exprs: arg
+    END_PAIRWISE,
+    STRING_LITERAL,     // string: value
+    SYMBOLIC_IF         // exprs: condition, true_expr, false_expr
+  };
+
+  int code;
+  int args[3];
+  std::size_t str_offset;  // Offset of the string in NLEventChunk::strings.
+  std::size_t str_size;
+  double values[2];
+  RecordedExpr exprs[3];
+};
+
+// A chunk of recorded events together with the strings they refer to.
+// Strings are copied because the input buffer may be unmapped by the time
+// the chunk is replayed.
+struct NLEventChunk {
+  std::vector<NLEvent> events;
+  std::string strings;
+
+  void clear() {
+    events.clear();
+    strings.clear();
+  }
+
+  void swap(NLEventChunk &other) {
+    events.swap(other.events);
+    strings.swap(other.strings);
+  }
+};
+
+// Replays recorded events into a handler implementing the NLHandler concept.
+template <typename Handler>
+class NLEventReplayer {
+ private:
+  Handler &handler_;
+
+  typedef typename Handler::Expr Expr;
+  typedef typename Handler::NumericExpr NumericExpr;
+  typedef typename Handler::LogicalExpr LogicalExpr;
+  typedef typename Handler::CountExpr CountExpr;
+  typedef typename Handler::Reference Reference;
+
+  // Expressions created by the handler indexed by RecordedExpr::id().
+  std::vector<NumericExpr> numeric_exprs_;
+  std::vector<LogicalExpr> logical_exprs_;
+  std::vector<CountExpr> count_exprs_;
+  std::vector<Reference> references_;
+  std::vector<Expr> symbolic_exprs_;
+
+  // Argument handlers of expressions being built. Nested expressions of
+  // the same kind are completed in the LIFO order so stacks are used.
+  std::vector<typename Handler::CallArgHandler> call_args_;
+  std::vector<typename Handler::VarArgHandler> vararg_args_;
+  std::vector<typename Handler::NumericArgHandler> sum_args_;
+  std::vector<typename Handler::CountArgHandler> count_args_;
+  std::vector<typename Handler::NumberOfArgHandler> numberof_args_;
+  std::vector<typename Handler::SymbolicArgHandler> symbolic_numberof_args_;
+  std::vector<typename Handler::LogicalArgHandler> logical_args_;
+  std::vector<typename Handler::PairwiseArgHandler> pairwise_args_;
+  std::vector<typename Handler::PLTermHandler> plterms_;
+
+  // Holds a handler of a segment such as a linear part of an objective.
+  // The handler is constructed directly from the result of a handler call
+  // and destroyed at the end of the segment as it would be in NLReader.
+  template <typename T>
+  class SegmentHandler {
+   private:
+    T *ptr_;
+
+    FMT_DISALLOW_COPY_AND_ASSIGN(SegmentHandler);
+
+   public:
+    SegmentHandler() : ptr_(0) {}
+    ~SegmentHandler() { delete ptr_; }
+
+    void reset(T *ptr = 0) {
+      delete ptr_;
+      ptr_ = ptr;
+    }
+
+    T &get() { return *ptr_; }
+  };
+
+  // Code of the event that started the current segment or -1 if none.
+  int segment_;
+
+  SegmentHandler<typename Handler::LinearObjHandler> obj_terms_;
+  SegmentHandler<typename Handler::LinearConHandler> con_terms_;
+  SegmentHandler<typename Handler::LinearExprHandler> common_expr_;
+  // NLReader passes a copy of the common expression handler to receive
+  // the linear terms.
+  SegmentHandler<typename Handler::LinearExprHandler> common_expr_terms_;
+  SegmentHandler<typename Handler::ColumnSizeHandler> column_sizes_;
+  SegmentHandler<typename Handler::IntSuffixHandler> int_suffix_;
+  SegmentHandler<typename Handler::DblSuffixHandler> dbl_suffix_;
+
+  // Ends the current segment unless the event with the specified code
+  // belongs to it.
+  void EndSegment(int code) {
+    switch (segment_) {
+    case NLEvent::LINEAR_OBJ:
+      if (code == NLEvent::OBJ_TERM) return;
+      obj_terms_.reset();
+      break;
+    case NLEvent::LINEAR_CON:
+      if (code == NLEvent::CON_TERM) return;
+      con_terms_.reset();
+      break;
+    case NLEvent::COMMON_EXPR_TERM:
+      if (code == NLEvent::COMMON_EXPR_TERM) return;
+      common_expr_terms_.reset();
+      break;
+    case NLEvent::COLUMN_SIZES:
+      if (code == NLEvent::COLUMN_SIZE) return;
+      column_sizes_.reset();
+      break;
+    case NLEvent::INT_SUFFIX:
+      if (code == NLEvent::INT_SUFFIX_VALUE) return;
+      int_suffix_.reset();
+      break;
+    case NLEvent::DBL_SUFFIX:
+      if (code == NLEvent::DBL_SUFFIX_VALUE) return;
+      dbl_suffix_.reset();
+      break;
+    }
+    segment_ = -1;
+  }
+
+  template <typename T>
+  static T Pop(std::vector<T> &stack) {
+    T value = stack.back();
+    stack.pop_back();
+    return value;
+  }
+
+  NumericExpr GetNumericExpr(RecordedExpr e) const {
+    switch (e.type()) {
+    case RecordedExpr::NUMERIC:
+      return numeric_exprs_[e.id()];
+    case RecordedExpr::COUNT:
+      return count_exprs_[e.id()];
+    case RecordedExpr::REFERENCE:
+      return references_[e.id()];
+    default:
+      return NumericExpr();
+    }
+  }
+
+  LogicalExpr GetLogicalExpr(RecordedExpr e) const {
+    return e.type() == RecordedExpr::LOGICAL ?
+          logical_exprs_[e.id()] : LogicalExpr();
+  }
+
+  Expr GetSymbolicExpr(RecordedExpr e) const {
+    if (e.type() == RecordedExpr::SYMBOLIC)
+      return symbolic_exprs_[e.id()];
+    return GetNumericExpr(e);
+  }
+
+  static expr::Kind GetKind(const NLEvent &e) {
+    return static_cast<expr::Kind>(e.args[0]);
+  }
+
+ public:
+  explicit NLEventReplayer(Handler &h) : handler_(h), segment_(-1) {}
+
+  // Replays events from the chunk.
+  void Replay(const NLEventChunk &chunk);
+
+  // Ends replaying; called after the last chunk.
+  void Finish() { EndSegment(-1); }
+};
+
+template <typename Handler>
+void NLEventReplayer<Handler>::Replay(const NLEventChunk &chunk) {
+  const NLEvent *events = chunk.events.empty() ? 0 : &chunk.events[0];
+  for (std::size_t i = 0, n = chunk.events.size(); i < n; ++i) {
+    const NLEvent &e = events[i];
+    fmt::StringRef str(chunk.strings.data() + e.str_offset, e.str_size);
+    if (segment_ != -1)
+      EndSegment(e.code);
+    switch (e.code) {
+    case NLEvent::OBJ:
+      handler_.OnObj(e.args[0], static_cast<obj::Type>(e.args[1]),
+                     GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::ALGEBRAIC_CON:
+      handler_.OnAlgebraicCon(e.args[0], GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::LOGICAL_CON:
+      handler_.OnLogicalCon(e.args[0], GetLogicalExpr(e.exprs[0]));
+      break;
+    case NLEvent::BEGIN_COMMON_EXPR:
+      common_expr_.reset(new typename Handler::LinearExprHandler(
+                           handler_.BeginCommonExpr(e.args[0], e.args[1])));
+      break;
+    case NLEvent::END_COMMON_EXPR:
+      handler_.EndCommonExpr(common_expr_.get(),
+                             GetNumericExpr(e.exprs[0]), e.args[0]);
+      common_expr_.reset();
+      break;
+    case NLEvent::COMPLEMENT:
+      handler_.OnComplement(e.args[0], e.args[1], e.args[2]);
+      break;
+    case NLEvent::LINEAR_OBJ:
+      obj_terms_.reset(new typename Handler::LinearObjHandler(
+                         handler_.OnLinearObjExpr(e.args[0], e.args[1])));
+      segment_ = e.code;
+      break;
+    case NLEvent::LINEAR_CON:
+      con_terms_.reset(new typename Handler::LinearConHandler(
+                         handler_.OnLinearConExpr(e.args[0], e.args[1])));
+      segment_ = e.code;
+      break;
+    case NLEvent::OBJ_TERM:
+      obj_terms_.get().AddTerm(e.args[0], e.values[0]);
+      break;
+    case NLEvent::CON_TERM:
+      con_terms_.get().AddTerm(e.args[0], e.values[0]);
+      break;
+    case NLEvent::COMMON_EXPR_TERM:
+      if (segment_ != NLEvent::COMMON_EXPR_TERM) {
+        common_expr_terms_.reset(
+              new typename Handler::LinearExprHandler(common_expr_.get()));
+        segment_ = e.code;
+      }
+      common_expr_terms_.get().AddTerm(e.args[0], e.values[0]);
+      break;
+    case NLEvent::VAR_BOUNDS:
+      handler_.OnVarBounds(e.args[0], e.values[0], e.values[1]);
+      break;
+    case NLEvent::CON_BOUNDS:
+      handler_.OnConBounds(e.args[0], e.values[0], e.values[1]);
+      break;
+    case NLEvent::INITIAL_VALUE:
+      handler_.OnInitialValue(e.args[0], e.values[0]);
+      break;
+    case NLEvent::INITIAL_DUAL_VALUE:
+      handler_.OnInitialDualValue(e.args[0], e.values[0]);
+      break;
+    case NLEvent::COLUMN_SIZES:
+      column_sizes_.reset(new typename Handler::ColumnSizeHandler(
+                            handler_.OnColumnSizes()));
+      segment_ = e.code;
+      break;
+    case NLEvent::COLUMN_SIZE:
+      column_sizes_.get().Add(e.args[0]);
+      break;
+    case NLEvent::FUNCTION:
+      handler_.OnFunction(e.args[0], str, e.args[1],
+                          static_cast<func::Type>(e.args[2]));
+      break;
+    case NLEvent::INT_SUFFIX:
+      int_suffix_.reset(new typename Handler::IntSuffixHandler(
+                          handler_.OnIntSuffix(str, e.args[0], e.args[1])));
+      segment_ = e.code;
+      break;
+    case NLEvent::INT_SUFFIX_VALUE:
+      int_suffix_.get().SetValue(e.args[0], e.args[1]);
+      break;
+    case NLEvent::DBL_SUFFIX:
+      dbl_suffix_.reset(new typename Handler::DblSuffixHandler(
+                          handler_.OnDblSuffix(str, e.args[0], e.args[1])));
+      segment_ = e.code;
+      break;
+    case NLEvent::DBL_SUFFIX_VALUE:
+      dbl_suffix_.get().SetValue(e.args[0], e.values[0]);
+      break;
+    case NLEvent::NUMERIC_CONSTANT:
+      numeric_exprs_.push_back(handler_.OnNumericConstant(e.values[0]));
+      break;
+    case NLEvent::VARIABLE_REF:
+      references_.push_back(handler_.OnVariableRef(e.args[0]));
+      break;
+    case NLEvent::COMMON_EXPR_REF:
+      references_.push_back(handler_.OnCommonExprRef(e.args[0]));
+      break;
+    case NLEvent::UNARY:
+      numeric_exprs_.push_back(
+            handler_.OnUnary(GetKind(e), GetNumericExpr(e.exprs[0])));
+      break;
+    case NLEvent::BINARY:
+      numeric_exprs_.push_back(
+            handler_.OnBinary(GetKind(e), GetNumericExpr(e.exprs[0]),
+                              GetNumericExpr(e.exprs[1])));
+      break;
+    case NLEvent::IF:
+      numeric_exprs_.push_back(
+            handler_.OnIf(GetLogicalExpr(e.exprs[0]),
+                          GetNumericExpr(e.exprs[1]),
+                          GetNumericExpr(e.exprs[2])));
+      break;
+    case NLEvent::BEGIN_PLTERM:
+      plterms_.push_back(handler_.BeginPLTerm(e.args[0]));
+      break;
+    case NLEvent::PLTERM_SLOPE:
+      plterms_.back().AddSlope(e.values[0]);
+      break;
+    case NLEvent::PLTERM_BREAKPOINT:
+      plterms_.back().AddBreakpoint(e.values[0]);
+      break;
+    case NLEvent::END_PLTERM: {
+      Reference arg = e.exprs[0].type() == RecordedExpr::REFERENCE ?
+            references_[e.exprs[0].id()] : Reference();
+      numeric_exprs_.push_back(handler_.EndPLTerm(Pop(plterms_), arg));
+      break;
+    }
+    case NLEvent::BEGIN_CALL:
+      call_args_.push_back(handler_.BeginCall(e.args[0], e.args[1]));
+      break;
+    case NLEvent::CALL_ARG:
+      call_args_.back().AddArg(GetSymbolicExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_CALL:
+      numeric_exprs_.push_back(handler_.EndCall(Pop(call_args_)));
+      break;
+    case NLEvent::BEGIN_VARARG:
+      vararg_args_.push_back(handler_.BeginVarArg(GetKind(e), e.args[1]));
+      break;
+    case NLEvent::VARARG_ARG:
+      vararg_args_.back().AddArg(GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_VARARG:
+      numeric_exprs_.push_back(handler_.EndVarArg(Pop(vararg_args_)));
+      break;
+    case NLEvent::BEGIN_SUM:
+      sum_args_.push_back(handler_.BeginSum(e.args[0]));
+      break;
+    case NLEvent::SUM_ARG:
+      sum_args_.back().AddArg(GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_SUM:
+      numeric_exprs_.push_back(handler_.EndSum(Pop(sum_args_)));
+      break;
+    case NLEvent::BEGIN_COUNT:
+      count_args_.push_back(handler_.BeginCount(e.args[0]));
+      break;
+    case NLEvent::COUNT_ARG:
+      count_args_.back().AddArg(GetLogicalExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_COUNT:
+      count_exprs_.push_back(handler_.EndCount(Pop(count_args_)));
+      break;
+    case NLEvent::BEGIN_NUMBEROF:
+      numberof_args_.push_back(
+            handler_.BeginNumberOf(e.args[0], GetNumericExpr(e.exprs[0])));
+      break;
+    case NLEvent::NUMBEROF_ARG:
+      numberof_args_.back().AddArg(GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_NUMBEROF:
+      numeric_exprs_.push_back(handler_.EndNumberOf(Pop(numberof_args_)));
+      break;
+    case NLEvent::BEGIN_SYMBOLIC_NUMBEROF:
+      symbolic_numberof_args_.push_back(handler_.BeginSymbolicNumberOf(
+                                          e.args[0],
+                                          GetSymbolicExpr(e.exprs[0])));
+      break;
+    case NLEvent::SYMBOLIC_NUMBEROF_ARG:
+      symbolic_numberof_args_.back().AddArg(GetSymbolicExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_SYMBOLIC_NUMBEROF:
+      numeric_exprs_.push_back(
+            handler_.EndSymbolicNumberOf(Pop(symbolic_numberof_args_)));
+      break;
+    case NLEvent::LOGICAL_CONSTANT:
+      logical_exprs_.push_back(handler_.OnLogicalConstant(e.args[0] != 0));
+      break;
+    case NLEvent::NOT:
+      logical_exprs_.push_back(handler_.OnNot(GetLogicalExpr(e.exprs[0])));
+      break;
+    case NLEvent::BINARY_LOGICAL:
+      logical_exprs_.push_back(
+            handler_.OnBinaryLogical(GetKind(e), GetLogicalExpr(e.exprs[0]),
+                                     GetLogicalExpr(e.exprs[1])));
+      break;
+    case NLEvent::RELATIONAL:
+      logical_exprs_.push_back(
+            handler_.OnRelational(GetKind(e), GetNumericExpr(e.exprs[0]),
+                                  GetNumericExpr(e.exprs[1])));
+      break;
+    case NLEvent::LOGICAL_COUNT:
+      logical_exprs_.push_back(
+            handler_.OnLogicalCount(GetKind(e), GetNumericExpr(e.exprs[0]),
+                                    count_exprs_[e.exprs[1].id()]));
+      break;
+    case NLEvent::IMPLICATION:
+      logical_exprs_.push_back(
+            handler_.OnImplication(GetLogicalExpr(e.exprs[0]),
+                                   GetLogicalExpr(e.exprs[1]),
+                                   GetLogicalExpr(e.exprs[2])));
+      break;
+    case NLEvent::BEGIN_ITERATED_LOGICAL:
+      logical_args_.push_back(
+            handler_.BeginIteratedLogical(GetKind(e), e.args[1]));
+      break;
+    case NLEvent::ITERATED_LOGICAL_ARG:
+      logical_args_.back().AddArg(GetLogicalExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_ITERATED_LOGICAL:
+      logical_exprs_.push_back(
+            handler_.EndIteratedLogical(Pop(logical_args_)));
+      break;
+    case NLEvent::BEGIN_PAIRWISE:
+      pairwise_args_.push_back(handler_.BeginPairwise(GetKind(e), e.args[1]));
+      break;
+    case NLEvent::PAIRWISE_ARG:
+      pairwise_args_.back().AddArg(GetNumericExpr(e.exprs[0]));
+      break;
+    case NLEvent::END_PAIRWISE:
+      logical_exprs_.push_back(handler_.EndPairwise(Pop(pairwise_args_)));
+      break;
+    case NLEvent::STRING_LITERAL:
+      symbolic_exprs_.push_back(handler_.OnStringLiteral(str));
+      break;
+    case NLEvent::SYMBOLIC_IF:
+      symbolic_exprs_.push_back(
+            handler_.OnSymbolicIf(GetLogicalExpr(e.exprs[0]),
+                                  GetSymbolicExpr(e.exprs[1]),
+                                  GetSymbolicExpr(e.exprs[2])));
+      break;
+    default:
+      MP_ASSERT(false, "invalid event code");
+    }
+  }
+}
+
+// Timing of a pipelined read.
+struct NLPipelineTimes {
+  double read_time;   // Wall clock time of the reader thread.
+  double build_time;  // Time spent passing notifications to the handler.
+};
+
+#ifdef MP_USE_THREAD
+
+// Thrown on the reader thread when the consumer has cancelled reading.
+struct NLPipelineCancelled {};
+
+// A bounded queue of event chunks shared by the reader and the builder
+// threads. Chunk buffers are recycled to avoid reallocation.
+class NLEventQueue {
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<NLEventChunk> chunks_;
+  std::vector<NLEventChunk> free_chunks_;
+  std::size_t max_size_;
+  bool closed_;
+  bool cancelled_;
+
+ public:
+  explicit NLEventQueue(std::size_t max_size = 8)
+    : max_size_(max_size), closed_(false), cancelled_(false) {}
+
+  // Moves the content of chunk to the queue replacing it with a recycled
+  // buffer. Blocks while the queue is full. Returns false if cancelled.
+  bool Push(NLEventChunk &chunk);
+
+  // Moves the next chunk from the queue to chunk. Blocks while the queue
+  // is empty. Returns false if there are no more chunks.
+  bool Pop(NLEventChunk &chunk);
+
+  // Signals that there will be no more chunks.
+  void Close();
+
+  // Cancels reading and wakes up the reader.
+  void Cancel();
+};
+
+// An NLHandler that records notifications into event chunks and passes
+// them to an NLEventQueue. OnHeader and NeedObj are forwarded to the
+// real handler synchronously since the reader depends on their results.
+template <typename Handler>
+class NLEventRecorder {
+ public:
+  typedef RecordedExpr Expr;
+  typedef RecordedExpr NumericExpr;
+  typedef RecordedExpr LogicalExpr;
+  typedef RecordedExpr CountExpr;
+  typedef RecordedExpr Reference;
+
+ private:
+  Handler &handler_;
+  NLEventQueue &queue_;
+  NLEventChunk chunk_;
+  int num_exprs_[RecordedExpr::SYMBOLIC + 1];
+
+  enum { CHUNK_SIZE = 4096 };
+
+  NLEvent &AddEvent(int code) {
+    if (chunk_.events.size() == CHUNK_SIZE)
+      Flush();
+    chunk_.events.push_back(NLEvent());
+    NLEvent &e = chunk_.events.back();
+    e.code = code;
+    e.str_offset = e.str_size = 0;
+    return e;
+  }
+
+  NLEvent &AddEvent(int code, fmt::StringRef str) {
+    NLEvent &e = AddEvent(code);
+    e.str_offset = chunk_.strings.size();
+    e.str_size = str.size();
+    chunk_.strings.append(str.c_str(), str.size());
+    return e;
+  }
+
+  NLEvent &AddEvent(int code, RecordedExpr arg) {
+    NLEvent &e = AddEvent(code);
+    e.exprs[0] = arg;
+    return e;
+  }
+
+  RecordedExpr MakeExpr(RecordedExpr::Type type) {
+    return RecordedExpr(type, num_exprs_[type]++);
+  }
+
+  // Records a notification of an expression with up to three arguments.
+  RecordedExpr OnExpr(RecordedExpr::Type type, int code, int arg,
+                      RecordedExpr e0, RecordedExpr e1 = RecordedExpr(),
+                      RecordedExpr e2 = RecordedExpr()) {
+    NLEvent &e = AddEvent(code);
+    e.args[0] = arg;
+    e.exprs[0] = e0;
+    e.exprs[1] = e1;
+    e.exprs[2] = e2;
+    return MakeExpr(type);
+  }
+
+  template <int CODE>
+  class ArgRecorder {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit ArgRecorder(NLEventRecorder &r) : recorder_(&r) {}
+
+    void AddArg(RecordedExpr arg) { recorder_->AddEvent(CODE, arg); }
+  };
+
+  template <int CODE>
+  class TermRecorder {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit TermRecorder(NLEventRecorder &r) : recorder_(&r) {}
+
+    void AddTerm(int var_index, double coef) {
+      NLEvent &e = recorder_->AddEvent(CODE);
+      e.args[0] = var_index;
+      e.values[0] = coef;
+    }
+  };
+
+  // Begins an expression with a variable number of arguments.
+  template <typename ArgHandler>
+  ArgHandler Begin(int code, int arg0, int arg1 = 0) {
+    NLEvent &e = AddEvent(code);
+    e.args[0] = arg0;
+    e.args[1] = arg1;
+    return ArgHandler(*this);
+  }
+
+  void OnBounds(int code, int index, double lb, double ub) {
+    NLEvent &e = AddEvent(code);
+    e.args[0] = index;
+    e.values[0] = lb;
+    e.values[1] = ub;
+  }
+
+ public:
+  NLEventRecorder(Handler &h, NLEventQueue &q) : handler_(h), queue_(q) {
+    std::fill(num_exprs_, num_exprs_ + RecordedExpr::SYMBOLIC + 1, 0);
+    chunk_.events.reserve(CHUNK_SIZE);
+  }
+
+  // Passes recorded events to the queue.
+  void Flush() {
+    if (chunk_.events.empty())
+      return;
+    if (!queue_.Push(chunk_))
+      throw NLPipelineCancelled();
+    chunk_.clear();
+    chunk_.events.reserve(CHUNK_SIZE);
+  }
+
+  void OnHeader(const NLHeader &h) { handler_.OnHeader(h); }
+
+  bool NeedObj(int obj_index) const { return handler_.NeedObj(obj_index); }
+
+  void OnObj(int index, obj::Type type, RecordedExpr expr) {
+    NLEvent &e = AddEvent(NLEvent::OBJ, expr);
+    e.args[0] = index;
+    e.args[1] = type;
+  }
+
+  void OnAlgebraicCon(int index, RecordedExpr expr) {
+    AddEvent(NLEvent::ALGEBRAIC_CON, expr).args[0] = index;
+  }
+
+  void OnLogicalCon(int index, RecordedExpr expr) {
+    AddEvent(NLEvent::LOGICAL_CON, expr).args[0] = index;
+  }
+
+  typedef TermRecorder<NLEvent::COMMON_EXPR_TERM> LinearExprHandler;
+
+  LinearExprHandler BeginCommonExpr(int index, int num_linear_terms) {
+    return Begin<LinearExprHandler>(
+          NLEvent::BEGIN_COMMON_EXPR, index, num_linear_terms);
+  }
+
+  void EndCommonExpr(LinearExprHandler, RecordedExpr expr, int position) {
+    AddEvent(NLEvent::END_COMMON_EXPR, expr).args[0] = position;
+  }
+
+  void OnComplement(int con_index, int var_index, int flags) {
+    NLEvent &e = AddEvent(NLEvent::COMPLEMENT);
+    e.args[0] = con_index;
+    e.args[1] = var_index;
+    e.args[2] = flags;
+  }
+
+  typedef TermRecorder<NLEvent::OBJ_TERM> LinearObjHandler;
+
+  LinearObjHandler OnLinearObjExpr(int obj_index, int num_linear_terms) {
+    return Begin<LinearObjHandler>(
+          NLEvent::LINEAR_OBJ, obj_index, num_linear_terms);
+  }
+
+  typedef TermRecorder<NLEvent::CON_TERM> LinearConHandler;
+
+  LinearConHandler OnLinearConExpr(int con_index, int num_linear_terms) {
+    return Begin<LinearConHandler>(
+          NLEvent::LINEAR_CON, con_index, num_linear_terms);
+  }
+
+  void OnVarBounds(int index, double lb, double ub) {
+    OnBounds(NLEvent::VAR_BOUNDS, index, lb, ub);
+  }
+
+  void OnConBounds(int index, double lb, double ub) {
+    OnBounds(NLEvent::CON_BOUNDS, index, lb, ub);
+  }
+
+  void OnInitialValue(int var_index, double value) {
+    NLEvent &e = AddEvent(NLEvent::INITIAL_VALUE);
+    e.args[0] = var_index;
+    e.values[0] = value;
+  }
+
+  void OnInitialDualValue(int con_index, double value) {
+    NLEvent &e = AddEvent(NLEvent::INITIAL_DUAL_VALUE);
+    e.args[0] = con_index;
+    e.values[0] = value;
+  }
+
+  class ColumnSizeHandler {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit ColumnSizeHandler(NLEventRecorder &r) : recorder_(&r) {}
+
+    void Add(int size) {
+      recorder_->AddEvent(NLEvent::COLUMN_SIZE).args[0] = size;
+    }
+  };
+
+  ColumnSizeHandler OnColumnSizes() {
+    AddEvent(NLEvent::COLUMN_SIZES);
+    return ColumnSizeHandler(*this);
+  }
+
+  void OnFunction(int index, fmt::StringRef name,
+                  int num_args, func::Type type) {
+    NLEvent &e = AddEvent(NLEvent::FUNCTION, name);
+    e.args[0] = index;
+    e.args[1] = num_args;
+    e.args[2] = type;
+  }
+
+  class IntSuffixHandler {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit IntSuffixHandler(NLEventRecorder &r) : recorder_(&r) {}
+
+    void SetValue(int index, int value) {
+      NLEvent &e = recorder_->AddEvent(NLEvent::INT_SUFFIX_VALUE);
+      e.args[0] = index;
+      e.args[1] = value;
+    }
+  };
+
+  IntSuffixHandler OnIntSuffix(fmt::StringRef name, int kind, int num_values) {
+    NLEvent &e = AddEvent(NLEvent::INT_SUFFIX, name);
+    e.args[0] = kind;
+    e.args[1] = num_values;
+    return IntSuffixHandler(*this);
+  }
+
+  class DblSuffixHandler {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit DblSuffixHandler(NLEventRecorder &r) : recorder_(&r) {}
+
+    void SetValue(int index, double value) {
+      NLEvent &e = recorder_->AddEvent(NLEvent::DBL_SUFFIX_VALUE);
+      e.args[0] = index;
+      e.values[0] = value;
+    }
+  };
+
+  DblSuffixHandler OnDblSuffix(fmt::StringRef name, int kind, int num_values) {
+    NLEvent &e = AddEvent(NLEvent::DBL_SUFFIX, name);
+    e.args[0] = kind;
+    e.args[1] = num_values;
+    return DblSuffixHandler(*this);
+  }
+
+  RecordedExpr OnNumericConstant(double value) {
+    AddEvent(NLEvent::NUMERIC_CONSTANT).values[0] = value;
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  RecordedExpr OnVariableRef(int var_index) {
+    AddEvent(NLEvent::VARIABLE_REF).args[0] = var_index;
+    return MakeExpr(RecordedExpr::REFERENCE);
+  }
+
+  RecordedExpr OnCommonExprRef(int expr_index) {
+    AddEvent(NLEvent::COMMON_EXPR_REF).args[0] = expr_index;
+    return MakeExpr(RecordedExpr::REFERENCE);
+  }
+
+  RecordedExpr OnUnary(expr::Kind kind, RecordedExpr arg) {
+    return OnExpr(RecordedExpr::NUMERIC, NLEvent::UNARY, kind, arg);
+  }
+
+  RecordedExpr OnBinary(expr::Kind kind, RecordedExpr lhs, RecordedExpr rhs) {
+    return OnExpr(RecordedExpr::NUMERIC, NLEvent::BINARY, kind, lhs, rhs);
+  }
+
+  RecordedExpr OnIf(RecordedExpr condition,
+                    RecordedExpr true_expr, RecordedExpr false_expr) {
+    return OnExpr(RecordedExpr::NUMERIC, NLEvent::IF, 0,
+                  condition, true_expr, false_expr);
+  }
+
+  class PLTermHandler {
+   private:
+    NLEventRecorder *recorder_;
+
+   public:
+    explicit PLTermHandler(NLEventRecorder &r) : recorder_(&r) {}
+
+    void AddSlope(double slope) {
+      recorder_->AddEvent(NLEvent::PLTERM_SLOPE).values[0] = slope;
+    }
+
+    void AddBreakpoint(double breakpoint) {
+      recorder_->AddEvent(NLEvent::PLTERM_BREAKPOINT).values[0] = breakpoint;
+    }
+  };
+
+  PLTermHandler BeginPLTerm(int num_breakpoints) {
+    return Begin<PLTermHandler>(NLEvent::BEGIN_PLTERM, num_breakpoints);
+  }
+
+  RecordedExpr EndPLTerm(PLTermHandler, RecordedExpr arg) {
+    AddEvent(NLEvent::END_PLTERM, arg);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  typedef ArgRecorder<NLEvent::CALL_ARG> CallArgHandler;
+
+  CallArgHandler BeginCall(int func_index, int num_args) {
+    return Begin<CallArgHandler>(NLEvent::BEGIN_CALL, func_index, num_args);
+  }
+
+  RecordedExpr EndCall(CallArgHandler) {
+    AddEvent(NLEvent::END_CALL);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  typedef ArgRecorder<NLEvent::VARARG_ARG> VarArgHandler;
+
+  VarArgHandler BeginVarArg(expr::Kind kind, int num_args) {
+    return Begin<VarArgHandler>(NLEvent::BEGIN_VARARG, kind, num_args);
+  }
+
+  RecordedExpr EndVarArg(VarArgHandler) {
+    AddEvent(NLEvent::END_VARARG);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  typedef ArgRecorder<NLEvent::SUM_ARG> NumericArgHandler;
+
+  NumericArgHandler BeginSum(int num_args) {
+    return Begin<NumericArgHandler>(NLEvent::BEGIN_SUM, num_args);
+  }
+
+  RecordedExpr EndSum(NumericArgHandler) {
+    AddEvent(NLEvent::END_SUM);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  typedef ArgRecorder<NLEvent::COUNT_ARG> CountArgHandler;
+
+  CountArgHandler BeginCount(int num_args) {
+    return Begin<CountArgHandler>(NLEvent::BEGIN_COUNT, num_args);
+  }
+
+  RecordedExpr EndCount(CountArgHandler) {
+    AddEvent(NLEvent::END_COUNT);
+    return MakeExpr(RecordedExpr::COUNT);
+  }
+
+  typedef ArgRecorder<NLEvent::NUMBEROF_ARG> NumberOfArgHandler;
+
+  NumberOfArgHandler BeginNumberOf(int num_args, RecordedExpr arg0) {
+    AddEvent(NLEvent::BEGIN_NUMBEROF, arg0).args[0] = num_args;
+    return NumberOfArgHandler(*this);
+  }
+
+  RecordedExpr EndNumberOf(NumberOfArgHandler) {
+    AddEvent(NLEvent::END_NUMBEROF);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  typedef ArgRecorder<NLEvent::SYMBOLIC_NUMBEROF_ARG> SymbolicArgHandler;
+
+  SymbolicArgHandler BeginSymbolicNumberOf(int num_args, RecordedExpr arg0) {
+    AddEvent(NLEvent::BEGIN_SYMBOLIC_NUMBEROF, arg0).args[0] = num_args;
+    return SymbolicArgHandler(*this);
+  }
+
+  RecordedExpr EndSymbolicNumberOf(SymbolicArgHandler) {
+    AddEvent(NLEvent::END_SYMBOLIC_NUMBEROF);
+    return MakeExpr(RecordedExpr::NUMERIC);
+  }
+
+  RecordedExpr OnLogicalConstant(bool value) {
+    AddEvent(NLEvent::LOGICAL_CONSTANT).args[0] = value;
+    return MakeExpr(RecordedExpr::LOGICAL);
+  }
+
+  RecordedExpr OnNot(RecordedExpr arg) {
+    return OnExpr(RecordedExpr::LOGICAL, NLEvent::NOT, 0, arg);
+  }
+
+  RecordedExpr OnBinaryLogical(
+      expr::Kind kind, RecordedExpr lhs, RecordedExpr rhs) {
+    return OnExpr(RecordedExpr::LOGICAL, NLEvent::BINARY_LOGICAL,
+                  kind, lhs, rhs);
+  }
+
+  RecordedExpr OnRelational(
+      expr::Kind kind, RecordedExpr lhs, RecordedExpr rhs) {
+    return OnExpr(RecordedExpr::LOGICAL, NLEvent::RELATIONAL, kind, lhs, rhs);
+  }
+
+  RecordedExpr OnLogicalCount(
+      expr::Kind kind, RecordedExpr lhs, RecordedExpr rhs) {
+    return OnExpr(RecordedExpr::LOGICAL, NLEvent::LOGICAL_COUNT,
+                  kind, lhs, rhs);
+  }
+
+  RecordedExpr OnImplication(RecordedExpr condition, RecordedExpr true_expr,
+                             RecordedExpr false_expr) {
+    return OnExpr(RecordedExpr::LOGICAL, NLEvent::IMPLICATION, 0,
+                  condition, true_expr, false_expr);
+  }
+
+  typedef ArgRecorder<NLEvent::ITERATED_LOGICAL_ARG> LogicalArgHandler;
+
+  LogicalArgHandler BeginIteratedLogical(expr::Kind kind, int num_args) {
+    return Begin<LogicalArgHandler>(
+          NLEvent::BEGIN_ITERATED_LOGICAL, kind, num_args);
+  }
+
+  RecordedExpr EndIteratedLogical(LogicalArgHandler) {
+    AddEvent(NLEvent::END_ITERATED_LOGICAL);
+    return MakeExpr(RecordedExpr::LOGICAL);
+  }
+
+  typedef ArgRecorder<NLEvent::PAIRWISE_ARG> PairwiseArgHandler;
+
+  PairwiseArgHandler BeginPairwise(expr::Kind kind, int num_args) {
+    return Begin<PairwiseArgHandler>(NLEvent::BEGIN_PAIRWISE, kind, num_args);
+  }
+
+  RecordedExpr EndPairwise(PairwiseArgHandler) {
+    AddEvent(NLEvent::END_PAIRWISE);
+    return MakeExpr(RecordedExpr::LOGICAL);
+  }
+
+  RecordedExpr OnStringLiteral(fmt::StringRef value) {
+    AddEvent(NLEvent::STRING_LITERAL, value);
+    return MakeExpr(RecordedExpr::SYMBOLIC);
+  }
+
+  RecordedExpr OnSymbolicIf(RecordedExpr condition, RecordedExpr true_expr,
+                            RecordedExpr false_expr) {
+    return OnExpr(RecordedExpr::SYMBOLIC, NLEvent::SYMBOLIC_IF, 0,
+                  condition, true_expr, false_expr);
+  }
+};
+
+// Runs the reader on the reader thread started by ReadNLPipelined
+// recording notifications into the queue.
+template <typename Reader, typename Handler>
+class NLReaderTask {
+ private:
+  Reader &reader_;
+  std::string filename_;
+  Handler &handler_;
+  NLEventQueue &queue_;
+  int flags_;
+  std::exception_ptr error_;
+  double time_;
+
+ public:
+  NLReaderTask(Reader &reader, fmt::StringRef filename, Handler &h,
+               NLEventQueue &q, int flags)
+    : reader_(reader), filename_(filename.c_str(), filename.size()),
+      handler_(h), queue_(q), flags_(flags), time_(0) {}
+
+  // Returns the exception thrown by the reader or null if none.
+  std::exception_ptr error() const { return error_; }
+
+  // Returns the wall clock time spent reading in seconds.
+  double time() const { return time_; }
+
+  void operator()() {
+    steady_clock::time_point start = steady_clock::now();
+    try {
+      NLEventRecorder<Handler> recorder(handler_, queue_);
+      reader_.Read(filename_, recorder, flags_);
+      recorder.Flush();
+    } catch (const NLPipelineCancelled &) {
+      // Reading has been cancelled by the consumer.
+    } catch (...) {
+      error_ = std::current_exception();
+    }
+    time_ = GetTimeAndReset(start);
+    queue_.Close();
+  }
+};
+
+// Reads an .nl file using reader on a separate thread and passes
+// notifications to handler on the calling thread. Exceptions thrown by
+// the reader or the handler are propagated to the caller.
+template <typename Reader, typename Handler>
+NLPipelineTimes ReadNLPipelined(Reader &reader, fmt::StringRef filename,
+                                Handler &handler, int flags) {
+  NLEventQueue queue;
+  NLReaderTask<Reader, Handler> task(reader, filename, handler, queue, flags);
+  NLPipelineTimes times = NLPipelineTimes();
+  std::thread thread(std::ref(task));
+  try {
+    NLEventReplayer<Handler> replayer(handler);
+    NLEventChunk chunk;
+    while (queue.Pop(chunk)) {
+      steady_clock::time_point start = steady_clock::now();
+      replayer.Replay(chunk);
+      times.build_time += GetTimeAndReset(start);
+    }
+    replayer.Finish();
+  } catch (...) {
+    queue.Cancel();
+    thread.join();
+    throw;
+  }
+  thread.join();
+  if (task.error())
+    std::rethrow_exception(task.error());
+  times.read_time = task.time();
+  return times;
+}
+#endif  // MP_USE_THREAD
+}  // namespace internal
+}  // namespace mp
+
+#endif  // MP_NL_PIPELINE_H_
@@ -43,9 +43,11 @@
 #include "mp/common.h"
 #include "mp/error.h"
 #include "mp/os.h"
+#include "mp/stats.h"
 
 #include <algorithm>
 #include <cctype>
+#include <climits>
 #include <cstdlib>
 #include <limits>
 #include <string>
@@ -63,7 +65,8 @@ enum {
 
 template <typename Handler>
 void ReadNLString(fmt::StringRef str, Handler &handler,
-                  fmt::StringRef name = "(input)", int flags = 0);
+                  fmt::StringRef name = "(input)", int flags = 0,
+                  Stats *stats = 0);
 
 // A read error with location information.
 class ReadError : public Error {
@@ -937,6 +940,38 @@ struct NullLinearExprHandler {
   void AddTerm(int, double) {}
 };
 
+// Accumulates time spent reading each segment type into timers named
+// "segment <type>". Does nothing if stats is null.
+class SegmentTimer {
+ private:
+  Stats *stats_;
+  int timer_;  // Timer of the current segment or -1 if none.
+  steady_clock::time_point start_;
+  int timers_[UCHAR_MAX + 1];  // Timer indices by segment type.
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(SegmentTimer);
+
+  void DoStart(char type);
+
+ public:
+  explicit SegmentTimer(Stats *stats) : stats_(stats), timer_(-1) {
+    if (stats)
+      std::fill(timers_, timers_ + UCHAR_MAX + 1, -1);
+  }
+
+  ~SegmentTimer() {
+    if (stats_)
+      DoStart(0);
+  }
+
+  // Stops timing of the current segment and starts timing the segment
+  // of the specified type. Type 0 only stops timing.
+  void Start(char type) {
+    if (stats_)
+      DoStart(type);
+  }
+};
+
 // An .nl file reader.
 // Handler: a class implementing the ProblemHandler concept that receives
 //          notifications of problem components
@@ -949,6 +984,18 @@ class NLReader {
   int flags_;
   int num_vars_and_exprs_;  // Number of variables and common expressions.
 
+  // Statistics or null if not collected. The counters below are only
+  // updated if statistics are collected.
+  Stats *stats_;
+  fmt::LongLong num_exprs_;
+  fmt::LongLong num_linear_terms_;
+  fmt::LongLong num_suffix_values_;
+
+  void CountExpr() {
+    if (stats_)
+      ++num_exprs_;
+  }
+
   typedef typename Handler::Expr Expr;
   typedef typename Handler::NumericExpr NumericExpr;
   typedef typename Handler::LogicalExpr LogicalExpr;
@@ -1060,6 +1107,20 @@ class NLReader {
       : lhs(ExprReader().Read(r)), rhs(ExprReader().Read(r)) {}
   };
 
+  // A unary or binary expression whose arguments are being read.
+  struct PendingExpr {
+    expr::Kind kind;
+    bool binary;
+    bool has_lhs;
+    NumericExpr lhs;
+  };
+  std::vector<PendingExpr> pending_exprs_;
+
+  // Reads a unary or binary expression of the specified kind. Nested
+  // unary and binary arguments are kept on an explicit stack, so long
+  // chains of such expressions are read without recursion.
+  NumericExpr ReadUnaryOrBinary(expr::Kind kind, bool binary);
+
   // Reads a numeric or string expression.
   Expr ReadSymbolicExpr();
 
@@ -1169,9 +1230,11 @@ class NLReader {
   void ReadSuffix(int kind);
 
  public:
-  NLReader(Reader &reader, const NLHeader &header, Handler &handler, int flags)
+  NLReader(Reader &reader, const NLHeader &header, Handler &handler,
+           int flags, Stats *stats = 0)
     : reader_(reader), header_(header), handler_(handler), flags_(flags),
-      num_vars_and_exprs_(0) {}
+      num_vars_and_exprs_(0), stats_(stats), num_exprs_(0),
+      num_linear_terms_(0), num_suffix_values_(0) {}
 
   // Algebraic constraint handler.
   struct AlgebraicConHandler : ItemHandler<CON> {
@@ -1233,11 +1296,15 @@ typename Handler::Expr NLReader<Reader, Handler>::ReadSymbolicExpr() {
   char c = reader_.ReadChar();
   switch (c) {
   case 'h':
+    CountExpr();
     return handler_.OnStringLiteral(reader_.ReadString());
   case 'o': {
     int opcode = ReadOpCode();
-    if (opcode != expr::opcode(expr::IFSYM))
+    if (opcode != expr::opcode(expr::IFSYM)) {
+      CountExpr();
       return ReadNumericExpr(opcode);
+    }
+    CountExpr();
     // Read symbolic if expression.
     LogicalExpr condition = ReadLogicalExpr();
     Expr true_expr = ReadSymbolicExpr();
@@ -1251,6 +1318,7 @@ typename Handler::Expr NLReader<Reader, Handler>::ReadSymbolicExpr() {
 template <typename Reader, typename Handler>
 typename Handler::NumericExpr
     NLReader<Reader, Handler>::ReadNumericExpr(char code, bool ignore_zero) {
+  CountExpr();
   switch (code) {
   case 'f': {
     // Read a function call.
@@ -1287,11 +1355,9 @@ typename Handler::NumericExpr
   expr::Kind kind = info.kind;
   switch (info.first_kind) {
   case expr::FIRST_UNARY:
-    return handler_.OnUnary(kind, ReadNumericExpr());
-  case expr::FIRST_BINARY: {
-    BinaryArgReader<> args(*this);
-    return handler_.OnBinary(kind, args.lhs, args.rhs);
-  }
+    return ReadUnaryOrBinary(kind, false);
+  case expr::FIRST_BINARY:
+    return ReadUnaryOrBinary(kind, true);
   case expr::IF: {
     LogicalExpr condition = ReadLogicalExpr();
     NumericExpr true_expr = ReadNumericExpr();
@@ -1352,8 +1418,53 @@ typename Handler::NumericExpr
   return NumericExpr();
 }
 
+template <typename Reader, typename Handler>
+typename Handler::NumericExpr
+    NLReader<Reader, Handler>::ReadUnaryOrBinary(expr::Kind kind, bool binary) {
+  std::size_t base = pending_exprs_.size();
+  PendingExpr pending = {kind, binary, false, NumericExpr()};
+  pending_exprs_.push_back(pending);
+  for (;;) {
+    // Read the next argument deferring unary and binary expressions.
+    NumericExpr arg;
+    char c = reader_.ReadChar();
+    if (c == 'o') {
+      CountExpr();
+      int opcode = ReadOpCode();
+      const expr::OpCodeInfo &info = expr::GetOpCodeInfo(opcode);
+      if (info.first_kind == expr::FIRST_UNARY ||
+          info.first_kind == expr::FIRST_BINARY) {
+        PendingExpr next = {
+          info.kind, info.first_kind == expr::FIRST_BINARY, false,
+          NumericExpr()
+        };
+        pending_exprs_.push_back(next);
+        continue;
+      }
+      arg = ReadNumericExpr(opcode);
+    } else {
+      arg = ReadNumericExpr(c, false);
+    }
+    // Pass the expressions that have all their arguments to the handler.
+    for (;;) {
+      PendingExpr &top = pending_exprs_.back();
+      if (top.binary && !top.has_lhs) {
+        top.lhs = arg;
+        top.has_lhs = true;
+        break;
+      }
+      arg = top.binary ? handler_.OnBinary(top.kind, top.lhs, arg) :
+                         handler_.OnUnary(top.kind, arg);
+      pending_exprs_.pop_back();
+      if (pending_exprs_.size() == base)
+        return arg;
+    }
+  }
+}
+
 template <typename Reader, typename Handler>
 typename Handler::LogicalExpr NLReader<Reader, Handler>::ReadLogicalExpr() {
+  CountExpr();
   switch (char c = reader_.ReadChar()) {
   case 'n': case 'l': case 's':
     return handler_.OnLogicalConstant(ReadConstant(c) != 0);
@@ -1435,6 +1546,8 @@ template <typename Reader, typename Handler>
 template <typename LinearHandler>
 void NLReader<Reader, Handler>::ReadLinearExpr(
     int num_terms, LinearHandler linear_expr) {
+  if (stats_)
+    num_linear_terms_ += num_terms;
   for (int i = 0; i < num_terms; ++i) {
     // Variable index should be less than num_vars because common
     // expressions are not allowed in a linear expressions.
@@ -1548,6 +1661,8 @@ void NLReader<Reader, Handler>::ReadSuffix(int kind) {
   int num_values = ReadUInt(1, num_items + 1);
   fmt::StringRef name = reader_.ReadName();
   reader_.ReadTillEndOfLine();
+  if (stats_)
+    num_suffix_values_ += num_values;
   if ((kind & suf::FLOAT) != 0) {
     typename Handler::DblSuffixHandler
         suffix_handler = handler_.OnDblSuffix(name, kind, num_values);
@@ -1569,8 +1684,10 @@ void NLReader<Reader, Handler>::Read(Reader *bound_reader) {
       header_.num_common_exprs_in_objs +
       header_.num_common_exprs_in_single_cons +
       header_.num_common_exprs_in_single_objs;
+  SegmentTimer segment_timer(stats_);
   for (;;) {
     char c = reader_.ReadChar();
+    segment_timer.Start(c);
     switch (c) {
     case 'C': {
       // Nonlinear part of an algebraic constraint body.
@@ -1717,6 +1834,11 @@ void NLReader<Reader, Handler>::Read() {
   } else {
     Read(0);
   }
+  if (stats_) {
+    stats_->Add("expressions", num_exprs_);
+    stats_->Add("linear terms", num_linear_terms_);
+    stats_->Add("suffix values", num_suffix_values_);
+  }
 }
 
 // An .nl file reader.
@@ -1726,6 +1848,7 @@ class NLFileReader {
   File file_;
   std::size_t size_;
   std::size_t rounded_size_;  // Size rounded up to a multiple of page size.
+  Stats *stats_;
 
   void Open(fmt::StringRef filename);
 
@@ -1733,10 +1856,18 @@ class NLFileReader {
   void Read(fmt::internal::MemoryBuffer<char, 1> &array);
 
  public:
-  NLFileReader() : size_(0), rounded_size_(0) {}
+  NLFileReader() : size_(0), rounded_size_(0), stats_(0) {}
+
+  // Constructs a reader with the configuration of other. The file is not
+  // shared, so the copy can be used in another thread.
+  NLFileReader(const NLFileReader &other)
+    : size_(0), rounded_size_(0), stats_(other.stats_) {}
 
   File &file() { return file_; }
 
+  // Sets the object to collect reader statistics or null to not collect them.
+  void set_stats(Stats *stats) { stats_ = stats; }
+
   // Opens and reads the file.
   template <typename Handler>
   void Read(fmt::StringRef filename, Handler &handler, int flags) {
@@ -1746,12 +1877,12 @@ class NLFileReader {
       // and therefore the mmap'ed buffer won't be zero terminated.
       fmt::internal::MemoryBuffer<char, 1> array;
       Read(array);
-      return ReadNLString(
-            fmt::StringRef(&array[0], size_), handler, filename, flags);
+      return ReadNLString(fmt::StringRef(&array[0], size_),
+                          handler, filename, flags, stats_);
     }
     MemoryMappedFile<File> mapped_file(file_, rounded_size_);
-    ReadNLString(
-          fmt::StringRef(mapped_file.start(), size_), handler, filename, flags);
+    ReadNLString(fmt::StringRef(mapped_file.start(), size_),
+                 handler, filename, flags, stats_);
   }
 };
 
@@ -1784,10 +1915,10 @@ void NLFileReader<File>::Read(fmt::internal::MemoryBuffer<char, 1> &array) {
 
 template <typename InputConverter, typename Handler>
 void ReadBinary(TextReader &reader, const NLHeader &header,
-                Handler &handler, int flags) {
+                Handler &handler, int flags, Stats *stats = 0) {
   BinaryReader<InputConverter> bin_reader(reader);
   NLReader<BinaryReader<InputConverter>, Handler>(
-        bin_reader, header, handler, flags).Read();
+        bin_reader, header, handler, flags, stats).Read();
 }
 }  // namespace internal
 
@@ -1795,29 +1926,37 @@ void ReadBinary(TextReader &reader, const NLHeader &header,
   Reads an optimization problem in the nl format from the string *str*
   and sends notifications of the problem components to the *handler* object.
   The *name* argument is used as the name of the input when reporting errors.
+  If *stats* is not null, reader timings and counters are added to it.
  */
 template <typename Handler>
 void ReadNLString(fmt::StringRef str, Handler &handler,
-                  fmt::StringRef name, int flags) {
+                  fmt::StringRef name, int flags, Stats *stats) {
+  if (stats)
+    stats->Add("bytes read", static_cast<fmt::LongLong>(str.size()));
   internal::TextReader reader(str, name);
   NLHeader header = NLHeader();
-  reader.ReadHeader(header);
-  handler.OnHeader(header);
+  {
+    ScopedTimer timer(stats, "header");
+    reader.ReadHeader(header);
+    handler.OnHeader(header);
+  }
   switch (header.format) {
   case NLHeader::TEXT:
     internal::NLReader<internal::TextReader, Handler>(
-          reader, header, handler, flags).Read();
+          reader, header, handler, flags, stats).Read();
     break;
   case NLHeader::BINARY: {
       using internal::ReadBinary;
     arith::Kind arith_kind = arith::GetKind();
     if (arith_kind == header.arith_kind) {
-      ReadBinary<internal::IdentityConverter>(reader, header, handler, flags);
+      ReadBinary<internal::IdentityConverter>(
+            reader, header, handler, flags, stats);
       break;
     }
     if (!IsIEEE(arith_kind) || !IsIEEE(header.arith_kind))
       throw ReadError(name, 0, 0, "unsupported floating-point arithmetic");
-    ReadBinary<internal::EndiannessConverter>(reader, header, handler, flags);
+    ReadBinary<internal::EndiannessConverter>(
+          reader, header, handler, flags, stats);
     break;
   }
   }
@@ -0,0 +1,113 @@
+/*
+ Multithreaded evaluation of constraints and the constraint Jacobian
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_PARALLEL_EVAL_H_
+#define MP_PARALLEL_EVAL_H_
+
+#include <vector>
+
+#include "mp/jacobian.h"
+#include "mp/thread-pool.h"
+
+namespace mp {
+
+// Evaluates constraints and the constraint Jacobian of a tape on a thread
+// pool. The tape and the sparsity pattern are shared by all threads while
+// register values and adjoints are kept in per-thread workspaces, so that
+// disjoint ranges of constraints are evaluated concurrently.
+//
+// Constraints are split on construction into chunks of consecutive
+// constraints with roughly equal amounts of work. A chunk is evaluated by
+// executing only the instructions its constraints depend on, so
+// instructions shared by several chunks such as common expressions are
+// executed once per chunk. Evaluation doesn't allocate memory.
+//
+// Only problems compiled into a Tape (see mp/tape.h) are evaluated in
+// parallel. ASL-based solvers evaluate through con2val, jac2val and
+// pshv_prod which keep their state in the ASL structure and in globals such
+// as cur_ASL, so they are not reentrant and remain serial.
+class ParallelEvaluator {
+ public:
+  // Number of chunks per thread. Several chunks per thread balance the
+  // load when chunks take different time to evaluate.
+  enum {CHUNKS_PER_THREAD = 4};
+
+ private:
+  ThreadPool &pool_;
+  JacobianEvaluator jac_;
+
+  // Chunk i consists of constraints [chunk_starts_[i], chunk_starts_[i + 1])
+  // and depends on instructions instrs_[instr_starts_[i]:instr_starts_[i + 1]]
+  // given in increasing order.
+  std::vector<int> chunk_starts_;
+  std::vector<int> instr_starts_;
+  std::vector<int> instrs_;
+
+  // Evaluation state of a thread.
+  struct Workspace {
+    std::vector<double> registers;
+    std::vector<double> adjoints;
+  };
+  std::vector<Workspace> workspaces_;
+
+  class ChunkTask;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ParallelEvaluator);
+
+  // Splits constraints into chunks and finds their dependencies.
+  void Split(int num_chunks);
+
+  // Evaluates constraints of a chunk at the point x using the workspace
+  // of the specified thread. Constraint values and Jacobian rows are
+  // stored in con_values and jac_values unless they are null.
+  void EvaluateChunk(int chunk, int thread_index, const double *x,
+                     double *con_values, double *jac_values);
+
+ public:
+  ParallelEvaluator(const Tape &tape, ThreadPool &pool);
+
+  const Tape &tape() const { return jac_.tape(); }
+
+  // Returns the Jacobian evaluator which defines the layout of values
+  // computed by GetJacobian (see JacobianEvaluator::jac_vars and
+  // JacobianEvaluator::jac_start).
+  const JacobianEvaluator &jacobian() const { return jac_; }
+
+  int num_chunks() const {
+    return static_cast<int>(chunk_starts_.size()) - 1;
+  }
+
+  // Returns the first constraint of the chunk. chunk_start(num_chunks())
+  // is the number of constraints.
+  int chunk_start(int chunk) const { return chunk_starts_[chunk]; }
+
+  // Computes values of all algebraic constraints at the point x.
+  void GetConValues(const double *x, double *values);
+
+  // Computes the constraint Jacobian at the point x. The values are stored
+  // in the same order as by JacobianEvaluator::GetJacobian. If con_values
+  // is not null, the constraint values are also stored there.
+  void GetJacobian(const double *x, double *values, double *con_values = 0);
+};
+}  // namespace mp
+
+#endif  // MP_PARALLEL_EVAL_H_
@@ -0,0 +1,168 @@
+/*
+ Presolve and postsolve of optimization problems
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_PRESOLVE_H_
+#define MP_PRESOLVE_H_
+
+#include <vector>
+
+#include "mp/problem.h"
+
+namespace mp {
+
+// Presolves a problem by removing fixed variables, turning constraints
+// with a single linear term into bounds on variables, dropping constraints
+// without variables and folding constant subexpressions.
+//
+// The reduced problem is built as a separate Problem. Each reduction is
+// pushed on a postsolve stack which is unwound in Postsolve to map a
+// solution of the reduced problem back to the original one. Suffixes are
+// copied to the reduced problem without the values of removed variables
+// and constraints, and suffixes of the reduced problem are mapped back
+// with PostsolveSuffixes. Problems with complementarity conditions are
+// not supported.
+class Presolver {
+ public:
+  // A reduction recorded on the postsolve stack.
+  struct Reduction {
+    enum Kind {
+      // Variable var is fixed at value and removed.
+      FIX_VAR,
+      // Constraint con with the single linear term value * var is
+      // replaced by bounds on var.
+      SINGLETON_CON,
+      // Constraint con without variables is dropped.
+      DROP_CON
+    };
+    Kind kind;
+    int var;
+    int con;
+    double value;
+
+    Reduction(Kind kind, int var, int con, double value)
+      : kind(kind), var(var), con(con), value(value) {}
+  };
+
+  // Relative tolerance used when comparing bounds.
+  static const double TOLERANCE;
+
+ private:
+  const Problem &original_;
+  Problem problem_;
+  std::vector<Reduction> stack_;
+
+  // Bounds on variables of the original problem after presolve.
+  std::vector<double> var_lbs_;
+  std::vector<double> var_ubs_;
+
+  // Indices of variables and algebraic constraints of the original
+  // problem in the reduced problem or -1 if removed.
+  std::vector<int> var_map_;
+  std::vector<int> con_map_;
+
+  // Singleton constraints that define the lower and upper bounds on
+  // each variable or -1 if the bound is original.
+  std::vector<int> lb_cons_;
+  std::vector<int> ub_cons_;
+
+  // nonlinear_vars_[i] is true if variable i appears in a nonlinear
+  // expression in which case duals of singleton constraints on it are
+  // not recovered.
+  std::vector<bool> nonlinear_vars_;
+
+  // Objective coefficients and columns of the linear constraint matrix
+  // for variables bounded by singleton constraints: column i has
+  // coefficients col_coefs_[col_starts_[i]:col_starts_[i + 1]] in
+  // constraints col_cons_[col_starts_[i]:col_starts_[i + 1]].
+  std::vector<double> obj_coefs_;
+  std::vector<int> col_starts_;
+  std::vector<int> col_cons_;
+  std::vector<double> col_coefs_;
+
+  int num_dropped_logical_cons_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(Presolver);
+
+  // Removes fixed variables and singleton constraints updating bounds
+  // on variables.
+  void Reduce();
+
+  // Builds the reduced problem.
+  void Build();
+
+  // Builds columns of the linear constraint matrix needed to recover
+  // duals of singleton constraints.
+  void BuildColumns();
+
+  // Returns the map of items of the specified suffix kind from the
+  // original problem to the reduced one or null if the items are the same.
+  const std::vector<int> *GetItemMap(int kind) const;
+
+  // Copies suffixes of the original problem to the reduced one.
+  void CopySuffixes();
+
+ public:
+  explicit Presolver(const Problem &p);
+
+  const Problem &original() const { return original_; }
+
+  // Returns the reduced problem.
+  Problem &problem() { return problem_; }
+
+  // Returns the postsolve stack with the last reduction at the end.
+  const std::vector<Reduction> &reductions() const { return stack_; }
+
+  // Returns the index of a variable of the original problem in the
+  // reduced problem or -1 if the variable has been removed.
+  int var_index(int var) const { return var_map_[var]; }
+
+  // Returns the index of an algebraic constraint of the original problem
+  // in the reduced problem or -1 if the constraint has been removed.
+  int con_index(int con) const { return con_map_[con]; }
+
+  int num_removed_vars() const {
+    return original_.num_vars() - problem_.num_vars();
+  }
+
+  int num_removed_cons() const {
+    return original_.num_algebraic_cons() - problem_.num_algebraic_cons() +
+        num_dropped_logical_cons_;
+  }
+
+  // Maps a solution of the reduced problem to the original problem.
+  // values or dual_values may be null in which case the corresponding
+  // output vector is cleared. Duals of removed constraints are recovered
+  // from reduced costs when the bound they imply is active and the
+  // variable only appears linearly and are zero otherwise.
+  void Postsolve(const double *values, const double *dual_values,
+                 std::vector<double> &orig_values,
+                 std::vector<double> &orig_dual_values) const;
+
+  // Maps integer and floating-point suffixes of the reduced problem to
+  // the original problem p adding those that p doesn't have. Values of
+  // removed variables and constraints are left unchanged or are zero if
+  // the suffix has been added.
+  void PostsolveSuffixes(Problem &p);
+};
+}  // namespace mp
+
+#endif  // MP_PRESOLVE_H_
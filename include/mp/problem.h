@@ -160,6 +160,13 @@ class BasicProblem : public ExprFactory, public SuffixManager {
     nonlinear_objs_[obj_index] = expr;
   }
 
+  void SetNonlinearConExpr(int con_index, NumericExpr expr) {
+    CheckIndex(con_index, algebraic_cons_.size());
+    if (nonlinear_cons_.size() <= static_cast<std::size_t>(con_index))
+      nonlinear_cons_.resize(con_index + 1);
+    nonlinear_cons_[con_index] = expr;
+  }
+
   // A list of problem elements.
   template <typename T>
   class List {
@@ -243,7 +250,8 @@ class BasicProblem : public ExprFactory, public SuffixManager {
     int type = kind & suf::MASK;
     SuffixSet::Set &set = suffixes(type).set_;
     Suffix &suffix = const_cast<Suffix&>(*set.insert(Suffix(name, kind)).first);
-    suffix.InitValues(GetSuffixSize(type));
+    bool dbl = !std::numeric_limits<T>::is_integer;
+    suffix.InitValues(GetSuffixSize(type), dbl);
     return SuffixHandler<T>(&suffix);
   }
 
@@ -311,6 +319,7 @@ class BasicProblem : public ExprFactory, public SuffixManager {
   class BasicAlgebraicCon : private Item {
    private:
     friend class BasicProblem;
+    friend class MutAlgebraicCon;
 
     BasicAlgebraicCon(typename Item::Problem *p, int index) : Item(p, index) {}
 
@@ -537,7 +546,7 @@ class BasicProblem : public ExprFactory, public SuffixManager {
 
     // Returns the linear part of the constraint expression.
     LinearExpr &linear_expr() const {
-      return this->problem_->linear_cons_[this->index_];
+      return this->problem_->algebraic_cons_[this->index_].linear_expr;
     }
 
     // Sets the nonlinear part of the constraint expression.
@@ -628,6 +637,83 @@ class BasicProblem : public ExprFactory, public SuffixManager {
     logical_cons_.push_back(expr);
   }
 
+  // Returns the number of common expressions.
+  int num_common_exprs() const {
+    return static_cast<int>(linear_exprs_.size());
+  }
+
+  // A common expression (defined variable).
+  class CommonExpr : private ProblemItem {
+   private:
+    friend class BasicProblem;
+
+    CommonExpr(const BasicProblem *p, int index) : ProblemItem(p, index) {}
+
+    static int num_items(const BasicProblem &p) {
+      return p.num_common_exprs();
+    }
+
+   public:
+    // Returns the linear part of the common expression.
+    const LinearExpr &linear_expr() const {
+      return this->problem_->linear_exprs_[this->index_];
+    }
+
+    // Returns the nonlinear part of the common expression.
+    NumericExpr nonlinear_expr() const {
+      return this->problem_->nonlinear_exprs_[this->index_];
+    }
+
+    bool operator==(CommonExpr other) const {
+      MP_ASSERT(this->problem_ == other.problem_,
+                "comparing common expressions from different problems");
+      return this->index_ == other.index_;
+    }
+    bool operator!=(CommonExpr other) const {
+      return !(*this == other);
+    }
+  };
+
+  // Returns the common expression at the specified index.
+  CommonExpr common_expr(int index) const {
+    CheckIndex(index, num_common_exprs());
+    return CommonExpr(this, index);
+  }
+
+  // A mutable common expression.
+  class MutCommonExpr : private MutProblemItem {
+   private:
+    friend class BasicProblem;
+
+    MutCommonExpr(BasicProblem *p, int index) : MutProblemItem(p, index) {}
+
+   public:
+    operator CommonExpr() const {
+      return CommonExpr(this->problem_, this->index_);
+    }
+
+    // Returns the linear part of the common expression.
+    LinearExpr &linear_expr() const {
+      return this->problem_->linear_exprs_[this->index_];
+    }
+
+    // Returns the nonlinear part of the common expression.
+    NumericExpr nonlinear_expr() const {
+      return this->problem_->nonlinear_exprs_[this->index_];
+    }
+
+    // Sets the nonlinear part of the common expression.
+    void set_nonlinear_expr(NumericExpr expr) const {
+      this->problem_->nonlinear_exprs_[this->index_] = expr;
+    }
+  };
+
+  // Returns the mutable common expression at the specified index.
+  MutCommonExpr common_expr(int index) {
+    CheckIndex(index, num_common_exprs());
+    return MutCommonExpr(this, index);
+  }
+
   // Begins building a common expression (defined variable).
   // Returns a builder for the linear part of a common expression.
   LinearExprBuilder BeginCommonExpr(int num_linear_terms) {
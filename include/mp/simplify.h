@@ -0,0 +1,45 @@
+/*
+ Algebraic simplification of problem expressions
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_SIMPLIFY_H_
+#define MP_SIMPLIFY_H_
+
+#include "mp/problem.h"
+
+namespace mp {
+
+// Simplifies nonlinear parts of objectives, algebraic constraints and
+// common expressions of a problem in place. Constant subexpressions
+// are folded, identities such as x * 1, x + 0 and x ^ 1 are removed,
+// nested sums and differences are flattened into a single sum and
+// x ^ 2 is replaced with POW2. Linear terms of the top-level sum are
+// moved to the linear part and the constant term of a constraint to
+// its bounds.
+//
+// Variables and constraints keep their indices, so a solution of the
+// simplified problem is a solution of the original one. Logical
+// constraints are not changed. Replaced expressions remain allocated
+// until the problem is destroyed.
+void Simplify(Problem &p);
+}  // namespace mp
+
+#endif  // MP_SIMPLIFY_H_
@@ -38,6 +38,27 @@ namespace mp {
 namespace internal {
 
 void WriteMessage(fmt::BufferedFile &file, const char *message);
+void WriteMessage(fmt::Writer &w, const char *message);
+
+// A .sol "file" that writes to memory.
+class MemorySolFile {
+ private:
+  fmt::Writer &writer_;
+
+ public:
+  explicit MemorySolFile(fmt::Writer &w) : writer_(w) {}
+
+  fmt::Writer &writer() { return writer_; }
+
+  void print(fmt::StringRef format_str, const fmt::ArgList &args) {
+    writer_.write(format_str, args);
+  }
+  FMT_VARIADIC(void, print, fmt::StringRef)
+};
+
+inline void WriteMessage(MemorySolFile &file, const char *message) {
+  WriteMessage(file.writer(), message);
+}
 
 // Suffix value visitor that counts values.
 class SuffixValueCounter {
@@ -54,19 +75,20 @@ class SuffixValueCounter {
 };
 
 // Suffix value visitor that writes values to a file.
+template <typename File>
 class SuffixValueWriter {
  private:
-  fmt::BufferedFile &file_;
+  File &file_;
 
  public:
-  explicit SuffixValueWriter(fmt::BufferedFile &file) : file_(file) {}
+  explicit SuffixValueWriter(File &file) : file_(file) {}
 
   template <typename T>
   void Visit(int index, T value) { file_.print("{} {}\n", index, value); }
 };
 
-template <typename SuffixMap>
-void WriteSuffixes(fmt::BufferedFile &file, const SuffixMap *suffixes) {
+template <typename File, typename SuffixMap>
+void WriteSuffixes(File &file, const SuffixMap *suffixes) {
   if (!suffixes)
     return;
   for (typename SuffixMap::iterator
@@ -83,17 +105,16 @@ void WriteSuffixes(fmt::BufferedFile &file, const SuffixMap *suffixes) {
                i->kind() & (suf::MASK | suf::FLOAT | suf::IODECL),
                num_values, std::strlen(name) + 1, 0, 0, name);
     // TODO: write table
-    SuffixValueWriter writer(file);
+    SuffixValueWriter<File> writer(file);
     i->VisitValues(writer);
   }
 }
-}  // namespace internal
 
-// Writes a solution to a .sol file.
-template <typename Solution>
-void WriteSolFile(fmt::StringRef filename, const Solution &sol) {
-  fmt::BufferedFile file(filename, "w");
-  internal::WriteMessage(file, sol.message());
+// Writes a solution in the .sol format to a file which is either
+// fmt::BufferedFile or MemorySolFile.
+template <typename File, typename Solution>
+void WriteSol(File &file, const Solution &sol) {
+  WriteMessage(file, sol.message());
   // Write options.
   file.print("Options\n");
   if (int num_options = sol.num_options()) {
@@ -110,9 +131,17 @@ void WriteSolFile(fmt::StringRef filename, const Solution &sol) {
     file.print("{}\n", sol.dual_value(i));
   file.print("objno 0 {}\n", sol.status());
   for (int suf_kind = 0; suf_kind < suf::NUM_KINDS; ++suf_kind)
-    internal::WriteSuffixes(file, sol.suffixes(suf_kind));
+    WriteSuffixes(file, sol.suffixes(suf_kind));
   // TODO: test
 }
+}  // namespace internal
+
+// Writes a solution to a .sol file.
+template <typename Solution>
+void WriteSolFile(fmt::StringRef filename, const Solution &sol) {
+  fmt::BufferedFile file(filename, "w");
+  internal::WriteSol(file, sol);
+}
 }  // namepace mp
 
 #endif  // MP_SOL_H_
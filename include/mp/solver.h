@@ -29,26 +29,40 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+#include <deque>
 #include <limits>
 #include <memory>
 #include <set>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #if MP_USE_ATOMIC
 # include <atomic>
 #endif
 
+#ifdef MP_USE_THREAD
+# include <condition_variable>
+# include <mutex>
+#endif
+
 #include "mp/arrayref.h"
 #include "mp/clock.h"
 #include "mp/error.h"
+#include "mp/expr-stats.h"
 #include "mp/format.h"
 #include "mp/nl.h"
+#include "mp/nl-pipeline.h"
+#include "mp/stats.h"
 #include "mp/option.h"
 #include "mp/os.h"
+#include "mp/presolve.h"
+#include "mp/simplify.h"
 #include "mp/problem-builder.h"
 #include "mp/sol.h"
 #include "mp/suffix.h"
+#include "mp/thread-pool.h"
 
 namespace mp {
 
@@ -174,6 +188,18 @@ class SolutionHandler {
       const double *values, const double *dual_values, double obj_value) = 0;
 };
 
+// An interface for receiving values of suffixes of a solved problem.
+class SuffixValueHandler {
+ public:
+  virtual ~SuffixValueHandler() {}
+
+  // Receives a nonzero value of the suffix of the specified kind
+  // (suf::VAR, suf::CON, suf::OBJ or suf::PROBLEM possibly combined with
+  // suf::FLOAT) for the item with the specified index.
+  virtual void HandleSuffixValue(
+      int kind, fmt::StringRef name, int index, double value) = 0;
+};
+
 class BasicSolutionHandler : public SolutionHandler {
  public:
   virtual void HandleFeasibleSolution(fmt::StringRef,
@@ -382,6 +408,10 @@ class Solver : private ErrorHandler,
   // The filename stub for returning multiple solutions.
   std::string solution_stub_;
 
+  // Name of the file to write timings and counters to.
+  std::string stats_file_;
+  Stats stats_;
+
   // Specifies whether to return the number of solutions in the .nsol suffix.
   bool count_solutions_;
 
@@ -396,7 +426,13 @@ class Solver : private ErrorHandler,
   OptionSet options_;
 
   bool timing_;
+  bool pipeline_;
+  bool simplify_;
+  bool presolve_;
+  bool expr_stats_;
+  ExprProfile expr_profile_;
   bool multiobj_;
+  bool thread_safe_;
 
   bool has_errors_;
   OutputHandler *output_handler_;
@@ -417,6 +453,11 @@ class Solver : private ErrorHandler,
     solution_stub_ = value.c_str();
   }
 
+  std::string GetStatsFile(const SolverOption &) const { return stats_file_; }
+  void SetStatsFile(const SolverOption &, fmt::StringRef value) {
+    stats_file_ = value.c_str();
+  }
+
  public:
   class SuffixInfo {
    private:
@@ -551,7 +592,19 @@ class Solver : private ErrorHandler,
     MULTIPLE_SOL = 1,
 
     // Multiple objectives support.
-    MULTIPLE_OBJ = 2
+    MULTIPLE_OBJ = 2,
+
+    // Presolve support.
+    // Makes Solver register the "presolve" option. SolverImpl sets it
+    // for solvers that build the problem as mp::Problem since presolve
+    // is only done for such problems.
+    PRESOLVE = 4,
+
+    // The solver can't solve problems in several threads at once even
+    // with separate Solver objects, for example, because it uses
+    // the global state of the ASL. Makes SolverApp reject more than one
+    // worker in server and batch modes. ASLSolver sets it.
+    NOT_THREAD_SAFE = 8
   };
 
  protected:
@@ -560,6 +613,8 @@ class Solver : private ErrorHandler,
   // flags: Bitwise OR of zero or more of the following values
   //          MULTIPLE_SOL
   //          MULTIPLE_OBJ
+  //          PRESOLVE
+  //          NOT_THREAD_SAFE
   Solver(fmt::StringRef name, fmt::StringRef long_name, long date, int flags);
 
   void set_long_name(fmt::StringRef name) { long_name_ = name; }
@@ -756,6 +811,43 @@ class Solver : private ErrorHandler,
   // Returns true if the timing is enabled.
   bool timing() const { return timing_; }
 
+  // Returns true if several Solver objects of this type can solve
+  // problems concurrently.
+  bool thread_safe() const { return thread_safe_; }
+
+  // Returns true if reading of the .nl file should be overlapped with
+  // problem construction.
+  bool pipeline() const { return pipeline_; }
+
+  // Returns true if expressions of problems represented as mp::Problem
+  // should be simplified before solving.
+  bool simplify() const { return simplify_; }
+
+  // Returns true if problems represented as mp::Problem should be
+  // presolved before solving.
+  bool presolve() const { return presolve_; }
+
+  // Returns true if statistics of expression trees should be reported.
+  bool expr_stats() const { return expr_stats_; }
+
+  // Returns the profile recording the time of converting expressions by
+  // kind or null if expression statistics are not reported.
+  ExprProfile *expr_profile() { return expr_stats_ ? &expr_profile_ : 0; }
+
+  // Prints expression statistics and adds them to stats if collected.
+  void ReportExprStats(const ExprStats &es);
+
+  // Prints the expression conversion profile and adds it to stats if
+  // collected. Does nothing if the profile is empty.
+  void ReportExprProfile();
+
+  // Returns the object collecting timings and counters or null if
+  // statistics are not collected.
+  Stats *stats() { return stats_file_.empty() ? 0 : &stats_; }
+
+  // Returns the name of the file to write statistics to.
+  const std::string &stats_file() const { return stats_file_; }
+
   // Returns true if multiobjective optimization is enabled.
   bool multiobj() const { return multiobj_; }
 
@@ -879,6 +971,15 @@ class Solver : private ErrorHandler,
 
   const SuffixList &suffixes() const { return suffixes_; }
 
+  // Reads a problem in the .nl format from memory and solves it passing
+  // solutions to sh. If suffix_handler is non-null, nonzero values of the
+  // problem suffixes are passed to it after solving. This allows solving
+  // problems without writing .nl and .sol files. The default
+  // implementation throws Error; solvers implement it with
+  // SolverImpl::DoSolveNL.
+  virtual void SolveNL(fmt::StringRef nl, SolutionHandler &sh,
+                       SuffixValueHandler *suffix_handler = 0);
+
   // Reports an error printing the formatted error message to stderr.
   // Usage: ReportError("File not found: {}") << filename;
   void ReportError(fmt::StringRef format, const fmt::ArgList &args) {
@@ -913,13 +1014,34 @@ class Solver : private ErrorHandler,
 
 template <typename ProblemBuilderT>
 class SolverImpl : public Solver {
+ private:
+  // Returns the flags of features supported for the problem builder.
+  template <typename Builder>
+  static int GetBuilderFlags(Builder *) { return 0; }
+  static int GetBuilderFlags(Problem *) { return PRESOLVE; }
+
  public:
   typedef ProblemBuilderT ProblemBuilder;
   typedef ProblemBuilderToNLAdapter<ProblemBuilder> NLProblemBuilder;
 
   SolverImpl(fmt::StringRef name, fmt::StringRef long_name = 0,
              long date = 0, int flags = 0)
-    : Solver(name, long_name, date, flags) {}
+    : Solver(name, long_name, date,
+             flags | GetBuilderFlags(static_cast<ProblemBuilder*>(0))) {}
+
+ protected:
+  // Reads a problem in the .nl format from memory into builder and solves
+  // it with solver s passing solutions to sh. SolverT is the solver class
+  // derived from SolverImpl.
+  // Usage:
+  //   void MySolver::SolveNL(fmt::StringRef nl, SolutionHandler &sh,
+  //                          SuffixValueHandler *) {
+  //     ProblemBuilder builder(GetProblemBuilder("(input)"));
+  //     DoSolveNL(*this, builder, nl, sh);
+  //   }
+  template <typename SolverT>
+  void DoSolveNL(SolverT &s, ProblemBuilder &builder,
+                 fmt::StringRef nl, SolutionHandler &sh);
 };
 
 // Adapts a solution for WriteSol.
@@ -975,6 +1097,36 @@ class SolFileWriter {
   }
 };
 
+// A .sol writer that keeps the solution written to the file with the
+// name set by set_filename in memory. Other files such as the ones
+// requested by the solutionstub option are written to disk.
+class MemorySolWriter {
+ private:
+  std::string filename_;
+  fmt::MemoryWriter sol_;
+
+ public:
+  void set_filename(fmt::StringRef filename) {
+    filename_.assign(filename.c_str(), filename.size());
+  }
+
+  // Returns the content of the .sol file.
+  fmt::StringRef sol() const {
+    return fmt::StringRef(sol_.c_str(), sol_.size());
+  }
+
+  template <typename Solution>
+  void Write(fmt::StringRef filename, const Solution &sol) {
+    if (filename_ != std::string(filename)) {
+      WriteSolFile(filename, sol);
+      return;
+    }
+    sol_.clear();
+    internal::MemorySolFile file(sol_);
+    internal::WriteSol(file, sol);
+  }
+};
+
 // A solution writer.
 // Solver: optimization solver class
 // Writer: .sol writer
@@ -1046,6 +1198,7 @@ void SolutionWriter<Solver, Writer>::HandleSolution(
         MakeArrayRef(values, values ? builder_.num_vars() : 0),
         MakeArrayRef(dual_values,
                      dual_values ? builder_.num_algebraic_cons() : 0));
+  ScopedTimer timer(solver_.stats(), "solution write");
   this->Write(stub_ + ".sol", sol);
 }
 
@@ -1062,6 +1215,20 @@ class SolverAppOptionParser {
 
   bool echo_solver_options_;
 
+  // The socket path in server mode or empty if not in server mode.
+  std::string server_path_;
+
+  // The stub list file or directory in batch mode or empty if not in
+  // batch mode.
+  std::string batch_path_;
+
+  int num_workers_;
+
+  // Parses the -server, -batch and -workers options which, unlike other
+  // command-line options, have arguments. Returns true if an option
+  // has been parsed.
+  bool ParseArgOption(char **&argv);
+
   // Prints usage information and stops processing options.
   bool ShowUsage();
 
@@ -1089,7 +1256,21 @@ class SolverAppOptionParser {
   // Retruns true if assignments of solver options should be echoed.
   bool echo_solver_options() const { return echo_solver_options_; }
 
-  // Parses command-line options.
+  // Returns true if the application should run as a server.
+  bool server() const { return !server_path_.empty(); }
+
+  // Returns true if the application should solve a batch of problems.
+  bool batch() const { return !batch_path_.empty(); }
+
+  // Returns the number of requests a server processes or problems of
+  // a batch solved concurrently or 0 if not specified. By default a server
+  // processes requests one at a time and a batch is solved on all hardware
+  // threads unless the solver is not thread safe.
+  int num_workers() const { return num_workers_; }
+
+  // Parses command-line options. Returns the stub or, in server and
+  // batch modes, the socket path and the stub list file or directory
+  // respectively or a null pointer if processing should stop.
   const char *Parse(char **&argv);
 };
 
@@ -1158,6 +1339,112 @@ class SignalHandler : public Interrupter {
   void SetHandler(InterruptHandler handler, void *data);
 };
 
+#ifndef _WIN32
+// A request to a solver server.
+struct ServerRequest {
+  enum Kind {
+    SOLVE,  // Solve a problem from the .nl file of the stub in data.
+    NL,     // Solve a problem from the .nl content in data.
+    QUIT    // Stop the server.
+  };
+  Kind kind;
+  std::string data;
+};
+
+// A listening Unix domain socket of a solver server.
+// Clients send requests in the form
+//   solve <stub>\n
+//   nl <size>\n<size bytes of .nl content>
+//   quit\n
+// over a connection and the server replies with
+//   done\n
+//   sol <size>\n<size bytes of .sol content>
+//   error <message>\n
+// respectively. The solution of a solve request is written to the
+// .sol file of the stub as in a normal solver run while the solution of
+// an nl request is sent back. Several requests can be sent over one
+// connection.
+class ServerSocket {
+ private:
+  int fd_;
+  std::string path_;
+  atomic<bool> stop_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ServerSocket);
+
+ public:
+  // Creates a socket listening at the specified path replacing
+  // an existing socket file if any.
+  explicit ServerSocket(fmt::StringRef path);
+  ~ServerSocket();
+
+  // Waits for a connection and returns its descriptor or -1 if the
+  // server has been stopped.
+  int Accept();
+
+  // Stops the server making the current and subsequent calls to Accept
+  // return -1.
+  void Stop();
+};
+
+// A connection of a client to a solver server.
+class ServerConnection {
+ private:
+  int fd_;
+  std::vector<char> buffer_;
+  std::size_t pos_;
+
+  // Reads more data into the buffer. Returns false on end of input.
+  bool Fill();
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ServerConnection);
+
+ public:
+  // Limits on the length of a request line and the size of an .nl
+  // payload so that a client can't make the server allocate unbounded
+  // memory.
+  enum {MAX_LINE_SIZE = 4096, MAX_NL_SIZE = 1 << 30};
+
+  // Constructs a connection object taking the ownership of fd.
+  explicit ServerConnection(int fd) : fd_(fd), pos_(0) {}
+  ~ServerConnection();
+
+  // Reads the next request. Returns false if there are no more requests.
+  // Throws Error if the request exceeds one of the limits.
+  bool ReadRequest(ServerRequest &request);
+
+  void Write(fmt::StringRef data);
+
+  // Writes an error reply.
+  void WriteError(fmt::StringRef message);
+};
+
+# ifdef MP_USE_THREAD
+// A queue of connections waiting to be served.
+class ConnectionQueue {
+ private:
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<int> fds_;
+  bool closed_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ConnectionQueue);
+
+ public:
+  ConnectionQueue() : closed_(false) {}
+  ~ConnectionQueue();
+
+  void Push(int fd);
+
+  // Waits for a connection and returns its descriptor or -1 if the queue
+  // has been closed.
+  int Pop();
+
+  void Close();
+};
+# endif
+#endif
+
 // An .nl handler for SolverApp.
 template <typename Solver>
 class SolverNLHandler : public Solver::NLProblemBuilder {
@@ -1208,10 +1495,185 @@ class NameProvider {
   fmt::StringRef name(std::size_t index);
 };
 
+// Returns the stub of an .nl file name which is the name without
+// the .nl extension.
+inline std::string GetStub(const char *filename) {
+  std::string stub = filename;
+  const char *ext = std::strrchr(filename, '.');
+  if (ext && std::strcmp(ext, ".nl") == 0)
+    stub.resize(stub.size() - 3);
+  return stub;
+}
+
+// Gets the stubs of a batch which are either the stubs of the .nl files
+// in the directory path in alphabetical order or the .nl file names or
+// stubs listed one per line in the file path. Empty lines and lines
+// starting with '#' in the file are ignored.
+void GetBatchStubs(fmt::StringRef path, std::vector<std::string> &stubs);
+
 // Prints a solution to stdout.
 void PrintSolution(const double *values, int num_values, const char *name_col,
                    const char *value_col, NameProvider &np);
 
+// Reads an .nl file on a separate thread building the problem on the
+// calling thread. Returns false if the reader doesn't support pipelining.
+template <typename Reader, typename Handler>
+inline bool ReadPipelined(Reader &, fmt::StringRef, Handler &, int,
+                          NLPipelineTimes &) {
+  return false;
+}
+
+// Sets the object to collect reader statistics if the reader supports it.
+template <typename Reader>
+inline void SetStats(Reader &, Stats *) {}
+
+template <typename File>
+inline void SetStats(NLFileReader<File> &reader, Stats *stats) {
+  reader.set_stats(stats);
+}
+
+// A reader of a server or batch worker. Workers can't share a reader, so
+// each gets a copy of the application reader which preserves its
+// configuration. Readers that can't be copied are default-constructed.
+template <typename Reader,
+          bool COPYABLE = std::is_copy_constructible<Reader>::value>
+class WorkerReader {
+ private:
+  Reader reader_;
+
+ public:
+  explicit WorkerReader(const Reader &app_reader) : reader_(app_reader) {}
+
+  Reader &get() { return reader_; }
+};
+
+template <typename Reader>
+class WorkerReader<Reader, false> {
+ private:
+  Reader reader_;
+
+ public:
+  explicit WorkerReader(const Reader &) {}
+
+  Reader &get() { return reader_; }
+};
+
+// Reads an .nl content from memory. Throws an exception if the reader
+// doesn't support reading from memory.
+template <typename Reader, typename Handler>
+inline void ReadFromMemory(Reader &, fmt::StringRef, Handler &,
+                           fmt::StringRef, int) {
+  throw Error("reading from memory is not supported");
+}
+
+template <typename File, typename Handler>
+inline void ReadFromMemory(NLFileReader<File> &, fmt::StringRef nl,
+                           Handler &handler, fmt::StringRef name, int flags) {
+  ReadNLString(nl, handler, name, flags);
+}
+
+#ifdef MP_USE_THREAD
+template <typename File, typename Handler>
+inline bool ReadPipelined(NLFileReader<File> &reader, fmt::StringRef filename,
+                          Handler &handler, int flags, NLPipelineTimes &times) {
+  times = ReadNLPipelined(reader, filename, handler, flags);
+  return true;
+}
+#endif
+
+// Maps solutions of a presolved problem to the original problem and
+// passes them to another handler.
+class PostsolveHandler : public SolutionHandler {
+ private:
+  Presolver &presolver_;
+  Problem &original_;
+  SolutionHandler &handler_;
+  std::vector<double> values_;
+  std::vector<double> dual_values_;
+
+  void Postsolve(const double *values, const double *dual_values) {
+    presolver_.Postsolve(values, dual_values, values_, dual_values_);
+  }
+
+  const double *values() const {
+    return values_.empty() ? 0 : &values_[0];
+  }
+  const double *dual_values() const {
+    return dual_values_.empty() ? 0 : &dual_values_[0];
+  }
+
+ public:
+  // original: the problem passed to the presolver
+  PostsolveHandler(Presolver &p, Problem &original, SolutionHandler &h)
+    : presolver_(p), original_(original), handler_(h) {}
+
+  void HandleFeasibleSolution(fmt::StringRef message, const double *values,
+                              const double *dual_values, double obj_value) {
+    Postsolve(values, dual_values);
+    handler_.HandleFeasibleSolution(
+          message, this->values(), this->dual_values(), obj_value);
+  }
+
+  void HandleSolution(int status, fmt::StringRef message,
+                      const double *values, const double *dual_values,
+                      double obj_value) {
+    Postsolve(values, dual_values);
+    // Output suffixes are written with the final solution.
+    presolver_.PostsolveSuffixes(original_);
+    handler_.HandleSolution(
+          status, message, this->values(), this->dual_values(), obj_value);
+  }
+};
+
+// Solves a problem passing solutions to a handler.
+template <typename Solver, typename ProblemBuilder>
+inline void Solve(Solver &s, ProblemBuilder &builder, SolutionHandler &sh) {
+  s.Solve(builder, sh);
+}
+
+// Solves a problem represented as mp::Problem simplifying and presolving
+// it first if enabled by the simplify and presolve options. Problems
+// with complementarity conditions are solved without presolve.
+template <typename Solver>
+void Solve(Solver &s, Problem &p, SolutionHandler &sh) {
+  if (s.simplify()) {
+    steady_clock::time_point start = steady_clock::now();
+    Simplify(p);
+    double simplify_time = GetTimeAndReset(start);
+    if (Stats *stats = s.stats())
+      stats->AddTime("simplify", simplify_time);
+    if (s.timing())
+      s.Print("Simplify time = {:.6f}s\n", simplify_time);
+  }
+  if (s.expr_stats()) {
+    ExprStats es;
+    CollectExprStats(p, es);
+    s.ReportExprStats(es);
+  }
+  if (!s.presolve()) {
+    s.Solve(p, sh);
+    return;
+  }
+  if (p.HasComplementarity()) {
+    s.Print("Presolve skipped: complementarity conditions "
+            "are not supported\n");
+    s.Solve(p, sh);
+    return;
+  }
+  steady_clock::time_point start = steady_clock::now();
+  Presolver presolver(p);
+  double presolve_time = GetTimeAndReset(start);
+  if (Stats *stats = s.stats()) {
+    stats->AddTime("presolve", presolve_time);
+    stats->Add("presolve removed vars", presolver.num_removed_vars());
+    stats->Add("presolve removed cons", presolver.num_removed_cons());
+  }
+  if (s.timing())
+    s.Print("Presolve time = {:.6f}s\n", presolve_time);
+  PostsolveHandler handler(presolver, p, sh);
+  s.Solve(presolver.problem(), handler);
+}
+
 // Solution handler for a solver application.
 template <typename Solver, typename Writer = SolFileWriter>
 class AppSolutionHandler : public SolutionWriter<Solver, Writer> {
@@ -1264,6 +1726,17 @@ void AppSolutionHandler<Solver, Writer>::HandleSolution(
 }
 }  // namespace internal
 
+template <typename ProblemBuilderT>
+template <typename SolverT>
+void SolverImpl<ProblemBuilderT>::DoSolveNL(
+    SolverT &s, ProblemBuilder &builder,
+    fmt::StringRef nl, SolutionHandler &sh) {
+  internal::SolverNLHandler<SolverT> handler(builder, s);
+  ReadNLString(nl, handler, "(input)", 0, stats());
+  builder.EndBuild();
+  internal::Solve(s, builder, sh);
+}
+
 // A solver application.
 // Solver: optimization solver class; normally a subclass of SolverImpl
 // Reader: .nl reader
@@ -1285,6 +1758,89 @@ class SolverApp : private Reader {
   };
   AppOutputHandler output_handler_;
 
+  // Reads a problem from the .nl file of the stub or, if nl is not null,
+  // from memory, solves it with the solver s and writes the solution to
+  // the .sol file of the stub or, if nl is not null, to *sol.
+  void SolveProblem(Solver &s, const std::string &stub,
+                    const std::string *nl, std::string *sol,
+                    int nl_reader_flags);
+
+  // Solves the problems of a batch concurrently writing their solutions
+  // to .sol files.
+  int RunBatch(const char *path, char **argv, int nl_reader_flags);
+
+  // A batch task: part i solves the problem of stubs[i] using the
+  // solver of the pool thread running it.
+  class BatchTask : public ThreadPool::Task {
+   private:
+    SolverApp &app_;
+    const std::vector<std::string> &stubs_;
+    const std::vector<Solver*> &solvers_;
+    std::vector<std::string> &errors_;
+    int nl_reader_flags_;
+
+   public:
+    BatchTask(SolverApp &app, const std::vector<std::string> &stubs,
+              const std::vector<Solver*> &solvers,
+              std::vector<std::string> &errors, int nl_reader_flags)
+      : app_(app), stubs_(stubs), solvers_(solvers), errors_(errors),
+        nl_reader_flags_(nl_reader_flags) {}
+
+    void Run(int index, int thread_index);
+  };
+
+  // Returns the number of server or batch workers given by -workers or
+  // default_value if the option is not specified. Throws Error if the
+  // solver is not thread safe and more than one worker is requested.
+  int GetNumWorkers(int default_value) const;
+
+  // Creates solvers for workers other than the first one, which uses
+  // the application solver, with the options from argv. A solver can't
+  // solve several problems at once, so each worker has its own.
+  // Returns false if option parsing has been stopped.
+  bool CreateSolvers(std::vector<Solver*> &solvers, int num_solvers,
+                     char **argv, unsigned flags);
+
+  // Deletes solvers created by CreateSolvers.
+  struct SolverList {
+    std::vector<Solver*> solvers;
+    ~SolverList() {
+      for (std::size_t i = 1, n = solvers.size(); i < n; ++i)
+        delete solvers[i];
+    }
+  };
+
+#ifndef _WIN32
+  // Solves problems from requests received over the connection fd
+  // using the solver s.
+  void HandleRequests(Solver &s, internal::ServerSocket &socket, int fd,
+                      int nl_reader_flags);
+
+  // Runs the application as a server listening at the socket path.
+  int Serve(const char *path, char **argv, int nl_reader_flags);
+
+# ifdef MP_USE_THREAD
+  // A server task: part 0 accepts connections and part i > 0 serves
+  // them using solvers[i - 1].
+  class ServerTask : public ThreadPool::Task {
+   private:
+    SolverApp &app_;
+    internal::ServerSocket &socket_;
+    internal::ConnectionQueue queue_;
+    const std::vector<Solver*> &solvers_;
+    int nl_reader_flags_;
+
+   public:
+    ServerTask(SolverApp &app, internal::ServerSocket &socket,
+               const std::vector<Solver*> &solvers, int nl_reader_flags)
+      : app_(app), socket_(socket), solvers_(solvers),
+        nl_reader_flags_(nl_reader_flags) {}
+
+    void Run(int index, int);
+  };
+# endif
+#endif
+
  public:
   SolverApp() : option_parser_(solver_) {
     solver_.set_output_handler(&output_handler_);
@@ -1315,6 +1871,12 @@ int SolverApp<Solver, Reader>::Run(char **argv, int nl_reader_flags) {
   // Parse command-line arguments.
   const char *filename = option_parser_.Parse(argv);
   if (!filename) return 0;
+#ifndef _WIN32
+  if (option_parser_.server())
+    return Serve(filename, argv, nl_reader_flags);
+#endif
+  if (option_parser_.batch())
+    return RunBatch(filename, argv, nl_reader_flags);
 
   std::size_t banner_size = 0;
   if (solver_.ampl_flag()) {
@@ -1328,40 +1890,249 @@ int SolverApp<Solver, Reader>::Run(char **argv, int nl_reader_flags) {
   // TODO: test output
 
   // Add .nl extension if necessary.
-  std::string nl_filename = filename, filename_no_ext = nl_filename;
-  const char *ext = std::strrchr(filename, '.');
-  if (!ext || std::strcmp(ext, ".nl") != 0)
-    nl_filename += ".nl";
-  else
-    filename_no_ext.resize(filename_no_ext.size() - 3);
+  std::string filename_no_ext = internal::GetStub(filename);
+  std::string nl_filename = filename_no_ext + ".nl";
 
   // Parse solver options.
   unsigned flags =
       option_parser_.echo_solver_options() ? 0 : Solver::NO_OPTION_ECHO;
+  steady_clock::time_point start = steady_clock::now();
   if (!solver_.ParseOptions(argv, flags))
     return 1;
+  // Statistics are enabled by an option so the parse time is added after
+  // the options are known.
+  Stats *stats = solver_.stats();
+  if (stats)
+    stats->AddTime("option parse", GetTimeAndReset(start));
+  internal::SetStats(reader(), stats);
 
   // Read the problem.
-  steady_clock::time_point start = steady_clock::now();
+  start = steady_clock::now();
   // TODO: use name provider instead of passing filename to builder
   ProblemBuilder builder(solver_.GetProblemBuilder(filename_no_ext));
   internal::SolverNLHandler<Solver> handler(builder, solver_);
-  this->Read(nl_filename, handler, nl_reader_flags);
-
-  builder.EndBuild();
-  double read_time = GetTimeAndReset(start);
-  if (solver_.timing())
-    solver_.Print("Input time = {:.6f}s\n", read_time);
+  internal::NLPipelineTimes times = internal::NLPipelineTimes();
+  if (solver_.pipeline() && internal::ReadPipelined(
+        reader(), nl_filename, handler, nl_reader_flags, times)) {
+    start = steady_clock::now();
+    builder.EndBuild();
+    double end_build_time = GetTimeAndReset(start);
+    times.build_time += end_build_time;
+    if (stats) {
+      stats->AddTime("read", times.read_time);
+      stats->AddTime("build", times.build_time);
+      stats->AddTime("end build", end_build_time);
+    }
+    if (solver_.timing()) {
+      solver_.Print("Input time = {:.6f}s\n", times.read_time);
+      solver_.Print("Build time = {:.6f}s\n", times.build_time);
+    }
+  } else {
+    this->Read(nl_filename, handler, nl_reader_flags);
+    double read_time = GetTimeAndReset(start);
+    builder.EndBuild();
+    double end_build_time = GetTimeAndReset(start);
+    if (stats) {
+      stats->AddTime("read", read_time);
+      stats->AddTime("end build", end_build_time);
+    }
+    if (solver_.timing())
+      solver_.Print("Input time = {:.6f}s\n", read_time + end_build_time);
+  }
 
   // Solve the problem and write solution(s) if necessary.
   ArrayRef<int> options(handler.options(), handler.num_options());
   internal::AppSolutionHandler<Solver> sol_handler(
         filename_no_ext, solver_, builder, options,
         output_handler_.has_output ? 0 : banner_size);
-  solver_.Solve(builder, sol_handler);
+  {
+    ScopedTimer timer(stats, "solve");
+    internal::Solve(solver_, builder, sol_handler);
+  }
+  if (stats)
+    stats->WriteJSON(solver_.stats_file());
   return 0;
 }
 
+template <typename Solver, typename Reader>
+void SolverApp<Solver, Reader>::SolveProblem(
+    Solver &s, const std::string &stub, const std::string *nl,
+    std::string *sol, int nl_reader_flags) {
+  ProblemBuilder builder(s.GetProblemBuilder(stub));
+  internal::SolverNLHandler<Solver> handler(builder, s);
+  internal::WorkerReader<Reader> worker_reader(this->reader());
+  Reader &reader = worker_reader.get();
+  // Statistics are collected per solver since workers run concurrently.
+  internal::SetStats(reader, s.stats());
+  if (nl)
+    internal::ReadFromMemory(reader, *nl, handler, stub, nl_reader_flags);
+  else
+    reader.Read(stub + ".nl", handler, nl_reader_flags);
+  builder.EndBuild();
+  ArrayRef<int> options(handler.options(), handler.num_options());
+  SolutionWriter<Solver, MemorySolWriter>
+      sol_handler(stub, s, builder, options);
+  MemorySolWriter &sol_writer = sol_handler.sol_writer();
+  if (nl)
+    sol_writer.set_filename(stub + ".sol");
+  internal::Solve(s, builder, sol_handler);
+  if (sol)
+    *sol = sol_writer.sol();
+}
+
+template <typename Solver, typename Reader>
+int SolverApp<Solver, Reader>::GetNumWorkers(int default_value) const {
+  int num_workers = option_parser_.num_workers();
+  if (num_workers == 0)
+    return default_value;
+  if (num_workers > 1 && !solver_.thread_safe()) {
+    throw Error("{} can't solve problems concurrently, use -workers 1",
+                solver_.name());
+  }
+  return num_workers;
+}
+
+template <typename Solver, typename Reader>
+bool SolverApp<Solver, Reader>::CreateSolvers(
+    std::vector<Solver*> &solvers, int num_solvers,
+    char **argv, unsigned flags) {
+  solvers.reserve(num_solvers);
+  solvers.push_back(&solver_);
+  for (int i = 1; i < num_solvers; ++i) {
+    solvers.push_back(new Solver());
+    if (!solvers.back()->ParseOptions(argv, flags | Solver::NO_OPTION_ECHO))
+      return false;
+  }
+  return true;
+}
+
+template <typename Solver, typename Reader>
+int SolverApp<Solver, Reader>::RunBatch(
+    const char *path, char **argv, int nl_reader_flags) {
+  unsigned flags =
+      option_parser_.echo_solver_options() ? 0 : Solver::NO_OPTION_ECHO;
+  if (!solver_.ParseOptions(argv, flags))
+    return 1;
+  std::vector<std::string> stubs;
+  internal::GetBatchStubs(path, stubs);
+  if (stubs.empty())
+    throw Error("no problems found in {}", path);
+  int num_stubs = static_cast<int>(stubs.size());
+  // By default problems are solved on all hardware threads or one at
+  // a time if the solver is not thread safe.
+  int num_workers = GetNumWorkers(solver_.thread_safe() ? 0 : 1);
+  ThreadPool pool(num_workers != 0 ? std::min(num_workers, num_stubs) : 0);
+  SolverList list;
+  if (!CreateSolvers(list.solvers, pool.num_threads(), argv, flags))
+    return 1;
+  std::vector<std::string> errors(num_stubs);
+  BatchTask task(*this, stubs, list.solvers, errors, nl_reader_flags);
+  pool.Run(task, num_stubs);
+  int num_errors = 0;
+  for (int i = 0; i < num_stubs; ++i) {
+    if (errors[i].empty())
+      continue;
+    fmt::print(stderr, "Error: {}: {}\n", stubs[i], errors[i]);
+    ++num_errors;
+  }
+  return num_errors != 0 ? 1 : 0;
+}
+
+template <typename Solver, typename Reader>
+void SolverApp<Solver, Reader>::BatchTask::Run(int index, int thread_index) {
+  try {
+    app_.SolveProblem(*solvers_[thread_index], stubs_[index], 0, 0,
+                      nl_reader_flags_);
+  } catch (const std::exception &e) {
+    errors_[index] = e.what();
+  }
+}
+
+#ifndef _WIN32
+template <typename Solver, typename Reader>
+void SolverApp<Solver, Reader>::HandleRequests(
+    Solver &s, internal::ServerSocket &socket, int fd, int nl_reader_flags) {
+  typedef internal::ServerRequest Request;
+  internal::ServerConnection conn(fd);
+  try {
+    Request request;
+    while (conn.ReadRequest(request)) {
+      if (request.kind == Request::QUIT) {
+        socket.Stop();
+        conn.Write("done\n");
+        return;
+      }
+      try {
+        if (request.kind == Request::SOLVE) {
+          SolveProblem(s, internal::GetStub(request.data.c_str()), 0, 0,
+                       nl_reader_flags);
+          conn.Write("done\n");
+        } else {
+          std::string sol;
+          SolveProblem(s, "(input)", &request.data, &sol, nl_reader_flags);
+          conn.Write(fmt::format("sol {}\n", sol.size()));
+          conn.Write(sol);
+        }
+      } catch (const std::exception &e) {
+        conn.WriteError(e.what());
+      }
+    }
+  } catch (const std::exception &e) {
+    // The request is invalid or the connection is broken, drop it.
+    fmt::print(stderr, "Error: {}\n", e.what());
+    try {
+      conn.WriteError(e.what());
+    } catch (const std::exception &) {}
+  }
+}
+
+template <typename Solver, typename Reader>
+int SolverApp<Solver, Reader>::Serve(
+    const char *path, char **argv, int nl_reader_flags) {
+  unsigned flags =
+      option_parser_.echo_solver_options() ? 0 : Solver::NO_OPTION_ECHO;
+  if (!solver_.ParseOptions(argv, flags))
+    return 1;
+#ifdef MP_USE_THREAD
+  int num_workers = GetNumWorkers(1);
+  if (num_workers > 1) {
+    SolverList list;
+    if (!CreateSolvers(list.solvers, num_workers, argv, flags))
+      return 1;
+    internal::ServerSocket socket(path);
+    ServerTask task(*this, socket, list.solvers, nl_reader_flags);
+    ThreadPool pool(num_workers + 1);
+    pool.Run(task, num_workers + 1);
+    return 0;
+  }
+#endif
+  internal::ServerSocket socket(path);
+  for (int fd; (fd = socket.Accept()) >= 0; )
+    HandleRequests(solver_, socket, fd, nl_reader_flags);
+  return 0;
+}
+
+# ifdef MP_USE_THREAD
+template <typename Solver, typename Reader>
+void SolverApp<Solver, Reader>::ServerTask::Run(int index, int) {
+  if (index != 0) {
+    Solver &s = *solvers_[index - 1];
+    for (int fd; (fd = queue_.Pop()) >= 0; )
+      app_.HandleRequests(s, socket_, fd, nl_reader_flags_);
+    return;
+  }
+  try {
+    for (int fd; (fd = socket_.Accept()) >= 0; )
+      queue_.Push(fd);
+  } catch (...) {
+    queue_.Close();
+    throw;
+  }
+  queue_.Close();
+}
+# endif
+#endif
+
 #ifdef MP_USE_UNIQUE_PTR
 typedef std::unique_ptr<Solver> SolverPtr;
 #else
@@ -0,0 +1,124 @@
+/*
+ Timers and counters
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_STATS_H_
+#define MP_STATS_H_
+
+#include <string>
+#include <vector>
+
+#include "mp/clock.h"
+#include "mp/format.h"
+
+namespace mp {
+
+// A registry of named timers and counters.
+//
+// Instrumented code receives a pointer to Stats which is null when
+// instrumentation is disabled, so the only cost in this case is a check
+// for null. Code on a hot path should look up the timer or counter index
+// once and use it afterwards:
+//   int counter = stats ? stats->GetCounter("linear terms") : 0;
+//   ...
+//   if (stats) stats->Add(counter, num_terms);
+class Stats {
+ public:
+  struct Timer {
+    std::string name;
+    double time;  // Total time in seconds.
+    int count;    // Number of measurements.
+  };
+
+  struct Counter {
+    std::string name;
+    fmt::LongLong value;
+  };
+
+ private:
+  std::vector<Timer> timers_;
+  std::vector<Counter> counters_;
+
+ public:
+  // Returns the index of the timer with the specified name adding a new
+  // timer if it doesn't exist.
+  int GetTimer(fmt::StringRef name);
+
+  // Returns the index of the counter with the specified name adding a new
+  // counter if it doesn't exist.
+  int GetCounter(fmt::StringRef name);
+
+  int num_timers() const { return static_cast<int>(timers_.size()); }
+  const Timer &timer(int index) const { return timers_[index]; }
+
+  int num_counters() const { return static_cast<int>(counters_.size()); }
+  const Counter &counter(int index) const { return counters_[index]; }
+
+  // Adds time in seconds to the timer with the specified index.
+  void AddTime(int timer, double time) {
+    Timer &t = timers_[timer];
+    t.time += time;
+    ++t.count;
+  }
+  void AddTime(fmt::StringRef timer, double time) {
+    AddTime(GetTimer(timer), time);
+  }
+
+  // Adds a value to the counter with the specified index.
+  void Add(int counter, fmt::LongLong value) {
+    counters_[counter].value += value;
+  }
+  void Add(fmt::StringRef counter, fmt::LongLong value) {
+    Add(GetCounter(counter), value);
+  }
+
+  // Writes timers and counters in JSON format.
+  void WriteJSON(fmt::Writer &w) const;
+
+  // Writes timers and counters in JSON format to a file.
+  void WriteJSON(fmt::StringRef filename) const;
+};
+
+// Adds the time between construction and destruction of this object to
+// a timer. Does nothing if stats is null.
+class ScopedTimer {
+ private:
+  Stats *stats_;
+  int timer_;
+  steady_clock::time_point start_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ScopedTimer);
+
+ public:
+  ScopedTimer(Stats *stats, fmt::StringRef name)
+    : stats_(stats), timer_(stats ? stats->GetTimer(name) : 0) {
+    if (stats)
+      start_ = steady_clock::now();
+  }
+
+  ~ScopedTimer() {
+    if (stats_)
+      stats_->AddTime(timer_, GetTimeAndReset(start_));
+  }
+};
+}  // namespace mp
+
+#endif  // MP_STATS_H_
@@ -45,23 +45,31 @@ class Suffix {
  private:
   std::string name_;
   int kind_;
+  // Values of an integer or a floating-point suffix. Only one of the
+  // arrays is allocated.
   int *values_;
+  double *dbl_values_;
   int size_;
 
   template <typename Alloc>
   friend class BasicProblem;
 
-  void InitValues(int size) {
-    assert(!values_);
-    values_ = new int[size];
+  void InitValues(int size, bool dbl) {
+    assert(!values_ && !dbl_values_);
+    if (dbl)
+      dbl_values_ = new double[size]();
+    else
+      values_ = new int[size]();
     size_ = size;
   }
 
  public:
   Suffix(fmt::StringRef name, int kind)
-    : name_(name.c_str(), name.size()), kind_(kind), values_(0), size_(0) {}
+    : name_(name.c_str(), name.size()), kind_(kind),
+      values_(0), dbl_values_(0), size_(0) {}
   ~Suffix() {
     delete [] values_;
+    delete [] dbl_values_;
   }
 
   // Returns the suffix name.
@@ -70,24 +78,47 @@ class Suffix {
   // Returns the suffix kind.
   int kind() const { return kind_; }
 
+  // Returns true if the suffix values are floating-point numbers.
+  bool is_dbl() const { return dbl_values_ != 0; }
+
   int value(int index) const {
     assert(index < size_);
-    return values_[index];
+    return dbl_values_ ?
+          static_cast<int>(dbl_values_[index]) : values_[index];
+  }
+
+  double dbl_value(int index) const {
+    assert(index < size_);
+    return dbl_values_ ? dbl_values_[index] : values_[index];
   }
 
   void set_value(int index, int value) {
     assert(index < size_);
-    values_[index] = value;
+    if (dbl_values_)
+      dbl_values_[index] = value;
+    else
+      values_[index] = value;
   }
 
   void set_value(int index, double value) {
     assert(index < size_);
-    MP_UNUSED2(index, value); // TODO: set double value
+    if (dbl_values_)
+      dbl_values_[index] = value;
+    else
+      values_[index] = static_cast<int>(value);
   }
 
   // Iterates over nonzero suffix values and sends them to the visitor.
   template <typename Visitor>
   void VisitValues(Visitor &visitor) const {
+    if (dbl_values_) {
+      for (int i = 0; i < size_; ++i) {
+        double value = dbl_values_[i];
+        if (value != 0)
+          visitor.Visit(i, value);
+      }
+      return;
+    }
     for (int i = 0; i < size_; ++i) {
       int value = values_[i];
       if (value != 0)
@@ -145,6 +176,10 @@ class SuffixManager {
     assert(kind < suf::NUM_KINDS);
     return suffixes_[kind];
   }
+  const SuffixSet &suffixes(int kind) const {
+    assert(kind < suf::NUM_KINDS);
+    return suffixes_[kind];
+  }
 };
 
 }  // namespace mp
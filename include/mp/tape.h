@@ -0,0 +1,241 @@
+/*
+ Expression tape
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_TAPE_H_
+#define MP_TAPE_H_
+
+#include <map>
+#include <vector>
+
+#include "mp/problem.h"
+
+namespace mp {
+
+namespace internal {
+class TapeCompiler;
+}
+
+// A compiled form of objective and constraint expressions of a problem.
+//
+// Each expression is flattened into a sequence of instructions writing
+// their results into separate registers, so that the whole problem is
+// evaluated in a single loop without recursion. Common expressions are
+// compiled once and their registers are shared by all references.
+//
+// Registers are laid out as follows:
+//   [0, num_vars)                  - values of variables,
+//   [num_vars, first_result)       - constants,
+//   [first_result, num_registers)  - instruction results; instruction i
+//                                    writes to register first_result + i.
+//
+// A tape is not modified by evaluation, so it can be shared by several
+// threads each using its own TapeEvaluator.
+class Tape {
+ public:
+  // Opcodes that don't correspond to expression kinds. Other opcodes are
+  // expression kinds such as expr::ADD.
+  enum {
+    // A linear expression: sum of coefficients times registers.
+    LINEAR = expr::LAST_EXPR + 1
+  };
+
+  // An instruction. The meaning of arguments depends on the opcode:
+  //   unary, binary, relational and binary logical expressions, NOT:
+  //     arg1, arg2 - operand registers;
+  //   IF, IMPLICATION:
+  //     arg1 - condition, arg2 - true and arg3 - false expression register;
+  //   PLTERM:
+  //     arg1 - argument register, arg2 - offset of slopes and breakpoints
+  //     interleaved as in PLTerm in data(), arg3 - number of breakpoints;
+  //   iterated expressions (MIN, MAX, SUM, NUMBEROF, COUNT, EXISTS, FORALL,
+  //   ALLDIFF, NOT_ALLDIFF) and LINEAR:
+  //     arg1 - offset of operand registers in args(), arg2 - number of
+  //     operands, arg3 - offset of coefficients in data() (LINEAR only);
+  //   logical count expressions (ATLEAST, ..., NOT_EXACTLY):
+  //     arg1 - left-hand side, arg2 - count register.
+  struct Instruction {
+    int opcode;
+    int arg1;
+    int arg2;
+    int arg3;
+  };
+
+ private:
+  int num_vars_;
+  std::vector<double> consts_;
+  std::vector<Instruction> instrs_;
+  std::vector<int> args_;
+  std::vector<double> data_;
+
+  // Registers holding values of common expressions, objectives and
+  // algebraic constraints.
+  std::vector<int> common_expr_regs_;
+  std::vector<int> obj_regs_;
+  std::vector<int> con_regs_;
+
+  // Map from bit patterns of constant values to indices in consts_ used
+  // during compilation. Comparing bits rather than values keeps 0.0 and
+  // -0.0 apart and gives NaNs a consistent order.
+  std::map<fmt::ULongLong, int> const_indices_;
+
+  friend class internal::TapeCompiler;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(Tape);
+
+  void BeginCompile(int num_vars);
+
+  // Compiles a linear expression with an optional nonlinear part and
+  // returns a register holding its value.
+  int Add(const LinearExpr &linear, NumericExpr nonlinear);
+
+  // Assigns final register numbers once all expressions are compiled.
+  void EndCompile();
+
+ public:
+  Tape() : num_vars_(0) {}
+
+  // Returns the number of operand registers stored in arg1, arg2 and arg3
+  // of an instruction with the specified opcode. Iterated and LINEAR
+  // instructions store operand registers in args() and return 0.
+  static int GetNumRegisterArgs(int opcode);
+
+  template <typename Problem>
+  explicit Tape(const Problem &p) : num_vars_(0) { Compile(p); }
+
+  // Compiles nonlinear and linear parts of common expressions, objectives
+  // and algebraic constraints of a problem replacing the current content.
+  // Logical constraints are ignored.
+  // Throws UnsupportedError if an expression cannot be compiled, for
+  // example, if it contains a function call.
+  template <typename Problem>
+  void Compile(const Problem &p);
+
+  int num_vars() const { return num_vars_; }
+  int num_consts() const { return static_cast<int>(consts_.size()); }
+
+  // Returns the first register holding an instruction result.
+  int first_result() const { return num_vars_ + num_consts(); }
+
+  int num_registers() const { return first_result() + num_instructions(); }
+
+  int num_instructions() const { return static_cast<int>(instrs_.size()); }
+
+  const Instruction &instruction(int index) const { return instrs_[index]; }
+
+  // Returns the value of the constant with the specified index; it is
+  // stored in the register num_vars() + index.
+  double constant(int index) const { return consts_[index]; }
+
+  // Returns a pointer to operand registers of iterated instructions.
+  const int *args() const { return args_.empty() ? 0 : &args_[0]; }
+
+  // Returns a pointer to coefficients and piecewise-linear terms.
+  const double *data() const { return data_.empty() ? 0 : &data_[0]; }
+
+  int num_common_exprs() const {
+    return static_cast<int>(common_expr_regs_.size());
+  }
+  int num_objs() const { return static_cast<int>(obj_regs_.size()); }
+  int num_cons() const { return static_cast<int>(con_regs_.size()); }
+
+  // Returns the register holding the value of a common expression.
+  int common_expr_register(int index) const {
+    return common_expr_regs_[index];
+  }
+
+  // Returns the register holding the value of an objective expression.
+  int obj_register(int index) const { return obj_regs_[index]; }
+
+  // Returns the register holding the value of a constraint expression.
+  int con_register(int index) const { return con_regs_[index]; }
+
+  // Initializes registers holding constants.
+  void InitConsts(double *registers) const;
+
+  // Executes instructions. Registers holding variable values and constants
+  // should be initialized before calling this function.
+  void Evaluate(double *registers) const;
+
+  // Executes only the instructions with the specified indices in the order
+  // they are given. Registers holding operands of these instructions
+  // should be initialized before calling this function.
+  void Evaluate(double *registers, const int *instrs, int num_instrs) const;
+};
+
+template <typename Problem>
+void Tape::Compile(const Problem &p) {
+  BeginCompile(p.num_vars());
+  int num_common_exprs = p.num_common_exprs();
+  common_expr_regs_.reserve(num_common_exprs);
+  for (int i = 0; i < num_common_exprs; ++i) {
+    typename Problem::CommonExpr e = p.common_expr(i);
+    common_expr_regs_.push_back(Add(e.linear_expr(), e.nonlinear_expr()));
+  }
+  int num_objs = p.num_objs();
+  obj_regs_.reserve(num_objs);
+  for (int i = 0; i < num_objs; ++i) {
+    typename Problem::Objective obj = p.obj(i);
+    obj_regs_.push_back(Add(obj.linear_expr(), obj.nonlinear_expr()));
+  }
+  int num_cons = p.num_algebraic_cons();
+  con_regs_.reserve(num_cons);
+  for (int i = 0; i < num_cons; ++i) {
+    typename Problem::AlgebraicCon con = p.algebraic_con(i);
+    con_regs_.push_back(Add(con.linear_expr(), con.nonlinear_expr()));
+  }
+  EndCompile();
+}
+
+// Evaluates a tape keeping values of all registers.
+class TapeEvaluator {
+ private:
+  const Tape &tape_;
+  std::vector<double> registers_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(TapeEvaluator);
+
+ public:
+  explicit TapeEvaluator(const Tape &tape);
+
+  const Tape &tape() const { return tape_; }
+
+  // Evaluates all expressions at the point x containing values of
+  // tape().num_vars() variables.
+  void Evaluate(const double *x);
+
+  // Returns the register values computed by the last call to Evaluate.
+  const double *registers() const { return &registers_[0]; }
+
+  double obj_value(int obj_index) const {
+    return registers_[tape_.obj_register(obj_index)];
+  }
+
+  double con_value(int con_index) const {
+    return registers_[tape_.con_register(con_index)];
+  }
+
+  // Copies values of all algebraic constraints to values.
+  void GetConValues(double *values) const;
+};
+}  // namespace mp
+
+#endif  // MP_TAPE_H_
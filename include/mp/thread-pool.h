@@ -0,0 +1,100 @@
+/*
+ A pool of worker threads
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_THREAD_POOL_H_
+#define MP_THREAD_POOL_H_
+
+#include "mp/format.h"
+
+#ifdef MP_USE_THREAD
+# include <condition_variable>
+# include <exception>
+# include <mutex>
+# include <thread>
+# include <vector>
+#endif
+
+namespace mp {
+
+// A fixed pool of worker threads running parts of parallel tasks.
+// If the library is built without thread support, tasks are run on the
+// calling thread and num_threads() is 1.
+class ThreadPool {
+ public:
+  // A task consisting of independent parts.
+  class Task {
+   public:
+    virtual ~Task() {}
+
+    // Runs the part with the specified index. thread_index is the index
+    // of the pool thread running the part in [0, num_threads()), so that
+    // per-thread state can be used without synchronization.
+    virtual void Run(int index, int thread_index) = 0;
+  };
+
+ private:
+#ifdef MP_USE_THREAD
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_cond_;
+  std::condition_variable done_cond_;
+
+  // The current task and the state of its parts. All are protected by
+  // mutex_. generation_ is incremented for each new task.
+  Task *task_;
+  int num_parts_;
+  int next_part_;
+  int num_done_;
+  unsigned generation_;
+  bool stop_;
+  std::exception_ptr error_;
+
+  void Work(int thread_index);
+
+  // Stops and joins all threads.
+  void Stop();
+#endif
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(ThreadPool);
+
+ public:
+  // Creates a pool with the specified number of threads. If num_threads
+  // is 0, the number of hardware threads is used.
+  explicit ThreadPool(int num_threads = 0);
+  ~ThreadPool();
+
+  int num_threads() const {
+#ifdef MP_USE_THREAD
+    return static_cast<int>(threads_.size());
+#else
+    return 1;
+#endif
+  }
+
+  // Runs parts [0, num_parts) of the task and waits for their completion.
+  // If some parts throw exceptions, the first one is rethrown after all
+  // parts have finished. Run shouldn't be called concurrently.
+  void Run(Task &task, int num_parts);
+};
+}  // namespace mp
+
+#endif  // MP_THREAD_POOL_H_
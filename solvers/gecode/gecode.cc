@@ -771,6 +771,7 @@ void GecodeSolver::DoSolve(ASLProblem &p, SolutionHandler &sh) {
 
   // Set up an optimization problem in Gecode.
   NLToGecodeConverter converter(p.num_vars(), icl_);
+  converter.set_profile(expr_profile());
   converter.Convert(p);
 
   // Post branching.
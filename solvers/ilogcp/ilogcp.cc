@@ -758,6 +758,7 @@ void IlogCPSolver::DoSolve(ASLProblem &p, SolutionHandler &sh) {
   if (GetOption(DEBUGEXPR) != 0)
     flags |= NLToConcertConverter::DEBUG;
   NLToConcertConverter converter(env_, flags);
+  converter.set_profile(expr_profile());
   converter.Convert(p);
 
   try {
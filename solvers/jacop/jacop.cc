@@ -553,6 +553,7 @@ void JaCoPSolver::DoSolve(ASLProblem &p, SolutionHandler &sh) {
 
   // Set up an optimization problem in JaCoP.
   NLToJaCoPConverter converter;
+  converter.set_profile(expr_profile());
   converter.Convert(p);
 
   Class<DepthFirstSearch> dfs_class;
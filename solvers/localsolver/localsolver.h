@@ -390,6 +390,12 @@ class LocalSolver : public SolverImpl<LSProblemBuilder> {
   void Solve(ProblemBuilder &builder, SolutionHandler &sh);
 
   LocalSolver &GetProblemBuilder(fmt::StringRef) { return *this; }
+
+  void SolveNL(fmt::StringRef nl, SolutionHandler &sh,
+               SuffixValueHandler * = 0) {
+    ProblemBuilder builder(GetProblemBuilder("(input)"));
+    DoSolveNL(*this, builder, nl, sh);
+  }
 };
 }  // namespace mp
 
@@ -25,6 +25,7 @@
 
 #include <cmath>
 #include <cstdio>
+#include <map>
 #include <set>
 
 using namespace mp::asl;
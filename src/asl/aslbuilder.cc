@@ -192,7 +192,7 @@ void ASLBuilder::Init(ASL *asl) {
   nderp_ = 0;
   static_ = 0;
   if (!asl) {
-    asl_ = ASL_alloc(ASL_read_fg);
+    asl_ = AllocASL(ASL_read_fg);
     own_asl_ = true;
   }
   for (int i = 0; i < suf::NUM_KINDS; ++i)
@@ -207,7 +207,7 @@ void ASLBuilder::Init(ASL *asl) {
 
 ASLBuilder::~ASLBuilder() {
   if (own_asl_)
-    ASL_free(&asl_);
+    FreeASL(&asl_);
   if (static_)
     delete static_;
 }
@@ -344,7 +344,7 @@ void ASLBuilder::SetInfo(const ProblemInfo &pi) {
     if (info.o_cexp1st_)
       *info.o_cexp1st_ = info.comc1_;
     if (info.nfunc_)
-      func_add(asl_);
+      AddFuncs(asl_);
     ncom = info.comb_ + info.comc_ + info.como_ + info.comc1_ + info.como1_;
   }
 
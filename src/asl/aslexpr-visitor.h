@@ -24,6 +24,7 @@
 #define MP_ASL_ASLEXPR_VISITOR_H_
 
 #include "mp/basic-expr-visitor.h"
+#include "mp/expr-stats.h"
 #include "asl/aslexpr.h"
 
 namespace mp {
@@ -42,9 +43,12 @@ inline bool IsZero(NumericExpr e) {
 
 // Expression converter.
 // Converts logical count expressions to corresponding relational expressions.
-// For example "atleast" is converted to "<=".
+// For example "atleast" is converted to "<=". Conversion time by expression
+// kind is recorded if a profile is set with set_profile.
 template <typename Impl, typename Result, typename LResult = Result>
-class ExprConverter : public ExprVisitor<Impl, Result, LResult> {
+class ExprConverter :
+    public BasicProfilingExprVisitor<Impl, Result, LResult,
+                                     internal::ExprTypes> {
  private:
   std::vector< ::expr> exprs_;
 
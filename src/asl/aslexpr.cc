@@ -144,8 +144,6 @@ class ExprEqual : public mp::asl::ExprVisitor<ExprEqual, bool, bool> {
 };
 }  // namespace
 
-#ifdef MP_USE_UNORDERED_MAP
-
 using asl::internal::HashCombine;
 
 namespace {
@@ -239,20 +237,31 @@ class ExprHasher : public mp::asl::ExprVisitor<ExprHasher, size_t, size_t> {
 };
 }
 
-namespace std {
-template <>
-struct hash<Expr> {
-  std::size_t operator()(Expr e) const;
-};
+size_t asl::internal::Hash<double>::operator()(double value) const {
+  // Zero is handled separately because 0.0 and -0.0 compare equal.
+  if (value == 0)
+    return 0;
+  fmt::ULongLong bits = 0;
+  std::memcpy(&bits, &value, sizeof(value));
+  return static_cast<size_t>(bits ^ (bits >> 32));
 }
 
-size_t std::hash<Expr>::operator()(Expr expr) const {
+size_t asl::internal::Hash<Expr>::operator()(Expr expr) const {
   ExprHasher hasher;
   NumericExpr n = Cast<NumericExpr>(expr);
   return n ? hasher.Visit(n) :
              hasher.VisitStringLiteral(Cast<asl::StringLiteral>(expr));
 }
 
+size_t asl::internal::Hash<NumericExpr>::operator()(NumericExpr expr) const {
+  return ExprHasher().Visit(expr);
+}
+
+size_t asl::internal::Hash<LogicalExpr>::operator()(LogicalExpr expr) const {
+  return ExprHasher().Visit(expr);
+}
+
+#ifdef MP_USE_UNORDERED_MAP
 size_t std::hash<NumericExpr>::operator()(NumericExpr expr) const {
   return ExprHasher().Visit(expr);
 }
@@ -260,17 +269,6 @@ size_t std::hash<NumericExpr>::operator()(NumericExpr expr) const {
 size_t std::hash<LogicalExpr>::operator()(LogicalExpr expr) const {
   return ExprHasher().Visit(expr);
 }
-#else
-# if defined(AMPL_NO_UNORDERED_MAP_WARNING)
-  // Do nothing.
-# elif defined(_MSC_VER)
-#  pragma message("warning: unordered_map not available, numberof may be slow")
-# else
-#  pragma clang diagnostic push
-#  pragma clang diagnostic ignored "-Wpedantic"
-#  warning "unordered_map not available, numberof may be slow"
-#  pragma clang diagnostic pop
-# endif
 #endif
 
 namespace mp {
@@ -290,14 +288,12 @@ bool Equal(LogicalExpr e1, LogicalExpr e2) {
   return ExprEqual(e1).Visit(e2);
 }
 
-#ifdef MP_USE_UNORDERED_MAP
 size_t internal::HashNumberOfArgs::operator()(NumberOfExpr e) const {
   size_t hash = 0;
   for (int i = 1, n = e.num_args(); i < n; ++i)
     hash = HashCombine(hash, e[i]);
   return hash;
 }
-#endif
 
 bool internal::EqualNumberOfArgs::operator()(
     NumberOfExpr lhs, NumberOfExpr rhs) const {
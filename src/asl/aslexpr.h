@@ -31,7 +31,6 @@
 #include <cstddef>
 #include <algorithm>
 #include <iterator>
-#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -847,17 +846,77 @@ struct ExprTypes {
   }
 };
 
-#ifdef MP_USE_UNORDERED_MAP
+// Hash function used for expressions and their components.
+// It doesn't depend on std::hash so that it is available in C++98 too.
+template <typename T>
+struct Hash;
+
+template <>
+struct Hash<int> {
+  std::size_t operator()(int value) const {
+    return static_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Hash<bool> {
+  std::size_t operator()(bool value) const { return value; }
+};
+
+template <>
+struct Hash<char> {
+  std::size_t operator()(char value) const {
+    return static_cast<unsigned char>(value);
+  }
+};
+
+template <>
+struct Hash<double> {
+  std::size_t operator()(double value) const;
+};
+
+// Pointers are hashed by address.
+template <typename T>
+struct Hash<T*> {
+  std::size_t operator()(T *value) const {
+    return reinterpret_cast<std::size_t>(value);
+  }
+};
+
+template <>
+struct Hash<Expr> {
+  std::size_t operator()(Expr e) const;
+};
+
+template <>
+struct Hash<NumericExpr> {
+  std::size_t operator()(NumericExpr e) const;
+};
+
+template <>
+struct Hash<LogicalExpr> {
+  std::size_t operator()(LogicalExpr e) const;
+};
+
 template <class T>
 inline std::size_t HashCombine(std::size_t seed, const T &v) {
-  return seed ^ (std::hash<T>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  return seed ^ (Hash<T>()(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+// Mixes bits of a hash value so that its low bits can be used as an index
+// in a hash table with a power of two size.
+inline std::size_t MixHash(std::size_t h) {
+  fmt::ULongLong x = h;
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdull;
+  x ^= x >> 33;
+  return static_cast<std::size_t>(x);
 }
 
 class HashNumberOfArgs {
  public:
   std::size_t operator()(NumberOfExpr e) const;
 };
-#endif
 
 class EqualNumberOfArgs {
  public:
@@ -885,7 +944,44 @@ class MatchNumberOfArgs {
 template <typename Var, typename CreateVar>
 class NumberOfMap {
  public:
-  typedef std::map<double, Var> ValueMap;
+  // A set of values of numberof expressions with the same arguments and
+  // corresponding variables stored in a vector sorted by value.
+  class ValueMap {
+   public:
+    typedef std::pair<double, Var> value_type;
+
+   private:
+    std::vector<value_type> values_;
+
+    friend class NumberOfMap;
+
+    struct Less {
+      bool operator()(const value_type &lhs, double rhs) const {
+        return lhs.first < rhs;
+      }
+    };
+
+   public:
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+    typedef const_iterator iterator;
+
+    std::size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end() const { return values_.end(); }
+
+    // Returns an iterator to the first element with a value not less than
+    // the argument.
+    const_iterator lower_bound(double value) const {
+      return std::lower_bound(values_.begin(), values_.end(), value, Less());
+    }
+
+    const_iterator find(double value) const {
+      const_iterator i = lower_bound(value);
+      return i != end() && !(value < i->first) ? i : end();
+    }
+  };
 
   struct NumberOf {
     NumberOfExpr expr;
@@ -897,15 +993,22 @@ class NumberOfMap {
  private:
   CreateVar create_var_;
 
-#ifdef MP_USE_UNORDERED_MAP
-  // Map from a numberof expression to an index in numberofs_.
-  typedef std::unordered_map<NumberOfExpr, std::size_t,
-    internal::HashNumberOfArgs, internal::EqualNumberOfArgs> Map;
-  Map map_;
-#endif
-
   std::vector<NumberOf> numberofs_;
 
+  // An open-addressing hash table of indices into numberofs_. Hash values
+  // of argument lists are stored in slots so that probing mostly avoids
+  // comparing expressions and rehashing doesn't recompute them.
+  struct Slot {
+    std::size_t hash;
+    int index;  // Index into numberofs_ or -1 if the slot is empty.
+  };
+  std::vector<Slot> slots_;
+
+  // Returns the slot for the argument list of e with the specified hash.
+  Slot &FindSlot(NumberOfExpr e, std::size_t hash);
+
+  void Grow();
+
  public:
   explicit NumberOfMap(CreateVar cv) : create_var_(cv) {}
 
@@ -923,27 +1026,56 @@ class NumberOfMap {
   Var Add(double value, NumberOfExpr e);
 };
 
+template <typename Var, typename CreateVar>
+typename NumberOfMap<Var, CreateVar>::Slot &
+    NumberOfMap<Var, CreateVar>::FindSlot(NumberOfExpr e, std::size_t hash) {
+  // The number of slots is a power of two so the mask gives the remainder.
+  std::size_t mask = slots_.size() - 1;
+  for (std::size_t i = internal::MixHash(hash) & mask; ; i = (i + 1) & mask) {
+    Slot &slot = slots_[i];
+    if (slot.index < 0 || (slot.hash == hash &&
+        internal::EqualNumberOfArgs()(numberofs_[slot.index].expr, e))) {
+      return slot;
+    }
+  }
+}
+
+template <typename Var, typename CreateVar>
+void NumberOfMap<Var, CreateVar>::Grow() {
+  std::vector<Slot> slots;
+  slots.swap(slots_);
+  Slot empty = {0, -1};
+  slots_.resize(slots.empty() ? 16 : 2 * slots.size(), empty);
+  std::size_t mask = slots_.size() - 1;
+  for (typename std::vector<Slot>::const_iterator
+       i = slots.begin(), end = slots.end(); i != end; ++i) {
+    if (i->index < 0) continue;
+    std::size_t j = internal::MixHash(i->hash) & mask;
+    while (slots_[j].index >= 0)
+      j = (j + 1) & mask;
+    slots_[j] = *i;
+  }
+}
+
 template <typename Var, typename CreateVar>
 Var NumberOfMap<Var, CreateVar>::Add(double value, NumberOfExpr e) {
   assert(Cast<NumericConstant>(e[0]).value() == value);
-#ifdef MP_USE_UNORDERED_MAP
-  std::pair<typename Map::iterator, bool> result =
-      map_.insert(typename Map::value_type(e, numberofs_.size()));
-  if (result.second)
+  // Keep the load factor at most 1/2.
+  if (2 * (numberofs_.size() + 1) > slots_.size())
+    Grow();
+  std::size_t hash = internal::HashNumberOfArgs()(e);
+  Slot &slot = FindSlot(e, hash);
+  if (slot.index < 0) {
+    slot.hash = hash;
+    slot.index = static_cast<int>(numberofs_.size());
     numberofs_.push_back(NumberOf(e));
-  ValueMap &values = numberofs_[result.first->second].values;
-#else
-  typename std::vector<NumberOf>::reverse_iterator np =
-      std::find_if(numberofs_.rbegin(), numberofs_.rend(),
-                   internal::MatchNumberOfArgs<NumberOf>(e));
-  if (np == numberofs_.rend()) {
-    numberofs_.push_back(NumberOf(e));
-    np = numberofs_.rbegin();
   }
-  ValueMap &values = np->values;
-#endif
-  typename ValueMap::iterator i = values.lower_bound(value);
-  if (i != values.end() && !values.key_comp()(value, i->first))
+  std::vector<typename ValueMap::value_type> &values =
+      numberofs_[slot.index].values.values_;
+  typename std::vector<typename ValueMap::value_type>::iterator i =
+      std::lower_bound(values.begin(), values.end(), value,
+                       typename ValueMap::Less());
+  if (i != values.end() && !(value < i->first))
     return i->second;
   Var var(create_var_());
   values.insert(i, typename ValueMap::value_type(value, var));
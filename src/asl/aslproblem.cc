@@ -31,6 +31,11 @@
 # include <io.h>
 #endif
 
+#ifdef MP_USE_THREAD
+# include <mutex>
+#endif
+
+#include "mp/expr-stats.h"
 #include "mp/nl.h"
 #include "mp/os.h"
 #include "mp/problem-builder.h"
@@ -45,8 +50,41 @@
 extern "C" int mkstemps(char *pattern, int suffix_len);
 #endif
 
+namespace {
+#ifdef MP_USE_THREAD
+// Guards the list of ASL objects and the table of imported functions.
+std::mutex asl_mutex;
+#endif
+
+// Holds asl_mutex while in scope.
+class ASLLock {
+#ifdef MP_USE_THREAD
+ private:
+  std::lock_guard<std::mutex> lock_;
+
+ public:
+  ASLLock() : lock_(asl_mutex) {}
+#endif
+};
+}
+
 namespace mp {
 
+ASL *asl::internal::AllocASL(int type) {
+  ASLLock lock;
+  return ASL_alloc(type);
+}
+
+void asl::internal::FreeASL(ASL **asl) {
+  ASLLock lock;
+  ASL_free(asl);
+}
+
+void asl::internal::AddFuncs(ASL *asl) {
+  ASLLock lock;
+  func_add(asl);
+}
+
 Solution::Solution()
 : solve_code_(-1), num_vars_(0), num_cons_(0), values_(0), dual_values_(0) {}
 
@@ -115,7 +153,7 @@ void ASLProblem::Free() {
 }
 
 ASLProblem::ASLProblem()
-: asl_(ASL_alloc(ASL_read_fg)), var_capacity_(0), obj_capacity_(0),
+: asl_(asl::internal::AllocASL(ASL_read_fg)), var_capacity_(0), obj_capacity_(0),
   logical_con_capacity_(0), var_types_(0) {
 }
 
@@ -127,7 +165,7 @@ ASLProblem::ASLProblem(Proxy proxy)
 
 ASLProblem::~ASLProblem() {
   Free();
-  ASL_free(reinterpret_cast<ASL**>(&asl_));
+  asl::internal::FreeASL(reinterpret_cast<ASL**>(&asl_));
 }
 
 // A manager of temporary files.
@@ -400,4 +438,18 @@ fmt::Writer &operator<<(fmt::Writer &w, const ASLProblem &p) {
   Write(w, p);
   return w;
 }
+
+void CollectExprStats(const ASLProblem &p, ExprStats &stats) {
+  BasicExprStatsCollector<asl::internal::ExprTypes> collector(stats);
+  for (int i = 0, n = p.num_objs(); i < n; ++i) {
+    if (asl::NumericExpr e = p.obj(i).nonlinear_expr())
+      collector.Collect(e);
+  }
+  for (int i = 0, n = p.num_algebraic_cons(); i < n; ++i) {
+    if (asl::NumericExpr e = p.algebraic_con(i).nonlinear_expr())
+      collector.Collect(e);
+  }
+  for (int i = 0, n = p.num_logical_cons(); i < n; ++i)
+    collector.Collect(p.logical_con_expr(i));
+}
 }
@@ -31,12 +31,25 @@
 
 namespace mp {
 
+class ExprStats;
+
 template <typename SuffixPtr>
 class SuffixData;
 
 namespace asl {
 namespace internal {
 class ASLBuilder;
+
+// Wrappers of ASL functions that modify the list of allocated ASL objects
+// and the table of imported functions. The calls are serialized to keep
+// these lists consistent, but this doesn't make the ASL thread safe:
+// it is built without MULTIPLE_THREADS, and reading and evaluation go
+// through the global cur_ASL, so problems can't be read or solved in
+// several threads at once. ASLSolver is marked as Solver::NOT_THREAD_SAFE
+// for this reason.
+ASL *AllocASL(int type);
+void FreeASL(ASL **asl);
+void AddFuncs(ASL *asl);
 }
 }
 
@@ -298,7 +311,7 @@ class ASLProblem {
 
     void Free() {
       if (asl_)
-        ASL_free(&asl_);
+        asl::internal::FreeASL(&asl_);
     }
 
    public:
@@ -664,6 +677,10 @@ class ASLProblem {
 // Writes the linear part of the problem in the AMPL format.
 fmt::Writer &operator<<(fmt::Writer &w, const ASLProblem &p);
 
+// Collects statistics of nonlinear parts of objectives and algebraic
+// constraints and of logical constraints.
+void CollectExprStats(const ASLProblem &p, ExprStats &stats);
+
 // Changes (additions) to an optimization problem.
 class ProblemChanges {
  private:
@@ -35,7 +35,18 @@ extern "C" {
 
 mp::ASLSolver::ASLSolver(
     fmt::StringRef name, fmt::StringRef long_name, long date, int flags)
-  : SolverImpl<asl::internal::ASLBuilder>(name, long_name, date, flags) {
+  : SolverImpl<asl::internal::ASLBuilder>(
+      name, long_name, date, flags | NOT_THREAD_SAFE),
+    func_cache_size_(0), suffix_value_handler_(0) {
+  AddIntOption("funcache",
+      "Number of entries in the cache of values of each imported function "
+      "(default 0, no caching). With a nonzero value calls of a function "
+      "with the same arguments as a cached call return the cached value "
+      "and derivatives instead of calling the function again. Use it for "
+      "expensive functions such as those from ``amplgsl`` that are "
+      "repeatedly evaluated at the same points. The number of cache hits "
+      "is reported after solving.",
+      &ASLSolver::GetFuncCacheSize, &ASLSolver::SetFuncCacheSize);
 }
 
 void mp::ASLSolver::RegisterSuffixes(ASL *asl) {
@@ -54,7 +65,7 @@ void mp::ASLSolver::RegisterSuffixes(ASL *asl) {
 }
 
 mp::ASLProblem::Proxy mp::ASLSolver::GetProblemBuilder(fmt::StringRef stub) {
-  ASLProblem::Proxy proxy(ASL_alloc(ASL_read_fg), read_flags_);
+  ASLProblem::Proxy proxy(asl::internal::AllocASL(ASL_read_fg), read_flags_);
   std::size_t stub_len = stub.size();
   Edaginfo &info = proxy.asl_->i;
   info.filename_ = reinterpret_cast<char*>(M1alloc_ASL(&info, stub_len + 5));
@@ -68,5 +79,79 @@ mp::ASLProblem::Proxy mp::ASLSolver::GetProblemBuilder(fmt::StringRef stub) {
 void mp::ASLSolver::Solve(ASLProblem &p, SolutionHandler &sh) {
   RegisterSuffixes(p.asl_);
   ASLSolutionHandler asl_sol_handler(sh, p);
+  // The profile is reported per problem, so discard the times recorded
+  // by previous solves of this solver in server and batch modes.
+  if (ExprProfile *profile = expr_profile())
+    profile->Clear();
+  if (expr_stats()) {
+    ExprStats es;
+    CollectExprStats(p, es);
+    ReportExprStats(es);
+  }
+  if (func_cache_size_ != 0)
+    fcache_ASL(p.asl_, 0, func_cache_size_);
   DoSolve(p, asl_sol_handler);
+  ReportExprProfile();
+  if (func_cache_size_ != 0)
+    ReportFuncCacheStats(p.asl_);
+  if (suffix_value_handler_)
+    ReportSuffixValues(p, *suffix_value_handler_);
+}
+
+namespace {
+// Passes suffix values to a SuffixValueHandler.
+class SuffixValueVisitor {
+ private:
+  mp::SuffixValueHandler &handler_;
+  int kind_;
+  const char *name_;
+
+ public:
+  SuffixValueVisitor(mp::SuffixValueHandler &h, int kind, const char *name)
+    : handler_(h), kind_(kind), name_(name) {}
+
+  template <typename T>
+  void Visit(int index, T value) {
+    handler_.HandleSuffixValue(kind_, name_, index, value);
+  }
+};
+}
+
+void mp::ASLSolver::ReportSuffixValues(
+    ASLProblem &p, SuffixValueHandler &h) {
+  for (int kind = 0; kind <= suf::PROBLEM; ++kind) {
+    SuffixView suffixes = p.suffixes(kind);
+    for (SuffixView::iterator
+         i = suffixes.begin(), end = suffixes.end(); i != end; ++i) {
+      SuffixValueVisitor visitor(h, i->kind(), i->name());
+      i->VisitValues(visitor);
+    }
+  }
+}
+
+void mp::ASLSolver::SolveNL(fmt::StringRef nl, SolutionHandler &sh,
+                            SuffixValueHandler *suffix_handler) {
+  asl::internal::ASLBuilder builder(GetProblemBuilder("(input)"));
+  // Solve takes ownership of the problem, so suffix values are reported
+  // from there.
+  suffix_value_handler_ = suffix_handler;
+  try {
+    DoSolveNL(*this, builder, nl, sh);
+  } catch (...) {
+    suffix_value_handler_ = 0;
+    throw;
+  }
+  suffix_value_handler_ = 0;
+}
+
+void mp::ASLSolver::ReportFuncCacheStats(ASL *asl) {
+  unsigned long hits = 0, calls = 0;
+  if (fcache_stats_ASL(asl, 0, &hits, &calls) == 0 || calls == 0)
+    return;
+  Print("Function cache: {} hits in {} calls ({:.1f}%)\n",
+        hits, calls, 100.0 * hits / calls);
+  if (Stats *s = stats()) {
+    s->Add("function cache hits", hits);
+    s->Add("function cache calls", calls);
+  }
 }
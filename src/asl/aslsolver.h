@@ -30,8 +30,31 @@ namespace mp {
 
 class ASLSolver : public SolverImpl<asl::internal::ASLBuilder> {
  private:
+  // Number of entries in the memo cache of each imported function,
+  // 0 if function values are not cached.
+  int func_cache_size_;
+
+  // Handler receiving suffix values of a problem solved by SolveNL
+  // or null.
+  SuffixValueHandler *suffix_value_handler_;
+
   void RegisterSuffixes(ASL *asl);
 
+  int GetFuncCacheSize(const SolverOption &) const {
+    return func_cache_size_;
+  }
+  void SetFuncCacheSize(const SolverOption &opt, int value) {
+    if (value < 0)
+      throw InvalidOptionValue(opt, value);
+    func_cache_size_ = value;
+  }
+
+  // Reports the hit rate of the function caches.
+  void ReportFuncCacheStats(ASL *asl);
+
+  // Passes nonzero suffix values of a problem to a handler.
+  static void ReportSuffixValues(ASLProblem &p, SuffixValueHandler &h);
+
  class ASLSolutionHandler : public SolutionHandler {
   private:
    SolutionHandler &handler_;
@@ -71,6 +94,9 @@ class ASLSolver : public SolverImpl<asl::internal::ASLBuilder> {
     ASLProblem problem(builder.GetProblem());
     Solve(problem, sh);
   }
+
+  void SolveNL(fmt::StringRef nl, SolutionHandler &sh,
+               SuffixValueHandler *suffix_handler = 0);
 };
 }
 
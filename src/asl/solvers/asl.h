@@ -100,6 +100,7 @@ typedef Long ftnlen;
  typedef struct derp derp;
  typedef struct expr_n expr_n;
  typedef struct func_info func_info;
+ typedef struct func_cache func_cache;
  typedef struct linpart linpart;
  typedef struct ograd ograd;
  typedef struct plterm plterm;
@@ -198,6 +199,7 @@ func_info {
 	int		nargs;
 	void		*funcinfo;
 	int		findex; /* for fg_write */
+	func_cache	*fcache; /* memo cache, see fcache_ASL */
 	};
 
  struct
@@ -991,6 +993,10 @@ QPinfo {
  extern int fg_wread_ASL(ASL*, FILE*, int);
  extern int fgh_read_ASL(ASL*, FILE*, int);
  extern int fg_write_ASL(ASL*, const char*, NewVCO*, int);
+ extern int fcache_ASL(ASL*, const char*, int);
+ extern int fcache_get_ASL(func_info*, arglist*, real*);
+ extern void fcache_put_ASL(func_info*, arglist*, real);
+ extern int fcache_stats_ASL(ASL*, const char*, unsigned long*, unsigned long*);
  extern void fintrouble_ASL(ASL*, func_info*, const char*, TMInfo*);
  extern void flagsave_ASL(ASL*, int);
  extern void freedtoa(char*);
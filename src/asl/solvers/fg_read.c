@@ -1634,6 +1634,7 @@ fg_read_ASL(ASL *a, FILE *nl, int flags)
 					fi->ftype = j;
 					fi->nargs = k;
 					fi->funcp = 0;
+					fi->fcache = 0;
 					fi->name = (Const char *)strcpy((char*)
 						mem(memadj(strlen(fname)+1)),
 						fname);
@@ -75,6 +75,7 @@ func_lookup(ASL *asl, register const char *s, int add)
 		fi->next = *finext;
 		*finext = fi;
 		fi->name = s0;
+		fi->fcache = 0;
 		}
 	return fi;
 	}
@@ -112,6 +113,181 @@ addfunc_ASL(const char *fname, ufunc *f, int ftype, int nargs, void *funcinfo, A
 		}
 	}
 
+/* Memo cache of imported function values:  fcache_ASL(asl, fname, n) */
+/* gives function fname (or all functions if fname == 0) a direct-mapped */
+/* cache of n entries (rounded up to a power of 2), or removes the cache */
+/* if n <= 0.  f_OPFUNCALL looks up the real arguments of each call and, */
+/* on a hit, returns the saved value and copies the saved partials to */
+/* al->derivs and al->hes without calling the function.  Calls with */
+/* symbolic arguments or with a number of real arguments that differs */
+/* from that of the first call are not cached, nor are calls that set */
+/* al->Errmsg.  fcache_stats_ASL reports the number of hits and lookups. */
+
+ enum { /* fc_entry flags */
+	FC_value = 1,
+	FC_derivs = 2,
+	FC_hes = 4
+	};
+
+ typedef struct
+fc_entry {
+	char *dig;	/* al->dig of the call that computed the partials */
+	int flags;
+	} fc_entry;
+
+ struct
+func_cache {
+	ASL *asl;
+	unsigned long calls, hits;
+	unsigned int mask;	/* number of entries - 1 */
+	int nr;		/* number of real args; -1 before the first call */
+	int nh;		/* length of the packed Hessian; 0 if not saved */
+	size_t stride;	/* reals per entry: args, value, derivs, hes */
+	fc_entry *e;
+	real *r;
+	};
+
+ int
+fcache_ASL(ASL *asl, const char *fname, int n)
+{
+	func_cache *fc;
+	func_info *fi;
+	int k;
+	unsigned int m;
+
+	for(m = 1; m < (unsigned int)n && m < 0x40000000U; m <<= 1);
+	k = 0;
+	for(fi = funcsfirst; fi; fi = fi->fnext) {
+		if (fname && strcmp(fname, fi->name))
+			continue;
+		if (fi->ftype & (FUNCADD_STRING_VALUED | FUNCADD_RANDOM_VALUED))
+			continue;
+		fc = 0;
+		if (n > 0) {
+			fc = (func_cache*)M1zapalloc(sizeof(func_cache));
+			fc->asl = asl;
+			fc->mask = m - 1;
+			fc->nr = -1;
+			}
+		fi->fcache = fc;
+		k++;
+		}
+	return k;
+	}
+
+ static void
+fc_init(func_cache *fc, int nr)
+{
+	ASL *asl = fc->asl;
+	size_t n = (size_t)fc->mask + 1;
+
+	fc->nr = nr;
+	if (asl->i.ASLtype == ASL_read_fgh || asl->i.ASLtype == ASL_read_pfgh)
+		fc->nh = nr*(nr+1) >> 1;
+	fc->stride = 2*nr + 1 + fc->nh;
+	fc->e = (fc_entry*)M1zapalloc(n*sizeof(fc_entry));
+	fc->r = (real*)M1alloc(n*fc->stride*sizeof(real));
+	}
+
+ static fc_entry *
+fc_find(func_cache *fc, arglist *al, real **rp)
+{
+	union { real r; unsigned int u[sizeof(real)/sizeof(unsigned int)]; } x;
+	real *ra, *rae;
+	size_t i;
+	unsigned int h;
+
+	/* FNV-1a over the bits of the args */
+	h = 2166136261U;
+	for(ra = al->ra, rae = ra + al->nr; ra < rae; ra++) {
+		x.r = *ra;
+		for(i = 0; i < sizeof(x.u)/sizeof(unsigned int); i++) {
+			h ^= x.u[i];
+			h *= 16777619U;
+			}
+		}
+	h = (h ^ (h >> 15)) & fc->mask;
+	*rp = fc->r + h*fc->stride;
+	return fc->e + h;
+	}
+
+ int
+fcache_get_ASL(func_info *fi, arglist *al, real *rv)
+{
+	fc_entry *fe;
+	func_cache *fc = fi->fcache;
+	int nr = al->nr;
+	real *r;
+
+	if (al->n != nr)
+		return 0;
+	if (fc->nr != nr) {
+		if (fc->nr >= 0)
+			return 0;
+		fc_init(fc, nr);
+		}
+	fc->calls++;
+	fe = fc_find(fc, al, &r);
+	if (!fe->flags || memcmp(r, al->ra, nr*sizeof(real)))
+		return 0;
+	if (al->derivs) {
+		if (!(fe->flags & FC_derivs) || (fe->dig && fe->dig != al->dig))
+			return 0;
+		if (al->hes && !(fe->flags & FC_hes))
+			return 0;
+		memcpy(al->derivs, r + nr + 1, nr*sizeof(real));
+		if (al->hes)
+			memcpy(al->hes, r + 2*nr + 1, fc->nh*sizeof(real));
+		}
+	fc->hits++;
+	*rv = r[nr];
+	return 1;
+	}
+
+ void
+fcache_put_ASL(func_info *fi, arglist *al, real rv)
+{
+	fc_entry *fe;
+	func_cache *fc = fi->fcache;
+	int nr = al->nr;
+	real *r;
+
+	if (al->n != nr || fc->nr != nr)
+		return;
+	fe = fc_find(fc, al, &r);
+	memcpy(r, al->ra, nr*sizeof(real));
+	r[nr] = rv;
+	fe->flags = FC_value;
+	fe->dig = al->dig;
+	if (al->derivs) {
+		memcpy(r + nr + 1, al->derivs, nr*sizeof(real));
+		fe->flags |= FC_derivs;
+		if (al->hes && fc->nh) {
+			memcpy(r + 2*nr + 1, al->hes, fc->nh*sizeof(real));
+			fe->flags |= FC_hes;
+			}
+		}
+	}
+
+ int
+fcache_stats_ASL(ASL *asl, const char *fname, unsigned long *hits, unsigned long *calls)
+{
+	func_cache *fc;
+	func_info *fi;
+	int k;
+
+	*hits = *calls = 0;
+	k = 0;
+	for(fi = funcsfirst; fi; fi = fi->fnext) {
+		if (!(fc = fi->fcache) || (fname && strcmp(fname, fi->name)))
+			continue;
+		*hits += fc->hits;
+		*calls += fc->calls;
+		k++;
+		}
+	return k;
+	}
+
 enum { NEFB = 5, NEFB0 = 2 };
 
  static Exitcall a_e_info[NEFB0];
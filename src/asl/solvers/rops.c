@@ -1072,14 +1072,18 @@ f_OPFUNCALL(expr *e A_ASL)
 		e = ap->e;
 		*ap->u.s = (*(sfunc*)e->op)(e K_ASL);
 		}
-	T.u.prev = 0;
 	al = f->al;
+	if (fi->fcache && fcache_get_ASL(fi, al, &rv))
+		return rv;
+	T.u.prev = 0;
 	al->TMI = &T;
 	al->Errmsg = 0;
 	rv = (*fi->funcp)(al);
 	errno_set(0);
 	if ((s = al->Errmsg))
 		fintrouble_ASL(asl, fi, s, &T);
+	else if (fi->fcache)
+		fcache_put_ASL(fi, al, rv);
 	for(T1 = T.u.prev; T1; T1 = T1prev) {
 		T1prev = T1->u.prev;
 		free(T1);
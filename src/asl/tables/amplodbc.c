@@ -49,6 +49,9 @@ THIS SOFTWARE.
 #ifndef SQLLEN
 #define SQLLEN SQLINTEGER
 #endif
+#ifndef SQLULEN
+#define SQLULEN SQLUINTEGER
+#endif
 #endif
 #endif
 
@@ -66,6 +69,11 @@ typedef long SQLLEN_t;
 /* little-endian systems, we can make an amplodbc.dll that works on both */
 /* kinds of Linux systems by pretending SQLLEN is a 64-bit type and */
 /* initializing SQLLEN variables to zero before ODBC assigns values to them. */
+/* This does not work for arrays of length indicators, whose stride would */
+/* be wrong with a 32-bit SQLLEN, so rows are not batched by default. */
+#ifndef DEFAULT_BATCH
+#define DEFAULT_BATCH 1
+#endif
 #else
 typedef SQLLEN SQLLEN_t;
 #endif
@@ -78,6 +86,13 @@ static unsigned char tolc[256];	/* for converting to lower case */
 #define DEFAULT_MAXLEN 480
 #endif
 
+#ifndef DEFAULT_BATCH
+#define DEFAULT_BATCH 1024
+#endif
+
+#define Stringize(x) #x
+#define Str(x) Stringize(x)
+
 #define CC (const char*)
 #define UC (UCHAR*)
 #define TM(len) (*ae->Tempmem)(TI->TMI,len)
@@ -97,6 +112,7 @@ HInfo {
 	HDBC	hc;
 	HSTMT	hs;
 	int	verbose;
+	unsigned int batch;	/* rows per SQLFetch or SQLExecute */
 	unsigned int maxlen;
 	char	*s, *se; /* for use in Adjust_ampl_odbc */
 	int	totbadtimes;
@@ -662,6 +678,7 @@ ODBC_check(AmplExports *AE, TableInfo *TI, HInfo *h)
 	h->TI = TI;
 	h->Missing = TI->Missing;
 	h->maxlen = DEFAULT_MAXLEN;
+	h->batch = DEFAULT_BATCH;
 
 	if (!tolc[1]) {
 		for(i = 0; i < 256; i++)
@@ -1235,6 +1252,21 @@ Connect(HInfo *h, DRV_desc **dsp, int *rc, char **sqlp)
 		s = *strs++;
 		--nstr;
 		}
+	if (match("batch=", UC s, UC s + 6)) {
+		s2 = "";
+		if ((ui = t = strtod(s+6,&s2)) > 0 && !*s2 && t == ui)
+			h->batch = ui;
+		else {
+			sprintf(TI->Errmsg = TM(strlen(s) + 72),
+				"Inappropriate value in \"%s\":\n\t%s",
+				s, "expected a positive decimal integer.");
+			goto eret;
+			}
+		if (nstr <= 0)
+			goto know_verbose;
+		s = *strs++;
+		--nstr;
+		}
 	if (match("maxlen=", UC s, UC s + 7)) {
 		s1 = s2 = "";
 		if ((ui = t = strtod(s+7,&s2)) > 0 && !*s2 && t == ui)
@@ -1621,6 +1653,32 @@ get_types(DRV_desc *ds, HInfo *h)
 	return 0;
 	}
 
+ static SQLULEN
+set_batch(HInfo *h, SQLINTEGER attr, SQLULEN n)
+{
+	/* Ask for arrays of n rows (attr = SQL_ATTR_ROW_ARRAY_SIZE) */
+	/* or parameter sets (attr = SQL_ATTR_PARAMSET_SIZE) and return */
+	/* the number the driver accepts, which is 1 if it has no arrays. */
+
+	SQLULEN v;
+	int i;
+
+	if (n <= 1)
+		return 1;
+	i = SQLSetStmtAttr(h->hs, attr, (SQLPOINTER)(size_t)n, 0);
+	if (i == SQL_SUCCESS)
+		return n;
+	if (i == SQL_SUCCESS_WITH_INFO) {
+		/* The driver substituted a value of its own. */
+		v = 0;
+		if (SQLGetStmtAttr(h->hs, attr, &v, 0, 0) == SQL_SUCCESS
+		 && v >= 1 && v <= n)
+			return v;
+		}
+	SQLSetStmtAttr(h->hs, attr, (SQLPOINTER)1, 0);
+	return 1;
+	}
+
  static void
 askusing(AmplExports *ae, TableInfo *TI, char *what, char *tname)
 {
@@ -1703,13 +1761,14 @@ Write_odbc(AmplExports *ae, TableInfo *TI)
 	HSTMT hs;
 	HInfo h;
 	TIMESTAMP_STRUCT *ts, *ts0, *ts1, **tsp, ***tsq;
+	SQLUSMALLINT *pstat;
 	UWORD u;
 	char *Missing;
-	char buf[32], *ct, *dt, *it, *s, **sb, **sp, **spe, *tname;
+	char buf[32], *ct, *dt, *it, *s, **sb, **sp, **spe, *t, *tname;
 	double *rb;
 	int deltry, i, i1, j, k, nc, nodrop, ntlen, nts, rc;
 	int *slen, *sw;
-	long ir, nr;
+	long ir, jr, nb, nr, nr1;
 	size_t L, sblen, tnlen;
 #ifdef NO_Adjust_ampl_odbc
 #define p(x) x
@@ -1792,10 +1851,6 @@ Write_odbc(AmplExports *ae, TableInfo *TI)
 	dt = (char*)TM(2*L+tnlen+16);
 	ct = dt+tnlen+16;
 	it = ct + L;
-	rb = (double*)TM(nc*(sizeof(char*) + sizeof(double))
-			+ nts*sizeof(TIMESTAMP_STRUCT) + sblen);
-	ts = ts0 = (TIMESTAMP_STRUCT*)(rb + nc);
-	sb = (char**)(ts + nts);
 	if (nodrop) {
 		j = sprintf(it = ct, "INSERT INTO %s (%s" /*)*/,
 				tname, quoted_colnames[0]);
@@ -1870,45 +1925,85 @@ Write_odbc(AmplExports *ae, TableInfo *TI)
 		TI->Errmsg = "Unexpected ODBC failure";
 		goto done;
 		}
+
+	/* Rows are sent nb at a time in column-wise parameter arrays: */
+	/* column i has nb values at rb + i*nb or nb strings of length */
+	/* slen[i] at sb[i], and time columns have nb values each in ts0. */
+
+	nr = TI->nrows;
+	nb = (long)set_batch(&h, SQL_ATTR_PARAMSET_SIZE,
+			nr < h.batch ? nr : h.batch);
+	rb = (double*)TM(nb*(nc*sizeof(double)
+			+ nts*sizeof(TIMESTAMP_STRUCT) + sblen)
+			+ nc*sizeof(char*));
+	ts = ts0 = (TIMESTAMP_STRUCT*)(rb + nc*nb);
+	sb = (char**)(ts + nts*nb);
 	s = (char*)(sb + nc);
+
+	/* With arrays, SQLExecute can return SQL_SUCCESS_WITH_INFO when */
+	/* some rows fail, so the status of each row is checked. */
+
+	pstat = 0;
+	if (nb > 1) {
+		pstat = (SQLUSMALLINT*)TM(nb*sizeof(SQLUSMALLINT));
+		if (SQLSetStmtAttr(hs, SQL_ATTR_PARAM_STATUS_PTR, pstat, 0)
+				!= SQL_SUCCESS)
+			pstat = 0;
+		}
 	db = TI->cols;
 	for(i = 0; i < nc; i++, db++) {
 		u = pi(i) + 1;
-		if (tsq && tsq[i])
+		if (tsq && tsq[i]) {
 			SQLBindParameter(hs, u, SQL_PARAM_INPUT, SQL_C_TIMESTAMP,
-					SQL_TIMESTAMP, ds->tprec, 0, ts++, 0, NULL);
+					SQL_TIMESTAMP, ds->tprec, 0, ts, 0, NULL);
+			ts += nb;
+			}
 		else if (db->sval) {
 			SQLBindParameter(hs, u, SQL_PARAM_INPUT, SQL_C_CHAR,
-					SQL_VARCHAR, slen[i], 0, sb[i] = s, 0, NULL);
-			s += slen[i];
+					SQL_VARCHAR, slen[i], 0, sb[i] = s,
+					slen[i], NULL);
+			s += slen[i]*nb;
 			}
 		else
 			SQLBindParameter(hs, u, SQL_PARAM_INPUT, SQL_C_DOUBLE,
-					SQL_DOUBLE, 0, 0, rb + i, 0, NULL);
-		}
-	nr = TI->nrows;
-	for(ir = 0; ir < nr; ir++) {
-		db = TI->cols;
-		ts1 = ts0;
-		for(i = 0; i < nc; i++, db++)
-			if (tsq && (tsp = tsq[i]))
-				*ts1++ = *tsp[ir];
-			else if ((sp = db->sval)) {
-				if ((s = sp[ir])) {
-					if (s == Missing)
-						*sb[i] = 0;
-					else if (h.oldquotes && mustquote(s,0))
-						sprintf(sb[i], "'%s'", s);
+					SQL_DOUBLE, 0, 0, rb + i*nb, 0, NULL);
+		}
+	for(ir = 0; ir < nr; ir += nr1) {
+		if ((nr1 = nr - ir) > nb)
+			nr1 = nb;
+		else if (nr1 < nb)
+			SQLSetStmtAttr(hs, SQL_ATTR_PARAMSET_SIZE,
+				(SQLPOINTER)(size_t)nr1, 0);
+		for(jr = 0; jr < nr1; jr++) {
+			if (pstat)
+				pstat[jr] = SQL_PARAM_SUCCESS;
+			db = TI->cols;
+			ts1 = ts0 + jr;
+			for(i = 0; i < nc; i++, db++)
+				if (tsq && (tsp = tsq[i])) {
+					*ts1 = *tsp[ir+jr];
+					ts1 += nb;
+					}
+				else if ((sp = db->sval)) {
+					t = sb[i] + jr*slen[i];
+					if ((s = sp[ir+jr])) {
+						if (s == Missing)
+							*t = 0;
+						else if (h.oldquotes
+							&& mustquote(s,0))
+							sprintf(t, "'%s'", s);
+						else
+							strcpy(t, s);
+						}
+					else if (db->dval)
+						sprintf(t, "%.g",
+							db->dval[ir+jr]);
 					else
-						strcpy(sb[i], s);
+						*t = 0;
 					}
-				else if (db->dval)
-					sprintf(sb[i], "%.g", db->dval[ir]);
 				else
-					*sb[i] = 0;
-				}
-			else
-				rb[i] = db->dval[ir];
+					rb[i*nb + jr] = db->dval[ir+jr];
+			}
 		i = SQLExecute(hs);
 		if (i != SQL_SUCCESS && i != SQL_SUCCESS_WITH_INFO) {
 			if (!ir && !nodrop) {
@@ -1918,6 +2013,17 @@ Write_odbc(AmplExports *ae, TableInfo *TI)
 			prc(&h, "SQLExecute", i);
 			goto failed;
 			}
+		if (pstat)
+			for(jr = 0; jr < nr1; jr++)
+				if (pstat[jr] == SQL_PARAM_ERROR
+				 || pstat[jr] == SQL_PARAM_UNUSED) {
+					if (h.verbose)
+						prc(&h, "SQLExecute", SQL_ERROR);
+					sprintf(TI->Errmsg = (char*)TM(strlen(tname) + 64),
+						"INSERT INTO %s failed for row %ld.",
+						tname, ir + jr + 1);
+					goto done;
+					}
 		}
 	if (prc(&h, "COMMIT CREATE INSERT", SQLTransact(h.env, h.hc, SQL_COMMIT)))
 		TI->Errmsg = "Write commit failure";
@@ -1938,6 +2044,7 @@ DBColinfo {
 	SQLLEN_t type;
 	SQLLEN_t prec;
 	SQLLEN_t len;
+	SQLLEN_t *lens;	/* for row arrays in Read_odbc */
 	int mytype;
 	int myoffset;
 	} DBColinfo;
@@ -2151,16 +2258,20 @@ Read_odbc(AmplExports *ae, TableInfo *TI)
 {
 	DBColinfo *dbc0, *dbc;
 	DRV_desc *ds;
-	DbCol *db;
+	DbCol *db, *db0;
 	HInfo h;
 	HSTMT hs;
 	PTR ptr;
+	SQLULEN nb, nfetched;
 	SWORD len, ncols;
 	TIMESTAMP_STRUCT *td, *ts;
 	UWORD u;
 	char **cd, *dsn, nbuf[512], *s, *sbuf, *tname;
 	double *dd, t;
+	real *dd1;
+	char **sv;
 	int *ct, dbq, i, j, k, mix, nk[4], nt, *p, *z, *zt;
+	long ir, nr;
 	int a = TI->arity;	/* number of indexing columns */
 	int nc = TI->ncols;	/* number of data columns desired */
 	int nf = a + nc;	/* total number of columns of interest */
@@ -2310,15 +2421,29 @@ Read_odbc(AmplExports *ae, TableInfo *TI)
 		}
 	if (h.sqldb)
 		printf("\n");
+
+	/* Rows are fetched nb at a time into column-wise arrays: */
+	/* dd + j*nb, cd[j] (nb strings of length prec) and td + j*nb */
+	/* for the jth column of each kind.  With nb > 1, the length */
+	/* indicators are arrays of SQLLEN_t, so drivers whose SQLLEN */
+	/* differs from ours need 'batch=1', the default where this can */
+	/* happen. */
+
+	nb = set_batch(&h, SQL_ATTR_ROW_ARRAY_SIZE, a <= 0 ? 1 : h.batch);
+	nfetched = 1;
+	if (nb > 1 && prc(&h, "SQLSetStmtAttr(ROWS_FETCHED_PTR)",
+			SQLSetStmtAttr(hs, SQL_ATTR_ROWS_FETCHED_PTR,
+				&nfetched, 0)))
+		goto badret;
 	dd = 0; /* shut up erroneous warning */
 	cd = 0; /* ditto */
 	td = 0; /* ditto */
 	if ((i = nk[0]))
-		dd = (double*)TM(i*sizeof(double));
+		dd = (double*)TM(i*nb*sizeof(double));
 	if ((i = nk[1]))
 		cd = (char**)TM(i*sizeof(char*));
 	if ((i = nk[2])) {
-		td = (TIMESTAMP_STRUCT*)TM(i*sizeof(TIMESTAMP_STRUCT));
+		td = (TIMESTAMP_STRUCT*)TM(i*nb*sizeof(TIMESTAMP_STRUCT));
 		}
 	memset(nk, 0, sizeof(nk));
 	for(i = 0; i < nf; i++) {
@@ -2328,22 +2453,33 @@ Read_odbc(AmplExports *ae, TableInfo *TI)
 		dbc->myoffset = j = nk[k = dbc->mytype]++;
 		switch(k) {
 		 case 0:
-			ptr = (PTR)&dd[j];
+			ptr = (PTR)&dd[j*nb];
 			break;
 		 case 1:
-			ptr = (PTR)(s = cd[j] = (char*)TM(dbc->prec));
-			*s = 0;	/* bypass MS Excel bug with empty cells */
+			ptr = (PTR)(s = cd[j] = (char*)TM(dbc->prec*nb));
+			/* bypass MS Excel bug with empty cells */
+			for(ir = 0; ir < nb; ir++)
+				s[ir*dbc->prec] = 0;
 			break;
-		 case 2: ptr = (PTR)&td[j];
-			td[j] = Missing_time;
+		 case 2: ptr = (PTR)&td[j*nb];
+			for(ir = 0; ir < nb; ir++)
+				td[j*nb + ir] = Missing_time;
 			break;
 		 default: continue;
 		 }
-		dbc->len = 0;
+		dbc->lens = (SQLLEN_t*)TM(nb*sizeof(SQLLEN_t));
+		memset(dbc->lens, 0, nb*sizeof(SQLLEN_t));
 		if (prc(&h, "SQLBindCol_3",
-				SQLBindCol(hs, u, sqlc[k], ptr, dbc->prec, (SQLLEN*)&dbc->len)))
+				SQLBindCol(hs, u, sqlc[k], ptr, dbc->prec, (SQLLEN*)dbc->lens)))
 			goto badret;
 		}
+	db0 = (DbCol*)TM(nf*(sizeof(DbCol) + nb*(sizeof(real) + sizeof(char*))));
+	dd1 = (real*)(db0 + nf);
+	sv = (char**)(dd1 + nf*nb);
+	for(i = 0; i < nf; i++) {
+		db0[i].dval = dd1 + i*nb;
+		db0[i].sval = sv + i*nb;
+		}
 	if (h.oldquotes)
 		mix = 3;
 	else if ((mix = h.nsmix) == 2) {
@@ -2361,31 +2497,33 @@ Read_odbc(AmplExports *ae, TableInfo *TI)
 		}
 	if (prc(&h, "SQLExecute", SQLExecute(hs)))
 		goto badret;
-	db = TI->cols;
 	while((i = SQLFetch(hs)) == SQL_SUCCESS || i == SQL_SUCCESS_WITH_INFO) {
-		for(i = 0; i < nf; i++, db++) {
+		nr = a <= 0 ? 1 : (long)nfetched;
+		for(ir = 0; ir < nr; ir++) {
+		    for(i = 0, db = db0; i < nf; i++, db++) {
 			dbc = dbc0 + p[i];
 			switch(dbc->mytype) {
 			 case 0:
-				if (dbc->len == SQL_NULL_DATA)
-					db->sval[0] = h.Missing;
+				if (dbc->lens[ir] == SQL_NULL_DATA)
+					db->sval[ir] = h.Missing;
 				else {
-					db->sval[0] = 0;
-					db->dval[0] = dd[dbc->myoffset];
+					db->sval[ir] = 0;
+					db->dval[ir] = dd[dbc->myoffset*nb + ir];
 					}
 				break;
 			 case 1:
-				db->sval[0] = scrunch(&h, cd[dbc->myoffset], db->dval, mix);
+				db->sval[ir] = scrunch(&h, cd[dbc->myoffset]
+					+ ir*dbc->prec, db->dval + ir, mix);
 				break;
 			 case 2:
-				ts = td + dbc->myoffset;
+				ts = td + dbc->myoffset*nb + ir;
 				if (ts->year < 0
 				 || !memcmp(ts, &No_time, sizeof(No_time))
 				 || !memcmp(ts, &Missing_time, sizeof(No_time))) {
-					db->sval[0] = TI->Missing;
+					db->sval[ir] = TI->Missing;
 					break;
 					}
-				db->sval[0] = 0;
+				db->sval[ir] = 0;
 				t = 100.*ts->year + ts->month;
 				t = 100.*t + ts->day;
 				t = 100.*t + ts->hour;
@@ -2393,22 +2531,28 @@ Read_odbc(AmplExports *ae, TableInfo *TI)
 				t = 100.*t + ts->second;
 				/*if (ts->fraction)
 					t += ts->fraction / 4294967296.;*/ /* 2^32 */
-				db->dval[0] = t;
+				db->dval[ir] = t;
 				*ts = Missing_time;
 				break;
 			  case 3:
-				db->sval[0] = scrunch(&h, cd[dbc->myoffset], db->dval, 1);
+				db->sval[ir] = scrunch(&h, cd[dbc->myoffset]
+					+ ir*dbc->prec, db->dval + ir, 1);
 			 }
 			}
-		db = TI->cols;
-		if ((*TI->AddRows)(TI, db, 1)) {
+		    }
+		if ((*TI->AddRows)(TI, db0, nr)) {
 			cleanup(&h);
 			return DB_Error;
 			}
 		if (a <= 0)
 			break;
-		for(i = nk[1]; i--;)
-			*cd[i] = 0;	/* to bypass MS Excel empty-cell bug */
+		/* to bypass MS Excel empty-cell bug */
+		for(i = 0; i < nf; i++) {
+			dbc = dbc0 + p[i];
+			if (dbc->mytype == 1 || dbc->mytype == 3)
+				for(ir = 0; ir < nr; ir++)
+					cd[dbc->myoffset][ir*dbc->prec] = 0;
+			}
 		}
 	cleanup(&h);
 	return DB_Done;
@@ -2425,11 +2569,16 @@ funcadd(AmplExports *ae)
 	"given in place of 'ext_name'.  For IN tables, 'SQL=sqlstmt' can appear in\n"
 	"place of 'ext_name', where sqlstmt is a SQL statement, such as a SELECT\n"
 	"statement.  Possible options, explained below:\n\n"
+	"\t'batch=nnn'\n"
 	"\t'maxlen=nnn'\n"
 	"\t'nsmix=...'\n"
 	"\t'time=...'\n"
 	"\t'verbose' or 'verbose=n'\twith 0 <= n <= 3\n"
 	"\t'write=append' or 'write=drop'\n\n"
+	"Use 'batch=nnn' to fetch and insert nnn rows per ODBC call (default "
+	Str(DEFAULT_BATCH) ")\n"
+	"when the driver supports arrays of rows and parameters.  Use 'batch=1'\n"
+	"with drivers that mishandle such arrays.\n\n"
 	"Use 'maxlen=nnn' to limit character strings to nnn characters (discarding\n"
 	"any excess characters).\n\n"
 	"With 'nsmix=*', columns of string data are treated as containing both\n"
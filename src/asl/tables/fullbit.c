@@ -32,6 +32,18 @@ THIS SOFTWARE.
 #include "funcadd.h"
 #include "arith.h"	/* for Arith_Kind_ASL and Long */
 
+/* Read_ampl_bit maps .bit files into memory unless compiled with */
+/* -DNo_mmap, in which case they are read with fread. */
+
+#ifndef No_mmap
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define Use_mmap
+#endif
+#endif
+
 #define TM(len) (*ae->Tempmem)(TI->TMI,len)
 
  static int Adjust_ampl_bit(AmplExports*, TableInfo*, FILE*, char*);
@@ -149,12 +161,60 @@ Tinfo {
 	char *tname;
 	char **fields;
 	char *buf;
+	char *b, *be;	/* free part of buf */
+	char *blk;	/* input block */
+	char *ib, *ibe;	/* unread part of blk */
+	char *map;	/* mapped .bit file or 0 */
+	size_t mlen, mpos;
 	FILE *f;
 	int *quoted;
 	char *s, *se;	/* scratch */
 	int nf;
 	} Tinfo;
 
+/* .tab files are read TAB_BLOCK bytes at a time, and Read_ampl_tab */
+/* passes rows to AddRows TAB_BATCH at a time. */
+
+#define TAB_BLOCK 262144
+#define TAB_BATCH 4096
+
+ static void
+bitmap(Tinfo *ti)
+{
+	/* Map the file privately, so columns can be byte-swapped in */
+	/* place and handed to AddRows without copying. */
+
+#ifdef Use_mmap
+	AmplExports *ae = ti->ae;
+	struct stat st;
+	void *v;
+	int fd;
+
+	ti->map = 0;
+	fd = fileno(ti->f);
+	if (fstat(fd, &st) || st.st_size <= 0)
+		return;
+	v = mmap(0, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+		fd, 0);
+	if (v == MAP_FAILED)
+		return;
+	ti->map = (char*)v;
+	ti->mlen = (size_t)st.st_size;
+	ti->mpos = 0;
+#else
+	ti->map = 0;
+#endif
+	}
+
+ static void
+bitunmap(Tinfo *ti)
+{
+#ifdef Use_mmap
+	if (ti->map)
+		munmap(ti->map, ti->mlen);
+#endif
+	}
+
  static int
 readerr(Tinfo *ti, char *msg)
 {
@@ -164,6 +224,7 @@ readerr(Tinfo *ti, char *msg)
 	sprintf(TI->Errmsg = (char*)TM(len + 32),
 		"Error reading file %s:\n\t%s.", ti->tname, msg);
 	fclose(ti->f);
+	bitunmap(ti);
 	return DB_Error;
 	}
 
@@ -193,43 +254,84 @@ geteol(AmplExports *ae, FILE *f, char *b, size_t blen)
 	}
 
  static void
-bgrow(char **fi, Tinfo *ti, char **bp, char **bpe)
+tabinit(Tinfo *ti)
 {
 	AmplExports *ae = ti->ae;
 	TableInfo *TI = ti->TI;
-	size_t olen = *bpe - *fi;
+
+	ti->b = ti->buf = (char*)TM(ti->buflen = 2000);
+	ti->be = ti->b + ti->buflen;
+	ti->ib = ti->ibe = ti->blk = (char*)TM(TAB_BLOCK);
+	ti->map = 0;
+	ti->line = 1;
+	}
+
+ static int
+tfill(Tinfo *ti)
+{
+	AmplExports *ae = ti->ae;
+	size_t n = fread(ti->blk, 1, TAB_BLOCK, ti->f);
+	ti->ib = ti->blk;
+	ti->ibe = ti->blk + n;
+	return n > 0;
+	}
+
+ static int
+tgetc1(Tinfo *ti)
+{
+	return tfill(ti) ? *(unsigned char*)ti->ib++ : EOF;
+	}
+
+#define tgetc(ti) ((ti)->ib < (ti)->ibe ? *(unsigned char*)(ti)->ib++ \
+			: tgetc1(ti))
+
+ static char *
+bgrow(Tinfo *ti, char *fs, size_t n)
+{
+	/* Make room for n more bytes of the field starting at fs.  */
+	/* Fields of previous rows stay where they are, since they */
+	/* may not have been passed to AddRows yet. */
+
+	AmplExports *ae = ti->ae;
+	TableInfo *TI = ti->TI;
+	size_t olen = ti->b - fs;
 	unsigned long nlen = 2*ti->buflen;
-	char *b = (char*)TM(nlen);
+	char *b;
+
+	while(nlen < olen + n)
+		nlen *= 2;
+	b = (char*)TM(nlen);
 	if (olen)
-		memcpy(b, *fi, olen);
-	*bp = b + ti->buflen;
+		memcpy(b, fs, olen);
 	ti->buflen = nlen;
-	*fi = ti->buf = b;
-	*bpe = b + nlen;
+	ti->buf = b;
+	ti->b = b + olen;
+	ti->be = b + nlen;
+	return b;
 	}
 
-#define bput(x) if (b >= be) bgrow(fi,ti,&b,&be); *b++ = x;
+#define bput(x) if (ti->b >= ti->be) fs = bgrow(ti,fs,1); *ti->b++ = x;
 
  static int
 getfields(Tinfo *ti)
 {
+	/* Fields are appended to ti->buf at ti->b; the caller resets */
+	/* ti->b = ti->buf once it is done with them. */
+
 	AmplExports *ae = ti->ae;
-	FILE *f = ti->f;
-	TableInfo *TI = ti->TI;
-	char *b, *be, **fi, **fie;
+	char *b, **fi, **fie, *fs, *s, *se, *t;
 	int c, c1, *q;
+	size_t n;
 
 	++ti->line;
-	b = ti->buf;
-	be = b + ti->buflen;
 	fi = ti->fields;
 	fie = fi + ti->nf;
 	q = ti->quoted;
 	for(;;q++) {
-		while((c = getc(f)) <= ' ') {
+		while((c = tgetc(ti)) <= ' ') {
 			if (c == EOF) {
 				if (fi == ti->fields && ti->line > 2) {
-					fclose(f);
+					fclose(ti->f);
 					return 1;
 					}
  eof:
@@ -245,43 +347,71 @@ getfields(Tinfo *ti)
 				goto ret2;
 				}
 			}
-		*fi = b;
+		fs = ti->b;
 		if (c == '\'' || c == '"') for(*q = 1;;) {
-			if ((c1 = getc(f)) == EOF)
+			/* Copy everything up to the next quote. */
+			if (ti->ib >= ti->ibe && !tfill(ti))
 				goto eof;
-			if (c == c1) {
-				if ((c1 = getc(f)) == EOF)
-					goto eof;
-				if (c1 != c) {
-					if (c1 > ' ') {
-						sprintf(b = ti->buf,
+			s = ti->ib;
+			se = (char*)memchr(s, c, ti->ibe - s);
+			n = (se ? se : ti->ibe) - s;
+			for(t = s; (t = (char*)memchr(t, '\n', s + n - t)); t++)
+				ti->line++;
+			if ((size_t)(ti->be - ti->b) <= n)
+				fs = bgrow(ti, fs, n + 1);
+			memcpy(ti->b, s, n);
+			ti->b += n;
+			ti->ib = s + n;
+			if (!se)
+				continue;
+			ti->ib++;
+			if ((c1 = tgetc(ti)) == EOF)
+				goto eof;
+			if (c1 != c) {
+				if (c1 > ' ') {
+					sprintf(b = ti->buf,
 					 "Malformed quoted string, line %ld",
-							ti->line);
-						goto ret2;
-						}
-					c = c1;
-					break;
+						ti->line);
+					goto ret2;
 					}
+				c = c1;
+				break;
 				}
-			if (c1 == '\n')
-				ti->line++;
-			bput(c1);
+			*ti->b++ = c;	/* doubled quote */
 			}
 		else {
 			*q = 0;
 			if (c == '.') {
-				if ((c = getc(f)) <= ' ') {
+				if ((c = tgetc(ti)) <= ' ') {
 					*fi = 0;
 					goto no_bput;
 					}
 				bput('.');
 				}
 			bput(c);
-			while((c = getc(f)) > ' ') {
-				bput(c);
+			/* Copy the rest of the field a block at a time. */
+			for(;;) {
+				s = ti->ib;
+				se = ti->ibe;
+				for(t = s; t < se && *(unsigned char*)t > ' '; t++);
+				n = t - s;
+				if ((size_t)(ti->be - ti->b) < n)
+					fs = bgrow(ti, fs, n);
+				memcpy(ti->b, s, n);
+				ti->b += n;
+				ti->ib = t;
+				if (t < se) {
+					c = *(unsigned char*)ti->ib++;
+					break;
+					}
+				if (!tfill(ti)) {
+					c = EOF;
+					break;
+					}
 				}
 			}
 		bput(0);
+		*fi = fs;
  no_bput:
 		if (++fi == fie)
 			break;
@@ -289,7 +419,7 @@ getfields(Tinfo *ti)
 			goto eol;
 		}
 	while(c != '\n') {
-		if ((c = getc(f)) == EOF)
+		if ((c = tgetc(ti)) == EOF)
 			goto eof;
 		if (c > ' ') {
 			sprintf(b = ti->buf, "Too many fields on line %ld",
@@ -303,6 +433,57 @@ getfields(Tinfo *ti)
 	}
 #undef bput
 
+ static real tenpow[16] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+	1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+	};
+
+ static int
+tabnum(AmplExports *ae, char *s, real *t)
+{
+	/* Returns 1 if s is a valid number and stores it in *t. */
+	/* Decimal numbers with at most 15 digits and no exponent are */
+	/* converted directly: both the digits and the power of 10 are */
+	/* exact, so one division gives the correctly rounded value. */
+	/* Everything else goes through strtod. */
+
+	char *s0 = s, *se;
+	int c, nd, nf, neg;
+	real x;
+
+	neg = 0;
+	if (*s == '-') {
+		neg = 1;
+		s++;
+		}
+	else if (*s == '+')
+		s++;
+	x = 0.;
+	nd = 0;
+	nf = -1;
+	for(;; s++) {
+		c = *s;
+		if (c >= '0' && c <= '9') {
+			x = 10.*x + (c - '0');
+			nd++;
+			if (nf >= 0)
+				nf++;
+			}
+		else if (c == '.' && nf < 0)
+			nf = 0;
+		else
+			break;
+		}
+	if (!c && nd > 0 && nd <= 15) {
+		if (nf > 0)
+			x /= tenpow[nf];
+		*t = neg ? -x : x;
+		return 1;
+		}
+	*t = strtod(s0, &se);
+	return !*se;
+	}
+
  static char **bletch;
 
  static int
@@ -357,11 +538,12 @@ permute(int n1, int n2, int *p, char **nam1, char **nam2, int *z, int *ncp)
  int
 Read_ampl_tab(AmplExports *ae, TableInfo *TI)
 {
-	DbCol *db;
+	DbCol *db, *dbe;
 	Tinfo ti;
-	char buf[64], *s, *se, *tbuf;
+	char buf[64], *s, **sv, *tbuf;
 	int a, i, j, k, nc, ncf, *p, *z;
-	real t;
+	long n;
+	real *dv;
 
 	if (!(ti.tname = tabnametab(ae,TI)))
 		return DB_Refuse;
@@ -392,8 +574,7 @@ Read_ampl_tab(AmplExports *ae, TableInfo *TI)
 	ti.quoted = (int*)(ti.fields + ti.nf);
 	p = ti.quoted + ti.nf;
 	z = p + ti.nf;
-	ti.buf = (char*)TM(ti.buflen = 2000);
-	ti.line = 1;
+	tabinit(&ti);
 	if (getfields(&ti))
 		return DB_Error;
 
@@ -418,29 +599,39 @@ Read_ampl_tab(AmplExports *ae, TableInfo *TI)
 		}
 	TI->nrows = 1;
 	nc += a;
-	db = TI->cols;
+	db = (DbCol*)TM(nc*(sizeof(DbCol)
+			+ TAB_BATCH*(sizeof(real) + sizeof(char*))));
+	dbe = db + nc;
+	dv = (real*)dbe;
+	sv = (char**)(dv + nc*TAB_BATCH);
+	for(i = 0; i < nc; i++) {
+		db[i].dval = dv + i*TAB_BATCH;
+		db[i].sval = sv + i*TAB_BATCH;
+		}
+	ti.b = ti.buf;
+	n = 0;
 	while(!(k = getfields(&ti))) {
-		for(i = 0; i < nc; i++, db++) {
+		for(i = 0; i < nc; i++) {
 			if (!(s = ti.fields[j = p[i]]))
-				db->sval[0] = TI->Missing;
+				db[i].sval[n] = TI->Missing;
 			else if (ti.quoted[j])
-				db->sval[0] = s;
-			else {
-				t = strtod(s, &se);
-				if (!*se) {/* valid number */
-					db->sval[0] = 0;
-					db->dval[0] = t;
-					}
-				else
-					db->sval[0] = s;
-				}
+				db[i].sval[n] = s;
+			else if (tabnum(ae, s, &db[i].dval[n])) /* valid number */
+				db[i].sval[n] = 0;
+			else
+				db[i].sval[n] = s;
 			}
-		db = TI->cols;
-		if ((*TI->AddRows)(TI, db, 1)) {
-			fclose(ti.f);
-			return DB_Error;
+		if (++n == TAB_BATCH) {
+			if ((*TI->AddRows)(TI, db, n)) {
+				fclose(ti.f);
+				return DB_Error;
+				}
+			n = 0;
+			ti.b = ti.buf;
 			}
 		}
+	if (k == 1 && n && (*TI->AddRows)(TI, db, n))
+		return DB_Error;
 	return k == 1 ? DB_Done : DB_Error;
 	}
 
@@ -470,10 +661,10 @@ Adjust_ampl_tab(AmplExports *ae, TableInfo *TI, FILE *f, char *tname)
 {
 	DbCol *db, *db0, *db1, *dbe;
 	Tinfo ti;
-	char *Missing, buf[64], *s, *se, **sp, **sv, **sv1, **sv2;
+	char *Missing, buf[64], *s, **sp, **sv, **sv1, **sv2;
 	int a, i, j, k, nc, ncf, nh, nn;
 	int *h, *p, *pe, *pe1, *z;
-	real *dv, *dv1, *dv2, t;
+	real *dv, *dv1, *dv2;
 
 	ti.ae = ae;
 	ti.TI = TI;
@@ -505,8 +696,7 @@ Adjust_ampl_tab(AmplExports *ae, TableInfo *TI, FILE *f, char *tname)
 	p = ti.quoted + ti.nf;
 	pe = p + k;
 	z = pe + ncf;
-	ti.buf = (char*)TM(ti.buflen = 2000);
-	ti.line = 1;
+	tabinit(&ti);
 	if (getfields(&ti))
 		return DB_Error;
 
@@ -564,22 +754,17 @@ Adjust_ampl_tab(AmplExports *ae, TableInfo *TI, FILE *f, char *tname)
 			}
 	dbe = db0 + nc;
 	Missing = TI->Missing;
+	ti.b = ti.buf;
 	while(!(k = getfields(&ti))) {
 		dv1 = 0;
 		sv1 = 0;
 		for(i = 0; i < ti.nf; i++) {
 			if (!(s = ti.fields[i]))
 				s = Missing;
-			else if (!ti.quoted[i]) {
-				t = strtod(s, &se);
-				if (!*se) {/* valid number */
-					dv[i] = t;
-					s = 0;
-					}
-				}
+			else if (!ti.quoted[i] && tabnum(ae, s, &dv[i]))
+				s = 0;	/* valid number */
 			sv[i] = s;
 			}
-		t = 0.;
 		for(i = 0; i < a; i++) {
 			j = z[i];
 			if (s = sv[i]) {
@@ -642,6 +827,7 @@ Adjust_ampl_tab(AmplExports *ae, TableInfo *TI, FILE *f, char *tname)
 			fclose(f);
 			return 0;
 			}
+		ti.b = ti.buf;
 		}
 	return k != 1;
 	}
@@ -803,62 +989,79 @@ Write_ampl_bit(AmplExports *ae, TableInfo *TI)
 	}
 
  static int
-frd(void *v, size_t vlen, Tinfo *ti, char *what)
+rderr(Tinfo *ti, char *what)
 {
 	AmplExports *ae;
 	TableInfo *TI;
 	int len;
 
 	ae = ti->ae;
-	if (fread(v, vlen, 1, ti->f) == 1)
-		return 0;
 	TI = ti->TI;
 	len = strlen(ti->tname) + strlen(what);
 	sprintf(TI->Errmsg = (char*)TM(len + 32),
 		"could not read %s from file %s.", what, ti->tname);
 	fclose(ti->f);
+	bitunmap(ti);
 	return DB_Error;
 	}
 
+ static int
+frd(void *v, size_t vlen, Tinfo *ti, char *what)
+{
+	AmplExports *ae;
+
+	ae = ti->ae;
+	if (fread(v, vlen, 1, ti->f) == 1)
+		return 0;
+	return rderr(ti, what);
+	}
+
+ static void*
+bitget(void *v, size_t vlen, Tinfo *ti, char *what)
+{
+	/* Returns the next vlen bytes of the file: a pointer into the */
+	/* mapped file if it is mapped, else v after reading them into v. */
+
+	char *s;
+
+	if (!ti->map)
+		return frd(v, vlen, ti, what) ? 0 : v;
+	if (vlen > ti->mlen - ti->mpos) {
+		rderr(ti, what);
+		return 0;
+		}
+	s = ti->map + ti->mpos;
+	ti->mpos += vlen;
+	return s;
+	}
+
+/* Byte swapping is unrolled so that compilers can vectorize it. */
+
  static void
 Lswap(Long *x, size_t L)
 {
-	char *s = (char*)x;
-	char *se = s + L;
-	char *s1, *s2;
+	unsigned char *s = (unsigned char*)x;
+	unsigned char *se = s + L;
 	int i;
 
-	while(s < se) {
-		s1 = s;
-		s2 = s + 3;
-		s = s2 + 1;
-		do {
-			i = *s1;
-			*s1++ = *s2;
-			*s2-- = i;
-			}
-			while(s1 < s2);
+	for(; s < se; s += 4) {
+		i = s[0]; s[0] = s[3]; s[3] = i;
+		i = s[1]; s[1] = s[2]; s[2] = i;
 		}
 	}
 
  static void
 rswap(real *x, size_t L)
 {
-	char *s = (char*)x;
-	char *se = s + L;
-	char *s1, *s2;
+	unsigned char *s = (unsigned char*)x;
+	unsigned char *se = s + L;
 	int i;
 
-	while(s < se) {
-		s1 = s;
-		s2 = s + 7;
-		s = s2 + 1;
-		do {
-			i = *s1;
-			*s1++ = *s2;
-			*s2-- = i;
-			}
-			while(s1 < s2);
+	for(; s < se; s += 8) {
+		i = s[0]; s[0] = s[7]; s[7] = i;
+		i = s[1]; s[1] = s[6]; s[6] = i;
+		i = s[2]; s[2] = s[5]; s[5] = i;
+		i = s[3]; s[3] = s[4]; s[4] = i;
 		}
 	}
 
@@ -879,6 +1082,7 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 	int a, bswap, i, j, je, k, nc, nr, ns, *p, rs, *z, *zs;
 	real *r, *r1, x;
 	size_t Lr, Ls, nr1;
+	void *v;
 
 	if (!(ti.tname = tabnamebit(TI)))
 		return DB_Refuse;
@@ -886,9 +1090,12 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 		return cantopen(ae,TI,ti.tname);
 	ti.ae = ae;
 	ti.TI = TI;
+	bitmap(&ti);
 
-	if (frd(&bh, sizeof(bh), &ti, "header"))
+	if (!(v = bitget(&bh, sizeof(bh), &ti, "header")))
 		return DB_Error;
+	if (v != &bh)
+		memcpy(&bh, v, sizeof(bh));
 	bswap = 0;
 	x = strtod(bh.arkind,&s);
 	if (x != Arith_Kind_ASL) {
@@ -915,10 +1122,12 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 			a + ti.nf, a + nc);
 		return readerr(&ti, buf);
 		}
-	ti.fields = (char**)TM(bh.strtablen + ti.nf*sizeof(char*));
-	s = ct = stab = (char*)(ti.fields + ti.nf);
-	if (frd(stab, bh.strtablen, &ti, "string table"))
+	ti.fields = (char**)TM((ti.map ? 0 : bh.strtablen)
+				+ ti.nf*sizeof(char*));
+	if (!(stab = (char*)bitget(ti.fields + ti.nf, bh.strtablen, &ti,
+			"string table")))
 		return DB_Error;
+	s = ct = stab;
 	while(*s++);
 	for(i = 0; i < ti.nf; i++) {
 		ti.fields[i] = s;
@@ -970,19 +1179,23 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 				ns++;
 			}
 		}
+	/* Columns of a mapped file are used where they are. */
 	nr1 = (size_t) bh.nrows;
+	r = 0;
+	sinfo = 0;
 	if (bh.nrcols) {
 		Lr = nr1 * sizeof(real);
 		if (nr < bh.nrcols)
 			nr++;	/* elbow room for omitting columns */
-		r = (real*)TM(Lr * nr);
+		if (!ti.map)
+			r = (real*)TM(Lr * nr);
 		}
 	if (bh.nscols) {
 		if (nr1 & 1)
 			nr1++;
 		Ls = nr1 * sizeof(Long);
-		sinfo = (Long*)TM(nr1*sizeof(Long));
-		sie = sinfo + bh.nrows;
+		if (!ti.map)
+			sinfo = (Long*)TM(nr1*sizeof(Long));
 		if (ns)
 			sp = (char**)TM(bh.nrows*ns*sizeof(char**));
 		}
@@ -992,18 +1205,20 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 		r1 = 0;
 		sp1 = 0;
 		if (rs & 1) {
-			if (frd(r1 = r, Lr, &ti, "real data"))
+			if (!(r1 = (real*)bitget(r, Lr, &ti, "real data")))
 				return DB_Error;
-			if (bswap)
+			if (bswap && j < je)
 				rswap(r1, Lr);
 			}
 		if (rs & 2) {
-			if (frd(si = sinfo, Ls, &ti, "symbol pointers"))
+			if (!(si = (Long*)bitget(sinfo, Ls, &ti,
+					"symbol pointers")))
 				return DB_Error;
 			if (j >= je)
 				continue;
 			if (bswap)
 				Lswap(si, Ls);
+			sie = si + bh.nrows;
 			sp1 = sp;
 			while(si < sie)
 				switch(*si++) {
@@ -1018,7 +1233,7 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 					while(*s++);
 				 }
 			}
-		if (r1 && j < je)
+		if (r1 && r1 == r && j < je)
 			r += bh.nrows;
 		while(j < je) {
 			db = TI->cols + z[j++];
@@ -1030,9 +1245,9 @@ Read_ampl_bit(AmplExports *ae, TableInfo *TI)
 		}
  done:
 	fclose(ti.f);
-	if ((*TI->AddRows)(TI, TI->cols, bh.nrows))
-		return DB_Error;
-	return DB_Done;
+	k = (*TI->AddRows)(TI, TI->cols, bh.nrows);
+	bitunmap(&ti);
+	return k ? DB_Error : DB_Done;
 	}
 
  static int
@@ -1054,6 +1269,7 @@ Adjust_ampl_bit(AmplExports*ae, TableInfo *TI, FILE *f, char *tname)
 	ti.TI = TI;
 	ti.tname = tname;
 	ti.f = f;
+	ti.map = 0;
 
 	if (frd(&bh, sizeof(bh), &ti, "header"))
 		return DB_Error;
@@ -42,6 +42,9 @@ of or in connection with the use or performance of this software.
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#if defined(__linux__) && !defined(F_SETPIPE_SZ)
+#define F_SETPIPE_SZ 1031
+#endif
 #ifdef STAND_ALONE /*{{*/
 #include "asl.h"
 #include "avltree.h"
@@ -116,12 +119,18 @@ TP_Head {
 	/* To return an error, we set the TPx_Error bit in job and return	*/
 	/* the error message as the one string value (the whole stable).	*/
 
+	/* In a read request, nrcols != 0 asks for compressed replies.  A	*/
+	/* compressed reply has the TPx_Compress bit set in job; its tablen	*/
+	/* bytes are the Uint length of the uncompressed tables followed by	*/
+	/* the tables compressed by tpz_pack.  Proxies that do not know	*/
+	/* about compression ignore nrcols and send uncompressed replies.	*/
+
 	} TP_Head;
 
 /* values for TP_Head.job */
 
 enum { TPx_Read = 0, TPx_Write = 1, TPx_Done = 2, TPx_Error = 4,
-	TPx_quit = 5, TPx_status = 6 };
+	TPx_quit = 5, TPx_status = 6, TPx_Compress = 8 };
 /*  } end of tableproxy.h */
 
  typedef struct ProxProg ProxProg;
@@ -144,6 +153,7 @@ ProxProg {
 	int remote;
 	int rowchunk;
 	int verbose;
+	int compress;	/* ask for compressed read replies */
 	};
 
  struct
@@ -372,6 +382,122 @@ H_init(TP_Head *H, int job, TableInfo *TI)
 		}
 	}
 
+/* LZ77 compression of read replies in the LZ4 block format: sequences of a */
+/* token (high nibble = literal count, low nibble = match length - 4, 15 */
+/* meaning more length bytes follow), the literals, and a 2-byte little- */
+/* endian match offset; the final sequence has only literals. */
+
+ typedef unsigned char UChar;
+
+ enum { TPZ_hbits = 12, TPZ_minmatch = 4, TPZ_maxoff = 65535 };
+
+#define TPZ_bound(n) ((n) + (n)/255 + 16)
+
+ static UChar *
+tpz_len(UChar *op, size_t L)
+{
+	for(; L >= 255; L -= 255)
+		*op++ = 255;
+	*op++ = (UChar)L;
+	return op;
+	}
+
+ static UChar *
+tpz_lit(UChar *op, const UChar *s, size_t L)
+{
+	*op++ = (UChar)((L >= 15 ? 15 : L) << 4);
+	if (L >= 15)
+		op = tpz_len(op, L - 15);
+	memcpy(op, s, L);
+	return op + L;
+	}
+
+ static size_t
+tpz_pack(const UChar *in, size_t n, UChar *out)
+{
+	Uint h, ht[1 << TPZ_hbits], v;
+	UChar *op, *t;
+	const UChar *a, *ie, *il, *ip, *m, *r;
+	size_t L, off;
+
+	memset(ht, 0, sizeof(ht));
+	op = out;
+	a = ip = in;
+	ie = in + n;
+	il = n > 12 ? ie - 12 : in;	/* no match starts in the last 12 bytes */
+	while(ip < il) {
+		memcpy(&v, ip, 4);
+		h = (v * 2654435761U) >> (32 - TPZ_hbits);
+		r = in + ht[h];
+		ht[h] = (Uint)(ip - in);
+		if (r >= ip || ip - r > TPZ_maxoff || memcmp(r, ip, 4)) {
+			++ip;
+			continue;
+			}
+		off = ip - r;
+		for(m = ip + 4, r += 4; m < ie - 5 && *m == *r; ++m, ++r);
+		t = op;
+		op = tpz_lit(op, a, ip - a);
+		*op++ = (UChar)off;
+		*op++ = (UChar)(off >> 8);
+		if ((L = m - ip - TPZ_minmatch) >= 15) {
+			*t |= 15;
+			op = tpz_len(op, L - 15);
+			}
+		else
+			*t |= (UChar)L;
+		a = ip = m;
+		}
+	return tpz_lit(op, a, ie - a) - out;
+	}
+
+ static int
+tpz_unpack(const UChar *in, size_t n, UChar *out, size_t olen)
+{
+	/* return 0 if in[0:n] expands to exactly out[0:olen] */
+	UChar *oe, *op;
+	const UChar *ie, *r;
+	size_t L, off;
+	int c, t;
+
+	ie = in + n;
+	op = out;
+	oe = out + olen;
+	for(;;) {
+		if (in >= ie)
+			return 1;
+		t = *in++;
+		if ((L = t >> 4) == 15)
+			do {
+				if (in >= ie)
+					return 1;
+				L += c = *in++;
+				} while(c == 255);
+		if (L > (size_t)(ie - in) || L > (size_t)(oe - op))
+			return 1;
+		memcpy(op, in, L);
+		op += L;
+		if ((in += L) == ie)
+			return op != oe;
+		if (ie - in < 2)
+			return 1;
+		off = in[0] | in[1] << 8;
+		in += 2;
+		if (!off || off > (size_t)(op - out))
+			return 1;
+		if ((L = t & 15) == 15)
+			do {
+				if (in >= ie)
+					return 1;
+				L += c = *in++;
+				} while(c == 255);
+		if ((L += TPZ_minmatch) > (size_t)(oe - op))
+			return 1;
+		for(r = op - off; L > 0; --L)
+			*op++ = *r++;
+		}
+	}
+
 #ifndef STAND_ALONE /*{{*/
 
  static ProxProg *
@@ -438,14 +564,14 @@ Malloc3(AmplExports *ae, TableInfo *TI, size_t L, cchar *where)
 #ifdef _WIN32 /*{{*/
 #define PathName "Path"
  static int
-pipe(TableInfo *TI, HANDLE *fd)
+pipe(TableInfo *TI, HANDLE *fd, int wlen)
 {
 	SECURITY_ATTRIBUTES S;
 
 	S.nLength = sizeof(S);
 	S.lpSecurityDescriptor = 0;
 	S.bInheritHandle = FALSE;
-	if (CreatePipe(fd,fd+1,&S,4096))
+	if (CreatePipe(fd,fd+1,&S,wlen > 4096 ? wlen : 4096))
 		return 0;
 	TI->Errmsg = "CreatePipe failed!";
 	return 1;
@@ -626,7 +752,7 @@ findprog(AmplExports *ae, char *prog, char *b, size_t buflen)
 	}
 
  static int
-get_sd(AmplExports *ae, TableInfo *TI, char *ipstr, int port, int proto)
+get_sd(AmplExports *ae, TableInfo *TI, char *ipstr, int port, int proto, int wlen)
 {
 	int rc, sd;
 	size_t L;
@@ -646,6 +772,9 @@ get_sd(AmplExports *ae, TableInfo *TI, char *ipstr, int port, int proto)
 		TI->Errmsg = "socket(PF_INET,...) failed.";
 		goto ret;
 		}
+	/* Set before connecting so the TCP window can be scaled to match. */
+	if (wlen > 0)
+		setsockopt(sd, SOL_SOCKET, SO_RCVBUF, (char*)&wlen, sizeof(wlen));
 	memcpy(&sab.sin_addr, ptrh->h_addr, ptrh->h_length);
 	if (connect(sd, (struct sockaddr *) &sab, sizeof(sab)) < 0) {
 		L = strlen(ipstr);
@@ -659,7 +788,7 @@ get_sd(AmplExports *ae, TableInfo *TI, char *ipstr, int port, int proto)
 	}
 
  static ProxProg*
-startremote(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *ipstr)
+startremote(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *ipstr, int wlen)
 {
 	ProxProg *pp;
 	char buf[256], *s, *se;
@@ -698,7 +827,7 @@ startremote(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *ipstr)
 		PI->proto = ptrp->p_proto;
 		PI->remotestarted = 1;
 		}
-	if ((sd = get_sd(ae, TI, ipstr, port, PI->proto)) < 0)
+	if ((sd = get_sd(ae, TI, ipstr, port, PI->proto, wlen)) < 0)
 		return 0;
 	pp = new_PP(ae, PI, TI, ipstr, port);
 	pp->fr = pp->fw = sd;
@@ -709,7 +838,7 @@ startremote(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *ipstr)
 	}
 
  static ProxProg*
-startprog(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *prog)
+startprog(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *prog, int wlen)
 {
 	ProxProg *pp;
 	char *av[3], buf[4096], **ep, *p;
@@ -760,12 +889,12 @@ startprog(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *prog)
 		free(cmdline);
 		return 0;
 		}
-	if (pipe(TI, fd0)) {
+	if (pipe(TI, fd0, wlen)) {
  free_e:
 		free(env);
 		goto free_cl;
 		}
-	if (pipe(TI, fd1)) {
+	if (pipe(TI, fd1, wlen)) {
 		CloseHandle(fd0[0]);
 		CloseHandle(fd0[1]);
 		goto free_e;
@@ -825,6 +954,14 @@ startprog(AmplExports *ae, TableInfo *TI, ProxyInfo *PI, char *prog)
 		}
 	close(fd0[1]);
 	close(fd1[0]);
+#ifdef F_SETPIPE_SZ
+	/* Ask for pipes holding wlen bytes, or as much as we are allowed. */
+	for(; wlen > 65536; wlen >>= 1)
+		if (fcntl(fd0[0], F_SETPIPE_SZ, wlen) >= 0) {
+			fcntl(fd1[1], F_SETPIPE_SZ, wlen);
+			break;
+			}
+#endif
 	pp = new_PP(ae, PI, TI, prog, 0);
 	pp->fr = fd0[0];
 	pp->fw = fd1[1];
@@ -840,7 +977,8 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 	ProxProg *p;
 	ProxyInfo *PI;
 	char *hname, *ip, *lib, *prog, *s, *s1, *se, **strs, **strs0, **strse, *verb;
-	int i, rowchunk, sd, verbose;
+	double w;
+	int compress, i, rowchunk, sd, verbose, window, wlen;
 
 	strs = TI->strings;
 	strse = strs + TI->nstrings;
@@ -849,7 +987,8 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 	strs0 = strs;
 	ip = lib = prog = verb = 0;
 	rowchunk = 512;
-	verbose = 0;
+	compress = verbose = 0;
+	window = -1;
 	hname = 0;
 	if (++strs >= strse) {
 		TI->Errmsg = "Two few strings before \":[...]\"; for more on the strings,\n"
@@ -870,6 +1009,13 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 			}
 		++s1;
 		switch(*s) {
+		 case 'c':
+			if (strncmp(s,"compress=",9))
+				goto badv;
+			compress = (int)strtol(s1,&se,10);
+			if (se <= s1 || *se)
+				goto badv;
+			continue;
 		 case 'I':
 			if (strncmp(s,"IP=",3)) {
  badv:
@@ -930,20 +1076,35 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 			if (se <= s1)
 				goto badv;
 			continue;
+		 case 'w':
+			if (strncmp(s,"window=",7))
+				goto badv;
+			window = (int)strtol(s1,&se,10);
+			if (window < 0 || *se)
+				goto badv;
+			continue;
 		 default: goto badv;
 		 }
 		}
  break2:
+	/* Buffer enough for the proxy to run about window chunks ahead, */
+	/* assuming 16 bytes per table entry.  By default, enlarge pipes */
+	/* for 4 chunks but leave socket buffers to the system. */
+	w = 16. * (window < 0 ? 4 : window) * rowchunk
+		* (TI->ncols + TI->arity) + sizeof(TP_Head);
+	wlen = w < (1 << 24) ? (int)w : 1 << 24;
+	if (!window || (ip && window < 0))
+		wlen = 0;
 	if (ip) {
 		for(p = PI->remote; p; p = p->prnext) {
 			if (!strcmp(ip, p->name)) {
-				if ((sd = get_sd(ae, TI, p->name, p->port, p->proto)) < 0)
+				if ((sd = get_sd(ae, TI, p->name, p->port, p->proto, wlen)) < 0)
 					return DB_Error;
 				p->fr = p->fw = sd;
 				goto found;
 				}
 			}
-		if ((p = startremote(ae, TI, PI, ip)))
+		if ((p = startremote(ae, TI, PI, ip, wlen)))
 			goto found;
 		return DB_Error;
 		}
@@ -953,7 +1114,7 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 		if (!strcmp(prog, p->name))
 			goto found;
 		}
-	if (!(p = startprog(ae, TI, PI, prog)))
+	if (!(p = startprog(ae, TI, PI, prog, wlen)))
 		return DB_Error;
  found:
 	*pp = p;
@@ -964,6 +1125,7 @@ hsetup(AmplExports *ae, TableInfo *TI, ProxyInfo **pPI, ProxProg **pp, int *nsu)
 	*nsu = strs - strs0;
 	p->rowchunk = rowchunk;
 	p->verbose = verbose;
+	p->compress = compress;
 	p->hname = hname;
 	return 0;
 	}
@@ -1002,14 +1164,17 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
 	ProxyInfo *PI;
 	ProxProg *p;
 	TP_Head *H, H0;
-	Uint Lt, i, is, *itab, *itst0, j, nitab, nr, stlen, *z;
-	char *s, *stab, **strs, **sv, **sv0, *x[2];
+	Uint Lt, Lu, i, is, *itab, *itst0, j, nitab, nr, stlen, *z;
+	char *s, *stab, **strs, **sv, **sv0, *x[2], *zb;
 	int k, nc, nc1, nstr, nsu, rc;
 	real *rtab, *rtab0;
-	size_t L, Ls;
+	size_t L, Lb, Ls, Lz;
 
 	if ((rc = hsetup(ae,TI,&PI,&p,&nsu)))
 		return rc;
+	dbc0 = 0;
+	zb = 0;
+	Lb = Lz = 0;
 	nstr = TI->nstrings - nsu;
 	strs = TI->strings + nsu;
 	nc = TI->ncols;
@@ -1027,6 +1192,7 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
 	H->tablen = stlen;
 	H->nstrings = nstr;
 	H->nrows = p->rowchunk;
+	H->nrcols = p->compress;
 	s = stab = (char*)(H+1);
 	s = strcpe(s, p->hname);
 	s = strcpe(s, TI->tname);
@@ -1064,13 +1230,41 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
 	Ls = 0;
 	if (H0.nscols)
 		Ls = (nr * H0.nscols * sizeof(char*) + sizeof(real) - 1) & ~(sizeof(real) - 1);
-	if (!(dbc0 = (DbCol*)Malloc3(ae,TI, L + Ls + H0.tablen,"Read_ampl_proxy read alloc")))
-		goto ret;
+	Lu = Lt = H0.tablen;
+	if (H0.job & TPx_Compress) {
+		if (Lt < sizeof(Uint)) {
+ badz:
+			TI->Errmsg = "Bad compressed reply in Read_ampl_proxy.";
+			goto ret;
+			}
+		if (Lt > Lz) {
+			free(zb);
+			Lz = 0;
+			if (!(zb = (char*)Malloc3(ae,TI,Lt,"Read_ampl_proxy read alloc")))
+				goto ret;
+			Lz = Lt;
+			}
+		if (p->read(p, zb, Lt) < 0)
+			goto badread;
+		memcpy(&Lu, zb, sizeof(Uint));
+		}
+	/* Reuse the buffer for subsequent chunks when it is large enough. */
+	if (L + Ls + Lu > Lb) {
+		free(dbc0);
+		Lb = 0;
+		if (!(dbc0 = (DbCol*)Malloc3(ae,TI, L + Ls + Lu,"Read_ampl_proxy read alloc")))
+			goto ret;
+		Lb = L + Ls + Lu;
+		}
 	dbc = dbc0;
 	sv0 = (char**)(dbc + nc1);
 	rtab = (real*)((char*)sv0 + Ls);
-	if (p->read(p, rtab, H0.tablen) < 0) {
-		free(dbc0);
+	if (H0.job & TPx_Compress) {
+		if (tpz_unpack((UChar*)zb + sizeof(Uint), Lt - sizeof(Uint), (UChar*)rtab, Lu))
+			goto badz;
+		}
+	else if (p->read(p, rtab, Lt) < 0) {
+ badread:
 		TI->Errmsg = "2nd read in Read_ampl_proxy failed.";
 		goto ret;
 		}
@@ -1080,10 +1274,8 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
 		s = stab + itab[nitab];
 		if (*s)
 			printf("%s", s);
-		if (!nr) {
-			free(dbc0);
+		if (!nr)
 			goto done;
-			}
 		}
 	itst0 = itab + 2*nc1 - nr;
 	irp = (IRpair*)itab;
@@ -1105,7 +1297,6 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
 			}
 		}
 	TI->AddRows(TI, dbc0, nr);
-	free(dbc0);
 	if (!(H0.job & TPx_Done))
 		goto readmore;
 	if (TI->Errmsg) {
@@ -1115,6 +1306,8 @@ Read_ampl_proxy(AmplExports *ae, TableInfo *TI)
  done:
 	rc = DB_Done;
  ret:
+	free(zb);
+	free(dbc0);
 	if (p->port > 0)
 		CloseSocket(p->fr);
 	return rc;
@@ -1259,6 +1452,8 @@ funcadd(AmplExports *ae)
 	"	'prog=...'\n"
 	"	'hname=...'\n"
 	"	'rowchunk=mmm'\n"
+	"	'window=www'\n"
+	"	'compress=1'\n"
 	"	'lib=...'\n\n"
 	"At most one of 'prog=...' and 'ip=...' may appear.\n"
 	"The ... in \"prog=...\" is the desired local program\n"
@@ -1270,6 +1465,12 @@ funcadd(AmplExports *ae)
 	"handler (i.e., the ... following Connection).\n"
 	"For reading tables, the mmm in 'rowchunk=mmm' is the maximum number of rows for\n"
 	"the remote proxy to cache before sending them to the local proxy (default 512).\n"
+	"The www in 'window=www' is roughly how many such chunks the remote proxy may\n"
+	"send before the local proxy has consumed them; it sizes the pipe or socket\n"
+	"buffers (default 4 for pipes; system defaults for sockets; 0 = system defaults).\n"
+	"Pipes are sized when the proxy program starts.\n"
+	"With 'compress=1', the remote proxy compresses the chunks it sends, which helps\n"
+	"on slow networks; proxies older than version 20150701 ignore this request.\n"
 	"The ... in \"lib=...\" is a shared library in which the remote proxy should\n"
 	"look for a suitable handler.  If neither 'ip=' nor 'prog=' appears,\n"
 	"'prog=tableproxy" Bits "' is assumed.";
@@ -1453,6 +1654,7 @@ THelp {
 	int ndcols, nscols;
 	int ntcols;		/* total number of cols: TI->ncols + TI->arity */
 	int needswap;
+	int compress;		/* compress read replies */
 	} THelp;
 
  typedef union {
@@ -2009,6 +2211,32 @@ sbcopy(THelp *th, Tcache *tc, long j, char *s)
 	th->slen += L;
 	}
 
+ static TP_Head*
+tpz_compress(THelp *th, TP_Head *H)
+{
+	TP_Head *Hz;
+	Uint Lu;
+	size_t L, Lz;
+
+	if ((L = H->tablen) < 256)
+		return H;
+	Hz = (TP_Head*)Malloc(sizeof(TP_Head) + sizeof(Uint) + TPZ_bound(L));
+	Lz = tpz_pack((UChar*)(H+1), L, (UChar*)(Hz+1) + sizeof(Uint));
+	if (Lz + sizeof(Uint) >= L) {
+		free(Hz);
+		return H;
+		}
+	memcpy(Hz, H, sizeof(TP_Head));
+	Hz->job |= TPx_Compress;
+	Hz->tablen = Lz + sizeof(Uint);
+	Lu = L;
+	if (th->needswap)
+		swap(&Lu, sizeof(Uint), 1);
+	memcpy(Hz+1, &Lu, sizeof(Uint));
+	free(H);
+	return Hz;
+	}
+
  static int
 rtab_send(THelp *th, TableInfo *TI, int flags)
 {
@@ -2135,14 +2363,17 @@ rtab_send(THelp *th, TableInfo *TI, int flags)
 		}
 	H->arith = th->tph.arith;
 	H->tablen = L;
-	L += sizeof(TP_Head);
 	if (th->needswap) {
 		if (r0)
 			swap(r0, sizeof(real), H->nrtab);
 		if (cd0)
 			swap(cd0, sizeof(Uint), H->nitab);
-		swap(&H->job, sizeof(Uint), TPH_n_Uint);
 		}
+	if (th->compress && H->nrows)
+		H = tpz_compress(th, H);
+	L = H->tablen + sizeof(TP_Head);
+	if (th->needswap)
+		swap(&H->job, sizeof(Uint), TPH_n_Uint);
 	P = th->P;
 	rc = 0;
 	if (P->write(P, H, L) != L) {
@@ -3215,6 +3446,7 @@ main(int argc, char **argv, char **arge)
 			break;
 		if ((th.needswap = th.tph.arith != Arith_Kind_ASL))
 			swap(&th.tph.job, sizeof(Uint), TPH_n_Uint);
+		th.compress = th.tph.job == TPx_Read && th.tph.nrcols;
 		switch(th.tph.job) {
 		  case TPx_Read:
 		  case TPx_Write:
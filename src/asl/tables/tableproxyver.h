@@ -1 +1 @@
-#define TableProxyVersion "20140525"
+#define TableProxyVersion "20150701"
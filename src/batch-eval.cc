@@ -0,0 +1,127 @@
+/*
+ Vectorized evaluation of expressions at many points
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/batch-eval.h"
+
+#include <algorithm>
+
+#define MP_BATCH_NAMESPACE generic
+#include "batch-kernel-inl.h"
+
+namespace {
+
+bool CPUSupports(mp::BatchEvaluator::InstructionSet isa) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  switch (isa) {
+  case mp::BatchEvaluator::AVX2:
+    return __builtin_cpu_supports("avx2") != 0;
+  case mp::BatchEvaluator::AVX512:
+    return __builtin_cpu_supports("avx512f") != 0;
+  default:
+    break;
+  }
+#endif
+  return isa == mp::BatchEvaluator::GENERIC;
+}
+}
+
+bool mp::BatchEvaluator::IsSupported(InstructionSet isa) {
+  switch (isa) {
+  case AUTO: case GENERIC:
+    return true;
+  case AVX2:
+#ifdef MP_BATCH_AVX2
+    return CPUSupports(isa);
+#else
+    return false;
+#endif
+  case AVX512:
+#ifdef MP_BATCH_AVX512
+    return CPUSupports(isa);
+#else
+    return false;
+#endif
+  }
+  return false;
+}
+
+mp::BatchEvaluator::BatchEvaluator(const Tape &tape, InstructionSet isa)
+  : tape_(tape), isa_(isa), kernel_(internal::generic::EvaluateBatch),
+    registers_(std::max(tape.num_registers(), 1) * BLOCK_SIZE) {
+  if (isa == AUTO)
+    isa_ = IsSupported(AVX512) ? AVX512 : IsSupported(AVX2) ? AVX2 : GENERIC;
+  else if (!IsSupported(isa))
+    throw Error("instruction set is not supported");
+  switch (isa_) {
+#ifdef MP_BATCH_AVX2
+  case AVX2:
+    kernel_ = internal::avx2::EvaluateBatch;
+    break;
+#endif
+#ifdef MP_BATCH_AVX512
+  case AVX512:
+    kernel_ = internal::avx512::EvaluateBatch;
+    break;
+#endif
+  default:
+    break;
+  }
+  for (int i = 0, n = tape.num_consts(); i < n; ++i) {
+    double *reg = &registers_[(tape.num_vars() + i) * BLOCK_SIZE];
+    std::fill(reg, reg + BLOCK_SIZE, tape.constant(i));
+  }
+}
+
+void mp::BatchEvaluator::Evaluate(int num_points, const double *x,
+                                  double *con_values, double *obj_values) {
+  internal::BatchTape t = {
+    &tape_, tape_.num_instructions() != 0 ? &tape_.instruction(0) : 0,
+    tape_.num_instructions(), tape_.first_result(),
+    tape_.args(), tape_.data()
+  };
+  int num_vars = tape_.num_vars();
+  int num_objs = tape_.num_objs(), num_cons = tape_.num_cons();
+  double *r = &registers_[0];
+  for (int first = 0; first < num_points; first += BLOCK_SIZE) {
+    int n = std::min(num_points - first, static_cast<int>(BLOCK_SIZE));
+    for (int j = 0; j < num_vars; ++j) {
+      const double *values = x + static_cast<std::size_t>(j) * num_points;
+      std::copy(values + first, values + first + n, r + j * BLOCK_SIZE);
+    }
+    kernel_(t, r, BLOCK_SIZE, n);
+    for (int i = 0; i < num_cons; ++i) {
+      const double *reg = r + tape_.con_register(i) * BLOCK_SIZE;
+      double *out = con_values + static_cast<std::size_t>(first) * num_cons;
+      for (int p = 0; p < n; ++p)
+        out[p * num_cons + i] = reg[p];
+    }
+    if (!obj_values)
+      continue;
+    for (int i = 0; i < num_objs; ++i) {
+      const double *reg = r + tape_.obj_register(i) * BLOCK_SIZE;
+      double *out = obj_values + static_cast<std::size_t>(first) * num_objs;
+      for (int p = 0; p < n; ++p)
+        out[p * num_objs + i] = reg[p];
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/*
+ Batch evaluation kernel
+
+ This file is included by translation units compiled for different
+ instruction sets with MP_BATCH_NAMESPACE defined to the namespace
+ the kernel is placed in.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <cmath>
+
+#include "batch-kernel.h"
+
+#ifndef MP_BATCH_NAMESPACE
+# error MP_BATCH_NAMESPACE is not defined
+#endif
+
+// Loops over points below are simple enough to be vectorized by the
+// compiler for the instruction set this file is compiled for. Operations
+// without a vectorizable form such as exp are still called in a tight
+// loop over points.
+
+#define MP_UNARY(expression) { \
+  const double *a = r + instr.arg1 * stride; \
+  for (int p = 0; p < n; ++p) { \
+    double x = a[p]; \
+    result[p] = expression; \
+  } \
+  break; \
+}
+
+#define MP_BINARY(expression) { \
+  const double *a = r + instr.arg1 * stride; \
+  const double *b = r + instr.arg2 * stride; \
+  for (int p = 0; p < n; ++p) { \
+    double x = a[p], y = b[p]; \
+    result[p] = expression; \
+  } \
+  break; \
+}
+
+// Initializes the result with init and combines it with each operand.
+#define MP_ITERATED(init, expression) { \
+  for (int p = 0; p < n; ++p) \
+    result[p] = init; \
+  for (const int *arg = args + instr.arg1, \
+       *end = arg + instr.arg2; arg != end; ++arg) { \
+    const double *a = r + *arg * stride; \
+    for (int p = 0; p < n; ++p) { \
+      double value = result[p], x = a[p]; \
+      result[p] = expression; \
+    } \
+  } \
+  break; \
+}
+
+namespace mp {
+namespace internal {
+namespace MP_BATCH_NAMESPACE {
+
+void EvaluateBatch(const BatchTape &t, double *r,
+                   std::size_t stride, int n) {
+  const int *args = t.args;
+  for (int i = 0; i < t.num_instrs; ++i) {
+    const Tape::Instruction &instr = t.instrs[i];
+    double *result = r + (t.first_result + i) * stride;
+    switch (instr.opcode) {
+    case expr::MINUS: MP_UNARY(-x)
+    case expr::ABS:   MP_UNARY(std::fabs(x))
+    case expr::FLOOR: MP_UNARY(std::floor(x))
+    case expr::CEIL:  MP_UNARY(std::ceil(x))
+    case expr::SQRT:  MP_UNARY(std::sqrt(x))
+    case expr::POW2:  MP_UNARY(x * x)
+    case expr::EXP:   MP_UNARY(std::exp(x))
+    case expr::LOG:   MP_UNARY(std::log(x))
+    case expr::SIN:   MP_UNARY(std::sin(x))
+    case expr::COS:   MP_UNARY(std::cos(x))
+    case expr::TANH:  MP_UNARY(std::tanh(x))
+    case expr::ATAN:  MP_UNARY(std::atan(x))
+    case expr::ADD:   MP_BINARY(x + y)
+    case expr::SUB:   MP_BINARY(x - y)
+    case expr::LESS:  MP_BINARY(x - y < 0 ? 0.0 : x - y)
+    case expr::MUL:   MP_BINARY(x * y)
+    case expr::DIV:   MP_BINARY(x / y)
+    case expr::POW: case expr::POW_CONST_BASE: case expr::POW_CONST_EXP:
+      MP_BINARY(std::pow(x, y))
+    case expr::IF: case expr::IMPLICATION: {
+      const double *c = r + instr.arg1 * stride;
+      const double *a = r + instr.arg2 * stride;
+      const double *b = r + instr.arg3 * stride;
+      for (int p = 0; p < n; ++p)
+        result[p] = c[p] != 0 ? a[p] : b[p];
+      break;
+    }
+    case expr::MIN: {
+      const double *a = r + args[instr.arg1] * stride;
+      for (int p = 0; p < n; ++p)
+        result[p] = a[p];
+      for (const int *arg = args + instr.arg1 + 1,
+           *end = args + instr.arg1 + instr.arg2; arg != end; ++arg) {
+        a = r + *arg * stride;
+        for (int p = 0; p < n; ++p)
+          result[p] = a[p] < result[p] ? a[p] : result[p];
+      }
+      break;
+    }
+    case expr::MAX: {
+      const double *a = r + args[instr.arg1] * stride;
+      for (int p = 0; p < n; ++p)
+        result[p] = a[p];
+      for (const int *arg = args + instr.arg1 + 1,
+           *end = args + instr.arg1 + instr.arg2; arg != end; ++arg) {
+        a = r + *arg * stride;
+        for (int p = 0; p < n; ++p)
+          result[p] = result[p] < a[p] ? a[p] : result[p];
+      }
+      break;
+    }
+    case expr::SUM:    MP_ITERATED(0, value + x)
+    case expr::COUNT:  MP_ITERATED(0, value + (x != 0))
+    case expr::EXISTS: MP_ITERATED(0, (value != 0) | (x != 0))
+    case expr::FORALL: MP_ITERATED(1, (value != 0) & (x != 0))
+    case Tape::LINEAR: {
+      for (int p = 0; p < n; ++p)
+        result[p] = 0;
+      const double *coef = t.data + instr.arg3;
+      for (const int *arg = args + instr.arg1,
+           *end = arg + instr.arg2; arg != end; ++arg, ++coef) {
+        const double *a = r + *arg * stride;
+        double c = *coef;
+        for (int p = 0; p < n; ++p)
+          result[p] += c * a[p];
+      }
+      break;
+    }
+    case expr::NOT: MP_UNARY(x == 0)
+    case expr::OR:  MP_BINARY((x != 0) | (y != 0))
+    case expr::AND: MP_BINARY((x != 0) & (y != 0))
+    case expr::IFF: MP_BINARY((x != 0) == (y != 0))
+    case expr::LT: case expr::NOT_ATMOST:  MP_BINARY(x < y)
+    case expr::LE: case expr::ATLEAST:     MP_BINARY(x <= y)
+    case expr::EQ: case expr::EXACTLY:     MP_BINARY(x == y)
+    case expr::GE: case expr::ATMOST:      MP_BINARY(x >= y)
+    case expr::GT: case expr::NOT_ATLEAST: MP_BINARY(x > y)
+    case expr::NE: case expr::NOT_EXACTLY: MP_BINARY(x != y)
+    default:
+      EvaluateStrided(*t.tape, i, r, stride, n);
+      break;
+    }
+  }
+}
+}  // namespace MP_BATCH_NAMESPACE
+}  // namespace internal
+}  // namespace mp
+
+#undef MP_UNARY
+#undef MP_BINARY
+#undef MP_ITERATED
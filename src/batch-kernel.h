@@ -0,0 +1,68 @@
+/*
+ Batch evaluation kernels
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_BATCH_KERNEL_H_
+#define MP_BATCH_KERNEL_H_
+
+#include <cstddef>
+
+#include "mp/tape.h"
+
+namespace mp {
+namespace internal {
+
+// A tape in the form accessible to batch evaluation kernels. Kernels are
+// compiled for different instruction sets, so they only access plain data
+// and don't call inline functions which could be shared with other
+// translation units.
+struct BatchTape {
+  const Tape *tape;
+  const Tape::Instruction *instrs;
+  int num_instrs;
+  int first_result;
+  const int *args;
+  const double *data;
+};
+
+// Executes the instruction with the specified index at num_points points
+// without vectorization. Register reg at point p is r[reg * stride + p].
+void EvaluateStrided(const Tape &t, int index, double *r,
+                     std::size_t stride, int num_points);
+
+// Kernels executing all instructions of a tape at num_points points.
+// Register reg at point p is r[reg * stride + p].
+namespace generic {
+void EvaluateBatch(const BatchTape &t, double *r,
+                   std::size_t stride, int num_points);
+}
+namespace avx2 {
+void EvaluateBatch(const BatchTape &t, double *r,
+                   std::size_t stride, int num_points);
+}
+namespace avx512 {
+void EvaluateBatch(const BatchTape &t, double *r,
+                   std::size_t stride, int num_points);
+}
+}  // namespace internal
+}  // namespace mp
+
+#endif  // MP_BATCH_KERNEL_H_
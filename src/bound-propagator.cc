@@ -0,0 +1,1000 @@
+/*
+ Interval evaluation of expressions and feasibility-based bound tightening
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/bound-propagator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+const double PI = 3.14159265358979323846;
+
+// Tolerance used when rounding bounds on integer variables.
+const double INT_TOLERANCE = 1e-6;
+
+// Returns true if a logical expression with the value a is known to be
+// true or false respectively.
+inline bool IsTrue(mp::Interval a) { return a.lb > 0; }
+inline bool IsFalse(mp::Interval a) { return a.ub <= 0; }
+
+inline double Scale(double x) { return std::max(std::fabs(x), 1.0); }
+
+// Returns the value of a piecewise-linear term at x. The term is zero
+// at 0.
+double EvalPLTerm(mp::PLTerm e, double x) {
+  int num_breakpoints = e.num_breakpoints();
+  if (x == INF || x == -INF) {
+    double slope = e.slope(x > 0 ? num_breakpoints : 0);
+    if (slope != 0)
+      return slope > 0 ? x : -x;
+    if (num_breakpoints == 0)
+      return 0;
+    x = x > 0 ? std::max(e.breakpoint(num_breakpoints - 1), 0.0) :
+                std::min(e.breakpoint(0), 0.0);
+  }
+  double result = 0;
+  if (x >= 0) {
+    // Sum the slopes of segments on [0, x].
+    double lb = 0;
+    int i = 0;
+    for (; i < num_breakpoints && e.breakpoint(i) <= 0; ++i) ;
+    for (; i < num_breakpoints; ++i) {
+      double breakpoint = e.breakpoint(i);
+      if (x <= breakpoint)
+        return result + e.slope(i) * (x - lb);
+      result += e.slope(i) * (breakpoint - lb);
+      lb = breakpoint;
+    }
+    return result + e.slope(num_breakpoints) * (x - lb);
+  }
+  // Sum the slopes of segments on [x, 0].
+  double ub = 0;
+  int i = num_breakpoints;
+  for (; i > 0 && e.breakpoint(i - 1) >= 0; --i) ;
+  for (; i > 0; --i) {
+    double breakpoint = e.breakpoint(i - 1);
+    if (x >= breakpoint)
+      return result - e.slope(i) * (ub - x);
+    result -= e.slope(i) * (ub - breakpoint);
+    ub = breakpoint;
+  }
+  return result - e.slope(0) * (ub - x);
+}
+
+// Returns an enclosure of {x : term(x) in target}.
+mp::Interval InvertPLTerm(mp::PLTerm e, mp::Interval target) {
+  mp::Interval result = mp::Interval::Empty();
+  int num_breakpoints = e.num_breakpoints();
+  for (int i = 0; i <= num_breakpoints; ++i) {
+    // Segment i is between breakpoints i - 1 and i.
+    mp::Interval segment(i > 0 ? e.breakpoint(i - 1) : -INF,
+                         i < num_breakpoints ? e.breakpoint(i) : INF);
+    double x0 = segment.lb != -INF ? segment.lb :
+        segment.ub != INF ? segment.ub : 0;
+    double y0 = EvalPLTerm(e, x0), slope = e.slope(i);
+    mp::Interval preimage;
+    if (slope == 0) {
+      if (!target.contains(y0))
+        continue;
+    } else {
+      double lb = x0 + (target.lb - y0) / slope;
+      double ub = x0 + (target.ub - y0) / slope;
+      preimage = slope > 0 ? mp::Interval(lb, ub) : mp::Interval(ub, lb);
+    }
+    result = mp::Hull(result, mp::Intersect(preimage, segment));
+  }
+  return result;
+}
+
+// Returns an enclosure of {x : f(x) in target} for an even function f
+// given an enclosure of nonnegative x and the current interval of x.
+mp::Interval InvertEven(mp::Interval nonnegative, mp::Interval x) {
+  if (nonnegative.empty() || x.lb >= 0)
+    return nonnegative;
+  if (x.ub <= 0)
+    return -nonnegative;
+  return mp::Interval(-nonnegative.ub, nonnegative.ub);
+}
+
+// Computes rests[i] = sum of terms[j] for all j != i.
+void ComputeRests(const std::vector<mp::Interval> &terms,
+                  std::vector<mp::Interval> &rests) {
+  double lb_sum = 0, ub_sum = 0;
+  int num_inf_lbs = 0, num_inf_ubs = 0;
+  for (std::size_t i = 0, n = terms.size(); i < n; ++i) {
+    if (terms[i].lb == -INF)
+      ++num_inf_lbs;
+    else
+      lb_sum += terms[i].lb;
+    if (terms[i].ub == INF)
+      ++num_inf_ubs;
+    else
+      ub_sum += terms[i].ub;
+  }
+  rests.resize(terms.size());
+  for (std::size_t i = 0, n = terms.size(); i < n; ++i) {
+    mp::Interval t = terms[i];
+    rests[i].lb = num_inf_lbs - (t.lb == -INF) > 0 ?
+          -INF : lb_sum - (t.lb == -INF ? 0 : t.lb);
+    rests[i].ub = num_inf_ubs - (t.ub == INF) > 0 ?
+          INF : ub_sum - (t.ub == INF ? 0 : t.ub);
+  }
+}
+
+mp::expr::Kind Negate(mp::expr::Kind kind) {
+  namespace expr = mp::expr;
+  switch (kind) {
+  case expr::LT: return expr::GE;
+  case expr::LE: return expr::GT;
+  case expr::EQ: return expr::NE;
+  case expr::GE: return expr::LT;
+  case expr::GT: return expr::LE;
+  case expr::NE: return expr::EQ;
+  default: break;
+  }
+  return kind;
+}
+}
+
+mp::Interval mp::IntervalEvaluator::Compare(
+    expr::Kind kind, Interval lhs, Interval rhs) {
+  if (lhs.empty() || rhs.empty())
+    return Interval::Empty();
+  bool is_true = false, is_false = false;
+  switch (kind) {
+  case expr::LT:
+    is_true = lhs.ub < rhs.lb;
+    is_false = lhs.lb >= rhs.ub;
+    break;
+  case expr::LE:
+    is_true = lhs.ub <= rhs.lb;
+    is_false = lhs.lb > rhs.ub;
+    break;
+  case expr::EQ: case expr::NE:
+    is_true = lhs.is_point() && rhs.is_point() && lhs.lb == rhs.lb;
+    is_false = Intersect(lhs, rhs).empty();
+    if (kind == expr::NE)
+      std::swap(is_true, is_false);
+    break;
+  case expr::GE:
+    is_true = lhs.lb >= rhs.ub;
+    is_false = lhs.ub < rhs.lb;
+    break;
+  case expr::GT:
+    is_true = lhs.lb > rhs.ub;
+    is_false = lhs.ub <= rhs.lb;
+    break;
+  default:
+    break;
+  }
+  return is_true ? Interval(1) : is_false ? Interval(0) : Interval(0, 1);
+}
+
+mp::Interval mp::IntervalEvaluator::Evaluate(const LinearExpr &linear) {
+  Interval result(0);
+  for (LinearExpr::iterator
+       i = linear.begin(), end = linear.end(); i != end; ++i) {
+    int var = i->var_index();
+    if (vars_)
+      vars_->push_back(var);
+    result = result + Interval(i->coef()) * var_bounds_[var];
+  }
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitVariable(Reference v) {
+  if (vars_)
+    vars_->push_back(v.index());
+  return var_bounds_[v.index()];
+}
+
+mp::Interval mp::IntervalEvaluator::VisitCommonExpr(Reference e) {
+  Problem::CommonExpr ce = problem_.common_expr(e.index());
+  Interval result = Evaluate(ce.linear_expr());
+  if (NumericExpr nonlinear = ce.nonlinear_expr())
+    result = result + Visit(nonlinear);
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitUnary(UnaryExpr e) {
+  Interval arg = Visit(e.arg());
+  switch (e.kind()) {
+  case expr::MINUS: return -arg;
+  case expr::ABS:   return Abs(arg);
+  case expr::FLOOR: return Floor(arg);
+  case expr::CEIL:  return Ceil(arg);
+  case expr::SQRT:  return Sqrt(arg);
+  case expr::POW2:  return Sqr(arg);
+  case expr::EXP:   return Exp(arg);
+  case expr::LOG:   return Log(arg);
+  case expr::LOG10: return Log10(arg);
+  case expr::SIN:   return Sin(arg);
+  case expr::SINH:  return Sinh(arg);
+  case expr::COS:   return Cos(arg);
+  case expr::COSH:  return Cosh(arg);
+  case expr::TAN:   return Tan(arg);
+  case expr::TANH:  return Tanh(arg);
+  case expr::ASIN:  return Asin(arg);
+  case expr::ASINH: return Asinh(arg);
+  case expr::ACOS:  return Acos(arg);
+  case expr::ACOSH: return Acosh(arg);
+  case expr::ATAN:  return Atan(arg);
+  case expr::ATANH: return Atanh(arg);
+  default:
+    break;
+  }
+  return Interval();
+}
+
+mp::Interval mp::IntervalEvaluator::VisitBinary(BinaryExpr e) {
+  Interval lhs = Visit(e.lhs());
+  Interval rhs = Visit(e.rhs());
+  if (lhs.empty() || rhs.empty())
+    return Interval::Empty();
+  switch (e.kind()) {
+  case expr::ADD: return lhs + rhs;
+  case expr::SUB: return lhs - rhs;
+  case expr::LESS: return Max(lhs - rhs, Interval(0));
+  case expr::MUL: return lhs * rhs;
+  case expr::DIV: return lhs / rhs;
+  case expr::INT_DIV: {
+    // Division truncated towards zero which is nondecreasing.
+    Interval d = lhs / rhs;
+    return Interval(d.lb >= 0 ? std::floor(d.lb) : std::ceil(d.lb),
+                    d.ub >= 0 ? std::floor(d.ub) : std::ceil(d.ub));
+  }
+  case expr::MOD: {
+    // The result has the sign of lhs and is less than |rhs| in magnitude.
+    double m = Abs(rhs).ub;
+    return Interval(lhs.lb >= 0 ? 0 : std::max(lhs.lb, -m),
+                    lhs.ub <= 0 ? 0 : std::min(lhs.ub, m));
+  }
+  case expr::POW: case expr::POW_CONST_BASE: case expr::POW_CONST_EXP:
+    return Pow(lhs, rhs);
+  case expr::ATAN2:
+    if (rhs.lb > 0)
+      return Atan(lhs / rhs);
+    return Interval(-PI, PI);
+  case expr::ROUND: case expr::TRUNC:
+    // Rounding to rhs decimal places changes a value by less than
+    // 10^-rhs.
+    if (rhs.is_point()) {
+      double delta = std::pow(10.0, -rhs.lb);
+      return Interval(lhs.lb - delta, lhs.ub + delta);
+    }
+    break;
+  default:
+    break;
+  }
+  return Interval();
+}
+
+mp::Interval mp::IntervalEvaluator::VisitIf(IfExpr e) {
+  Interval condition = Visit(e.condition());
+  Interval true_value = Visit(e.true_expr());
+  NumericExpr false_expr = e.false_expr();
+  Interval false_value = false_expr ? Visit(false_expr) : Interval(0);
+  if (IsTrue(condition))
+    return true_value;
+  if (IsFalse(condition))
+    return false_value;
+  return Hull(true_value, false_value);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitPLTerm(PLTerm e) {
+  Interval arg = Visit(e.arg());
+  if (arg.empty())
+    return arg;
+  double lb_value = EvalPLTerm(e, arg.lb), ub_value = EvalPLTerm(e, arg.ub);
+  Interval result(std::min(lb_value, ub_value), std::max(lb_value, ub_value));
+  for (int i = 0, n = e.num_breakpoints(); i < n; ++i) {
+    double breakpoint = e.breakpoint(i);
+    if (arg.lb < breakpoint && breakpoint < arg.ub)
+      result = Hull(result, Interval(EvalPLTerm(e, breakpoint)));
+  }
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitMin(VarArgExpr e) {
+  VarArgExpr::iterator i = e.begin(), end = e.end();
+  Interval result = Visit(*i);
+  for (++i; i != end; ++i)
+    result = Min(result, Visit(*i));
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitMax(VarArgExpr e) {
+  VarArgExpr::iterator i = e.begin(), end = e.end();
+  Interval result = Visit(*i);
+  for (++i; i != end; ++i)
+    result = Max(result, Visit(*i));
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitSum(SumExpr e) {
+  Interval result(0);
+  for (SumExpr::iterator i = e.begin(), end = e.end(); i != end; ++i)
+    result = result + Visit(*i);
+  return result;
+}
+
+mp::Interval mp::IntervalEvaluator::VisitNumberOf(NumberOfExpr e) {
+  NumberOfExpr::iterator i = e.begin(), end = e.end();
+  Interval value = Visit(*i);
+  int num_equal = 0, num_possibly_equal = 0;
+  for (++i; i != end; ++i) {
+    Interval arg = Visit(*i);
+    if (arg.is_point() && value.is_point() && arg.lb == value.lb)
+      ++num_equal;
+    if (!Intersect(arg, value).empty())
+      ++num_possibly_equal;
+  }
+  return Interval(num_equal, num_possibly_equal);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitCount(CountExpr e) {
+  int num_true = 0, num_possibly_true = 0;
+  for (CountExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+    Interval arg = Visit(*i);
+    if (IsTrue(arg))
+      ++num_true;
+    if (!IsFalse(arg))
+      ++num_possibly_true;
+  }
+  return Interval(num_true, num_possibly_true);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitBinaryLogical(BinaryLogicalExpr e) {
+  Interval lhs = Visit(e.lhs());
+  Interval rhs = Visit(e.rhs());
+  switch (e.kind()) {
+  case expr::OR:
+    if (IsTrue(lhs) || IsTrue(rhs))
+      return Interval(1);
+    if (IsFalse(lhs) && IsFalse(rhs))
+      return Interval(0);
+    break;
+  case expr::AND:
+    if (IsFalse(lhs) || IsFalse(rhs))
+      return Interval(0);
+    if (IsTrue(lhs) && IsTrue(rhs))
+      return Interval(1);
+    break;
+  case expr::IFF:
+    if ((IsTrue(lhs) || IsFalse(lhs)) && (IsTrue(rhs) || IsFalse(rhs)))
+      return Interval(IsTrue(lhs) == IsTrue(rhs) ? 1 : 0);
+    break;
+  default:
+    break;
+  }
+  return Interval(0, 1);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitLogicalCount(LogicalCountExpr e) {
+  Interval lhs = Visit(e.lhs());
+  Interval count = Visit(e.rhs());
+  switch (e.kind()) {
+  case expr::ATLEAST:     return Compare(expr::LE, lhs, count);
+  case expr::ATMOST:      return Compare(expr::GE, lhs, count);
+  case expr::EXACTLY:     return Compare(expr::EQ, lhs, count);
+  case expr::NOT_ATLEAST: return Compare(expr::GT, lhs, count);
+  case expr::NOT_ATMOST:  return Compare(expr::LT, lhs, count);
+  case expr::NOT_EXACTLY: return Compare(expr::NE, lhs, count);
+  default:
+    break;
+  }
+  return Interval(0, 1);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitImplication(ImplicationExpr e) {
+  Interval condition = Visit(e.condition());
+  Interval true_value = Visit(e.true_expr());
+  LogicalExpr false_expr = e.false_expr();
+  Interval false_value = false_expr ? Visit(false_expr) : Interval(1);
+  if (IsTrue(condition))
+    return true_value;
+  if (IsFalse(condition))
+    return false_value;
+  return Hull(true_value, false_value);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitIteratedLogical(
+    IteratedLogicalExpr e) {
+  bool exists = e.kind() == expr::EXISTS;
+  // For exists count true arguments, for forall count false ones.
+  int num_decided = 0, num_undecided = 0;
+  for (IteratedLogicalExpr::iterator
+       i = e.begin(), end = e.end(); i != end; ++i) {
+    Interval arg = Visit(*i);
+    if (exists ? IsTrue(arg) : IsFalse(arg))
+      ++num_decided;
+    else if (!(exists ? IsFalse(arg) : IsTrue(arg)))
+      ++num_undecided;
+  }
+  if (num_decided != 0)
+    return Interval(exists ? 1 : 0);
+  if (num_undecided == 0)
+    return Interval(exists ? 0 : 1);
+  return Interval(0, 1);
+}
+
+mp::Interval mp::IntervalEvaluator::VisitAllDiff(PairwiseExpr e) {
+  std::vector<Interval> args;
+  args.reserve(e.num_args());
+  for (PairwiseExpr::iterator i = e.begin(), end = e.end(); i != end; ++i)
+    args.push_back(Visit(*i));
+  bool all_disjoint = true;
+  for (std::size_t i = 0, n = args.size(); i < n; ++i) {
+    for (std::size_t j = i + 1; j < n; ++j) {
+      if (args[i].is_point() && args[j].is_point() && args[i].lb == args[j].lb)
+        return Interval(0);
+      if (!Intersect(args[i], args[j]).empty())
+        all_disjoint = false;
+    }
+  }
+  return all_disjoint ? Interval(1) : Interval(0, 1);
+}
+
+// Narrows intervals of subexpressions of the expression last evaluated
+// by the IntervalEvaluator top-down tightening bounds on variables.
+class mp::BoundPropagator::Narrower :
+    public ExprVisitor<Narrower, void, void> {
+ private:
+  typedef IntervalEvaluator::Node Node;
+
+  BoundPropagator &bp_;
+  const std::vector<Node> &nodes_;
+
+  // The node being narrowed and its new interval.
+  int node_;
+  Interval target_;
+
+  Interval value(int node) const { return nodes_[node].value; }
+
+  // Returns the index of the node following the subexpression at node.
+  int next(int node) const { return nodes_[node].end; }
+
+  void NarrowLogical(LogicalExpr e, int node, bool value) {
+    Narrow(e, node, Interval(value ? 1 : 0));
+  }
+
+ public:
+  explicit Narrower(BoundPropagator &bp)
+    : bp_(bp), nodes_(bp.eval_.nodes()), node_(0) {}
+
+  // Narrows the interval of the subexpression e recorded at node to
+  // target.
+  template <typename ExprType>
+  void Narrow(ExprType e, int node, Interval target);
+
+  // Narrows the sum of a linear expression and an optional nonlinear
+  // expression recorded at nonlinear_node to target.
+  void NarrowLinear(const LinearExpr &linear, NumericExpr nonlinear,
+                    int nonlinear_node, Interval target);
+
+  void VisitUnhandledNumericExpr(NumericExpr) {}
+  void VisitUnhandledLogicalExpr(LogicalExpr) {}
+
+  void VisitVariable(Reference v) { bp_.Tighten(v.index(), target_); }
+
+  void VisitCommonExpr(Reference e) {
+    Problem::CommonExpr ce = bp_.problem_.common_expr(e.index());
+    NarrowLinear(ce.linear_expr(), ce.nonlinear_expr(), node_ + 1, target_);
+  }
+
+  void VisitUnary(UnaryExpr e);
+  void VisitBinary(BinaryExpr e);
+  void VisitIf(IfExpr e);
+
+  void VisitPLTerm(PLTerm e) {
+    Narrow(e.arg(), node_ + 1, InvertPLTerm(e, target_));
+  }
+
+  void VisitMin(VarArgExpr e) {
+    int node = node_ + 1;
+    for (VarArgExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+      Narrow(*i, node, Interval(target_.lb, INF));
+      node = next(node);
+    }
+  }
+
+  void VisitMax(VarArgExpr e) {
+    int node = node_ + 1;
+    for (VarArgExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+      Narrow(*i, node, Interval(-INF, target_.ub));
+      node = next(node);
+    }
+  }
+
+  void VisitSum(SumExpr e);
+  void VisitCount(CountExpr e);
+
+  void VisitNot(NotExpr e) {
+    Narrow(e.arg(), node_ + 1, Interval(1) - target_);
+  }
+
+  void VisitBinaryLogical(BinaryLogicalExpr e);
+  void VisitRelational(RelationalExpr e);
+  void VisitImplication(ImplicationExpr e);
+  void VisitIteratedLogical(IteratedLogicalExpr e);
+};
+
+template <typename ExprType>
+void mp::BoundPropagator::Narrower::Narrow(
+    ExprType e, int node, Interval target) {
+  if (bp_.infeasible_)
+    return;
+  // Bounds computed from infinities may be NaN.
+  if (!(target.lb >= -INF))
+    target.lb = -INF;
+  if (!(target.ub <= INF))
+    target.ub = INF;
+  Interval value = nodes_[node].value;
+  Interval narrowed = Intersect(value, target);
+  if (narrowed.empty()) {
+    if (narrowed.lb - narrowed.ub > TOLERANCE * Scale(narrowed.lb))
+      bp_.infeasible_ = true;
+    return;
+  }
+  if (narrowed == value)
+    return;
+  int saved_node = node_;
+  Interval saved_target = target_;
+  node_ = node;
+  target_ = narrowed;
+  Visit(e);
+  node_ = saved_node;
+  target_ = saved_target;
+}
+
+void mp::BoundPropagator::Narrower::NarrowLinear(
+    const LinearExpr &linear, NumericExpr nonlinear,
+    int nonlinear_node, Interval target) {
+  int num_terms = linear.num_terms();
+  std::vector<Interval> terms;
+  terms.reserve(num_terms + 1);
+  for (LinearExpr::iterator
+       i = linear.begin(), end = linear.end(); i != end; ++i) {
+    terms.push_back(Interval(i->coef()) * bp_.var_bounds_[i->var_index()]);
+  }
+  if (nonlinear)
+    terms.push_back(value(nonlinear_node));
+  std::vector<Interval> rests;
+  ComputeRests(terms, rests);
+  int index = 0;
+  for (LinearExpr::iterator
+       i = linear.begin(), end = linear.end(); i != end; ++i, ++index) {
+    if (i->coef() != 0)
+      bp_.Tighten(i->var_index(), (target - rests[index]) / Interval(i->coef()));
+  }
+  if (nonlinear)
+    Narrow(nonlinear, nonlinear_node, target - rests[num_terms]);
+}
+
+void mp::BoundPropagator::Narrower::VisitUnary(UnaryExpr e) {
+  int arg_node = node_ + 1;
+  Interval arg = value(arg_node), t = target_, result;
+  switch (e.kind()) {
+  case expr::MINUS: result = -t; break;
+  case expr::ABS:   result = InvertEven(t, arg); break;
+  case expr::FLOOR:
+    result = Interval(std::ceil(t.lb), std::floor(t.ub) + 1);
+    break;
+  case expr::CEIL:
+    result = Interval(std::ceil(t.lb) - 1, std::floor(t.ub));
+    break;
+  case expr::SQRT:
+    t = Intersect(t, Interval(0, INF));
+    result = Interval(t.lb * t.lb, t.ub * t.ub);
+    break;
+  case expr::POW2:  result = InvertEven(Sqrt(t), arg); break;
+  case expr::EXP:   result = Log(t); break;
+  case expr::LOG:   result = Exp(t); break;
+  case expr::LOG10: result = Pow(Interval(10), t); break;
+  case expr::SINH:  result = Asinh(t); break;
+  case expr::COSH:  result = InvertEven(Acosh(t), arg); break;
+  case expr::TANH:  result = Atanh(t); break;
+  case expr::ASIN:  result = Sin(Intersect(t, Interval(-PI / 2, PI / 2))); break;
+  case expr::ACOS:  result = Cos(Intersect(t, Interval(0, PI))); break;
+  case expr::ATAN:  result = Tan(t); break;
+  case expr::ASINH: result = Sinh(t); break;
+  case expr::ACOSH: result = Cosh(Intersect(t, Interval(0, INF))); break;
+  case expr::ATANH: result = Tanh(t); break;
+  default:
+    return;
+  }
+  if (result.empty()) {
+    bp_.infeasible_ = true;
+    return;
+  }
+  Narrow(e.arg(), arg_node, result);
+}
+
+void mp::BoundPropagator::Narrower::VisitBinary(BinaryExpr e) {
+  int lhs_node = node_ + 1, rhs_node = next(lhs_node);
+  Interval lhs = value(lhs_node), rhs = value(rhs_node), t = target_;
+  switch (e.kind()) {
+  case expr::ADD:
+    Narrow(e.lhs(), lhs_node, t - rhs);
+    Narrow(e.rhs(), rhs_node, t - lhs);
+    break;
+  case expr::SUB:
+    Narrow(e.lhs(), lhs_node, t + rhs);
+    Narrow(e.rhs(), rhs_node, lhs - t);
+    break;
+  case expr::LESS:
+    // If max(lhs - rhs, 0) > 0, then lhs - rhs is equal to it.
+    if (t.lb > 0) {
+      Narrow(e.lhs(), lhs_node, t + rhs);
+      Narrow(e.rhs(), rhs_node, lhs - t);
+    }
+    break;
+  case expr::MUL:
+    Narrow(e.lhs(), lhs_node, t / rhs);
+    Narrow(e.rhs(), rhs_node, t / lhs);
+    break;
+  case expr::DIV:
+    Narrow(e.lhs(), lhs_node, t * rhs);
+    Narrow(e.rhs(), rhs_node, lhs / t);
+    break;
+  case expr::POW: case expr::POW_CONST_EXP: {
+    if (!rhs.is_point())
+      break;
+    double exponent = rhs.lb;
+    if (exponent <= 0)
+      break;
+    if (exponent == std::floor(exponent) && exponent <= 1e9) {
+      int n = static_cast<int>(exponent);
+      if (n % 2 != 0) {
+        Narrow(e.lhs(), lhs_node, Root(t, n));
+      } else {
+        t = Intersect(t, Interval(0, INF));
+        Interval root = Root(t, n);
+        root.lb = t.empty() ? INF : std::pow(t.lb, 1.0 / n);
+        Narrow(e.lhs(), lhs_node, InvertEven(root, lhs));
+      }
+    } else {
+      Narrow(e.lhs(), lhs_node,
+             Pow(Intersect(t, Interval(0, INF)), Interval(1 / exponent)));
+    }
+    break;
+  }
+  case expr::POW_CONST_BASE: {
+    double base = lhs.lb;
+    if (lhs.is_point() && base > 0 && base != 1)
+      Narrow(e.rhs(), rhs_node, Log(t) * Interval(1 / std::log(base)));
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitIf(IfExpr e) {
+  int condition_node = node_ + 1, true_node = next(condition_node);
+  int false_node = next(true_node);
+  Interval condition = value(condition_node);
+  NumericExpr false_expr = e.false_expr();
+  if (IsTrue(condition)) {
+    Narrow(e.true_expr(), true_node, target_);
+  } else if (IsFalse(condition)) {
+    if (false_expr)
+      Narrow(false_expr, false_node, target_);
+  } else {
+    // Both branches are possible: if one of them can't have a value in
+    // the target interval, the condition selects the other one.
+    Interval false_value = false_expr ? value(false_node) : Interval(0);
+    if (Intersect(false_value, target_).empty()) {
+      NarrowLogical(e.condition(), condition_node, true);
+      Narrow(e.true_expr(), true_node, target_);
+    } else if (Intersect(value(true_node), target_).empty()) {
+      NarrowLogical(e.condition(), condition_node, false);
+      if (false_expr)
+        Narrow(false_expr, false_node, target_);
+    }
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitSum(SumExpr e) {
+  std::vector<Interval> terms;
+  terms.reserve(e.num_args());
+  for (int node = node_ + 1, end = next(node_); node != end; node = next(node))
+    terms.push_back(value(node));
+  std::vector<Interval> rests;
+  ComputeRests(terms, rests);
+  int node = node_ + 1, index = 0;
+  for (SumExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+    Narrow(*i, node, target_ - rests[index++]);
+    node = next(node);
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitCount(CountExpr e) {
+  Interval count = value(node_);
+  // If the count must be at most the number of true arguments, the
+  // remaining ones are false and if it must be at least the number of
+  // possibly true arguments, all of them are true.
+  bool set_false = target_.ub <= count.lb, set_true = target_.lb >= count.ub;
+  if (!set_false && !set_true)
+    return;
+  int node = node_ + 1;
+  for (CountExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+    Interval arg = value(node);
+    if (!IsTrue(arg) && !IsFalse(arg))
+      NarrowLogical(*i, node, set_true);
+    node = next(node);
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitBinaryLogical(BinaryLogicalExpr e) {
+  int lhs_node = node_ + 1, rhs_node = next(lhs_node);
+  Interval lhs = value(lhs_node), rhs = value(rhs_node);
+  bool is_true = IsTrue(target_);
+  switch (e.kind()) {
+  case expr::AND:
+    if (is_true) {
+      NarrowLogical(e.lhs(), lhs_node, true);
+      NarrowLogical(e.rhs(), rhs_node, true);
+    } else if (IsTrue(lhs)) {
+      NarrowLogical(e.rhs(), rhs_node, false);
+    } else if (IsTrue(rhs)) {
+      NarrowLogical(e.lhs(), lhs_node, false);
+    }
+    break;
+  case expr::OR:
+    if (!is_true) {
+      NarrowLogical(e.lhs(), lhs_node, false);
+      NarrowLogical(e.rhs(), rhs_node, false);
+    } else if (IsFalse(lhs)) {
+      NarrowLogical(e.rhs(), rhs_node, true);
+    } else if (IsFalse(rhs)) {
+      NarrowLogical(e.lhs(), lhs_node, true);
+    }
+    break;
+  case expr::IFF:
+    if (IsTrue(lhs) || IsFalse(lhs))
+      NarrowLogical(e.rhs(), rhs_node, IsTrue(lhs) == is_true);
+    else if (IsTrue(rhs) || IsFalse(rhs))
+      NarrowLogical(e.lhs(), lhs_node, IsTrue(rhs) == is_true);
+    break;
+  default:
+    break;
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitRelational(RelationalExpr e) {
+  int lhs_node = node_ + 1, rhs_node = next(lhs_node);
+  Interval lhs = value(lhs_node), rhs = value(rhs_node);
+  expr::Kind kind = IsTrue(target_) ? e.kind() : Negate(e.kind());
+  switch (kind) {
+  case expr::LT: case expr::LE:
+    Narrow(e.lhs(), lhs_node, Interval(-INF, rhs.ub));
+    Narrow(e.rhs(), rhs_node, Interval(lhs.lb, INF));
+    break;
+  case expr::GT: case expr::GE:
+    Narrow(e.lhs(), lhs_node, Interval(rhs.lb, INF));
+    Narrow(e.rhs(), rhs_node, Interval(-INF, lhs.ub));
+    break;
+  case expr::EQ: {
+    Interval common = Intersect(lhs, rhs);
+    Narrow(e.lhs(), lhs_node, common);
+    Narrow(e.rhs(), rhs_node, common);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitImplication(ImplicationExpr e) {
+  int condition_node = node_ + 1, true_node = next(condition_node);
+  int false_node = next(true_node);
+  Interval condition = value(condition_node);
+  LogicalExpr false_expr = e.false_expr();
+  bool is_true = IsTrue(target_);
+  if (IsTrue(condition)) {
+    NarrowLogical(e.true_expr(), true_node, is_true);
+  } else if (IsFalse(condition)) {
+    if (false_expr)
+      NarrowLogical(false_expr, false_node, is_true);
+  } else if (is_true) {
+    // The condition selects a branch that can be true.
+    if (IsFalse(value(true_node)))
+      NarrowLogical(e.condition(), condition_node, false);
+    else if (false_expr && IsFalse(value(false_node)))
+      NarrowLogical(e.condition(), condition_node, true);
+  }
+}
+
+void mp::BoundPropagator::Narrower::VisitIteratedLogical(
+    IteratedLogicalExpr e) {
+  // exists is false or forall is true iff all arguments have that value.
+  bool value = e.kind() != expr::EXISTS;
+  if (IsTrue(target_) == value) {
+    int node = node_ + 1;
+    for (IteratedLogicalExpr::iterator
+         i = e.begin(), end = e.end(); i != end; ++i) {
+      NarrowLogical(*i, node, value);
+      node = next(node);
+    }
+    return;
+  }
+  // Otherwise at least one argument has the opposite value. Fix it if
+  // it is the only one that can.
+  int candidate = -1, candidate_node = 0, index = 0;
+  for (int node = node_ + 1, end = next(node_); node != end;
+       node = next(node), ++index) {
+    Interval arg = this->value(node);
+    if (value ? !IsTrue(arg) : !IsFalse(arg)) {
+      if (candidate != -1)
+        return;
+      candidate = index;
+      candidate_node = node;
+    }
+  }
+  if (candidate != -1)
+    NarrowLogical(e.arg(candidate), candidate_node, !value);
+}
+
+const double mp::BoundPropagator::MIN_CHANGE = 1e-6;
+const double mp::BoundPropagator::TOLERANCE = 1e-9;
+
+mp::BoundPropagator::BoundPropagator(const Problem &p)
+  : problem_(p), eval_(p, 0), current_con_(-1), infeasible_(false),
+    num_tightenings_(0) {
+  int num_vars = p.num_vars();
+  var_bounds_.reserve(num_vars);
+  for (int i = 0; i < num_vars; ++i) {
+    Problem::Variable var = p.var(i);
+    Interval bounds(var.lb(), var.ub());
+    if (var.type() != var::CONTINUOUS) {
+      bounds.lb = std::ceil(bounds.lb - INT_TOLERANCE);
+      bounds.ub = std::floor(bounds.ub + INT_TOLERANCE);
+    }
+    var_bounds_.push_back(bounds);
+  }
+  eval_.set_var_bounds(var_bounds_.empty() ? 0 : &var_bounds_[0]);
+  // Find constraints that depend on each variable.
+  int num_algebraic_cons = p.num_algebraic_cons();
+  int num_cons = num_algebraic_cons + p.num_logical_cons();
+  std::vector<int> vars, con_vars, con_var_starts(1);
+  eval_.set_var_collector(&vars);
+  for (int i = 0; i < num_cons; ++i) {
+    vars.clear();
+    if (i < num_algebraic_cons) {
+      Problem::AlgebraicCon con = p.algebraic_con(i);
+      if (NumericExpr nonlinear = con.nonlinear_expr())
+        eval_.Evaluate(nonlinear);
+      eval_.Evaluate(con.linear_expr());
+    } else {
+      eval_.Evaluate(p.logical_con(i - num_algebraic_cons).expr());
+    }
+    std::sort(vars.begin(), vars.end());
+    con_vars.insert(con_vars.end(), vars.begin(),
+                    std::unique(vars.begin(), vars.end()));
+    con_var_starts.push_back(static_cast<int>(con_vars.size()));
+  }
+  eval_.set_var_collector(0);
+  // Transpose the constraint-variable incidence.
+  var_con_starts_.assign(num_vars + 1, 0);
+  for (std::size_t i = 0, n = con_vars.size(); i < n; ++i)
+    ++var_con_starts_[con_vars[i] + 1];
+  for (int i = 0; i < num_vars; ++i)
+    var_con_starts_[i + 1] += var_con_starts_[i];
+  var_cons_.resize(con_vars.size());
+  std::vector<int> positions(var_con_starts_.begin(), var_con_starts_.end());
+  for (int con = 0; con < num_cons; ++con) {
+    for (int i = con_var_starts[con]; i < con_var_starts[con + 1]; ++i)
+      var_cons_[positions[con_vars[i]]++] = con;
+  }
+  in_queue_.resize(num_cons);
+  for (int i = 0; i < num_cons; ++i)
+    Enqueue(i);
+}
+
+void mp::BoundPropagator::PropagateCon(int con) {
+  int num_algebraic_cons = problem_.num_algebraic_cons();
+  Narrower narrower(*this);
+  if (con >= num_algebraic_cons) {
+    LogicalExpr e = problem_.logical_con(con - num_algebraic_cons).expr();
+    eval_.Evaluate(e);
+    narrower.Narrow(e, 0, Interval(1));
+    return;
+  }
+  Problem::AlgebraicCon c = problem_.algebraic_con(con);
+  NumericExpr nonlinear = c.nonlinear_expr();
+  Interval value = nonlinear ? eval_.Evaluate(nonlinear) : Interval(0);
+  value = value + eval_.Evaluate(c.linear_expr());
+  Interval target(c.lb(), c.ub());
+  Interval narrowed = Intersect(value, target);
+  if (narrowed.empty()) {
+    if (narrowed.lb - narrowed.ub > TOLERANCE * Scale(narrowed.lb))
+      infeasible_ = true;
+    return;
+  }
+  if (narrowed != value)
+    narrower.NarrowLinear(c.linear_expr(), nonlinear, 0, target);
+}
+
+void mp::BoundPropagator::Tighten(int var, Interval bounds) {
+  if (infeasible_)
+    return;
+  Interval &current = var_bounds_[var];
+  double lb = bounds.lb, ub = bounds.ub;
+  // Relax the new bounds to account for rounding errors.
+  if (lb >= -INF)
+    lb -= TOLERANCE * Scale(lb);
+  else
+    lb = -INF;
+  if (ub <= INF)
+    ub += TOLERANCE * Scale(ub);
+  else
+    ub = INF;
+  if (problem_.var(var).type() != var::CONTINUOUS) {
+    lb = std::ceil(lb - INT_TOLERANCE);
+    ub = std::floor(ub + INT_TOLERANCE);
+  }
+  lb = std::max(lb, current.lb);
+  ub = std::min(ub, current.ub);
+  if (lb > ub) {
+    if (lb - ub > TOLERANCE * Scale(lb))
+      infeasible_ = true;
+    return;
+  }
+  bool changed = false;
+  if (lb > current.lb &&
+      (current.lb == -INF || lb - current.lb > MIN_CHANGE * Scale(current.lb))) {
+    current.lb = lb;
+    changed = true;
+  }
+  if (ub < current.ub &&
+      (current.ub == INF || current.ub - ub > MIN_CHANGE * Scale(current.ub))) {
+    current.ub = ub;
+    changed = true;
+  }
+  if (!changed)
+    return;
+  ++num_tightenings_;
+  for (int i = var_con_starts_[var]; i < var_con_starts_[var + 1]; ++i) {
+    if (var_cons_[i] != current_con_)
+      Enqueue(var_cons_[i]);
+  }
+}
+
+void mp::BoundPropagator::SetVarBounds(int var, Interval bounds) {
+  var_bounds_[var] = bounds;
+  for (int i = var_con_starts_[var]; i < var_con_starts_[var + 1]; ++i)
+    Enqueue(var_cons_[i]);
+}
+
+bool mp::BoundPropagator::Propagate(int max_con_visits) {
+  for (int i = 0; i < max_con_visits && !queue_.empty() && !infeasible_; ++i) {
+    current_con_ = queue_.front();
+    queue_.pop_front();
+    in_queue_[current_con_] = false;
+    PropagateCon(current_con_);
+  }
+  current_con_ = -1;
+  return !infeasible_;
+}
@@ -21,8 +21,8 @@
  Author: Victor Zverovich
  */
 
+#include <algorithm>
 #include <cstring>
-#include <limits>
 #include "mp/format.h"
 #include "funcadd.h"
 
@@ -32,22 +32,47 @@ void error(arglist *al, fmt::StringRef message) {
   std::strcpy(al->Errmsg, message.c_str());
 }
 
+// Reports an invalid index. Kept out of element so that formatting
+// the message doesn't slow down the common path.
+double InvalidIndex(arglist *al, double index) {
+  fmt::MemoryWriter message;
+  message.write("invalid index {}", index);
+  error(al, message.c_str());
+  return 0;
+}
+
 double element(arglist *al) {
-  if (al->derivs) {
-    for (int i = 0, n = al->n; i < n; ++i)
-      al->derivs[i] = std::numeric_limits<double>::quiet_NaN();
-    if (al->hes) {
-      error(al, "derivatives are not provided");
-      return 0;
-    }
-  }
-  double index = al->ra[al->n - 1];
+  int num_elements = al->n - 1;
+  double index = al->ra[num_elements];
   int int_index = static_cast<int>(index);
-  if (int_index != index || int_index < 0 || int_index >= al->n - 1) {
-    fmt::MemoryWriter message;
-    message.write("invalid index {}", index);
-    error(al, message.c_str());
-    return 0;
+  if (int_index != index || int_index < 0 || int_index >= num_elements)
+    return InvalidIndex(al, index);
+  if (double *derivs = al->derivs) {
+    // element is linear in the selected argument and piecewise constant
+    // in the index, so the gradient is a unit vector and the Hessian is 0.
+    double *hes = al->hes;
+    const char *dig = al->dig;
+    if (dig && dig[num_elements]) {
+      // The index is a constant, so only partials with respect to the
+      // elements that are not constant (dig[i] == 0) are used and need
+      // to be written. The Hessian is stored as the upper triangle by
+      // columns: element (i, j), i <= j, is hes[i + j * (j + 1) / 2].
+      for (int j = 0; j < num_elements; ++j) {
+        if (dig[j]) continue;
+        derivs[j] = j == int_index ? 1 : 0;
+        if (!hes) continue;
+        double *col = hes + j * (j + 1) / 2;
+        for (int i = 0; i <= j; ++i) {
+          if (!dig[i])
+            col[i] = 0;
+        }
+      }
+      return al->ra[int_index];
+    }
+    std::fill(derivs, derivs + al->n, 0.0);
+    derivs[int_index] = 1;
+    if (hes)
+      std::fill(hes, hes + al->n * (al->n + 1) / 2, 0.0);
   }
   return al->ra[int_index];
 }
@@ -0,0 +1,200 @@
+/*
+ Expression simplifier
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_EXPR_SIMPLIFIER_H_
+#define MP_EXPR_SIMPLIFIER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mp/expr-visitor.h"
+#include "mp/problem.h"
+
+namespace mp {
+namespace internal {
+
+// Computes the value of a unary expression with a constant argument.
+// Returns false if the expression can't be folded.
+bool FoldUnary(expr::Kind kind, double x, double &result);
+
+// Computes the value of a binary expression with constant arguments.
+// Returns false if the expression can't be folded.
+bool FoldBinary(expr::Kind kind, double x, double y, double &result);
+
+// Simplifies expressions folding constant subexpressions, removing
+// identities such as x * 1 and x ^ 1, flattening nested sums into
+// a single sum and replacing x ^ 2 with POW2.
+//
+// Simplified expressions are built in a destination problem. If it is
+// the problem containing the original expressions, leaves are reused.
+// Otherwise variables are renumbered with var_map where a negative index
+// means that the variable is replaced with its value from var_values.
+class ExprSimplifier :
+    public ExprVisitor<ExprSimplifier, NumericExpr, LogicalExpr> {
+ public:
+  // A sum of a constant, linear terms (variable, coefficient) and
+  // nonlinear terms (coefficient, expression). Variables and expressions
+  // belong to the destination problem.
+  struct Terms {
+    double constant;
+    std::vector< std::pair<int, double> > linear;
+    std::vector< std::pair<double, NumericExpr> > nonlinear;
+
+    Terms() : constant(0) {}
+  };
+
+ private:
+  Problem &problem_;
+  const std::vector<int> *var_map_;
+  const std::vector<double> *var_values_;
+
+  // Functions of the destination problem by name.
+  std::map<std::string, Function> funcs_;
+
+  // positions_[var] is the position of the term with variable var in
+  // the linear terms being merged or -1.
+  std::vector<int> positions_;
+
+  static bool GetValue(NumericExpr e, double &value) {
+    NumericConstant c = mp::Cast<NumericConstant>(e);
+    if (c)
+      value = c.value();
+    return c != 0;
+  }
+
+  static bool GetValue(LogicalExpr e, bool &value) {
+    LogicalConstant c = mp::Cast<LogicalConstant>(e);
+    if (c)
+      value = c.value();
+    return c != 0;
+  }
+
+  NumericExpr MakeConst(double value) {
+    return problem_.MakeNumericConstant(value);
+  }
+
+  LogicalExpr MakeBool(bool value) {
+    return problem_.MakeLogicalConstant(value);
+  }
+
+  // Returns e simplified unless it is already simplified.
+  NumericExpr Simplify(NumericExpr e, bool simplified) {
+    return simplified ? e : Visit(e);
+  }
+
+  // Returns coef * e.
+  NumericExpr Scale(double coef, NumericExpr e);
+
+  // Returns the function of the destination problem corresponding to f.
+  Function GetFunction(Function f);
+
+  // Copies an argument of a call or symbolic numberof expression.
+  Expr CopyArg(Expr e);
+
+  CountExpr CopyCount(CountExpr e);
+
+  // Simplifies a sum, difference, negation, product or quotient.
+  NumericExpr SimplifySum(NumericExpr e) {
+    Terms terms;
+    Collect(e, 1, terms);
+    return MakeSum(terms, false);
+  }
+
+  NumericExpr SimplifyPow(BinaryExpr e);
+
+ public:
+  // Constructs an object that simplifies expressions of p in place.
+  explicit ExprSimplifier(Problem &p)
+    : problem_(p), var_map_(0), var_values_(0) {}
+
+  // Constructs an object that simplifies expressions into another
+  // problem renumbering variables.
+  ExprSimplifier(Problem &dest, const std::vector<int> &var_map,
+                 const std::vector<double> &var_values)
+    : problem_(dest), var_map_(&var_map), var_values_(&var_values) {}
+
+  // Adds the terms of coef * e to terms. If simplified is true,
+  // e is a simplified expression of the destination problem.
+  void Collect(NumericExpr e, double coef, Terms &terms,
+               bool simplified = false);
+
+  // Combines linear terms with the same variables and returns the sum
+  // of the terms or a null expression if the sum is empty. If hoist is
+  // true, the constant and the linear terms are left in terms and only
+  // the nonlinear terms are summed.
+  NumericExpr MakeSum(Terms &terms, bool hoist);
+
+  // Returns e + constant where e may be null.
+  NumericExpr AddConstant(NumericExpr e, double constant);
+
+  NumericExpr VisitNumericConstant(NumericConstant c) {
+    return var_map_ ? MakeConst(c.value()) : c;
+  }
+
+  NumericExpr VisitVariable(Reference v);
+
+  NumericExpr VisitCommonExpr(Reference e) {
+    return var_map_ ? problem_.MakeCommonExpr(e.index()) : e;
+  }
+
+  NumericExpr VisitUnary(UnaryExpr e);
+  NumericExpr VisitBinary(BinaryExpr e);
+  NumericExpr VisitIf(IfExpr e);
+  NumericExpr VisitPLTerm(PLTerm e);
+  NumericExpr VisitCall(CallExpr e);
+  NumericExpr VisitVarArg(VarArgExpr e);
+  NumericExpr VisitSum(SumExpr e) { return SimplifySum(e); }
+  NumericExpr VisitNumberOf(NumberOfExpr e);
+  NumericExpr VisitNumberOfSym(SymbolicNumberOfExpr e);
+  NumericExpr VisitCount(CountExpr e) { return CopyCount(e); }
+
+  LogicalExpr VisitLogicalConstant(LogicalConstant c) {
+    return var_map_ ? MakeBool(c.value()) : c;
+  }
+
+  LogicalExpr VisitNot(NotExpr e) {
+    LogicalExpr arg = Visit(e.arg());
+    bool value = false;
+    if (GetValue(arg, value))
+      return MakeBool(!value);
+    return problem_.MakeNot(arg);
+  }
+
+  LogicalExpr VisitBinaryLogical(BinaryLogicalExpr e);
+  LogicalExpr VisitRelational(RelationalExpr e);
+
+  LogicalExpr VisitLogicalCount(LogicalCountExpr e) {
+    NumericExpr lhs = Visit(e.lhs());
+    return problem_.MakeLogicalCount(e.kind(), lhs, CopyCount(e.rhs()));
+  }
+
+  LogicalExpr VisitImplication(ImplicationExpr e);
+  LogicalExpr VisitIteratedLogical(IteratedLogicalExpr e);
+  LogicalExpr VisitAllDiff(PairwiseExpr e);
+  LogicalExpr VisitNotAllDiff(PairwiseExpr e) { return VisitAllDiff(e); }
+};
+}  // namespace internal
+}  // namespace mp
+
+#endif  // MP_EXPR_SIMPLIFIER_H_
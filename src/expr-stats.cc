@@ -0,0 +1,174 @@
+/*
+ Expression tree statistics and visitor profiling
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/expr-stats.h"
+
+#include <algorithm>
+
+namespace {
+
+// Compares expression kinds by self time in decreasing order.
+class SelfTimeGreater {
+ private:
+  const mp::ExprProfile &profile_;
+
+ public:
+  explicit SelfTimeGreater(const mp::ExprProfile &p) : profile_(p) {}
+
+  bool operator()(mp::expr::Kind lhs, mp::expr::Kind rhs) const {
+    return profile_[lhs].self_time > profile_[rhs].self_time;
+  }
+};
+}  // namespace
+
+mp::ExprStats::KindStats::KindStats() : count(0), num_args(0), max_args(0) {
+  std::fill(depths, depths + MAX_DEPTH, 0);
+  std::fill(args, args + NUM_ARG_BUCKETS, 0);
+}
+
+void mp::ExprStats::AddArgs(expr::Kind kind, int num_args) {
+  KindStats &s = kinds_[kind];
+  s.num_args += num_args;
+  if (num_args > s.max_args)
+    s.max_args = num_args;
+  int bucket = 0;
+  for (int n = num_args; n > 1 && bucket < NUM_ARG_BUCKETS - 1; n >>= 1)
+    ++bucket;
+  ++s.args[bucket];
+}
+
+void mp::ExprStats::Write(fmt::Writer &w) const {
+  w.write("Expression trees: {}, maximum depth: {}\n", num_trees_, max_depth_);
+  w.write("{:<18} {:>10} {:>10} {:>10}\n", "kind", "count", "avg args",
+          "max args");
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    const KindStats &s = kinds_[i];
+    if (s.count == 0)
+      continue;
+    w.write("{:<18} {:>10}", expr::str(static_cast<expr::Kind>(i)), s.count);
+    if (s.num_args != 0) {
+      w.write(" {:>10.1f} {:>10}", static_cast<double>(s.num_args) / s.count,
+              s.max_args);
+    }
+    w.write("\n");
+  }
+  w.write("Depth histograms (depth:count):\n");
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    const KindStats &s = kinds_[i];
+    if (s.count == 0)
+      continue;
+    w.write("{:<18}", expr::str(static_cast<expr::Kind>(i)));
+    for (int d = 0; d < MAX_DEPTH; ++d) {
+      if (s.depths[d] != 0)
+        w.write(d == MAX_DEPTH - 1 ? " {}+:{}" : " {}:{}", d, s.depths[d]);
+    }
+    w.write("\n");
+  }
+  w.write("Argument count histograms (args:count):\n");
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    const KindStats &s = kinds_[i];
+    if (s.num_args == 0)
+      continue;
+    w.write("{:<18}", expr::str(static_cast<expr::Kind>(i)));
+    for (int b = 0; b < NUM_ARG_BUCKETS; ++b) {
+      if (s.args[b] == 0)
+        continue;
+      int lower = b == 0 ? 0 : 1 << b, upper = (1 << (b + 1)) - 1;
+      if (b == NUM_ARG_BUCKETS - 1)
+        w.write(" {}+:{}", lower, s.args[b]);
+      else
+        w.write(" {}-{}:{}", lower, upper, s.args[b]);
+    }
+    w.write("\n");
+  }
+}
+
+void mp::ExprStats::AddTo(Stats &stats) const {
+  stats.Add("expr trees", num_trees_);
+  stats.Add("expr max depth", max_depth_);
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    const KindStats &s = kinds_[i];
+    if (s.count == 0)
+      continue;
+    const char *name = expr::str(static_cast<expr::Kind>(i));
+    stats.Add(fmt::format("expr {}", name), s.count);
+    if (s.num_args != 0)
+      stats.Add(fmt::format("expr {} args", name), s.num_args);
+  }
+}
+
+void mp::CollectExprStats(const Problem &p, ExprStats &stats) {
+  ExprStatsCollector collector(stats);
+  for (int i = 0, n = p.num_objs(); i < n; ++i) {
+    if (NumericExpr e = p.obj(i).nonlinear_expr())
+      collector.Collect(e);
+  }
+  for (int i = 0, n = p.num_algebraic_cons(); i < n; ++i) {
+    if (NumericExpr e = p.algebraic_con(i).nonlinear_expr())
+      collector.Collect(e);
+  }
+  for (int i = 0, n = p.num_logical_cons(); i < n; ++i)
+    collector.Collect(p.logical_con(i).expr());
+  for (int i = 0, n = p.num_common_exprs(); i < n; ++i) {
+    if (NumericExpr e = p.common_expr(i).nonlinear_expr())
+      collector.Collect(e);
+  }
+}
+
+bool mp::ExprProfile::empty() const {
+  for (std::size_t i = 0, n = entries_.size(); i < n; ++i) {
+    if (entries_[i].count != 0)
+      return false;
+  }
+  return true;
+}
+
+void mp::ExprProfile::Write(fmt::Writer &w) const {
+  std::vector<expr::Kind> kinds;
+  double total_time = 0;
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    if (entries_[i].count == 0)
+      continue;
+    kinds.push_back(static_cast<expr::Kind>(i));
+    total_time += entries_[i].self_time;
+  }
+  std::stable_sort(kinds.begin(), kinds.end(), SelfTimeGreater(*this));
+  w.write("{:<18} {:>10} {:>12} {:>12} {:>7}\n",
+          "kind", "count", "time, s", "self, s", "self %");
+  for (std::size_t i = 0, n = kinds.size(); i < n; ++i) {
+    const Entry &e = entries_[kinds[i]];
+    w.write("{:<18} {:>10} {:>12.6f} {:>12.6f} {:>7.1f}\n",
+            expr::str(kinds[i]), e.count, e.time, e.self_time,
+            total_time != 0 ? 100 * e.self_time / total_time : 0);
+  }
+}
+
+void mp::ExprProfile::AddTo(Stats &stats) const {
+  for (int i = expr::FIRST_EXPR; i <= expr::LAST_EXPR; ++i) {
+    const Entry &e = entries_[i];
+    if (e.count == 0)
+      continue;
+    const char *name = expr::str(static_cast<expr::Kind>(i));
+    stats.AddTime(fmt::format("convert {}", name), e.self_time);
+    stats.Add(fmt::format("convert {} count", name), e.count);
+  }
+}
@@ -23,6 +23,9 @@
 #ifndef MP_EXPR_WRITER_H_
 #define MP_EXPR_WRITER_H_
 
+#include <algorithm>
+#include <vector>
+
 #include "mp/basic-expr-visitor.h"
 #include "precedence.h"
 
@@ -39,19 +42,66 @@ inline bool IsZero(NumericExpr expr) {
 // to fmt::Writer. It takes into account precedence and associativity
 // of operators avoiding unnecessary parentheses except for potentially
 // confusing cases such as "!x = y" which is written as "!(x = y) instead.
+//
+// Subexpressions and the text following them are put on an explicit stack
+// instead of being written recursively, so the depth of the call stack
+// doesn't depend on the depth of the expression.
 template <typename ExprTypes>
 class ExprWriter :
     public BasicExprVisitor<ExprWriter<ExprTypes>, void, void, ExprTypes> {
  private:
-  fmt::Writer &writer_;
-  int precedence_;
-
   MP_DEFINE_EXPR_TYPES(ExprTypes);
 
   typedef BasicExprVisitor<ExprWriter<ExprTypes>, void, void, ExprTypes> Base;
 
+  // An item to write.
+  struct Item {
+    enum Type {
+      NUMERIC,   // A numeric expression.
+      LOGICAL,   // A logical expression.
+      CALL_ARG,  // A function call argument.
+      TEXT,      // A text.
+      END        // The end of an expression.
+    };
+    Type type;
+    Expr expr;
+    const char *text;
+    // The precedence of the context of an expression or the precedence
+    // to restore at the end of an expression.
+    int precedence;
+    // Whether to write a closing parenthesis at the end of an expression.
+    bool paren;
+  };
+
+  fmt::Writer &writer_;
+  int precedence_;
+  std::vector<Item> stack_;
+
   static int precedence(Expr e) { return internal::precedence(e.kind()); }
 
+  void DoPush(typename Item::Type type, Expr e, const char *text = 0,
+              int precedence = -1, bool paren = false) {
+    Item item = {type, e, text, precedence, paren};
+    stack_.push_back(item);
+  }
+
+  // Schedules writing of an expression after the previously scheduled
+  // items. Precedence -1 means the precedence of the parent expression.
+  // Visit* methods write the text preceding the first subexpression
+  // directly and schedule the rest.
+  void Push(NumericExpr e, int precedence = -1) {
+    DoPush(Item::NUMERIC, e, 0, precedence);
+  }
+  void Push(LogicalExpr e, int precedence = -1) {
+    DoPush(Item::LOGICAL, e, 0, precedence);
+  }
+
+  // Schedules writing of a text after the previously scheduled items.
+  void Push(const char *text) { DoPush(Item::TEXT, Expr(), text); }
+
+  // Writes scheduled items starting from an expression.
+  void Write(typename Item::Type type, Expr e, int precedence);
+
   // Writes an argument list surrounded by parentheses.
   template <typename Iter>
   void WriteArgs(Iter begin, Iter end, const char *sep = ", ",
@@ -75,47 +125,34 @@ class ExprWriter :
 
   void WriteCallArg(Expr arg);
 
-  class Parenthesizer {
-   private:
-    ExprWriter &writer_;
-    int saved_precedence_;
-    bool write_paren_;
-
-   public:
-    Parenthesizer(ExprWriter &w, Expr e, int precedence);
-    ~Parenthesizer();
-  };
-
  public:
   explicit ExprWriter(fmt::Writer &w)
   : writer_(w), precedence_(prec::UNKNOWN) {}
 
   void Visit(NumericExpr e, int precedence = -1) {
-    Parenthesizer p(*this, e, precedence);
-    Base::Visit(e);
+    Write(Item::NUMERIC, e, precedence);
   }
 
   void Visit(LogicalExpr e, int precedence = -1) {
-    Parenthesizer p(*this, e, precedence);
-    Base::Visit(e);
+    Write(Item::LOGICAL, e, precedence);
   }
 
   void VisitNumericConstant(NumericConstant c) { writer_ << c.value(); }
 
   void VisitUnary(UnaryExpr e) {
     writer_ << str(e.kind()) << '(';
-    Visit(e.arg(), prec::UNKNOWN);
-    writer_ << ')';
+    Push(e.arg(), prec::UNKNOWN);
+    Push(")");
   }
 
   void VisitMinus(UnaryExpr e) {
     writer_ << '-';
-    Visit(e.arg());
+    Push(e.arg());
   }
 
   void VisitPow2(UnaryExpr e) {
-    Visit(e.arg(), prec::EXPONENTIATION + 1);
-    writer_ << " ^ 2";
+    Push(e.arg(), prec::EXPONENTIATION + 1);
+    Push(" ^ 2");
   }
 
   void VisitBinary(BinaryExpr e) { WriteBinary(e); }
@@ -128,14 +165,15 @@ class ExprWriter :
   void VisitPLTerm(PLTerm e);
   void VisitCall(CallExpr e);
   void VisitVariable(Variable v) { writer_ << 'x' << (v.index() + 1); }
+  void VisitCommonExpr(CommonExpr e) { writer_ << 'e' << (e.index() + 1); }
 
   void VisitNot(NotExpr e) {
      writer_ << '!';
      // Use a precedence higher then relational to print expressions
      // as "!(x = y)" instead of "!x = y".
      LogicalExpr arg = e.arg();
-     Visit(arg,
-           precedence(arg) == prec::RELATIONAL ? prec::RELATIONAL + 1 : -1);
+     Push(arg,
+          precedence(arg) == prec::RELATIONAL ? prec::RELATIONAL + 1 : -1);
   }
 
   void VisitBinaryLogical(BinaryLogicalExpr e) { WriteBinary(e); }
@@ -148,38 +186,59 @@ class ExprWriter :
 };
 
 template <typename ExprTypes>
-ExprWriter<ExprTypes>::Parenthesizer::Parenthesizer(
-    ExprWriter<ExprTypes> &w, Expr e, int prec)
-: writer_(w), write_paren_(false) {
-  saved_precedence_ = w.precedence_;
-  if (prec == -1)
-    prec = w.precedence_;
-  write_paren_ = precedence(e) < prec;
-  if (write_paren_)
-    w.writer_ << '(';
-  w.precedence_ = precedence(e);
-}
-
-template <typename ExprTypes>
-ExprWriter<ExprTypes>::Parenthesizer::~Parenthesizer() {
-  writer_.precedence_ = saved_precedence_;
-  if (write_paren_)
-    writer_.writer_ << ')';
+void ExprWriter<ExprTypes>::Write(
+    typename Item::Type type, Expr e, int precedence) {
+  std::size_t base = stack_.size();
+  DoPush(type, e, 0, precedence);
+  while (stack_.size() > base) {
+    Item item = stack_.back();
+    stack_.pop_back();
+    switch (item.type) {
+    case Item::TEXT:
+      writer_ << item.text;
+      break;
+    case Item::END:
+      precedence_ = item.precedence;
+      if (item.paren)
+        writer_ << ')';
+      break;
+    case Item::CALL_ARG:
+      WriteCallArg(item.expr);
+      break;
+    default: {
+      int prec = item.precedence == -1 ? precedence_ : item.precedence;
+      bool paren = ExprWriter::precedence(item.expr) < prec;
+      if (paren)
+        writer_ << '(';
+      DoPush(Item::END, Expr(), 0, precedence_, paren);
+      precedence_ = ExprWriter::precedence(item.expr);
+      std::size_t start = stack_.size();
+      if (item.type == Item::NUMERIC)
+        Base::Visit(ExprTypes::template UncheckedCast<NumericExpr>(item.expr));
+      else
+        Base::Visit(ExprTypes::template UncheckedCast<LogicalExpr>(item.expr));
+      // Items are scheduled in the writing order, so reverse them to pop
+      // the first one first.
+      std::reverse(stack_.begin() + start, stack_.end());
+      break;
+    }
+    }
+  }
 }
 
 template <typename ExprTypes>
 template <typename Iter>
 void ExprWriter<ExprTypes>::WriteArgs(
     Iter begin, Iter end, const char *sep, int precedence) {
-  writer_ << '(';
+  Push("(");
   if (begin != end) {
-    Visit(*begin, precedence);
+    Push(*begin, precedence);
     for (++begin; begin != end; ++begin) {
-      writer_ << sep;
-      Visit(*begin, precedence);
+      Push(sep);
+      Push(*begin, precedence);
     }
   }
-  writer_ << ')';
+  Push(")");
 }
 
 template <typename ExprTypes>
@@ -187,15 +246,17 @@ template <typename ExprType>
 void ExprWriter<ExprTypes>::WriteBinary(ExprType e) {
   int prec = precedence(e);
   bool right_associative = prec == prec::EXPONENTIATION;
-  Visit(e.lhs(), prec + (right_associative ? 1 : 0));
-  writer_ << ' ' << str(e.kind()) << ' ';
-  Visit(e.rhs(), prec + (right_associative ? 0 : 1));
+  Push(e.lhs(), prec + (right_associative ? 1 : 0));
+  Push(" ");
+  Push(str(e.kind()));
+  Push(" ");
+  Push(e.rhs(), prec + (right_associative ? 0 : 1));
 }
 
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::WriteCallArg(Expr arg) {
   if (NumericExpr e = ExprTypes::template Cast<NumericExpr>(arg)) {
-    Visit(e, prec::UNKNOWN);
+    Push(e, prec::UNKNOWN);
     return;
   }
   assert(arg.kind() == expr::STRING);
@@ -221,23 +282,23 @@ void ExprWriter<ExprTypes>::WriteCallArg(Expr arg) {
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::VisitBinaryFunc(BinaryExpr e) {
   writer_ << str(e.kind()) << '(';
-  Visit(e.lhs(), prec::UNKNOWN);
-  writer_ << ", ";
-  Visit(e.rhs(), prec::UNKNOWN);
-  writer_ << ')';
+  Push(e.lhs(), prec::UNKNOWN);
+  Push(", ");
+  Push(e.rhs(), prec::UNKNOWN);
+  Push(")");
 }
 
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::VisitIf(IfExpr e) {
   writer_ << "if ";
-  Visit(e.condition(), prec::UNKNOWN);
-  writer_ << " then ";
+  Push(e.condition(), prec::UNKNOWN);
+  Push(" then ");
   NumericExpr false_expr = e.false_expr();
   bool has_else = !IsZero<ExprTypes>(false_expr);
-  Visit(e.true_expr(), prec::CONDITIONAL + (has_else ? 1 : 0));
+  Push(e.true_expr(), prec::CONDITIONAL + (has_else ? 1 : 0));
   if (has_else) {
-    writer_ << " else ";
-    Visit(false_expr);
+    Push(" else ");
+    Push(false_expr);
   }
 }
 
@@ -246,21 +307,21 @@ void ExprWriter<ExprTypes>::VisitSum(SumExpr e) {
   writer_ << "/* sum */ (";
   typename SumExpr::iterator i = e.begin(), end = e.end();
   if (i != end) {
-    Visit(*i);
+    Push(*i);
     for (++i; i != end; ++i) {
-      writer_ << " + ";
-      Visit(*i);
+      Push(" + ");
+      Push(*i);
     }
   }
-  writer_ << ')';
+  Push(")");
 }
 
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::VisitNumberOf(NumberOfExpr e) {
   writer_ << "numberof ";
   typename NumberOfExpr::iterator i = e.begin();
-  Visit(*i++, prec::UNKNOWN);
-  writer_ << " in ";
+  Push(*i++, prec::UNKNOWN);
+  Push(" in ");
   WriteArgs(i, e.end());
 }
 
@@ -285,20 +346,20 @@ void ExprWriter<ExprTypes>::VisitCall(CallExpr e) {
   writer_ << e.function().name() << '(';
   typename CallExpr::iterator i = e.begin(), end = e.end();
   if (i != end) {
-    WriteCallArg(*i++);
+    DoPush(Item::CALL_ARG, *i++);
     for (; i != end; ++i) {
-      writer_ << ", ";
-      WriteCallArg(*i);
+      Push(", ");
+      DoPush(Item::CALL_ARG, *i);
     }
   }
-  writer_ << ')';
+  Push(")");
 }
 
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::VisitLogicalCount(LogicalCountExpr e) {
   writer_ << str(e.kind()) << ' ';
-  Visit(e.lhs());
-  writer_ << ' ';
+  Push(e.lhs());
+  Push(" ");
   WriteArgs(e.rhs());
 }
 
@@ -319,14 +380,14 @@ void ExprWriter<ExprTypes>::VisitIteratedLogical(IteratedLogicalExpr e) {
 
 template <typename ExprTypes>
 void ExprWriter<ExprTypes>::VisitImplication(ImplicationExpr e) {
-  Visit(e.condition());
-  writer_ << " ==> ";
-  Visit(e.true_expr(), prec::IMPLICATION + 1);
+  Push(e.condition());
+  Push(" ==> ");
+  Push(e.true_expr(), prec::IMPLICATION + 1);
   LogicalExpr false_expr = e.false_expr();
   LogicalConstant c = ExprTypes::template Cast<LogicalConstant>(false_expr);
   if (!c || c.value() != 0) {
-    writer_ << " else ";
-    Visit(false_expr);
+    Push(" else ");
+    Push(false_expr);
   }
 }
 
@@ -0,0 +1,113 @@
+/*
+ A generator of synthetic .nl files for testing and benchmarking.
+
+ Usage: gen-nl [option=value...] filename
+
+ Options:
+   binary   - 0 or 1 (default 0): whether to use binary format
+   seed     - random seed (default 1)
+   vars     - number of variables (default 100)
+   nlvars   - number of variables in nonlinear expressions (default 50)
+   cons     - number of constraints (default 100)
+   nlcons   - number of nonlinear constraints (default 50)
+   nonzeros - number of Jacobian nonzeros (default 500)
+   depth    - depth of nonlinear expressions (default 3)
+   exprs    - number of common expressions (default 10)
+   suffixes - number of suffixes (default 1)
+
+ The output only depends on the options so the same file is generated
+ for the same options on all platforms.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "mp/error.h"
+#include "nl-generator.h"
+
+namespace {
+
+// Parses an option of the form name=value. Returns false if arg is not
+// an option.
+bool ParseOption(const char *arg, mp::NLGeneratorParams &params) {
+  const char *eq = std::strchr(arg, '=');
+  if (!eq)
+    return false;
+  std::string name(arg, eq);
+  char *end = 0;
+  fmt::LongLong value = std::strtoll(eq + 1, &end, 10);
+  if (*end || end == eq + 1)
+    throw mp::Error("invalid value for option {}: {}", name, eq + 1);
+  if (name == "nonzeros") {
+    params.num_nonzeros = value;
+    return true;
+  }
+  if (value < INT_MIN || value > INT_MAX)
+    throw mp::Error("value out of range for option {}", name);
+  int int_value = static_cast<int>(value);
+  if (name == "binary")
+    params.binary = int_value != 0;
+  else if (name == "seed")
+    params.seed = static_cast<unsigned>(int_value);
+  else if (name == "vars")
+    params.num_vars = int_value;
+  else if (name == "nlvars")
+    params.num_nl_vars = int_value;
+  else if (name == "cons")
+    params.num_cons = int_value;
+  else if (name == "nlcons")
+    params.num_nl_cons = int_value;
+  else if (name == "depth")
+    params.expr_depth = int_value;
+  else if (name == "exprs")
+    params.num_common_exprs = int_value;
+  else if (name == "suffixes")
+    params.num_suffixes = int_value;
+  else
+    throw mp::Error("unknown option {}", name);
+  return true;
+}
+}
+
+int main(int argc, char **argv) {
+  try {
+    mp::NLGeneratorParams params;
+    const char *filename = 0;
+    for (int i = 1; i < argc; ++i) {
+      if (!ParseOption(argv[i], params)) {
+        if (filename)
+          throw mp::Error("too many arguments");
+        filename = argv[i];
+      }
+    }
+    if (!filename) {
+      fmt::print(stderr, "usage: gen-nl [option=value...] filename\n");
+      return 1;
+    }
+    mp::GenerateNLFile(filename, params);
+  } catch (const std::exception &e) {
+    fmt::print(stderr, "gen-nl: {}\n", e.what());
+    return 1;
+  }
+}
@@ -31,7 +31,7 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_version.h>
 
-#include "funcadd.h"
+#include "amplgsl.h"
 
 enum { MAX_ERROR_MESSAGE_SIZE = 100 };
 
@@ -94,7 +94,8 @@ static void format_eval_error(arglist *al, char prefix, const char *suffix) {
   if (prefix)
     *message++ = prefix;
   n += al->AE->SnprintF(message, MAX_ERROR_MESSAGE_SIZE,
-      "can't evaluate %s%s(", al->funcinfo, suffix);
+      "can't evaluate %s%s(",
+      ((const amplgsl_funcinfo*)al->funcinfo)->name, suffix);
   for (i = 0; i < al->n - 1; ++i) {
     n += al->AE->SnprintF(message + n, MAX_ERROR_MESSAGE_SIZE - n,
         "%g, ", al->ra[i]);
@@ -153,6 +154,64 @@ static double check_result(arglist *al, double result) {
   return result;
 }
 
+/* Loads the arguments of the point with the specified index into al->ra. */
+static void load_args(arglist *al, const real *const *x, int index) {
+  int j = 0;
+  for (; j < al->n; ++j)
+    al->ra[j] = x[j][index];
+}
+
+/* Returns the index of the first NaN in x[0:n] or n if there are none.
+   x != x is used instead of gsl_isnan to keep the loop vectorizable. */
+static int find_nan(const real *x, int n) {
+  int i = 0, has_nan = 0;
+  for (; i < n; ++i)
+    has_nan |= x[i] != x[i];
+  if (!has_nan)
+    return n;
+  for (i = 0; x[i] == x[i]; ++i)
+    ;
+  return i;
+}
+
+/* Returns the index of the first point with a NaN argument or num_points
+   if there is none. */
+static int find_nan_arg(arglist *al, int num_points, const real *const *x) {
+  int j = 0;
+  for (; j < al->n; ++j)
+    num_points = find_nan(x[j], num_points);
+  return num_points;
+}
+
+/* The vector counterpart of check_result. The function has been evaluated
+   at the first num_evaluated points, which have no NaN arguments.
+   Returns the number of points evaluated successfully. */
+static int check_results(arglist *al, int num_evaluated, int num_points,
+                         const real *const *x, const real *y) {
+  int i = find_nan(y, num_evaluated);
+  if (i < num_points) {
+    load_args(al, x, i);
+    eval_error(al);
+  }
+  return i;
+}
+
+/* Evaluates a function without a specialized vector version at each
+   point in turn. */
+static int eval_vec(arglist *al, int num_points,
+                    const real *const *x, real *y) {
+  rfunc func = ((const amplgsl_funcinfo*)al->funcinfo)->func;
+  int i = 0;
+  al->Errmsg = 0;
+  for (; i < num_points; ++i) {
+    load_args(al, x, i);
+    y[i] = func(al);
+    if (al->Errmsg)
+      break;
+  }
+  return i;
+}
+
 /* Flags for check_bessel_args */
 enum {
   DERIV_INT_MIN = 1 /* Derivative can be computed for n = INT_MIN */
@@ -250,6 +309,10 @@ static int check_bessel_args(arglist *al, int flags, const char *arg_name) {
 #define RNG_ARGS2 rng, ARGS2
 #define RNG_ARGS3 rng, ARGS3
 
+/* WRAP and WRAP_CHECKED also define vector versions of the functions
+   (see amplgsl_vfunc) which check all arguments and all results for NaNs
+   in separate passes outside the evaluation loop. */
+
 #define WRAP(func, args) \
   static double ampl##func(arglist *al) { \
     if (!check_args(al)) \
@@ -257,6 +320,16 @@ static int check_bessel_args(arglist *al, int flags, const char *arg_name) {
     if (al->derivs) \
       deriv_error(al, DERIVS_NOT_PROVIDED); \
     return check_result(al, func(args)); \
+  } \
+  static int ampl##func##_vec(arglist *al, int num_points, \
+                              const real *const *x, real *y) { \
+    int i = 0, n = find_nan_arg(al, num_points, x); \
+    al->Errmsg = 0; \
+    for (; i < n; ++i) { \
+      load_args(al, x, i); \
+      y[i] = func(args); \
+    } \
+    return check_results(al, n, num_points, x, y); \
   }
 
 #define WRAP_CHECKED(func, args) \
@@ -268,6 +341,21 @@ static int check_bessel_args(arglist *al, int flags, const char *arg_name) {
       deriv_error(al, DERIVS_NOT_PROVIDED); \
     CHECK_CALL(value, func##_e(args, &result)); \
     return check_result(al, value); \
+  } \
+  static int ampl##func##_vec(arglist *al, int num_points, \
+                              const real *const *x, real *y) { \
+    int i = 0, n = find_nan_arg(al, num_points, x); \
+    al->Errmsg = 0; \
+    for (; i < n; ++i) { \
+      gsl_sf_result result = {0, 0}; \
+      load_args(al, x, i); \
+      if (func##_e(args, &result) != GSL_SUCCESS) { \
+        eval_error(al); \
+        return i; \
+      } \
+      y[i] = result.val; \
+    } \
+    return check_results(al, n, num_points, x, y); \
   }
 
 #define UNUSED(x) (void)(x)
@@ -277,6 +365,10 @@ static const char *amplgsl_version(arglist *al) {
   return gsl_version;
 }
 
+static amplgsl_funcinfo version_info = {
+  "gsl_version", (rfunc)amplgsl_version, 0
+};
+
 static double amplgsl_log1p(arglist *al) {
   double x = al->ra[0];
   if (al->derivs) {
@@ -2923,11 +3015,23 @@ WRAP_DISCRETE(gsl_cdf_hypergeometric_Q,
 WRAP(gsl_ran_logarithmic, RNG_ARGS1)
 WRAP_DISCRETE(gsl_ran_logarithmic_pdf, ARGS2, DEFAULT_ARGS)
 
+#define ADDFUNC_INFO(name, num_args, type, vfunc) { \
+    static amplgsl_funcinfo info = {#name, ampl##name, vfunc}; \
+    addfunc(#name, ampl##name, type, num_args, &info); \
+  }
+
 #define ADDFUNC(name, num_args) \
-    addfunc(#name, ampl##name, FUNCADD_REAL_VALUED, num_args, #name);
+    ADDFUNC_INFO(name, num_args, FUNCADD_REAL_VALUED, eval_vec)
 
 #define ADDFUNC_RANDOM(name, num_args) \
-    addfunc(#name, ampl##name, FUNCADD_RANDOM_VALUED, num_args, #name);
+    ADDFUNC_INFO(name, num_args, FUNCADD_RANDOM_VALUED, eval_vec)
+
+/* Adds a function defined with WRAP or WRAP_CHECKED. */
+#define ADDFUNC_VEC(name, num_args) \
+    ADDFUNC_INFO(name, num_args, FUNCADD_REAL_VALUED, ampl##name##_vec)
+
+#define ADDFUNC_RANDOM_VEC(name, num_args) \
+    ADDFUNC_INFO(name, num_args, FUNCADD_RANDOM_VALUED, ampl##name##_vec)
 
 void funcadd_ASL(AmplExports *ae)
 {
@@ -2935,7 +3039,7 @@ void funcadd_ASL(AmplExports *ae)
   gsl_set_error_handler_off();
 
   addfunc("gsl_version", (rfunc)amplgsl_version,
-      FUNCADD_STRING_VALUED, 0, "gsl_version");
+      FUNCADD_STRING_VALUED, 0, &version_info);
 
   /**
    * @file elementary
@@ -3944,7 +4048,7 @@ void funcadd_ASL(AmplExports *ae)
    *  parameters $m = k^2$ and $\sin^2(\alpha) = k^2$, with the change of
    *  sign $n \to -n$.
    */
-  ADDFUNC(gsl_sf_ellint_P, 3);
+  ADDFUNC_VEC(gsl_sf_ellint_P, 3);
 
   /**
    * .. function:: gsl_sf_ellint_D(phi, k, n)
@@ -3959,7 +4063,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    * The argument $n$ is not used and will be removed in a future release.
    */
-  ADDFUNC(gsl_sf_ellint_D, 3);
+  ADDFUNC_VEC(gsl_sf_ellint_D, 3);
 
   /**
    * Carlson Forms
@@ -3971,28 +4075,28 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  This routine computes the incomplete elliptic integral $RC(x,y)$.
    */
-  ADDFUNC(gsl_sf_ellint_RC, 2);
+  ADDFUNC_VEC(gsl_sf_ellint_RC, 2);
 
   /**
    * .. function:: gsl_sf_ellint_RD(x, y, z)
    *
    *  This routine computes the incomplete elliptic integral $RD(x,y,z)$.
    */
-  ADDFUNC(gsl_sf_ellint_RD, 3);
+  ADDFUNC_VEC(gsl_sf_ellint_RD, 3);
 
   /**
    * .. function:: gsl_sf_ellint_RF(x, y, z)
    *
    *  This routine computes the incomplete elliptic integral $RF(x,y,z)$.
    */
-  ADDFUNC(gsl_sf_ellint_RF, 3);
+  ADDFUNC_VEC(gsl_sf_ellint_RF, 3);
 
   /**
    * .. function:: gsl_sf_ellint_RJ(x, y, z, p)
    *
    *  This routine computes the incomplete elliptic integral $RJ(x,y,z,p)$.
    */
-  ADDFUNC(gsl_sf_ellint_RJ, 4);
+  ADDFUNC_VEC(gsl_sf_ellint_RJ, 4);
 
   /* Elliptic Functions (Jacobi) */
   /* Wrapper for gsl_sf_elljac_e is not provided since the latter produces
@@ -4299,14 +4403,14 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  This routine computes the complete Fermi-Dirac integral $F_{-1/2}(x)$.
    */
-  ADDFUNC(gsl_sf_fermi_dirac_mhalf, 1);
+  ADDFUNC_VEC(gsl_sf_fermi_dirac_mhalf, 1);
 
   /**
    * .. function:: gsl_sf_fermi_dirac_half(x)
    *
    *  This routine computes the complete Fermi-Dirac integral $F_{1/2}(x)$.
    */
-  ADDFUNC(gsl_sf_fermi_dirac_half, 1);
+  ADDFUNC_VEC(gsl_sf_fermi_dirac_half, 1);
 
   /**
    * .. function:: gsl_sf_fermi_dirac_3half(x)
@@ -4423,7 +4527,7 @@ void funcadd_ASL(AmplExports *ae)
    *  When $a$ and $a+x$ are negative integers or zero, the limiting
    *  value of the ratio is returned.
    */
-  ADDFUNC(gsl_sf_poch, 2);
+  ADDFUNC_VEC(gsl_sf_poch, 2);
 
   /**
    * .. function:: gsl_sf_lnpoch(a, x)
@@ -4431,7 +4535,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the logarithm of the Pochhammer symbol,
    *  $\log((a)_x) = \log(\Gamma(a + x)/\Gamma(a))$.
    */
-  ADDFUNC(gsl_sf_lnpoch, 2);
+  ADDFUNC_VEC(gsl_sf_lnpoch, 2);
 
   /**
    * .. function:: gsl_sf_pochrel(a, x)
@@ -4439,7 +4543,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the relative Pochhammer symbol
    *  $((a)_x - 1)/x$ where $(a)_x = \Gamma(a + x)/\Gamma(a)$.
    */
-  ADDFUNC(gsl_sf_pochrel, 2);
+  ADDFUNC_VEC(gsl_sf_pochrel, 2);
 
   /**
    * Incomplete Gamma Functions
@@ -4462,7 +4566,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $Q(a,x) = 1/\Gamma(a) \int_x^\infty t^{a-1} \exp(-t) dt$ for
    *  $a > 0$, $x \geq 0$.
    */
-  ADDFUNC(gsl_sf_gamma_inc_Q, 2);
+  ADDFUNC_VEC(gsl_sf_gamma_inc_Q, 2);
 
   /**
    * .. function:: gsl_sf_gamma_inc_P(a, x)
@@ -4477,7 +4581,7 @@ void funcadd_ASL(AmplExports *ae)
    *  Note that Abramowitz & Stegun call $P(a,x)$ the incomplete gamma
    *  function (section 6.5).
    */
-  ADDFUNC(gsl_sf_gamma_inc_P, 2);
+  ADDFUNC_VEC(gsl_sf_gamma_inc_P, 2);
 
   /**
    * Beta Functions
@@ -4520,7 +4624,7 @@ void funcadd_ASL(AmplExports *ae)
    *  .. math::
    *    I_x(a,b) = (1/a) x^a {}_2F_1(a,1-b,a+1,x)/\operatorname{B}(a,b).
    */
-  ADDFUNC(gsl_sf_beta_inc, 3);
+  ADDFUNC_VEC(gsl_sf_beta_inc, 3);
 
   /**
    * @file gegenpoly
@@ -4596,7 +4700,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the confluent hypergeometric function
    *  ${}_1F_1(a,b,x) = M(a,b,x)$ for general parameters $a$, $b$.
    */
-  ADDFUNC(gsl_sf_hyperg_1F1, 3);
+  ADDFUNC_VEC(gsl_sf_hyperg_1F1, 3);
 
   /**
    * .. function:: gsl_sf_hyperg_U_int(m, n, x)
@@ -4611,7 +4715,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  This routine computes the confluent hypergeometric function $U(a,b,x)$.
    */
-  ADDFUNC(gsl_sf_hyperg_U, 3);
+  ADDFUNC_VEC(gsl_sf_hyperg_U, 3);
 
   /**
    * .. function:: gsl_sf_hyperg_2F1(a, b, c, x)
@@ -4624,7 +4728,7 @@ void funcadd_ASL(AmplExports *ae)
    *  converges too slowly. This occurs in the region of
    *  $x=1, c - a - b = m$ for integer $m$.
    */
-  ADDFUNC(gsl_sf_hyperg_2F1, 4);
+  ADDFUNC_VEC(gsl_sf_hyperg_2F1, 4);
 
   /**
    * .. function:: gsl_sf_hyperg_2F1_conj(aR, aI, c, x)
@@ -4633,7 +4737,7 @@ void funcadd_ASL(AmplExports *ae)
    *  ${}_2F_1(a_R + i a_I, a_R - i a_I, c, x)$ with complex parameters
    *  for $|x| < 1$.
    */
-  ADDFUNC(gsl_sf_hyperg_2F1_conj, 4);
+  ADDFUNC_VEC(gsl_sf_hyperg_2F1_conj, 4);
 
   /**
    * .. function:: gsl_sf_hyperg_2F1_renorm(a, b, c, x)
@@ -4641,7 +4745,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the renormalized Gauss hypergeometric
    *  function ${}_2F_1(a,b,c,x) / \Gamma(c)$ for $|x| < 1$.
    */
-  ADDFUNC(gsl_sf_hyperg_2F1_renorm, 4);
+  ADDFUNC_VEC(gsl_sf_hyperg_2F1_renorm, 4);
 
   /**
    * .. function:: gsl_sf_hyperg_2F1_conj_renorm(aR, aI, c, x)
@@ -4650,7 +4754,7 @@ void funcadd_ASL(AmplExports *ae)
    *  function ${}_2F_1(a_R + i a_I, a_R - i a_I, c, x) / \Gamma(c)$
    *  for $|x| < 1$.
    */
-  ADDFUNC(gsl_sf_hyperg_2F1_conj_renorm, 4);
+  ADDFUNC_VEC(gsl_sf_hyperg_2F1_conj_renorm, 4);
 
   /**
    * .. function:: gsl_sf_hyperg_2F0(a, b, x)
@@ -4659,7 +4763,7 @@ void funcadd_ASL(AmplExports *ae)
    *  The series representation is a divergent hypergeometric series.
    *  However, for $x < 0$ we have ${}_2F_0(a,b,x) = (-1/x)^a U(a,1+a-b,-1/x)$
    */
-  ADDFUNC(gsl_sf_hyperg_2F0, 3);
+  ADDFUNC_VEC(gsl_sf_hyperg_2F0, 3);
 
   /**
    * @file laguerre
@@ -4858,7 +4962,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the irregular Spherical Conical Function
    *  $P^{1/2}_{-1/2 + i \lambda}(x)$ for $x > -1$.
    */
-  ADDFUNC(gsl_sf_conicalP_half, 2);
+  ADDFUNC_VEC(gsl_sf_conicalP_half, 2);
 
   /**
    * .. function:: gsl_sf_conicalP_mhalf(lambda, x)
@@ -4866,7 +4970,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the regular Spherical Conical Function
    *  $P^{-1/2}_{-1/2 + i \lambda}(x)$ for $x > -1$.
    */
-  ADDFUNC(gsl_sf_conicalP_mhalf, 2);
+  ADDFUNC_VEC(gsl_sf_conicalP_mhalf, 2);
 
   /**
    * .. function:: gsl_sf_conicalP_0(lambda, x)
@@ -4874,7 +4978,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the conical function
    *  $P^0_{-1/2 + i \lambda}(x)$ for $x > -1$.
    */
-  ADDFUNC(gsl_sf_conicalP_0, 2);
+  ADDFUNC_VEC(gsl_sf_conicalP_0, 2);
 
   /**
    * .. function:: gsl_sf_conicalP_1(lambda, x)
@@ -4882,7 +4986,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the conical function
    *  $P^1_{-1/2 + i \lambda}(x)$ for $x > -1$.
    */
-  ADDFUNC(gsl_sf_conicalP_1, 2);
+  ADDFUNC_VEC(gsl_sf_conicalP_1, 2);
 
   /**
    * .. function:: gsl_sf_conicalP_sph_reg(l, lambda, x)
@@ -4923,7 +5027,7 @@ void funcadd_ASL(AmplExports *ae)
    *  In the flat limit this takes the form
    *  $L^{H3d}_0(\lambda,\eta) = j_0(\lambda\eta)$.
    */
-  ADDFUNC(gsl_sf_legendre_H3d_0, 2);
+  ADDFUNC_VEC(gsl_sf_legendre_H3d_0, 2);
 
   /**
    * .. function:: gsl_sf_legendre_H3d_1(lambda, eta)
@@ -4939,7 +5043,7 @@ void funcadd_ASL(AmplExports *ae)
    *  In the flat limit this takes the form
    *  $L^{H3d}_1(\lambda,\eta) = j_1(\lambda\eta)$.
    */
-  ADDFUNC(gsl_sf_legendre_H3d_1, 2);
+  ADDFUNC_VEC(gsl_sf_legendre_H3d_1, 2);
 
   /**
    * .. function:: gsl_sf_legendre_H3d(l, lambda, eta)
@@ -5156,7 +5260,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the real part of the digamma function on
    *  the line $1+i y, \operatorname{Re}[\psi(1 + i y)]$.
    */
-  ADDFUNC(gsl_sf_psi_1piy, 1);
+  ADDFUNC_VEC(gsl_sf_psi_1piy, 1);
 
   /**
    * Trigamma Function
@@ -5204,7 +5308,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the first `synchrotron function`:index:
    *  $x \int_x^\infty K_{5/3}(t) dt$ for $x \geq 0$.
    */
-  ADDFUNC(gsl_sf_synchrotron_1, 1);
+  ADDFUNC_VEC(gsl_sf_synchrotron_1, 1);
 
   /**
    * .. function:: gsl_sf_synchrotron_2(x)
@@ -5212,7 +5316,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the second synchrotron function
    *  $x K_{2/3}(x)$ for $x \geq 0$.
    */
-  ADDFUNC(gsl_sf_synchrotron_2, 1);
+  ADDFUNC_VEC(gsl_sf_synchrotron_2, 1);
 
   /**
    * @file transport
@@ -5291,7 +5395,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the Riemann zeta function $\zeta(s)$ for arbitrary
    *  $s, s \ne 1$.
    */
-  ADDFUNC(gsl_sf_zeta, 1);
+  ADDFUNC_VEC(gsl_sf_zeta, 1);
 
   /**
    * Riemann Zeta Function Minus One
@@ -5314,7 +5418,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  This routine computes $\zeta(s) - 1$ for arbitrary $s, s \ne 1.$.
    */
-  ADDFUNC(gsl_sf_zetam1, 1);
+  ADDFUNC_VEC(gsl_sf_zetam1, 1);
 
   /**
    * Hurwitz Zeta Function
@@ -5330,7 +5434,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This routine computes the Hurwitz zeta function $\zeta(s,q)$ for
    *  $s > 1, q > 0$.
    */
-  ADDFUNC(gsl_sf_hzeta, 2);
+  ADDFUNC_VEC(gsl_sf_hzeta, 2);
 
   /**
    * Eta Function
@@ -5351,7 +5455,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  This routine computes the eta function $\eta(s)$ for arbitrary $s$.
    */
-  ADDFUNC(gsl_sf_eta, 1);
+  ADDFUNC_VEC(gsl_sf_eta, 1);
 
   /**
    * @file sf-refs
@@ -5549,7 +5653,7 @@ void funcadd_ASL(AmplExports *ae)
    *  Box-Muller algorithm which requires two calls to the random number
    *  generator.
    */
-  ADDFUNC_RANDOM(gsl_ran_gaussian, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gaussian, 1);
 
   /**
    * .. function:: gsl_ran_gaussian_pdf(x, sigma)
@@ -5563,7 +5667,7 @@ void funcadd_ASL(AmplExports *ae)
   /**
    * .. function:: gsl_ran_gaussian_ziggurat(sigma)
    */
-  ADDFUNC_RANDOM(gsl_ran_gaussian_ziggurat, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gaussian_ziggurat, 1);
 
   /**
    * .. function:: gsl_ran_gaussian_ratio_method(sigma)
@@ -5572,12 +5676,12 @@ void funcadd_ASL(AmplExports *ae)
    *  Marsaglia-Tsang ziggurat and Kinderman-Monahan-Leva ratio methods.
    *  The Ziggurat algorithm is the fastest available algorithm in most cases.
    */
-  ADDFUNC_RANDOM(gsl_ran_gaussian_ratio_method, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gaussian_ratio_method, 1);
 
   /**
    * .. function:: gsl_ran_ugaussian()
    */
-  ADDFUNC_RANDOM(gsl_ran_ugaussian, 0);
+  ADDFUNC_RANDOM_VEC(gsl_ran_ugaussian, 0);
 
   /**
    * .. function:: gsl_ran_ugaussian_pdf(x)
@@ -5591,7 +5695,7 @@ void funcadd_ASL(AmplExports *ae)
    *  They are equivalent to the functions above with a standard deviation
    *  of one, ``sigma`` = 1.
    */
-  ADDFUNC_RANDOM(gsl_ran_ugaussian_ratio_method, 0);
+  ADDFUNC_RANDOM_VEC(gsl_ran_ugaussian_ratio_method, 0);
 
   /**
    * .. function:: gsl_cdf_gaussian_P(x, sigma)
@@ -5601,12 +5705,12 @@ void funcadd_ASL(AmplExports *ae)
   /**
    * .. function:: gsl_cdf_gaussian_Q(x, sigma)
    */
-  ADDFUNC(gsl_cdf_gaussian_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_gaussian_Q, 2);
 
   /**
    * .. function:: gsl_cdf_gaussian_Pinv(P, sigma)
    */
-  ADDFUNC(gsl_cdf_gaussian_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_gaussian_Pinv, 2);
 
   /**
    * .. function:: gsl_cdf_gaussian_Qinv(Q, sigma)
@@ -5615,7 +5719,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Gaussian distribution with
    *  standard deviation ``sigma``.
    */
-  ADDFUNC(gsl_cdf_gaussian_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_gaussian_Qinv, 2);
 
   /**
    * .. function:: gsl_cdf_ugaussian_P(x)
@@ -5625,7 +5729,7 @@ void funcadd_ASL(AmplExports *ae)
   /**
    * .. function:: gsl_cdf_ugaussian_Q(x)
    */
-  ADDFUNC(gsl_cdf_ugaussian_Q, 1);
+  ADDFUNC_VEC(gsl_cdf_ugaussian_Q, 1);
 
   /**
    * .. function:: gsl_cdf_ugaussian_Pinv(P)
@@ -5638,7 +5742,7 @@ void funcadd_ASL(AmplExports *ae)
    *  These functions compute the cumulative distribution functions
    *  $P(x), Q(x)$ and their inverses for the unit Gaussian distribution.
    */
-  ADDFUNC(gsl_cdf_ugaussian_Qinv, 1);
+  ADDFUNC_VEC(gsl_cdf_ugaussian_Qinv, 1);
 
   /**
    * @file ran-gaussian-tail
@@ -5668,7 +5772,7 @@ void funcadd_ASL(AmplExports *ae)
    *  .. math::
    *    N(a;\sigma) = (1/2) \operatorname{erfc}(a / \sqrt{2 \sigma^2}).
    */
-  ADDFUNC_RANDOM(gsl_ran_gaussian_tail, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gaussian_tail, 2);
 
   /**
    * .. function:: gsl_ran_gaussian_tail_pdf(x, a, sigma)
@@ -5677,12 +5781,12 @@ void funcadd_ASL(AmplExports *ae)
    *  Gaussian tail distribution with standard deviation ``sigma`` and lower
    *  limit ``a``, using the formula given above.
    */
-  ADDFUNC(gsl_ran_gaussian_tail_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_gaussian_tail_pdf, 3);
 
   /**
    * .. function:: gsl_ran_ugaussian_tail(a)
    */
-  ADDFUNC_RANDOM(gsl_ran_ugaussian_tail, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_ugaussian_tail, 1);
 
   /**
    * .. function:: gsl_ran_ugaussian_tail_pdf(x, a)
@@ -5691,7 +5795,7 @@ void funcadd_ASL(AmplExports *ae)
    *  distribution. They are equivalent to the functions above with a
    *  standard deviation of one, ``sigma`` = 1.
    */
-  ADDFUNC(gsl_ran_ugaussian_tail_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_ugaussian_tail_pdf, 2);
 
   /* The bivariate Gaussian distribution is not wrapped because it returns
      more than one value. */
@@ -5714,7 +5818,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x \geq 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_exponential, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_exponential, 1);
 
   /**
    * .. function:: gsl_ran_exponential_pdf(x, mu)
@@ -5727,17 +5831,17 @@ void funcadd_ASL(AmplExports *ae)
   /**
    * .. function:: gsl_cdf_exponential_P(x, mu)
    */
-  ADDFUNC(gsl_cdf_exponential_P, 2);
+  ADDFUNC_VEC(gsl_cdf_exponential_P, 2);
 
   /**
    * .. function:: gsl_cdf_exponential_Q(x, mu)
    */
-  ADDFUNC(gsl_cdf_exponential_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_exponential_Q, 2);
 
   /**
    * .. function:: gsl_cdf_exponential_Pinv(P, mu)
    */
-  ADDFUNC(gsl_cdf_exponential_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_exponential_Pinv, 2);
 
   /**
    * .. function:: gsl_cdf_exponential_Qinv(Q, mu)
@@ -5746,7 +5850,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the exponential distribution
    *  with mean ``mu``.
    */
-  ADDFUNC(gsl_cdf_exponential_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_exponential_Qinv, 2);
 
   /**
    * @file ran-laplace
@@ -5766,7 +5870,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $-\infty < x < \infty$.
    */
-  ADDFUNC_RANDOM(gsl_ran_laplace, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_laplace, 1);
 
   /**
    * .. function:: gsl_ran_laplace_pdf(x, a)
@@ -5779,17 +5883,17 @@ void funcadd_ASL(AmplExports *ae)
   /**
    * .. function:: gsl_ran_laplace_P(x, a)
    */
-  ADDFUNC(gsl_cdf_laplace_P, 2);
+  ADDFUNC_VEC(gsl_cdf_laplace_P, 2);
 
   /**
    * .. function:: gsl_ran_laplace_Q(x, a)
    */
-  ADDFUNC(gsl_cdf_laplace_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_laplace_Q, 2);
 
   /**
    * .. function:: gsl_ran_laplace_Pinv(P, a)
    */
-  ADDFUNC(gsl_cdf_laplace_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_laplace_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_laplace_Qinv(Q, a)
@@ -5798,7 +5902,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Laplace distribution
    *  with width ``a``.
    */
-  ADDFUNC(gsl_cdf_laplace_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_laplace_Qinv, 2);
 
   /**
    * @file ran-exppow
@@ -5821,7 +5925,7 @@ void funcadd_ASL(AmplExports *ae)
    *  For $b = 2$ it has the same form as a Gaussian distribution, but with
    *  $a = \sqrt{2} \sigma$.
    */
-  ADDFUNC_RANDOM(gsl_ran_exppow, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_exppow, 2);
 
   /**
    * .. function:: gsl_ran_exppow_pdf(x, a, b)
@@ -5830,12 +5934,12 @@ void funcadd_ASL(AmplExports *ae)
    *  exponential power distribution with scale parameter ``a`` and exponent
    *  ``b``, using the formula given above.
    */
-  ADDFUNC(gsl_ran_exppow_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_exppow_pdf, 3);
 
   /**
    * .. function:: gsl_ran_exppow_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_exppow_P, 3);
+  ADDFUNC_VEC(gsl_cdf_exppow_P, 3);
 
   /**
    * .. function:: gsl_ran_exppow_Q(x, a, b)
@@ -5844,7 +5948,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ for the exponential power distribution with parameters
    *  ``a`` and ``b``.
    */
-  ADDFUNC(gsl_cdf_exppow_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_exppow_Q, 3);
 
   /**
    * @file ran-cauchy
@@ -5866,7 +5970,7 @@ void funcadd_ASL(AmplExports *ae)
    *  for $x$ in the range $-\infty$ to $+\infty$. The Cauchy distribution
    *  is also known as the Lorentz distribution.
    */
-  ADDFUNC_RANDOM(gsl_ran_cauchy, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_cauchy, 1);
 
   /**
    * .. function:: gsl_ran_cauchy_pdf(x, a)
@@ -5875,22 +5979,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Cauchy distribution with scale parameter ``a``, using the formula
    *  given above.
    */
-  ADDFUNC(gsl_ran_cauchy_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_cauchy_pdf, 2);
 
   /**
    * .. function:: gsl_ran_cauchy_P(x, a)
    */
-  ADDFUNC(gsl_cdf_cauchy_P, 2);
+  ADDFUNC_VEC(gsl_cdf_cauchy_P, 2);
 
   /**
    * .. function:: gsl_ran_cauchy_Q(x, a)
    */
-  ADDFUNC(gsl_cdf_cauchy_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_cauchy_Q, 2);
 
   /**
    * .. function:: gsl_ran_cauchy_Pinv(P, a)
    */
-  ADDFUNC(gsl_cdf_cauchy_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_cauchy_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_cauchy_Qinv(Q, a)
@@ -5899,7 +6003,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Cauchy distribution with
    *  scale parameter ``a``.
    */
-  ADDFUNC(gsl_cdf_cauchy_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_cauchy_Qinv, 2);
 
   /**
    * @file ran-rayleigh
@@ -5920,7 +6024,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x > 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_rayleigh, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_rayleigh, 1);
 
   /**
    * .. function:: gsl_ran_rayleigh_pdf(x, sigma)
@@ -5929,22 +6033,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Rayleigh distribution with scale parameter ``sigma``, using the formula
    *  given above.
    */
-  ADDFUNC(gsl_ran_rayleigh_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_rayleigh_pdf, 2);
 
   /**
    * .. function:: gsl_ran_rayleigh_P(x, sigma)
    */
-  ADDFUNC(gsl_cdf_rayleigh_P, 2);
+  ADDFUNC_VEC(gsl_cdf_rayleigh_P, 2);
 
   /**
    * .. function:: gsl_ran_rayleigh_Q(x, sigma)
    */
-  ADDFUNC(gsl_cdf_rayleigh_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_rayleigh_Q, 2);
 
   /**
    * .. function:: gsl_ran_rayleigh_Pinv(P, sigma)
    */
-  ADDFUNC(gsl_cdf_rayleigh_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_rayleigh_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_rayleigh_Qinv(Q, sigma)
@@ -5953,7 +6057,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Rayleigh distribution with
    *  scale parameter ``sigma``.
    */
-  ADDFUNC(gsl_cdf_rayleigh_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_rayleigh_Qinv, 2);
 
   /**
    * @file ran-rayleigh-tail
@@ -5974,7 +6078,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x > a$.
    */
-  ADDFUNC_RANDOM(gsl_ran_rayleigh_tail, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_rayleigh_tail, 2);
 
   /**
    * .. function:: gsl_ran_rayleigh_tail_pdf(x, a, sigma)
@@ -5983,7 +6087,7 @@ void funcadd_ASL(AmplExports *ae)
    *  Rayleigh tail distribution with scale parameter ``sigma`` and lower
    *  limit ``a``, using the formula given above.
    */
-  ADDFUNC(gsl_ran_rayleigh_tail_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_rayleigh_tail_pdf, 3);
 
   /**
    * @file ran-landau
@@ -6009,7 +6113,7 @@ void funcadd_ASL(AmplExports *ae)
    *  .. math::
    *    p(x) = (1/\pi) \int_0^\infty \exp(-t \log(t) - x t) \sin(\pi t) dt.
    */
-  ADDFUNC_RANDOM(gsl_ran_landau, 0);
+  ADDFUNC_RANDOM_VEC(gsl_ran_landau, 0);
 
   /**
    * .. function:: gsl_ran_landau_pdf(x)
@@ -6017,7 +6121,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This function computes the probability density $p(x)$ at $x$ for the
    *  Landau distribution using an approximation to the formula given above.
    */
-  ADDFUNC(gsl_ran_landau_pdf, 1);
+  ADDFUNC_VEC(gsl_ran_landau_pdf, 1);
 
   /**
    * @file ran-levy
@@ -6046,7 +6150,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  The algorithm only works for $0 < \alpha \leq 2$.
    */
-  ADDFUNC_RANDOM(gsl_ran_levy, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_levy, 2);
 
   /**
    * @file ran-levy-skew
@@ -6085,7 +6189,7 @@ void funcadd_ASL(AmplExports *ae)
    * will also be distributed as an alpha-stable variate,
    * $p(N^{1/\alpha} c, \alpha, \beta)$.
    */
-  ADDFUNC_RANDOM(gsl_ran_levy_skew, 3);
+  ADDFUNC_RANDOM_VEC(gsl_ran_levy_skew, 3);
 
   /**
    * @file ran-gamma
@@ -6110,7 +6214,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  The variates are computed using the Marsaglia-Tsang fast gamma method.
    */
-  ADDFUNC_RANDOM(gsl_ran_gamma, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gamma, 2);
 
   /**
    * .. function:: gsl_ran_gamma_knuth(a, b)
@@ -6118,7 +6222,7 @@ void funcadd_ASL(AmplExports *ae)
    *  This function returns a gamma variate using the algorithms from Knuth
    *  (vol 2).
    */
-  ADDFUNC_RANDOM(gsl_ran_gamma_knuth, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gamma_knuth, 2);
 
   /**
    * .. function:: gsl_ran_gamma_pdf(x, a, b)
@@ -6127,22 +6231,22 @@ void funcadd_ASL(AmplExports *ae)
    *  gamma distribution with parameters ``a`` and ``b``, using the formula
    *  given above.
    */
-  ADDFUNC(gsl_ran_gamma_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_gamma_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_gamma_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gamma_P, 3);
+  ADDFUNC_VEC(gsl_cdf_gamma_P, 3);
 
   /**
    * .. function:: gsl_cdf_gamma_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gamma_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_gamma_Q, 3);
 
   /**
    * .. function:: gsl_cdf_gamma_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_gamma_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gamma_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_gamma_Qinv(Q, a, b)
@@ -6151,7 +6255,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the gamma distribution with
    *  parameters ``a`` and ``b``.
    */
-  ADDFUNC(gsl_cdf_gamma_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gamma_Qinv, 3);
 
   /**
    * @file ran-flat
@@ -6175,7 +6279,7 @@ void funcadd_ASL(AmplExports *ae)
    *    flat distribution
    *    uniform distribution
    */
-  ADDFUNC_RANDOM(gsl_ran_flat, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_flat, 2);
 
   /**
    * .. function:: gsl_ran_flat_pdf(x, a, b)
@@ -6183,22 +6287,22 @@ void funcadd_ASL(AmplExports *ae)
    *  This function computes the probability density $p(x)$ at $x$ for a
    *  uniform distribution from ``a`` to ``b``, using the formula given above.
    */
-  ADDFUNC(gsl_ran_flat_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_flat_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_flat_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_flat_P, 3);
+  ADDFUNC_VEC(gsl_cdf_flat_P, 3);
 
   /**
    * .. function:: gsl_cdf_flat_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_flat_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_flat_Q, 3);
 
   /**
    * .. function:: gsl_cdf_flat_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_flat_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_flat_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_flat_Qinv(Q, a, b)
@@ -6207,7 +6311,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for a uniform distribution from
    *  ``a`` to ``b``.
    */
-  ADDFUNC(gsl_cdf_flat_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_flat_Qinv, 3);
 
   /**
    * @file ran-lognormal
@@ -6228,7 +6332,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x > 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_lognormal, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_lognormal, 2);
 
   /**
    * .. function:: gsl_ran_lognormal_pdf(x, zeta, sigma)
@@ -6237,22 +6341,22 @@ void funcadd_ASL(AmplExports *ae)
    *  lognormal distribution with parameters ``zeta`` and ``sigma``, using
    *  the formula given above.
    */
-  ADDFUNC(gsl_ran_lognormal_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_lognormal_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_lognormal_P(x, zeta, sigma)
    */
-  ADDFUNC(gsl_cdf_lognormal_P, 3);
+  ADDFUNC_VEC(gsl_cdf_lognormal_P, 3);
 
   /**
    * .. function:: gsl_cdf_lognormal_Q(x, zeta, sigma)
    */
-  ADDFUNC(gsl_cdf_lognormal_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_lognormal_Q, 3);
 
   /**
    * .. function:: gsl_cdf_lognormal_Pinv(P, zeta, sigma)
    */
-  ADDFUNC(gsl_cdf_lognormal_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_lognormal_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_lognormal_Qinv(Q, zeta, sigma)
@@ -6261,7 +6365,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the lognormal distribution
    *  with parameters ``zeta`` and ``sigma``.
    */
-  ADDFUNC(gsl_cdf_lognormal_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_lognormal_Qinv, 3);
 
   /**
    * @file ran-chisq
@@ -6290,7 +6394,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x \geq 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_chisq, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_chisq, 1);
 
   /**
    * .. function:: gsl_ran_chisq_pdf(x, nu)
@@ -6299,22 +6403,22 @@ void funcadd_ASL(AmplExports *ae)
    *  chi-squared distribution with ``nu`` degrees of freedom, using the
    *  formula given above.
    */
-  ADDFUNC(gsl_ran_chisq_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_chisq_pdf, 2);
 
   /**
    * .. function:: gsl_ran_chisq_P(x, nu)
    */
-  ADDFUNC(gsl_cdf_chisq_P, 2);
+  ADDFUNC_VEC(gsl_cdf_chisq_P, 2);
 
   /**
    * .. function:: gsl_ran_chisq_Q(x, nu)
    */
-  ADDFUNC(gsl_cdf_chisq_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_chisq_Q, 2);
 
   /**
    * .. function:: gsl_ran_chisq_Pinv(P, nu)
    */
-  ADDFUNC(gsl_cdf_chisq_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_chisq_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_chisq_Qinv(Q, nu)
@@ -6323,7 +6427,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the chi-squared distribution
    *  with ``nu`` degrees of freedom.
    */
-  ADDFUNC(gsl_cdf_chisq_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_chisq_Qinv, 2);
 
   /**
    * @file ran-fdist
@@ -6356,7 +6460,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    * for $x \geq 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_fdist, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_fdist, 2);
 
   /**
    * .. function:: gsl_ran_fdist_pdf(x, nu1, nu2)
@@ -6365,22 +6469,22 @@ void funcadd_ASL(AmplExports *ae)
    *  F-distribution with ``nu1`` and ``nu2`` degrees of freedom, using
    *  the formula given above.
    */
-  ADDFUNC(gsl_ran_fdist_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_fdist_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_fdist_P(x, nu1, nu2)
    */
-  ADDFUNC(gsl_cdf_fdist_P, 3);
+  ADDFUNC_VEC(gsl_cdf_fdist_P, 3);
 
   /**
    * .. function:: gsl_cdf_fdist_Q(x, nu1, nu2)
    */
-  ADDFUNC(gsl_cdf_fdist_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_fdist_Q, 3);
 
   /**
    * .. function:: gsl_cdf_fdist_Pinv(P, nu1, nu2)
    */
-  ADDFUNC(gsl_cdf_fdist_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_fdist_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_fdist_Qinv(Q, nu1, nu2)
@@ -6389,7 +6493,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the F-distribution with
    *  ``nu1`` and ``nu2`` degrees of freedom.
    */
-  ADDFUNC(gsl_cdf_fdist_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_fdist_Qinv, 3);
 
   /**
    * @file ran-tdist
@@ -6419,7 +6523,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $-\infty < x < +\infty$.
    */
-  ADDFUNC_RANDOM(gsl_ran_tdist, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_tdist, 1);
 
   /**
    * .. function:: gsl_ran_tdist_pdf(x, nu)
@@ -6428,22 +6532,22 @@ void funcadd_ASL(AmplExports *ae)
    *  t-distribution with ``nu`` degrees of freedom, using the formula
    *  given above.
    */
-  ADDFUNC(gsl_ran_tdist_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_tdist_pdf, 2);
 
   /**
    * .. function:: gsl_ran_tdist_P(x, nu)
    */
-  ADDFUNC(gsl_cdf_tdist_P, 2);
+  ADDFUNC_VEC(gsl_cdf_tdist_P, 2);
 
   /**
    * .. function:: gsl_ran_tdist_Q(x, nu)
    */
-  ADDFUNC(gsl_cdf_tdist_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_tdist_Q, 2);
 
   /**
    * .. function:: gsl_ran_tdist_Pinv(P, nu)
    */
-  ADDFUNC(gsl_cdf_tdist_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_tdist_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_tdist_Qinv(Q, nu)
@@ -6452,7 +6556,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the t-distribution with ``nu``
    *  degrees of freedom.
    */
-  ADDFUNC(gsl_cdf_tdist_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_tdist_Qinv, 2);
 
   /**
    * @file ran-beta
@@ -6473,7 +6577,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $0 \leq x \leq 1$.
    */
-  ADDFUNC_RANDOM(gsl_ran_beta, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_beta, 2);
 
   /**
    * .. function:: gsl_ran_beta_pdf(x, a, b)
@@ -6482,22 +6586,22 @@ void funcadd_ASL(AmplExports *ae)
    *  beta distribution with parameters ``a`` and ``b``, using the formula
    *  given above.
    */
-  ADDFUNC(gsl_ran_beta_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_beta_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_beta_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_beta_P, 3);
+  ADDFUNC_VEC(gsl_cdf_beta_P, 3);
 
   /**
    * .. function:: gsl_cdf_beta_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_beta_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_beta_Q, 3);
 
   /**
    * .. function:: gsl_cdf_beta_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_beta_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_beta_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_beta_Qinv(Q, a, b)
@@ -6506,7 +6610,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the beta distribution with
    *  parameters ``a`` and ``b``.
    */
-  ADDFUNC(gsl_cdf_beta_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_beta_Qinv, 3);
 
   /**
    * @file ran-logistic
@@ -6526,7 +6630,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $-\infty < x < \infty$.
    */
-  ADDFUNC_RANDOM(gsl_ran_logistic, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_logistic, 1);
 
   /**
    * .. function:: gsl_ran_logistic_pdf(x, a)
@@ -6535,22 +6639,22 @@ void funcadd_ASL(AmplExports *ae)
    *  logistic distribution with scale parameter a, using the formula given
    *  above.
    */
-  ADDFUNC(gsl_ran_logistic_pdf, 2);
+  ADDFUNC_VEC(gsl_ran_logistic_pdf, 2);
 
   /**
    * .. function:: gsl_ran_logistic_P(x, a)
    */
-  ADDFUNC(gsl_cdf_logistic_P, 2);
+  ADDFUNC_VEC(gsl_cdf_logistic_P, 2);
 
   /**
    * .. function:: gsl_ran_logistic_Q(x, a)
    */
-  ADDFUNC(gsl_cdf_logistic_Q, 2);
+  ADDFUNC_VEC(gsl_cdf_logistic_Q, 2);
 
   /**
    * .. function:: gsl_ran_logistic_Pinv(P, a)
    */
-  ADDFUNC(gsl_cdf_logistic_Pinv, 2);
+  ADDFUNC_VEC(gsl_cdf_logistic_Pinv, 2);
 
   /**
    * .. function:: gsl_ran_logistic_Qinv(Q, a)
@@ -6559,7 +6663,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the logistic distribution
    *  with scale parameter ``a``.
    */
-  ADDFUNC(gsl_cdf_logistic_Qinv, 2);
+  ADDFUNC_VEC(gsl_cdf_logistic_Qinv, 2);
 
   /**
    * @file ran-pareto
@@ -6579,7 +6683,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x \geq b$.
    */
-  ADDFUNC_RANDOM(gsl_ran_pareto, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_pareto, 2);
 
   /**
    * .. function:: gsl_ran_pareto_pdf(x, a, b)
@@ -6588,22 +6692,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Pareto distribution with exponent ``a`` and scale ``b``, using the
    *  formula given above.
    */
-  ADDFUNC(gsl_ran_pareto_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_pareto_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_pareto_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_pareto_P, 3);
+  ADDFUNC_VEC(gsl_cdf_pareto_P, 3);
 
   /**
    * .. function:: gsl_cdf_pareto_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_pareto_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_pareto_Q, 3);
 
   /**
    * .. function:: gsl_cdf_pareto_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_pareto_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_pareto_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_pareto_Qinv(Q, a, b)
@@ -6612,7 +6716,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Pareto distribution
    *  with exponent ``a`` and scale ``b``.
    */
-  ADDFUNC(gsl_cdf_pareto_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_pareto_Qinv, 3);
 
   /* The spherical vector distributions are not wrapped because they return
      more than one value. */
@@ -6635,7 +6739,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $x \geq 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_weibull, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_weibull, 2);
 
   /**
    * .. function:: gsl_ran_weibull_pdf(x, a, b)
@@ -6644,22 +6748,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Weibull distribution with scale ``a`` and exponent ``b``, using the
    *  formula given above.
    */
-  ADDFUNC(gsl_ran_weibull_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_weibull_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_weibull_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_weibull_P, 3);
+  ADDFUNC_VEC(gsl_cdf_weibull_P, 3);
 
   /**
    * .. function:: gsl_cdf_weibull_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_weibull_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_weibull_Q, 3);
 
   /**
    * .. function:: gsl_cdf_weibull_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_weibull_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_weibull_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_weibull_Qinv(Q, a, b)
@@ -6668,7 +6772,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Weibull distribution
    *  with scale ``a`` and exponent ``b``.
    */
-  ADDFUNC(gsl_cdf_weibull_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_weibull_Qinv, 3);
 
   /**
    * @file ran-gumbel1
@@ -6688,7 +6792,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $-\infty < x < \infty$.
    */
-  ADDFUNC_RANDOM(gsl_ran_gumbel1, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gumbel1, 2);
 
   /**
    * .. function:: gsl_ran_gumbel1_pdf(x, a, b)
@@ -6697,22 +6801,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Type-1 Gumbel distribution with parameters ``a`` and ``b``, using the
    *  formula given above.
    */
-  ADDFUNC(gsl_ran_gumbel1_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_gumbel1_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel1_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel1_P, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel1_P, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel1_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel1_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel1_Q, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel1_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel1_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel1_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel1_Qinv(Q, a, b)
@@ -6721,7 +6825,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Type-1 Gumbel distribution
    *  with parameters ``a`` and ``b``.
    */
-  ADDFUNC(gsl_cdf_gumbel1_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel1_Qinv, 3);
 
   /**
    * @file ran-gumbel2
@@ -6741,7 +6845,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $-\infty < x < \infty$.
    */
-  ADDFUNC_RANDOM(gsl_ran_gumbel2, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_gumbel2, 2);
 
   /**
    * .. function:: gsl_ran_gumbel2_pdf(x, a, b)
@@ -6750,22 +6854,22 @@ void funcadd_ASL(AmplExports *ae)
    *  Type-2 Gumbel distribution with parameters ``a`` and ``b``, using the
    *  formula given above.
    */
-  ADDFUNC(gsl_ran_gumbel2_pdf, 3);
+  ADDFUNC_VEC(gsl_ran_gumbel2_pdf, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel2_P(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel2_P, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel2_P, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel2_Q(x, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel2_Q, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel2_Q, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel2_Pinv(P, a, b)
    */
-  ADDFUNC(gsl_cdf_gumbel2_Pinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel2_Pinv, 3);
 
   /**
    * .. function:: gsl_cdf_gumbel2_Qinv(Q, a, b)
@@ -6774,7 +6878,7 @@ void funcadd_ASL(AmplExports *ae)
    *  $P(x), Q(x)$ and their inverses for the Type-2 Gumbel distribution
    *  with parameters ``a`` and ``b``.
    */
-  ADDFUNC(gsl_cdf_gumbel2_Qinv, 3);
+  ADDFUNC_VEC(gsl_cdf_gumbel2_Qinv, 3);
 
   /* The Dirichlet distributions is not wrapped because it returns more
      than one value. */
@@ -6801,7 +6905,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $k \geq 0$.
    */
-  ADDFUNC_RANDOM(gsl_ran_poisson, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_poisson, 1);
 
   /**
    * .. function:: gsl_ran_poisson_pdf(k, mu)
@@ -6844,7 +6948,7 @@ void funcadd_ASL(AmplExports *ae)
    *    p(0) = 1 - p \\
    *    p(1) = p
    */
-  ADDFUNC_RANDOM(gsl_ran_bernoulli, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_bernoulli, 1);
 
   /**
    * .. function:: gsl_ran_bernoulli_pdf(k, p)
@@ -6923,7 +7027,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  Note that ``n`` is not required to be an integer.
    */
-  ADDFUNC_RANDOM(gsl_ran_negative_binomial, 2);
+  ADDFUNC_RANDOM_VEC(gsl_ran_negative_binomial, 2);
 
   /**
    * .. function:: gsl_ran_negative_binomial_pdf(k, p, n)
@@ -7014,7 +7118,7 @@ void funcadd_ASL(AmplExports *ae)
    *  definition. There is another convention in which the exponent $k-1$ is
    *  replaced by $k$.
    */
-  ADDFUNC_RANDOM(gsl_ran_geometric, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_geometric, 1);
 
   /**
    * .. function:: gsl_ran_geometric_pdf(k, p)
@@ -7107,7 +7211,7 @@ void funcadd_ASL(AmplExports *ae)
    *
    *  for $k \geq 1$.
    */
-  ADDFUNC_RANDOM(gsl_ran_logarithmic, 1);
+  ADDFUNC_RANDOM_VEC(gsl_ran_logarithmic, 1);
 
   /**
    * .. function:: gsl_ran_logarithmic_pdf(k, p)
@@ -0,0 +1,55 @@
+/*
+ Vector evaluation interface of the AMPL bindings for GNU Scientific Library.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+ */
+
+#ifndef AMPLGSL_H_
+#define AMPLGSL_H_
+
+#include "funcadd.h"
+
+/*
+ * Evaluates a function at num_points points. x[j] points to the values of
+ * argument j at all points, so the arguments of point i are
+ * x[0][i], ..., x[al->n - 1][i]. The function values are stored in
+ * y[0], ..., y[num_points - 1].
+ *
+ * al should be set up as for a scalar call except that al->derivs and
+ * al->hes should be null: derivatives are not computed. al->ra is used
+ * as scratch space for the arguments of one point.
+ *
+ * Returns the number of points evaluated successfully. If it is less than
+ * num_points, al->Errmsg describes the error at the point with this index
+ * and al->ra holds the arguments of that point.
+ */
+typedef int (*amplgsl_vfunc)(arglist *al, int num_points,
+                             const real *const *x, real *y);
+
+/*
+ * Information about an amplgsl function. funcadd_ASL passes a pointer to
+ * it as funcinfo, so al->funcinfo of every amplgsl function points to an
+ * amplgsl_funcinfo object. A host that has loaded amplgsl can use vfunc
+ * to evaluate a function at many points with one call.
+ */
+typedef struct amplgsl_funcinfo {
+  const char *name;     /* function name */
+  rfunc func;           /* scalar entry point */
+  amplgsl_vfunc vfunc;  /* vector entry point, null if not available */
+} amplgsl_funcinfo;
+
+#endif  /* AMPLGSL_H_ */
@@ -0,0 +1,657 @@
+/*
+ Sparse Hessian of the Lagrangian evaluation
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/hessian.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tape-diff.h"
+
+namespace {
+
+const double LN10 = 2.302585092994045684;
+
+// First and second partial derivatives of a unary or binary instruction
+// with respect to its operands u0 and u1.
+struct Partials {
+  double d0, d1;          // d/du0, d/du1
+  double d00, d01, d11;   // d2/du0^2, d2/du0du1, d2/du1^2
+};
+
+// Computes partial derivatives of a unary or binary instruction with
+// result v. Returns the number of operands or 0 if the instruction is not
+// unary or binary or its derivatives are zero.
+int GetPartials(const mp::Tape::Instruction &instr, const double *r,
+                double v, Partials &p) {
+  namespace expr = mp::expr;
+  int opcode = instr.opcode;
+  double x = 0, y = 0;
+  if (opcode >= expr::FIRST_UNARY && opcode <= expr::LAST_UNARY) {
+    x = r[instr.arg1];
+  } else if (opcode >= expr::FIRST_BINARY && opcode <= expr::LAST_BINARY) {
+    x = r[instr.arg1];
+    y = r[instr.arg2];
+  } else {
+    return 0;
+  }
+  p.d0 = p.d1 = p.d00 = p.d01 = p.d11 = 0;
+  switch (opcode) {
+  case expr::MINUS: p.d0 = -1; return 1;
+  case expr::ABS:   p.d0 = x < 0 ? -1 : 1; return 1;
+  case expr::SQRT:
+    p.d0 = 0.5 / v;
+    p.d00 = -0.5 * p.d0 / x;
+    return 1;
+  case expr::POW2:
+    p.d0 = 2 * x;
+    p.d00 = 2;
+    return 1;
+  case expr::EXP:
+    p.d0 = p.d00 = v;
+    return 1;
+  case expr::LOG:
+    p.d0 = 1 / x;
+    p.d00 = -p.d0 * p.d0;
+    return 1;
+  case expr::LOG10:
+    p.d0 = 1 / (x * LN10);
+    p.d00 = -p.d0 / x;
+    return 1;
+  case expr::SIN:
+    p.d0 = std::cos(x);
+    p.d00 = -v;
+    return 1;
+  case expr::SINH:
+    p.d0 = std::cosh(x);
+    p.d00 = v;
+    return 1;
+  case expr::COS:
+    p.d0 = -std::sin(x);
+    p.d00 = -v;
+    return 1;
+  case expr::COSH:
+    p.d0 = std::sinh(x);
+    p.d00 = v;
+    return 1;
+  case expr::TAN: {
+    double c = std::cos(x);
+    p.d0 = 1 / (c * c);
+    p.d00 = 2 * v * p.d0;
+    return 1;
+  }
+  case expr::TANH: {
+    double c = std::cosh(x);
+    p.d0 = 1 / (c * c);
+    p.d00 = -2 * v * p.d0;
+    return 1;
+  }
+  case expr::ASIN: case expr::ACOS: {
+    double d = 1 / std::sqrt(1 - x * x);
+    p.d0 = d;
+    p.d00 = x * d * d * d;
+    if (opcode == expr::ACOS) {
+      p.d0 = -p.d0;
+      p.d00 = -p.d00;
+    }
+    return 1;
+  }
+  case expr::ASINH: {
+    double d = 1 / std::sqrt(1 + x * x);
+    p.d0 = d;
+    p.d00 = -x * d * d * d;
+    return 1;
+  }
+  case expr::ACOSH: {
+    double d = 1 / std::sqrt(x * x - 1);
+    p.d0 = d;
+    p.d00 = -x * d * d * d;
+    return 1;
+  }
+  case expr::ATAN:
+    p.d0 = 1 / (1 + x * x);
+    p.d00 = -2 * x * p.d0 * p.d0;
+    return 1;
+  case expr::ATANH:
+    p.d0 = 1 / (1 - x * x);
+    p.d00 = 2 * x * p.d0 * p.d0;
+    return 1;
+  case expr::ADD:
+    p.d0 = p.d1 = 1;
+    return 2;
+  case expr::SUB:
+    p.d0 = 1;
+    p.d1 = -1;
+    return 2;
+  case expr::LESS:
+    if (v > 0) {
+      p.d0 = 1;
+      p.d1 = -1;
+    }
+    return 2;
+  case expr::MUL:
+    p.d0 = y;
+    p.d1 = x;
+    p.d01 = 1;
+    return 2;
+  case expr::DIV:
+    p.d0 = 1 / y;
+    p.d1 = -v / y;
+    p.d01 = -p.d0 * p.d0;
+    p.d11 = -2 * p.d1 / y;
+    return 2;
+  case expr::MOD: {
+    double q = x / y;
+    p.d0 = 1;
+    p.d1 = q >= 0 ? -std::floor(q) : -std::ceil(q);
+    return 2;
+  }
+  case expr::POW_CONST_EXP:
+    p.d0 = y * std::pow(x, y - 1);
+    p.d00 = y * (y - 1) * std::pow(x, y - 2);
+    return 2;
+  case expr::POW_CONST_BASE:
+    if (x > 0) {
+      double log_x = std::log(x);
+      p.d1 = v * log_x;
+      p.d11 = p.d1 * log_x;
+    }
+    return 2;
+  case expr::POW: {
+    double pow_x = std::pow(x, y - 1);
+    p.d0 = y * pow_x;
+    p.d00 = y * (y - 1) * std::pow(x, y - 2);
+    if (x > 0) {
+      double log_x = std::log(x);
+      p.d1 = v * log_x;
+      p.d01 = pow_x * (1 + y * log_x);
+      p.d11 = p.d1 * log_x;
+    }
+    return 2;
+  }
+  case expr::ATAN2: {
+    double d = x * x + y * y;
+    p.d0 = y / d;
+    p.d1 = -x / d;
+    d *= d;
+    p.d00 = -2 * x * y / d;
+    p.d01 = (x * x - y * y) / d;
+    p.d11 = 2 * x * y / d;
+    return 2;
+  }
+  }
+  return 0;
+}
+
+// Returns the register of the operand that an if-then-else, min, max or
+// piecewise-linear instruction with result v depends on locally and the
+// corresponding derivative in coef, or -1 if there is no such operand.
+int GetActiveArg(const mp::Tape &t, const mp::Tape::Instruction &instr,
+                 const double *r, double v, double &coef) {
+  namespace expr = mp::expr;
+  coef = 1;
+  switch (instr.opcode) {
+  case expr::IF:
+    return r[instr.arg1] != 0 ? instr.arg2 : instr.arg3;
+  case expr::PLTERM:
+    coef = mp::internal::GetPLTermSlope(
+          t.data() + instr.arg2, instr.arg3, r[instr.arg1]);
+    return instr.arg1;
+  case expr::MIN: case expr::MAX:
+    for (const int *arg = t.args() + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg) {
+      if (r[*arg] == v)
+        return *arg;
+    }
+    break;
+  }
+  return -1;
+}
+
+// Returns true if an instruction with the specified opcode has nonzero
+// second derivatives.
+bool IsNonlinear(int opcode) {
+  namespace expr = mp::expr;
+  switch (opcode) {
+  case expr::MINUS: case expr::ABS: case expr::FLOOR: case expr::CEIL:
+    return false;
+  case expr::MUL: case expr::DIV: case expr::POW: case expr::POW_CONST_BASE:
+  case expr::POW_CONST_EXP: case expr::ATAN2:
+    return true;
+  }
+  return opcode >= expr::FIRST_UNARY && opcode <= expr::LAST_UNARY;
+}
+
+// Adds the elements (i, j) for all i in rows and j in cols to the upper
+// triangle of a sparsity pattern stored by columns.
+void AddElements(const std::vector<int> &rows, const std::vector<int> &cols,
+                 std::vector< std::vector<int> > &pattern) {
+  for (std::size_t i = 0, m = rows.size(); i < m; ++i) {
+    for (std::size_t j = 0, n = cols.size(); j < n; ++j) {
+      int row = rows[i], col = cols[j];
+      if (row > col)
+        std::swap(row, col);
+      pattern[col].push_back(row);
+    }
+  }
+}
+
+// Sorts the elements of v and removes duplicates.
+void SortUnique(std::vector<int> &v) {
+  std::sort(v.begin(), v.end());
+  v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+}
+
+mp::HessianEvaluator::HessianEvaluator(const Tape &tape)
+  : eval_(tape), num_colors_(0) {
+  FindSparsity();
+  Color();
+  int num_registers = std::max(tape.num_registers(), 1);
+  compressed_.resize(hes_vars_.size() * num_colors_);
+  tangents_.resize(static_cast<std::size_t>(num_registers) * BATCH_SIZE);
+  adjoints_.resize(num_registers);
+  adjoint_tangents_.resize(tangents_.size());
+}
+
+void mp::HessianEvaluator::FindSparsity() {
+  const Tape &t = tape();
+  int num_vars = t.num_vars(), first_result = t.first_result();
+
+  // Find instructions that the Lagrangian depends on.
+  std::vector<bool> visited(t.num_registers());
+  std::vector<int> stack;
+  for (int i = 0, n = t.num_objs(); i < n; ++i)
+    stack.push_back(t.obj_register(i));
+  for (int i = 0, n = t.num_cons(); i < n; ++i)
+    stack.push_back(t.con_register(i));
+  while (!stack.empty()) {
+    int reg = stack.back();
+    stack.pop_back();
+    if (reg < first_result || visited[reg])
+      continue;
+    visited[reg] = true;
+    int instr_index = reg - first_result;
+    instrs_.push_back(instr_index);
+    internal::PushDiffArgs(t, t.instruction(instr_index), stack);
+  }
+  std::sort(instrs_.begin(), instrs_.end());
+
+  // Find the variables each instruction depends on and add elements
+  // for instructions with nonzero second derivatives.
+  std::vector< std::vector<int> > deps(instrs_.size());
+  std::vector<int> positions(t.num_instructions(), -1);
+  std::vector< std::vector<int> > pattern(num_vars);
+  std::vector<int> arg_deps[2], regs;
+  for (std::size_t i = 0, n = instrs_.size(); i < n; ++i) {
+    positions[instrs_[i]] = static_cast<int>(i);
+    const Tape::Instruction &instr = t.instruction(instrs_[i]);
+    regs.clear();
+    internal::PushDiffArgs(t, instr, regs);
+    std::vector<int> &result = deps[i];
+    for (std::size_t j = 0, num_regs = regs.size(); j < num_regs; ++j) {
+      int reg = regs[j];
+      std::vector<int> *d = j < 2 ? &arg_deps[j] : 0;
+      if (d)
+        d->clear();
+      if (reg < num_vars) {
+        result.push_back(reg);
+        if (d)
+          d->push_back(reg);
+      } else if (reg >= first_result) {
+        const std::vector<int> &arg = deps[positions[reg - first_result]];
+        result.insert(result.end(), arg.begin(), arg.end());
+        if (d)
+          *d = arg;
+      }
+    }
+    SortUnique(result);
+    if (!IsNonlinear(instr.opcode))
+      continue;
+    switch (instr.opcode) {
+    case expr::MUL:
+      AddElements(arg_deps[0], arg_deps[1], pattern);
+      break;
+    case expr::DIV:
+      AddElements(arg_deps[0], arg_deps[1], pattern);
+      AddElements(arg_deps[1], arg_deps[1], pattern);
+      break;
+    case expr::POW_CONST_EXP:
+      AddElements(arg_deps[0], arg_deps[0], pattern);
+      break;
+    case expr::POW_CONST_BASE:
+      AddElements(arg_deps[1], arg_deps[1], pattern);
+      break;
+    default:
+      // Unary expression, pow or atan2.
+      AddElements(result, result, pattern);
+      break;
+    }
+    // Remove duplicates to limit memory used for the pattern.
+    for (std::vector<int>::const_iterator
+         j = result.begin(), end = result.end(); j != end; ++j) {
+      std::vector<int> &col = pattern[*j];
+      if (col.size() > 2 * result.size())
+        SortUnique(col);
+    }
+  }
+
+  col_starts_.reserve(num_vars + 1);
+  col_starts_.push_back(0);
+  std::vector<bool> in_hessian(num_vars);
+  for (int j = 0; j < num_vars; ++j) {
+    std::vector<int> &col = pattern[j];
+    SortUnique(col);
+    rows_.insert(rows_.end(), col.begin(), col.end());
+    col_starts_.push_back(static_cast<int>(rows_.size()));
+    if (!col.empty())
+      in_hessian[j] = true;
+    for (std::size_t i = 0, n = col.size(); i < n; ++i)
+      in_hessian[col[i]] = true;
+    std::vector<int>().swap(col);
+  }
+  for (int j = 0; j < num_vars; ++j) {
+    if (in_hessian[j])
+      hes_vars_.push_back(j);
+  }
+}
+
+void mp::HessianEvaluator::Color() {
+  int num_vars = tape().num_vars();
+  // Build the adjacency graph: neighbors of variable i are
+  // adj[adj_starts[i]:adj_starts[i + 1]].
+  std::vector<int> adj_starts(num_vars + 1);
+  for (int j = 0; j < num_vars; ++j) {
+    for (int k = col_starts_[j], end = col_starts_[j + 1]; k != end; ++k) {
+      int i = rows_[k];
+      if (i != j) {
+        ++adj_starts[i + 1];
+        ++adj_starts[j + 1];
+      }
+    }
+  }
+  for (int i = 0; i < num_vars; ++i)
+    adj_starts[i + 1] += adj_starts[i];
+  std::vector<int> adj(adj_starts[num_vars]);
+  std::vector<int> next(adj_starts.begin(), adj_starts.end() - 1);
+  for (int j = 0; j < num_vars; ++j) {
+    for (int k = col_starts_[j], end = col_starts_[j + 1]; k != end; ++k) {
+      int i = rows_[k];
+      if (i != j) {
+        adj[next[i]++] = j;
+        adj[next[j]++] = i;
+      }
+    }
+  }
+
+  // Star coloring: a distance-1 coloring in which every path on four
+  // vertices uses at least three colors, computed greedily as described
+  // in A. H. Gebremedhin, F. Manne, A. Pothen. What color is your
+  // Jacobian? Graph coloring for computing derivatives. SIAM Review 47(4),
+  // 2005, Algorithm 4.1.
+  std::vector<int> colors(num_vars, -1);
+  std::vector<int> forbidden(hes_vars_.size() + 1, -1);
+  num_colors_ = 0;
+  for (std::size_t vi = 0, nv = hes_vars_.size(); vi < nv; ++vi) {
+    int v = hes_vars_[vi];
+    for (int k = adj_starts[v], end = adj_starts[v + 1]; k != end; ++k) {
+      int w = adj[k], w_color = colors[w];
+      if (w_color >= 0)
+        forbidden[w_color] = v;
+      for (int l = adj_starts[w], l_end = adj_starts[w + 1];
+           l != l_end; ++l) {
+        int x = adj[l], x_color = colors[x];
+        if (x == v || x_color < 0)
+          continue;
+        if (w_color < 0) {
+          forbidden[x_color] = v;
+          continue;
+        }
+        for (int m = adj_starts[x], m_end = adj_starts[x + 1];
+             m != m_end; ++m) {
+          int y = adj[m];
+          if (y != w && colors[y] == w_color) {
+            forbidden[x_color] = v;
+            break;
+          }
+        }
+      }
+    }
+    int color = 0;
+    while (forbidden[color] == v)
+      ++color;
+    colors[v] = color;
+    num_colors_ = std::max(num_colors_, color + 1);
+  }
+  colors_.resize(hes_vars_.size());
+  std::vector<int> positions(num_vars, -1);
+  for (std::size_t i = 0, n = hes_vars_.size(); i < n; ++i) {
+    colors_[i] = colors[hes_vars_[i]];
+    positions[hes_vars_[i]] = static_cast<int>(i);
+  }
+
+  // Find where each element can be recovered from. In a star coloring
+  // one of the vertices i and j of each edge is the only neighbor of
+  // the other with its color, so the element is equal to the element
+  // of the compressed Hessian in the row of the other vertex.
+  recovery_.resize(rows_.size());
+  std::vector<int> counts(num_colors_);
+  for (int j = 0; j < num_vars; ++j) {
+    int start = col_starts_[j], end = col_starts_[j + 1];
+    if (start == end)
+      continue;
+    int j_color = colors[j];
+    for (int k = adj_starts[j], k_end = adj_starts[j + 1]; k != k_end; ++k)
+      ++counts[colors[adj[k]]];
+    for (int k = start; k != end; ++k) {
+      int i = rows_[k], i_color = colors[i];
+      if (i == j || counts[i_color] == 1) {
+        recovery_[k] = positions[j] * num_colors_ + i_color;
+        continue;
+      }
+      int count = 0;
+      for (int l = adj_starts[i], l_end = adj_starts[i + 1];
+           l != l_end; ++l) {
+        if (colors[adj[l]] == j_color)
+          ++count;
+      }
+      MP_ASSERT(count == 1, "invalid coloring");
+      recovery_[k] = positions[i] * num_colors_ + j_color;
+    }
+    for (int k = adj_starts[j], k_end = adj_starts[j + 1]; k != k_end; ++k)
+      counts[colors[adj[k]]] = 0;
+  }
+}
+
+void mp::HessianEvaluator::Multiply(
+    const double *obj_weights, const double *con_multipliers,
+    int first_color, int num_dirs) {
+  const Tape &t = tape();
+  const double *r = eval_.registers();
+  const int *args = t.args();
+  const double *data = t.data();
+  int num_vars = t.num_vars(), first_result = t.first_result();
+  double *tan = &tangents_[0];
+  double *adj = &adjoints_[0];
+  double *adj_tan = &adjoint_tangents_[0];
+
+  // Seed the tangents of variables with the directions. Tangents of
+  // constants are always zero.
+  std::fill(tan, tan + num_vars * BATCH_SIZE, 0.0);
+  for (std::size_t i = 0, n = hes_vars_.size(); i < n; ++i) {
+    int dir = colors_[i] - first_color;
+    if (dir >= 0 && dir < num_dirs)
+      tan[hes_vars_[i] * BATCH_SIZE + dir] = 1;
+  }
+
+  // Forward sweep computing tangents.
+  Partials p = Partials();
+  for (std::size_t i = 0, n = instrs_.size(); i < n; ++i) {
+    const Tape::Instruction &instr = t.instruction(instrs_[i]);
+    int reg = first_result + instrs_[i];
+    double *result = tan + reg * BATCH_SIZE;
+    std::fill(result, result + num_dirs, 0.0);
+    switch (instr.opcode) {
+    case expr::IF: case expr::PLTERM: case expr::MIN: case expr::MAX: {
+      double coef = 0;
+      int arg = GetActiveArg(t, instr, r, r[reg], coef);
+      if (arg < 0)
+        break;
+      const double *arg_tan = tan + arg * BATCH_SIZE;
+      for (int k = 0; k < num_dirs; ++k)
+        result[k] = coef * arg_tan[k];
+      break;
+    }
+    case expr::SUM:
+      for (const int *arg = args + instr.arg1,
+           *end = arg + instr.arg2; arg != end; ++arg) {
+        const double *arg_tan = tan + *arg * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          result[k] += arg_tan[k];
+      }
+      break;
+    case Tape::LINEAR: {
+      const double *coef = data + instr.arg3;
+      for (const int *arg = args + instr.arg1,
+           *end = arg + instr.arg2; arg != end; ++arg, ++coef) {
+        const double *arg_tan = tan + *arg * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          result[k] += *coef * arg_tan[k];
+      }
+      break;
+    }
+    default:
+      switch (GetPartials(instr, r, r[reg], p)) {
+      case 1: {
+        const double *tan0 = tan + instr.arg1 * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          result[k] = p.d0 * tan0[k];
+        break;
+      }
+      case 2: {
+        const double *tan0 = tan + instr.arg1 * BATCH_SIZE;
+        const double *tan1 = tan + instr.arg2 * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          result[k] = p.d0 * tan0[k] + p.d1 * tan1[k];
+        break;
+      }
+      }
+    }
+  }
+
+  // Reverse sweep computing adjoints and adjoint tangents. Adjoints of
+  // instruction results are cleared as they are consumed.
+  std::fill(adj, adj + first_result, 0.0);
+  std::fill(adj_tan, adj_tan + first_result * BATCH_SIZE, 0.0);
+  if (obj_weights) {
+    for (int i = 0, n = t.num_objs(); i < n; ++i)
+      adj[t.obj_register(i)] += obj_weights[i];
+  }
+  if (con_multipliers) {
+    for (int i = 0, n = t.num_cons(); i < n; ++i)
+      adj[t.con_register(i)] += con_multipliers[i];
+  }
+  for (std::size_t i = instrs_.size(); i-- > 0; ) {
+    const Tape::Instruction &instr = t.instruction(instrs_[i]);
+    int reg = first_result + instrs_[i];
+    double a = adj[reg];
+    adj[reg] = 0;
+    double *at = adj_tan + reg * BATCH_SIZE;
+    switch (instr.opcode) {
+    case expr::IF: case expr::PLTERM: case expr::MIN: case expr::MAX: {
+      double coef = 0;
+      int arg = GetActiveArg(t, instr, r, r[reg], coef);
+      if (arg < 0)
+        break;
+      adj[arg] += a * coef;
+      double *arg_at = adj_tan + arg * BATCH_SIZE;
+      for (int k = 0; k < num_dirs; ++k)
+        arg_at[k] += coef * at[k];
+      break;
+    }
+    case expr::SUM:
+      for (const int *arg = args + instr.arg1,
+           *end = arg + instr.arg2; arg != end; ++arg) {
+        adj[*arg] += a;
+        double *arg_at = adj_tan + *arg * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          arg_at[k] += at[k];
+      }
+      break;
+    case Tape::LINEAR: {
+      const double *coef = data + instr.arg3;
+      for (const int *arg = args + instr.arg1,
+           *end = arg + instr.arg2; arg != end; ++arg, ++coef) {
+        adj[*arg] += a * *coef;
+        double *arg_at = adj_tan + *arg * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          arg_at[k] += *coef * at[k];
+      }
+      break;
+    }
+    default:
+      switch (GetPartials(instr, r, r[reg], p)) {
+      case 1: {
+        adj[instr.arg1] += a * p.d0;
+        const double *tan0 = tan + instr.arg1 * BATCH_SIZE;
+        double *at0 = adj_tan + instr.arg1 * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k)
+          at0[k] += p.d0 * at[k] + a * p.d00 * tan0[k];
+        break;
+      }
+      case 2: {
+        adj[instr.arg1] += a * p.d0;
+        adj[instr.arg2] += a * p.d1;
+        const double *tan0 = tan + instr.arg1 * BATCH_SIZE;
+        const double *tan1 = tan + instr.arg2 * BATCH_SIZE;
+        double *at0 = adj_tan + instr.arg1 * BATCH_SIZE;
+        double *at1 = adj_tan + instr.arg2 * BATCH_SIZE;
+        for (int k = 0; k < num_dirs; ++k) {
+          at0[k] += p.d0 * at[k] + a * (p.d00 * tan0[k] + p.d01 * tan1[k]);
+          at1[k] += p.d1 * at[k] + a * (p.d01 * tan0[k] + p.d11 * tan1[k]);
+        }
+        break;
+      }
+      }
+    }
+    std::fill(at, at + num_dirs, 0.0);
+  }
+
+  // Store the Hessian-vector products.
+  for (std::size_t i = 0, n = hes_vars_.size(); i < n; ++i) {
+    const double *var_at = adj_tan + hes_vars_[i] * BATCH_SIZE;
+    double *row = &compressed_[i * num_colors_ + first_color];
+    for (int k = 0; k < num_dirs; ++k)
+      row[k] = var_at[k];
+  }
+}
+
+void mp::HessianEvaluator::GetHessian(
+    const double *obj_weights, const double *con_multipliers,
+    double *values) {
+  for (int color = 0; color < num_colors_; color += BATCH_SIZE) {
+    Multiply(obj_weights, con_multipliers, color,
+             std::min(static_cast<int>(BATCH_SIZE), num_colors_ - color));
+  }
+  for (std::size_t k = 0, n = recovery_.size(); k < n; ++k)
+    values[k] = compressed_[recovery_[k]];
+}
@@ -0,0 +1,44 @@
+/*
+ Inverse hyperbolic functions
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_HYPERBOLIC_H_
+#define MP_HYPERBOLIC_H_
+
+#include <cmath>
+
+namespace mp {
+namespace internal {
+
+// Inverse hyperbolic functions computed as in ASL since they are not
+// available in C++98.
+inline double Asinh(double x) {
+  double t = std::log(std::fabs(x) + std::sqrt(x * x + 1));
+  return x < 0 ? -t : t;
+}
+
+inline double Acosh(double x) { return std::log(x + std::sqrt(x * x - 1)); }
+
+inline double Atanh(double x) { return 0.5 * std::log((1 + x) / (1 - x)); }
+}  // namespace internal
+}  // namespace mp
+
+#endif  // MP_HYPERBOLIC_H_
@@ -0,0 +1,431 @@
+/*
+ Interval arithmetic
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/interval.h"
+
+#include <cmath>
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+const double PI = 3.14159265358979323846;
+
+// Maximum error in ulps of the math library functions such as exp and sin.
+// Their results can't be checked for exactness, so bounds computed with
+// them are moved outward by this many ulps.
+const int LIBM_ULPS = 4;
+
+// Rounding errors of results with magnitude below this may not be
+// representable because of underflow, so such results are treated as
+// inexact.
+const double MIN_EXACT = 4 * std::numeric_limits<double>::min() /
+    std::numeric_limits<double>::epsilon();
+
+// An unknown rounding error.
+const double UNKNOWN = std::numeric_limits<double>::quiet_NaN();
+
+inline bool IsFinite(double x) { return x - x == 0; }
+
+// Returns the next double towards -inf or +inf.
+inline double Down(double x) { return std::nextafter(x, -INF); }
+inline double Up(double x) { return std::nextafter(x, INF); }
+
+// Rounds the result r of an operation down or up given the difference
+// between the true result and r computed with an error-free
+// transformation or NaN if the difference is not known. finite_args
+// is true if the arguments are finite, in which case an infinite r is
+// the result of an overflow.
+inline double RoundDown(double r, double error, bool finite_args) {
+  if (!IsFinite(r))
+    return finite_args ? Down(r) : r;
+  return error >= 0 ? r : Down(r);
+}
+
+inline double RoundUp(double r, double error, bool finite_args) {
+  if (!IsFinite(r))
+    return finite_args ? Up(r) : r;
+  return error <= 0 ? r : Up(r);
+}
+
+// Returns the error of s = a + b (TwoSum).
+inline double AddError(double a, double b, double s) {
+  double bb = s - a;
+  return (a - (s - bb)) + (b - bb);
+}
+
+inline double AddDown(double a, double b) {
+  double s = a + b;
+  return RoundDown(s, AddError(a, b, s), IsFinite(a) && IsFinite(b));
+}
+
+inline double AddUp(double a, double b) {
+  double s = a + b;
+  return RoundUp(s, AddError(a, b, s), IsFinite(a) && IsFinite(b));
+}
+
+// Returns the error of p = a * b.
+inline double MulError(double a, double b, double p) {
+  return std::fabs(p) >= MIN_EXACT ? std::fma(a, b, -p) : UNKNOWN;
+}
+
+// Products of bounds with 0 * inf = 0 rounded down and up.
+inline double MulDown(double a, double b) {
+  if (a == 0 || b == 0)
+    return 0;
+  double p = a * b;
+  return RoundDown(p, MulError(a, b, p), IsFinite(a) && IsFinite(b));
+}
+
+inline double MulUp(double a, double b) {
+  if (a == 0 || b == 0)
+    return 0;
+  double p = a * b;
+  return RoundUp(p, MulError(a, b, p), IsFinite(a) && IsFinite(b));
+}
+
+// Returns a value with the sign of the error of q = a / b which is the
+// sign of (a - q * b) / b.
+inline double DivError(double a, double b, double q) {
+  if (a != 0 && (std::fabs(a) < MIN_EXACT || std::fabs(q) < MIN_EXACT))
+    return UNKNOWN;
+  double r = std::fma(-q, b, a);
+  return b < 0 ? -r : r;
+}
+
+inline double DivDown(double a, double b) {
+  double q = a / b;
+  return RoundDown(q, DivError(a, b, q), IsFinite(a) && IsFinite(b));
+}
+
+inline double DivUp(double a, double b) {
+  double q = a / b;
+  return RoundUp(q, DivError(a, b, q), IsFinite(a) && IsFinite(b));
+}
+
+// Returns a value with the sign of the error of s = sqrt(x) which is the
+// sign of x - s * s.
+inline double SqrtError(double x, double s) {
+  return x == 0 || x >= MIN_EXACT ? std::fma(-s, s, x) : UNKNOWN;
+}
+
+inline double SqrtDown(double x) {
+  double s = std::sqrt(x);
+  return RoundDown(s, SqrtError(x, s), IsFinite(x));
+}
+
+inline double SqrtUp(double x) {
+  double s = std::sqrt(x);
+  return RoundUp(s, SqrtError(x, s), IsFinite(x));
+}
+
+// Returns x^n for a nonnegative x and an integer n > 0 rounded down or up.
+// Products of nonnegative numbers are monotone, so rounding each of them
+// in the same direction gives a bound.
+template <double (*Mul)(double, double)>
+double PowInt(double x, int n) {
+  double result = 1;
+  for (;;) {
+    if ((n & 1) != 0)
+      result = Mul(result, x);
+    n >>= 1;
+    if (n == 0)
+      break;
+    x = Mul(x, x);
+  }
+  return result;
+}
+
+inline double PowDown(double x, int n) { return PowInt<MulDown>(x, n); }
+inline double PowUp(double x, int n) { return PowInt<MulUp>(x, n); }
+
+// Returns the n-th root of a nonnegative x rounded down or up. The result
+// of pow is adjusted until its n-th power brackets x.
+double RootDown(double x, int n) {
+  double r = std::pow(x, 1.0 / n);
+  while (r > 0 && PowUp(r, n) > x)
+    r = Down(r);
+  return r;
+}
+
+double RootUp(double x, int n) {
+  double r = std::pow(x, 1.0 / n);
+  while (PowDown(r, n) < x)
+    r = Up(r);
+  return r;
+}
+
+// Moves the bounds of a nonempty interval computed with math library
+// functions outward by LIBM_ULPS ulps.
+mp::Interval Widen(mp::Interval a) {
+  if (a.empty())
+    return a;
+  for (int i = 0; i < LIBM_ULPS; ++i) {
+    a.lb = Down(a.lb);
+    a.ub = Up(a.ub);
+  }
+  return a;
+}
+
+inline double Min4(double a, double b, double c, double d) {
+  double ab = a < b ? a : b, cd = c < d ? c : d;
+  return ab < cd ? ab : cd;
+}
+
+inline double Max4(double a, double b, double c, double d) {
+  double ab = a > b ? a : b, cd = c > d ? c : d;
+  return ab > cd ? ab : cd;
+}
+
+// Applies a nondecreasing function computing exact results such as floor
+// to an interval.
+inline mp::Interval Increasing(double (*f)(double), mp::Interval a) {
+  if (a.empty())
+    return a;
+  return mp::Interval(f(a.lb), f(a.ub));
+}
+
+// Applies a nondecreasing math library function to an interval.
+inline mp::Interval IncreasingLibm(double (*f)(double), mp::Interval a) {
+  return Widen(Increasing(f, a));
+}
+
+// Returns true if the interval may contain offset + 2 * k * pi for some k.
+// The interval is extended by an estimate of the error of computing such
+// points, so that a point close to a bound is never missed.
+bool ContainsPeriodic(mp::Interval a, double offset) {
+  double tol = 4 * std::numeric_limits<double>::epsilon() *
+      (std::fabs(a.lb) + std::fabs(a.ub) + 2 * PI);
+  double k = std::ceil((a.lb - tol - offset) / (2 * PI));
+  return offset + 2 * k * PI <= a.ub + tol;
+}
+
+double Sinh(double x) { return std::sinh(x); }
+double Tanh(double x) { return std::tanh(x); }
+
+// Inverse hyperbolic functions from the math library which, unlike the
+// formulas used by ASL, are accurate to a few ulps for small arguments.
+double Asinh(double x) { return std::asinh(x); }
+double Acosh(double x) { return std::acosh(x); }
+double Atanh(double x) { return std::atanh(x); }
+}
+
+mp::Interval mp::operator+(Interval a, Interval b) {
+  if (a.empty() || b.empty())
+    return Interval::Empty();
+  return Interval(AddDown(a.lb, b.lb), AddUp(a.ub, b.ub));
+}
+
+mp::Interval mp::operator-(Interval a, Interval b) {
+  if (a.empty() || b.empty())
+    return Interval::Empty();
+  return Interval(AddDown(a.lb, -b.ub), AddUp(a.ub, -b.lb));
+}
+
+mp::Interval mp::operator*(Interval a, Interval b) {
+  if (a.empty() || b.empty())
+    return Interval::Empty();
+  return Interval(
+        Min4(MulDown(a.lb, b.lb), MulDown(a.lb, b.ub),
+             MulDown(a.ub, b.lb), MulDown(a.ub, b.ub)),
+        Max4(MulUp(a.lb, b.lb), MulUp(a.lb, b.ub),
+             MulUp(a.ub, b.lb), MulUp(a.ub, b.ub)));
+}
+
+mp::Interval mp::operator/(Interval a, Interval b) {
+  if (a.empty() || b.empty() || (b.lb == 0 && b.ub == 0))
+    return Interval::Empty();
+  Interval inverse;
+  if (b.lb > 0 || b.ub < 0)
+    inverse = Interval(DivDown(1, b.ub), DivUp(1, b.lb));
+  else if (b.lb == 0)
+    inverse = Interval(DivDown(1, b.ub), INF);
+  else if (b.ub == 0)
+    inverse = Interval(-INF, DivUp(1, b.lb));
+  else
+    return Interval();
+  return a * inverse;
+}
+
+mp::Interval mp::Abs(Interval a) {
+  if (a.empty() || a.lb >= 0)
+    return a;
+  if (a.ub <= 0)
+    return -a;
+  return Interval(0, -a.lb > a.ub ? -a.lb : a.ub);
+}
+
+mp::Interval mp::Sqr(Interval a) {
+  a = Abs(a);
+  if (a.empty())
+    return a;
+  return Interval(MulDown(a.lb, a.lb), MulUp(a.ub, a.ub));
+}
+
+mp::Interval mp::Sqrt(Interval a) {
+  a = Intersect(a, Interval(0, INF));
+  if (a.empty())
+    return a;
+  return Interval(SqrtDown(a.lb), SqrtUp(a.ub));
+}
+
+mp::Interval mp::Exp(Interval a) {
+  return Intersect(IncreasingLibm(std::exp, a), Interval(0, INF));
+}
+
+mp::Interval mp::Log(Interval a) {
+  return IncreasingLibm(std::log, Intersect(a, Interval(0, INF)));
+}
+
+mp::Interval mp::Log10(Interval a) {
+  return IncreasingLibm(std::log10, Intersect(a, Interval(0, INF)));
+}
+
+mp::Interval mp::Pow(Interval base, Interval exponent) {
+  if (base.empty() || exponent.empty())
+    return Interval::Empty();
+  if (exponent.is_point()) {
+    double n = exponent.lb;
+    if (n == 0)
+      return Interval(1);
+    if (n == std::floor(n) && std::fabs(n) <= 1e9) {
+      int k = static_cast<int>(std::fabs(n));
+      Interval result;
+      if (k % 2 == 0) {
+        Interval abs = Abs(base);
+        result = Interval(PowDown(abs.lb, k), PowUp(abs.ub, k));
+      } else {
+        result = Interval(
+              base.lb < 0 ? -PowUp(-base.lb, k) : PowDown(base.lb, k),
+              base.ub < 0 ? -PowDown(-base.ub, k) : PowUp(base.ub, k));
+      }
+      return n > 0 ? result : Interval(1) / result;
+    }
+  }
+  // Use base^exponent = exp(exponent * log(base)) for base >= 0.
+  return Exp(exponent * Log(base));
+}
+
+mp::Interval mp::Sin(Interval a) {
+  if (a.empty())
+    return a;
+  if (a.ub - a.lb >= 2 * PI)
+    return Interval(-1, 1);
+  double sin_lb = std::sin(a.lb), sin_ub = std::sin(a.ub);
+  Interval result = Widen(Interval(sin_lb < sin_ub ? sin_lb : sin_ub,
+                                   sin_lb > sin_ub ? sin_lb : sin_ub));
+  if (ContainsPeriodic(a, PI / 2))
+    result.ub = 1;
+  if (ContainsPeriodic(a, -PI / 2))
+    result.lb = -1;
+  return Intersect(result, Interval(-1, 1));
+}
+
+mp::Interval mp::Cos(Interval a) {
+  if (a.empty())
+    return a;
+  if (a.ub - a.lb >= 2 * PI)
+    return Interval(-1, 1);
+  double cos_lb = std::cos(a.lb), cos_ub = std::cos(a.ub);
+  Interval result = Widen(Interval(cos_lb < cos_ub ? cos_lb : cos_ub,
+                                   cos_lb > cos_ub ? cos_lb : cos_ub));
+  if (ContainsPeriodic(a, 0))
+    result.ub = 1;
+  if (ContainsPeriodic(a, PI))
+    result.lb = -1;
+  return Intersect(result, Interval(-1, 1));
+}
+
+mp::Interval mp::Tan(Interval a) {
+  if (a.empty())
+    return a;
+  // tan is increasing between consecutive poles pi/2 + k * pi.
+  if (a.ub - a.lb >= PI || ContainsPeriodic(a, PI / 2) ||
+      ContainsPeriodic(a, -PI / 2)) {
+    return Interval();
+  }
+  return Widen(Interval(std::tan(a.lb), std::tan(a.ub)));
+}
+
+mp::Interval mp::Sinh(Interval a) { return IncreasingLibm(::Sinh, a); }
+
+mp::Interval mp::Cosh(Interval a) {
+  a = Abs(a);
+  return Intersect(IncreasingLibm(std::cosh, a), Interval(1, INF));
+}
+
+mp::Interval mp::Tanh(Interval a) {
+  return Intersect(IncreasingLibm(::Tanh, a), Interval(-1, 1));
+}
+
+mp::Interval mp::Asin(Interval a) {
+  return IncreasingLibm(std::asin, Intersect(a, Interval(-1, 1)));
+}
+
+mp::Interval mp::Acos(Interval a) {
+  a = Intersect(a, Interval(-1, 1));
+  if (a.empty())
+    return a;
+  return Intersect(Widen(Interval(std::acos(a.ub), std::acos(a.lb))),
+                   Interval(0, INF));
+}
+
+mp::Interval mp::Atan(Interval a) { return IncreasingLibm(std::atan, a); }
+
+mp::Interval mp::Asinh(Interval a) { return IncreasingLibm(::Asinh, a); }
+
+mp::Interval mp::Acosh(Interval a) {
+  return Intersect(IncreasingLibm(::Acosh, Intersect(a, Interval(1, INF))),
+                   Interval(0, INF));
+}
+
+mp::Interval mp::Atanh(Interval a) {
+  return IncreasingLibm(::Atanh, Intersect(a, Interval(-1, 1)));
+}
+
+mp::Interval mp::Floor(Interval a) { return Increasing(std::floor, a); }
+
+mp::Interval mp::Ceil(Interval a) { return Increasing(std::ceil, a); }
+
+mp::Interval mp::Min(Interval a, Interval b) {
+  if (a.empty() || b.empty())
+    return Interval::Empty();
+  return Interval(a.lb < b.lb ? a.lb : b.lb, a.ub < b.ub ? a.ub : b.ub);
+}
+
+mp::Interval mp::Max(Interval a, Interval b) {
+  if (a.empty() || b.empty())
+    return Interval::Empty();
+  return Interval(a.lb > b.lb ? a.lb : b.lb, a.ub > b.ub ? a.ub : b.ub);
+}
+
+mp::Interval mp::Root(Interval a, int n) {
+  if (a.empty())
+    return a;
+  if (n % 2 != 0) {
+    return Interval(a.lb < 0 ? -RootUp(-a.lb, n) : RootDown(a.lb, n),
+                    a.ub < 0 ? -RootDown(-a.ub, n) : RootUp(a.ub, n));
+  }
+  if (a.ub < 0)
+    return Interval::Empty();
+  double ub = RootUp(a.ub, n);
+  return Interval(-ub, ub);
+}
@@ -0,0 +1,298 @@
+/*
+ Sparse Jacobian and gradient evaluation by reverse-mode automatic
+ differentiation
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/jacobian.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "tape-diff.h"
+
+namespace {
+
+const double LN10 = 2.302585092994045684;
+
+// Propagates the adjoint a of the result of an instruction with value v
+// to its operands.
+void Propagate(const mp::Tape &t, const mp::Tape::Instruction &instr,
+               const double *r, double v, double a, double *adj) {
+  namespace expr = mp::expr;
+  // arg1 is not a register for iterated instructions.
+  double x = mp::Tape::GetNumRegisterArgs(instr.opcode) != 0 ?
+        r[instr.arg1] : 0;
+  switch (instr.opcode) {
+  case expr::MINUS: adj[instr.arg1] -= a; break;
+  case expr::ABS:   adj[instr.arg1] += x < 0 ? -a : a; break;
+  case expr::SQRT:  adj[instr.arg1] += 0.5 * a / v; break;
+  case expr::POW2:  adj[instr.arg1] += 2 * x * a; break;
+  case expr::EXP:   adj[instr.arg1] += a * v; break;
+  case expr::LOG:   adj[instr.arg1] += a / x; break;
+  case expr::LOG10: adj[instr.arg1] += a / (x * LN10); break;
+  case expr::SIN:   adj[instr.arg1] += a * std::cos(x); break;
+  case expr::SINH:  adj[instr.arg1] += a * std::cosh(x); break;
+  case expr::COS:   adj[instr.arg1] -= a * std::sin(x); break;
+  case expr::COSH:  adj[instr.arg1] += a * std::sinh(x); break;
+  case expr::TAN: {
+    double c = std::cos(x);
+    adj[instr.arg1] += a / (c * c);
+    break;
+  }
+  case expr::TANH: {
+    double c = std::cosh(x);
+    adj[instr.arg1] += a / (c * c);
+    break;
+  }
+  case expr::ASIN:  adj[instr.arg1] += a / std::sqrt(1 - x * x); break;
+  case expr::ASINH: adj[instr.arg1] += a / std::sqrt(1 + x * x); break;
+  case expr::ACOS:  adj[instr.arg1] -= a / std::sqrt(1 - x * x); break;
+  case expr::ACOSH: adj[instr.arg1] += a / std::sqrt(x * x - 1); break;
+  case expr::ATAN:  adj[instr.arg1] += a / (1 + x * x); break;
+  case expr::ATANH: adj[instr.arg1] += a / (1 - x * x); break;
+  case expr::ADD:
+    adj[instr.arg1] += a;
+    adj[instr.arg2] += a;
+    break;
+  case expr::SUB:
+    adj[instr.arg1] += a;
+    adj[instr.arg2] -= a;
+    break;
+  case expr::LESS:
+    if (v > 0) {
+      adj[instr.arg1] += a;
+      adj[instr.arg2] -= a;
+    }
+    break;
+  case expr::MUL:
+    adj[instr.arg1] += a * r[instr.arg2];
+    adj[instr.arg2] += a * x;
+    break;
+  case expr::DIV: {
+    double y = r[instr.arg2];
+    adj[instr.arg1] += a / y;
+    adj[instr.arg2] -= a * v / y;
+    break;
+  }
+  case expr::MOD: {
+    double q = x / r[instr.arg2];
+    adj[instr.arg1] += a;
+    adj[instr.arg2] -= a * (q >= 0 ? std::floor(q) : std::ceil(q));
+    break;
+  }
+  case expr::POW_CONST_EXP: {
+    double y = r[instr.arg2];
+    adj[instr.arg1] += a * y * std::pow(x, y - 1);
+    break;
+  }
+  case expr::POW_CONST_BASE:
+    if (x > 0)
+      adj[instr.arg2] += a * v * std::log(x);
+    break;
+  case expr::POW: {
+    double y = r[instr.arg2];
+    adj[instr.arg1] += a * y * std::pow(x, y - 1);
+    if (x > 0)
+      adj[instr.arg2] += a * v * std::log(x);
+    break;
+  }
+  case expr::ATAN2: {
+    double y = r[instr.arg2];
+    double d = x * x + y * y;
+    adj[instr.arg1] += a * y / d;
+    adj[instr.arg2] -= a * x / d;
+    break;
+  }
+  case expr::IF:
+    adj[x != 0 ? instr.arg2 : instr.arg3] += a;
+    break;
+  case expr::PLTERM:
+    adj[instr.arg1] += a * mp::internal::GetPLTermSlope(
+          t.data() + instr.arg2, instr.arg3, x);
+    break;
+  case expr::MIN: case expr::MAX: {
+    // Only the first operand attaining the extremum gets the adjoint.
+    for (const int *arg = t.args() + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg) {
+      if (r[*arg] == v) {
+        adj[*arg] += a;
+        break;
+      }
+    }
+    break;
+  }
+  case expr::SUM:
+    for (const int *arg = t.args() + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg) {
+      adj[*arg] += a;
+    }
+    break;
+  case mp::Tape::LINEAR: {
+    const double *coef = t.data() + instr.arg3;
+    for (const int *arg = t.args() + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg, ++coef) {
+      adj[*arg] += a * *coef;
+    }
+    break;
+  }
+  }
+}
+}
+
+void mp::internal::PushArgs(
+    const Tape &t, const Tape::Instruction &instr, std::vector<int> &regs) {
+  switch (Tape::GetNumRegisterArgs(instr.opcode)) {
+  case 0: {
+    const int *args = t.args() + instr.arg1;
+    regs.insert(regs.end(), args, args + instr.arg2);
+    break;
+  }
+  case 3:
+    regs.push_back(instr.arg3);
+    // Fall through.
+  case 2:
+    regs.push_back(instr.arg2);
+    // Fall through.
+  case 1:
+    regs.push_back(instr.arg1);
+    break;
+  }
+}
+
+void mp::internal::PushDiffArgs(
+    const Tape &t, const Tape::Instruction &instr, std::vector<int> &regs) {
+  switch (instr.opcode) {
+  case expr::FLOOR: case expr::CEIL: case expr::INT_DIV:
+  case expr::PRECISION: case expr::ROUND: case expr::TRUNC:
+    return;
+  case expr::IF:
+    regs.push_back(instr.arg2);
+    regs.push_back(instr.arg3);
+    return;
+  case expr::PLTERM:
+    regs.push_back(instr.arg1);
+    return;
+  case expr::MIN: case expr::MAX: case expr::SUM: case Tape::LINEAR: {
+    const int *args = t.args() + instr.arg1;
+    regs.insert(regs.end(), args, args + instr.arg2);
+    return;
+  }
+  }
+  if (instr.opcode >= expr::FIRST_UNARY && instr.opcode <= expr::LAST_UNARY) {
+    regs.push_back(instr.arg1);
+  } else if (instr.opcode >= expr::FIRST_BINARY &&
+             instr.opcode <= expr::LAST_BINARY) {
+    regs.push_back(instr.arg1);
+    regs.push_back(instr.arg2);
+  }
+}
+
+double mp::internal::GetPLTermSlope(
+    const double *data, int num_breakpoints, double x) {
+  int i = 0;
+  while (i < num_breakpoints && data[2 * i + 1] < x)
+    ++i;
+  return data[2 * i];
+}
+
+mp::JacobianEvaluator::JacobianEvaluator(const Tape &tape)
+  : eval_(tape), adjoints_(std::max(tape.num_registers(), 1)) {
+  int num_outputs = tape.num_objs() + tape.num_cons();
+  instr_starts_.reserve(num_outputs + 1);
+  var_starts_.reserve(num_outputs + 1);
+  instr_starts_.push_back(0);
+  var_starts_.push_back(0);
+  int num_vars = tape.num_vars(), first_result = tape.first_result();
+  // marks[reg] is the index of the last output that reached reg.
+  std::vector<int> marks(tape.num_registers(), -1);
+  std::vector<int> stack;
+  for (int output = 0; output < num_outputs; ++output) {
+    stack.push_back(GetOutputRegister(output));
+    while (!stack.empty()) {
+      int reg = stack.back();
+      stack.pop_back();
+      if (marks[reg] == output)
+        continue;
+      marks[reg] = output;
+      if (reg < num_vars) {
+        vars_.push_back(reg);
+      } else if (reg >= first_result) {
+        int instr_index = reg - first_result;
+        instrs_.push_back(instr_index);
+        internal::PushDiffArgs(tape, tape.instruction(instr_index), stack);
+      }
+    }
+    std::sort(instrs_.begin() + instr_starts_.back(), instrs_.end());
+    std::sort(vars_.begin() + var_starts_.back(), vars_.end());
+    instr_starts_.push_back(static_cast<int>(instrs_.size()));
+    var_starts_.push_back(static_cast<int>(vars_.size()));
+  }
+}
+
+int mp::JacobianEvaluator::GetOutputRegister(int output) const {
+  int num_objs = tape().num_objs();
+  return output < num_objs ?
+        tape().obj_register(output) : tape().con_register(output - num_objs);
+}
+
+void mp::JacobianEvaluator::Differentiate(
+    int output, const double *r, double *adj, double *values) const {
+  const Tape &t = tape();
+  int first_result = t.first_result();
+  int out = GetOutputRegister(output);
+  adj[out] = 1;
+  for (int i = instr_starts_[output + 1] - 1,
+       start = instr_starts_[output]; i >= start; --i) {
+    int instr_index = instrs_[i];
+    int reg = first_result + instr_index;
+    double a = adj[reg];
+    if (a == 0)
+      continue;
+    adj[reg] = 0;
+    Propagate(t, t.instruction(instr_index), r, r[reg], a, adj);
+  }
+  for (int i = var_starts_[output],
+       end = var_starts_[output + 1]; i != end; ++i) {
+    int var = vars_[i];
+    *values++ = adj[var];
+    adj[var] = 0;
+  }
+  adj[out] = 0;
+}
+
+void mp::JacobianEvaluator::ClearConstAdjoints(double *adj) const {
+  const Tape &t = tape();
+  std::fill(adj + t.num_vars(), adj + t.first_result(), 0.0);
+}
+
+void mp::JacobianEvaluator::GetObjGradient(int obj_index, double *values) {
+  ClearConstAdjoints(&adjoints_[0]);
+  Differentiate(obj_index, eval_.registers(), &adjoints_[0], values);
+}
+
+void mp::JacobianEvaluator::GetJacobian(double *values) {
+  double *adj = &adjoints_[0];
+  ClearConstAdjoints(adj);
+  const double *r = eval_.registers();
+  int num_objs = tape().num_objs();
+  for (int i = 0, n = tape().num_cons(); i < n; ++i)
+    Differentiate(num_objs + i, r, adj, values + jac_start(i));
+}
@@ -0,0 +1,327 @@
+/*
+ Synthetic .nl file generator
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "nl-generator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include "mp/error.h"
+#include "mp/nl.h"
+#include "mp/posix.h"
+
+namespace {
+
+// Kinds of items with their own random number sequences.
+enum ItemKind { CON, COMMON_EXPR, SUFFIX, BOUNDS };
+
+// Mixes bits of a 64-bit value (the splitmix64 finalizer).
+fmt::ULongLong Mix(fmt::ULongLong x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+}
+
+void mp::NLWriter::Flush() {
+  if (!file_ || w_.size() == 0)
+    return;
+  if (std::fwrite(w_.data(), 1, w_.size(), file_) != w_.size())
+    throw fmt::SystemError(errno, "cannot write to file");
+  w_.clear();
+}
+
+void mp::NLWriter::WriteHeader(const NLHeader &h) {
+  w_ << h;
+}
+
+void mp::NLWriter::WriteSuffix(int kind, int num_values, fmt::StringRef name) {
+  w_ << 'S';
+  if (binary_) {
+    WriteBinary(kind);
+    WriteBinary(num_values);
+    WriteBinary(static_cast<int>(name.size()));
+    w_ << name;
+  } else {
+    w_ << kind << ' ' << num_values << ' ' << name;
+  }
+  EndLine();
+}
+
+mp::NLGenerator::Random::Random(fmt::ULongLong seed) : state_(Mix(seed)) {
+  if (state_ == 0)
+    state_ = 1;  // xorshift requires a nonzero state.
+}
+
+mp::NLGenerator::Random mp::NLGenerator::GetRandom(
+    int item_kind, int index) const {
+  fmt::ULongLong seed = Mix(params_.seed);
+  return Random(Mix(seed + item_kind) ^ static_cast<unsigned>(index));
+}
+
+int mp::NLGenerator::GetNumNonzeros(int con_index) const {
+  fmt::LongLong num_cons = params_.num_cons;
+  int n = static_cast<int>(params_.num_nonzeros / num_cons);
+  return con_index < params_.num_nonzeros % num_cons ? n + 1 : n;
+}
+
+int mp::NLGenerator::GetConVars(
+    int con_index, Random &r, std::vector<int> &vars) const {
+  // Select num_nonzeros distinct variables using Floyd's algorithm.
+  int num_nonzeros = GetNumNonzeros(con_index);
+  vars.clear();
+  for (int j = params_.num_vars - num_nonzeros; j < params_.num_vars; ++j) {
+    int var = r.Next(j + 1);
+    std::vector<int>::iterator it =
+        std::lower_bound(vars.begin(), vars.end(), var);
+    if (it != vars.end() && *it == var) {
+      // j is greater than all selected variables.
+      var = j;
+      it = vars.end();
+    }
+    vars.insert(it, var);
+  }
+  if (con_index >= params_.num_nl_cons)
+    return -1;
+  // Make sure that a nonlinear constraint depends on a nonlinear variable
+  // and on variables of the common expression it references.
+  int expr_index = -1, var = -1;
+  if (params_.num_common_exprs != 0) {
+    expr_index = r.Next(params_.num_common_exprs);
+    var = GetCommonExprVar(expr_index);
+  } else if (vars[0] >= params_.num_nl_vars) {
+    var = r.Next(params_.num_nl_vars);
+  }
+  if (var >= 0 && !std::binary_search(vars.begin(), vars.end(), var)) {
+    vars[r.Next(num_nonzeros)] = var;
+    std::sort(vars.begin(), vars.end());
+  }
+  return expr_index;
+}
+
+void mp::NLGenerator::WriteExpr(NLWriter &w, Random &r, int depth,
+                                const std::vector<int> &vars,
+                                int num_vars) const {
+  if (depth <= 0) {
+    if (r.Next(4) == 0)
+      w.WriteConstant(r.NextConstant());
+    else
+      w.WriteReference(vars[r.Next(num_vars)]);
+    return;
+  }
+  --depth;
+  switch (r.Next(6)) {
+  case 0: case 1: case 2: {
+    static const expr::Kind kinds[] = {expr::ADD, expr::SUB, expr::MUL};
+    w.WriteOpCode(kinds[r.Next(3)]);
+    WriteExpr(w, r, depth, vars, num_vars);
+    WriteExpr(w, r, depth, vars, num_vars);
+    break;
+  }
+  case 3:
+    w.WriteOpCode(expr::SIN);
+    WriteExpr(w, r, depth, vars, num_vars);
+    break;
+  case 4:
+    w.WriteOpCode(expr::POW2);
+    WriteExpr(w, r, depth, vars, num_vars);
+    break;
+  default: {
+    enum {NUM_ARGS = 3};
+    w.WriteOpCode(expr::SUM);
+    w.WriteUInt(NUM_ARGS);
+    for (int i = 0; i < NUM_ARGS; ++i)
+      WriteExpr(w, r, depth, vars, num_vars);
+    break;
+  }
+  }
+}
+
+mp::NLGenerator::NLGenerator(const NLGeneratorParams &params)
+  : params_(params) {
+  const NLGeneratorParams &p = params_;
+  if (p.num_vars <= 0)
+    throw Error("invalid number of variables {}", p.num_vars);
+  if (p.num_cons < 0)
+    throw Error("invalid number of constraints {}", p.num_cons);
+  if (p.num_nl_cons < 0 || p.num_nl_cons > p.num_cons) {
+    throw Error("invalid number of nonlinear constraints {}",
+                p.num_nl_cons);
+  }
+  if (p.num_nl_vars < 0 || p.num_nl_vars > p.num_vars ||
+      (p.num_nl_vars == 0 && p.num_nl_cons != 0)) {
+    throw Error("invalid number of nonlinear variables {}", p.num_nl_vars);
+  }
+  if (p.num_nonzeros < p.num_cons || p.num_nonzeros > INT_MAX ||
+      (p.num_cons != 0 &&
+       (p.num_nonzeros + p.num_cons - 1) / p.num_cons > p.num_vars) ||
+      (p.num_cons == 0 && p.num_nonzeros != 0)) {
+    throw Error("invalid number of nonzeros {}", p.num_nonzeros);
+  }
+  if (p.expr_depth < 0)
+    throw Error("invalid expression depth {}", p.expr_depth);
+  if (p.num_common_exprs < 0 || p.num_common_exprs > p.num_vars)
+    throw Error("invalid number of common expressions {}", p.num_common_exprs);
+  if (p.num_suffixes < 0)
+    throw Error("invalid number of suffixes {}", p.num_suffixes);
+  // Common expressions are only used in nonlinear constraints.
+  if (p.num_nl_cons == 0)
+    params_.num_common_exprs = 0;
+}
+
+void mp::NLGenerator::Generate(NLWriter &w) const {
+  const NLGeneratorParams &p = params_;
+  int num_obj_nonzeros = std::min(p.num_vars, 10);
+  NLHeader header;
+  if (p.binary) {
+    header.format = NLHeader::BINARY;
+    header.arith_kind = arith::GetKind();
+  }
+  header.num_vars = p.num_vars;
+  header.num_algebraic_cons = p.num_cons;
+  header.num_objs = 1;
+  header.num_eqns = 0;
+  header.num_nl_cons = p.num_nl_cons;
+  header.num_nl_vars_in_cons = p.num_nl_cons != 0 ? p.num_nl_vars : 0;
+  header.num_nl_vars_in_both = 0;
+  header.num_con_nonzeros = static_cast<std::size_t>(p.num_nonzeros);
+  header.num_obj_nonzeros = num_obj_nonzeros;
+  header.num_common_exprs_in_cons = p.num_common_exprs;
+  w.WriteHeader(header);
+
+  // Write suffixes.
+  for (int i = 0; i < p.num_suffixes; ++i) {
+    Random r = GetRandom(SUFFIX, i);
+    int kind = i % 2 == 0 || p.num_cons == 0 ? suf::VAR : suf::CON;
+    if (i % 4 >= 2)
+      kind |= suf::FLOAT;
+    int num_values = (kind & suf::MASK) == suf::VAR ? p.num_vars : p.num_cons;
+    w.WriteSuffix(kind, num_values, fmt::format("suffix{}", i));
+    for (int j = 0; j < num_values; ++j) {
+      if ((kind & suf::FLOAT) != 0)
+        w.WritePair(j, r.NextConstant());
+      else
+        w.WritePair(j, r.Next(10));
+    }
+  }
+
+  // Write common expressions. Each common expression depends on a single
+  // variable so that it is easy to include it in the Jacobian sparsity
+  // of constraints that use it.
+  std::vector<int> vars(1);
+  for (int i = 0; i < p.num_common_exprs; ++i) {
+    Random r = GetRandom(COMMON_EXPR, i);
+    vars[0] = GetCommonExprVar(i);
+    w.WriteSegment('V', p.num_vars + i, 1, 0);
+    w.WritePair(vars[0], r.NextConstant());
+    WriteExpr(w, r, p.expr_depth, vars, 1);
+  }
+
+  // Write constraint expressions.
+  for (int i = 0; i < p.num_cons; ++i) {
+    w.WriteSegment('C', i);
+    if (i >= p.num_nl_cons) {
+      w.WriteConstant(0);
+      continue;
+    }
+    Random r = GetRandom(CON, i);
+    int expr_index = GetConVars(i, r, vars);
+    int num_nl_vars = static_cast<int>(
+          std::lower_bound(vars.begin(), vars.end(), p.num_nl_vars) -
+          vars.begin());
+    if (expr_index >= 0) {
+      w.WriteOpCode(expr::ADD);
+      w.WriteReference(p.num_vars + expr_index);
+    }
+    WriteExpr(w, r, p.expr_depth, vars, num_nl_vars);
+  }
+
+  // Write the objective. It is linear because nonlinear objectives are not
+  // different from nonlinear constraints for the purposes of reading.
+  w.WriteSegment('O', 0, 0);
+  w.WriteConstant(0);
+
+  // Write bounds.
+  Random bound_random = GetRandom(BOUNDS, 0);
+  if (p.num_cons != 0) {
+    w.WriteSegment('r');
+    for (int i = 0; i < p.num_cons; ++i) {
+      enum {UPPER = 1};
+      w.WriteBound(UPPER, bound_random.NextConstant());
+    }
+  }
+  w.WriteSegment('b');
+  for (int i = 0; i < p.num_vars; ++i) {
+    enum {RANGE = 0};
+    w.WriteBound(RANGE, 0, bound_random.NextConstant());
+  }
+
+  // Write cumulative column sizes of the Jacobian.
+  if (p.num_cons != 0) {
+    std::vector<int> col_sizes(p.num_vars);
+    for (int i = 0; i < p.num_cons; ++i) {
+      Random r = GetRandom(CON, i);
+      GetConVars(i, r, vars);
+      for (std::size_t j = 0, n = vars.size(); j < n; ++j)
+        ++col_sizes[vars[j]];
+    }
+    w.WriteSegment('k', p.num_vars - 1);
+    int total = 0;
+    for (int j = 0; j < p.num_vars - 1; ++j) {
+      total += col_sizes[j];
+      w.WriteUInt(total);
+    }
+  }
+
+  // Write the Jacobian.
+  for (int i = 0; i < p.num_cons; ++i) {
+    Random r = GetRandom(CON, i);
+    GetConVars(i, r, vars);
+    int num_nonzeros = static_cast<int>(vars.size());
+    w.WriteSegment('J', i, num_nonzeros);
+    for (int j = 0; j < num_nonzeros; ++j)
+      w.WritePair(vars[j], r.NextConstant());
+  }
+
+  // Write the objective gradient.
+  w.WriteSegment('G', 0, num_obj_nonzeros);
+  for (int j = 0; j < num_obj_nonzeros; ++j)
+    w.WritePair(j * (p.num_vars / num_obj_nonzeros), 1.0);
+}
+
+std::string mp::GenerateNL(const NLGeneratorParams &params) {
+  NLWriter w(params.binary);
+  NLGenerator(params).Generate(w);
+  return w.buffer().str();
+}
+
+void mp::GenerateNLFile(
+    fmt::StringRef filename, const NLGeneratorParams &params) {
+  NLGenerator generator(params);
+  fmt::BufferedFile file(filename, "wb");
+  NLWriter w(params.binary, file.get());
+  generator.Generate(w);
+  w.Flush();
+  file.close();
+}
@@ -0,0 +1,263 @@
+/*
+ Synthetic .nl file generator
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_NL_GENERATOR_H_
+#define MP_NL_GENERATOR_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "mp/common.h"
+#include "mp/format.h"
+
+namespace mp {
+
+struct NLHeader;
+
+// Writes .nl file components in text or binary format.
+// If a file is given, output is flushed to it as the buffer grows,
+// otherwise it is accumulated in the buffer.
+class NLWriter {
+ private:
+  fmt::MemoryWriter w_;
+  std::FILE *file_;
+  bool binary_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(NLWriter);
+
+  enum {BUFFER_SIZE = 1 << 20};
+
+  template <typename T>
+  void WriteBinary(T value) {
+    w_ << fmt::StringRef(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  // Ends a line in text format and flushes the output if necessary.
+  void EndLine() {
+    if (!binary_)
+      w_ << '\n';
+    if (file_ && w_.size() >= BUFFER_SIZE)
+      Flush();
+  }
+
+ public:
+  explicit NLWriter(bool binary, std::FILE *file = 0)
+    : file_(file), binary_(binary) {}
+
+  bool binary() const { return binary_; }
+
+  // Returns the buffered output.
+  fmt::MemoryWriter &buffer() { return w_; }
+
+  // Writes the buffered output to the file if there is one.
+  void Flush();
+
+  void WriteHeader(const NLHeader &h);
+
+  // Writes a segment header such as "r", "C0" or "J0 3".
+  void WriteSegment(char type) {
+    w_ << type;
+    EndLine();
+  }
+  void WriteSegment(char type, int arg) {
+    w_ << type;
+    WriteUInt(arg);
+  }
+  void WriteSegment(char type, int arg1, int arg2) {
+    w_ << type;
+    if (binary_) {
+      WriteBinary(arg1);
+      WriteBinary(arg2);
+    } else {
+      w_ << arg1 << ' ' << arg2;
+    }
+    EndLine();
+  }
+  void WriteSegment(char type, int arg1, int arg2, int arg3) {
+    w_ << type;
+    if (binary_) {
+      WriteBinary(arg1);
+      WriteBinary(arg2);
+      WriteBinary(arg3);
+    } else {
+      w_ << arg1 << ' ' << arg2 << ' ' << arg3;
+    }
+    EndLine();
+  }
+
+  // Writes a suffix header.
+  void WriteSuffix(int kind, int num_values, fmt::StringRef name);
+
+  // Writes an unsigned integer on a separate line.
+  void WriteUInt(int value) {
+    if (binary_)
+      WriteBinary(value);
+    else
+      w_ << value;
+    EndLine();
+  }
+
+  void WriteOpCode(expr::Kind kind) {
+    w_ << 'o';
+    WriteUInt(expr::opcode(kind));
+  }
+
+  // Writes a reference to a variable or a common expression; the latter
+  // have indices starting from the number of variables.
+  void WriteReference(int index) {
+    w_ << 'v';
+    WriteUInt(index);
+  }
+
+  void WriteConstant(double value) {
+    w_ << 'n';
+    if (binary_)
+      WriteBinary(value);
+    else
+      w_ << value;
+    EndLine();
+  }
+
+  // Writes an index-value pair such as a linear term or a suffix value.
+  template <typename T>
+  void WritePair(int index, T value) {
+    if (binary_) {
+      WriteBinary(index);
+      WriteBinary(value);
+    } else {
+      w_ << index << ' ' << value;
+    }
+    EndLine();
+  }
+
+  // Writes a bound of the specified type and value(s).
+  // See NLReader::ReadBounds for the list of bound types.
+  void WriteBound(int type) {
+    w_ << static_cast<char>('0' + type);
+    EndLine();
+  }
+  void WriteBound(int type, double value) {
+    w_ << static_cast<char>('0' + type);
+    if (binary_)
+      WriteBinary(value);
+    else
+      w_ << ' ' << value;
+    EndLine();
+  }
+  void WriteBound(int type, double lb, double ub) {
+    w_ << static_cast<char>('0' + type);
+    if (binary_) {
+      WriteBinary(lb);
+      WriteBinary(ub);
+    } else {
+      w_ << ' ' << lb << ' ' << ub;
+    }
+    EndLine();
+  }
+};
+
+// Parameters of a generated problem.
+struct NLGeneratorParams {
+  bool binary;           // Whether to use binary format.
+  unsigned seed;         // Random seed.
+  int num_vars;          // Number of variables.
+  int num_nl_vars;       // Number of variables in nonlinear expressions.
+  int num_cons;          // Number of algebraic constraints.
+  int num_nl_cons;       // Number of nonlinear constraints.
+  fmt::LongLong num_nonzeros;  // Number of Jacobian nonzeros.
+  int expr_depth;        // Depth of nonlinear expressions.
+  int num_common_exprs;  // Number of common expressions (V segments).
+  int num_suffixes;      // Number of suffixes.
+
+  NLGeneratorParams()
+    : binary(false), seed(1), num_vars(100), num_nl_vars(50), num_cons(100),
+      num_nl_cons(50), num_nonzeros(500), expr_depth(3),
+      num_common_exprs(10), num_suffixes(1) {}
+};
+
+// Generates a random problem in the .nl format. The problem is valid,
+// in particular nonlinear variables and constraints precede linear ones,
+// and the Jacobian sparsity includes all variables a constraint depends
+// on. The output is deterministic for the same parameters.
+class NLGenerator {
+ private:
+  NLGeneratorParams params_;
+
+  // A random number generator (xorshift64*) used instead of the C++11
+  // <random> facilities to get the same output on all platforms.
+  class Random {
+   private:
+    fmt::ULongLong state_;
+
+   public:
+    explicit Random(fmt::ULongLong seed);
+
+    fmt::ULongLong Next() {
+      state_ ^= state_ >> 12;
+      state_ ^= state_ << 25;
+      state_ ^= state_ >> 27;
+      return state_ * 2685821657736338717ull;
+    }
+
+    // Returns a random integer in the range [0, n).
+    int Next(int n) {
+      return static_cast<int>((Next() >> 33) % static_cast<unsigned>(n));
+    }
+
+    // Returns a random constant exactly representable in text format.
+    double NextConstant() { return Next(1000) / 8.0 + 0.125; }
+  };
+
+  // Returns a generator for the item with the specified index.
+  Random GetRandom(int item_kind, int index) const;
+
+  int GetNumNonzeros(int con_index) const;
+
+  // Returns the variable of the common expression with the specified index.
+  int GetCommonExprVar(int expr_index) const {
+    return expr_index % params_.num_nl_vars;
+  }
+
+  // Returns the sorted variable indices of the constraint and the index of
+  // a common expression it references or -1 if none.
+  int GetConVars(int con_index, Random &r, std::vector<int> &vars) const;
+
+  void WriteExpr(NLWriter &w, Random &r, int depth,
+                 const std::vector<int> &vars, int num_vars) const;
+
+ public:
+  explicit NLGenerator(const NLGeneratorParams &params);
+
+  const NLGeneratorParams &params() const { return params_; }
+
+  void Generate(NLWriter &w) const;
+};
+
+// Generates a problem in the .nl format and returns it as a string.
+std::string GenerateNL(const NLGeneratorParams &params);
+
+// Generates a problem in the .nl format and writes it to a file.
+void GenerateNLFile(fmt::StringRef filename, const NLGeneratorParams &params);
+}  // namespace mp
+
+#endif  // MP_NL_GENERATOR_H_
@@ -0,0 +1,71 @@
+/*
+ Pipelined .nl reading.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/nl-pipeline.h"
+
+#ifdef MP_USE_THREAD
+
+bool mp::internal::NLEventQueue::Push(NLEventChunk &chunk) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (chunks_.size() >= max_size_ && !cancelled_)
+    cond_.wait(lock);
+  if (cancelled_)
+    return false;
+  chunks_.push_back(NLEventChunk());
+  chunks_.back().swap(chunk);
+  if (!free_chunks_.empty()) {
+    chunk.swap(free_chunks_.back());
+    free_chunks_.pop_back();
+  }
+  cond_.notify_all();
+  return true;
+}
+
+bool mp::internal::NLEventQueue::Pop(NLEventChunk &chunk) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (chunks_.empty() && !closed_)
+    cond_.wait(lock);
+  if (chunks_.empty())
+    return false;
+  // Return the buffer of the previous chunk for reuse by the reader.
+  chunk.clear();
+  free_chunks_.push_back(NLEventChunk());
+  free_chunks_.back().swap(chunk);
+  chunk.swap(chunks_.front());
+  chunks_.pop_front();
+  cond_.notify_all();
+  return true;
+}
+
+void mp::internal::NLEventQueue::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  cond_.notify_all();
+}
+
+void mp::internal::NLEventQueue::Cancel() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  cancelled_ = true;
+  cond_.notify_all();
+}
+
+#endif  // MP_USE_THREAD
@@ -257,3 +257,20 @@ void mp::internal::BinaryReaderBase::ReportError(
   w.write(format_str, args);
   throw BinaryReadError(name_, offset, w.c_str());
 }
+
+void mp::internal::SegmentTimer::DoStart(char type) {
+  if (timer_ >= 0)
+    stats_->AddTime(timer_, GetTimeAndReset(start_));
+  else
+    start_ = steady_clock::now();
+  timer_ = -1;
+  if (type == 0)
+    return;
+  int &timer = timers_[static_cast<unsigned char>(type)];
+  if (timer < 0) {
+    char name[] = "segment ?";
+    name[sizeof(name) - 2] = type;
+    timer = stats_->GetTimer(name);
+  }
+  timer_ = timer;
+}
@@ -0,0 +1,53 @@
+/*
+ A tool that prints statistics of expression trees in .nl files:
+ counts and depth histograms by expression kind, numbers of arguments
+ of iterated expressions and breakpoints of piecewise-linear terms.
+
+ Usage: nlstats filename...
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <exception>
+
+#include "mp/error.h"
+#include "mp/expr-stats.h"
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fmt::print(stderr, "usage: nlstats filename...\n");
+    return 1;
+  }
+  try {
+    for (int i = 1; i < argc; ++i) {
+      mp::Problem p;
+      mp::ReadNLFile(argv[i], p);
+      mp::ExprStats stats;
+      mp::CollectExprStats(p, stats);
+      fmt::MemoryWriter w;
+      if (argc > 2)
+        w.write("{}:\n", argv[i]);
+      stats.Write(w);
+      fmt::print("{}", w.c_str());
+    }
+  } catch (const std::exception &e) {
+    fmt::print(stderr, "nlstats: {}\n", e.what());
+    return 1;
+  }
+}
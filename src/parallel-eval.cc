@@ -0,0 +1,138 @@
+/*
+ Multithreaded evaluation of constraints and the constraint Jacobian
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/parallel-eval.h"
+
+#include <algorithm>
+
+#include "tape-diff.h"
+
+class mp::ParallelEvaluator::ChunkTask : public ThreadPool::Task {
+ private:
+  ParallelEvaluator &eval_;
+  const double *x_;
+  double *con_values_;
+  double *jac_values_;
+
+ public:
+  ChunkTask(ParallelEvaluator &eval, const double *x,
+            double *con_values, double *jac_values)
+    : eval_(eval), x_(x), con_values_(con_values), jac_values_(jac_values) {}
+
+  void Run(int index, int thread_index) {
+    eval_.EvaluateChunk(index, thread_index, x_, con_values_, jac_values_);
+  }
+};
+
+mp::ParallelEvaluator::ParallelEvaluator(const Tape &tape, ThreadPool &pool)
+  : pool_(pool), jac_(tape), workspaces_(pool.num_threads()) {
+  int num_registers = std::max(tape.num_registers(), 1);
+  for (std::size_t i = 0, n = workspaces_.size(); i < n; ++i) {
+    Workspace &ws = workspaces_[i];
+    ws.registers.resize(num_registers);
+    ws.adjoints.resize(num_registers);
+    tape.InitConsts(&ws.registers[0]);
+  }
+  Split(std::min(tape.num_cons(), CHUNKS_PER_THREAD * pool.num_threads()));
+}
+
+void mp::ParallelEvaluator::Split(int num_chunks) {
+  const Tape &t = tape();
+  int num_cons = t.num_cons(), num_objs = t.num_objs();
+  // Estimate the work of a constraint by the number of instructions
+  // its derivatives depend on.
+  const std::vector<int> &jac_instr_starts = jac_.instr_starts_;
+  double total_work = 0;
+  for (int i = 0; i < num_cons; ++i) {
+    total_work += jac_instr_starts[num_objs + i + 1] -
+        jac_instr_starts[num_objs + i] + 1;
+  }
+  chunk_starts_.push_back(0);
+  double work = 0;
+  for (int i = 0; i < num_cons; ++i) {
+    work += jac_instr_starts[num_objs + i + 1] -
+        jac_instr_starts[num_objs + i] + 1;
+    int num_chunks_done = static_cast<int>(chunk_starts_.size());
+    if (work >= total_work * num_chunks_done / num_chunks && i + 1 < num_cons)
+      chunk_starts_.push_back(i + 1);
+  }
+  if (num_cons != 0)
+    chunk_starts_.push_back(num_cons);
+  // Find instructions each chunk depends on.
+  int first_result = t.first_result();
+  instr_starts_.reserve(chunk_starts_.size());
+  instr_starts_.push_back(0);
+  // marks[reg] is the index of the last chunk that reached reg.
+  std::vector<int> marks(t.num_registers(), -1);
+  std::vector<int> stack;
+  for (int chunk = 0, n = this->num_chunks(); chunk < n; ++chunk) {
+    for (int i = chunk_starts_[chunk]; i < chunk_starts_[chunk + 1]; ++i)
+      stack.push_back(t.con_register(i));
+    while (!stack.empty()) {
+      int reg = stack.back();
+      stack.pop_back();
+      if (reg < first_result || marks[reg] == chunk)
+        continue;
+      marks[reg] = chunk;
+      int instr_index = reg - first_result;
+      instrs_.push_back(instr_index);
+      internal::PushArgs(t, t.instruction(instr_index), stack);
+    }
+    std::sort(instrs_.begin() + instr_starts_.back(), instrs_.end());
+    instr_starts_.push_back(static_cast<int>(instrs_.size()));
+  }
+}
+
+void mp::ParallelEvaluator::EvaluateChunk(
+    int chunk, int thread_index, const double *x,
+    double *con_values, double *jac_values) {
+  const Tape &t = tape();
+  Workspace &ws = workspaces_[thread_index];
+  double *r = &ws.registers[0];
+  std::copy(x, x + t.num_vars(), r);
+  int start = instr_starts_[chunk];
+  t.Evaluate(r, instrs_.empty() ? 0 : &instrs_[start],
+             instr_starts_[chunk + 1] - start);
+  int first_con = chunk_starts_[chunk], end_con = chunk_starts_[chunk + 1];
+  if (con_values) {
+    for (int i = first_con; i < end_con; ++i)
+      con_values[i] = r[t.con_register(i)];
+  }
+  if (!jac_values)
+    return;
+  double *adj = &ws.adjoints[0];
+  jac_.ClearConstAdjoints(adj);
+  int num_objs = t.num_objs();
+  for (int i = first_con; i < end_con; ++i)
+    jac_.Differentiate(num_objs + i, r, adj, jac_values + jac_.jac_start(i));
+}
+
+void mp::ParallelEvaluator::GetConValues(const double *x, double *values) {
+  ChunkTask task(*this, x, values, 0);
+  pool_.Run(task, num_chunks());
+}
+
+void mp::ParallelEvaluator::GetJacobian(
+    const double *x, double *values, double *con_values) {
+  ChunkTask task(*this, x, con_values, values);
+  pool_.Run(task, num_chunks());
+}
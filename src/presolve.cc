@@ -0,0 +1,454 @@
+/*
+ Presolve and postsolve of optimization problems
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/presolve.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mp/bound-propagator.h"
+#include "mp/error.h"
+#include "expr-simplifier.h"
+
+namespace {
+
+// Tolerance used when checking if a bound implied by a singleton
+// constraint is active in a solution.
+const double ACTIVE_TOLERANCE = 1e-6;
+
+// Tolerance used when rounding bounds on integer variables.
+const double INT_TOLERANCE = 1e-6;
+
+inline double Scale(double x) { return std::max(std::fabs(x), 1.0); }
+
+// Returns the number of items of the specified suffix kind in a problem.
+int GetNumItems(const mp::Problem &p, int kind) {
+  switch (kind) {
+  case mp::suf::VAR:
+    return p.num_vars();
+  case mp::suf::CON:
+    return p.num_algebraic_cons();
+  case mp::suf::OBJ:
+    return p.num_objs();
+  }
+  return 1;
+}
+}
+
+const double mp::Presolver::TOLERANCE = 1e-9;
+
+void mp::Presolver::Reduce() {
+  int num_vars = original_.num_vars();
+  int num_cons = original_.num_algebraic_cons();
+  // Find variables in nonlinear expressions and constraints with
+  // nonlinear parts which are not reduced.
+  std::vector<Interval> whole(num_vars);
+  std::vector<int> vars;
+  IntervalEvaluator eval(original_, whole.empty() ? 0 : &whole[0]);
+  eval.set_var_collector(&vars);
+  std::vector<bool> nonlinear_cons(num_cons);
+  for (int i = 0; i < num_cons; ++i) {
+    if (NumericExpr e = original_.algebraic_con(i).nonlinear_expr()) {
+      eval.Evaluate(e);
+      nonlinear_cons[i] = true;
+    }
+  }
+  for (int i = 0, n = original_.num_objs(); i < n; ++i) {
+    if (NumericExpr e = original_.obj(i).nonlinear_expr())
+      eval.Evaluate(e);
+  }
+  for (int i = 0, n = original_.num_logical_cons(); i < n; ++i)
+    eval.Evaluate(original_.logical_con(i).expr());
+  for (std::size_t i = 0, n = vars.size(); i < n; ++i)
+    nonlinear_vars_[vars[i]] = true;
+
+  for (int i = 0; i < num_vars; ++i) {
+    if (var_lbs_[i] == var_ubs_[i]) {
+      var_map_[i] = -1;
+      stack_.push_back(Reduction(Reduction::FIX_VAR, i, -1, var_lbs_[i]));
+    }
+  }
+
+  // Remove singleton and empty constraints until no variable is fixed.
+  for (bool changed = true; changed; ) {
+    changed = false;
+    for (int i = 0; i < num_cons; ++i) {
+      if (con_map_[i] < 0 || nonlinear_cons[i])
+        continue;
+      Problem::AlgebraicCon con = original_.algebraic_con(i);
+      const LinearExpr &linear = con.linear_expr();
+      double constant = 0, coef = 0;
+      int var = -1;
+      bool singleton = true;
+      for (LinearExpr::iterator
+           j = linear.begin(), end = linear.end(); j != end; ++j) {
+        int index = j->var_index();
+        if (var_map_[index] < 0) {
+          constant += j->coef() * var_lbs_[index];
+        } else if (var < 0 || var == index) {
+          var = index;
+          coef += j->coef();
+        } else {
+          singleton = false;
+          break;
+        }
+      }
+      if (!singleton)
+        continue;
+      double lb = con.lb() - constant, ub = con.ub() - constant;
+      if (var < 0 || coef == 0) {
+        // Leave infeasible constraints to the solver.
+        if (lb <= TOLERANCE * Scale(lb) && ub >= -TOLERANCE * Scale(ub)) {
+          con_map_[i] = -1;
+          stack_.push_back(Reduction(Reduction::DROP_CON, var, i, 0));
+        }
+        continue;
+      }
+      double var_lb = lb / coef, var_ub = ub / coef;
+      if (coef < 0)
+        std::swap(var_lb, var_ub);
+      if (original_.var(var).type() != var::CONTINUOUS) {
+        var_lb = std::ceil(var_lb - INT_TOLERANCE);
+        var_ub = std::floor(var_ub + INT_TOLERANCE);
+      }
+      double &cur_lb = var_lbs_[var], &cur_ub = var_ubs_[var];
+      double new_lb = std::max(var_lb, cur_lb);
+      double new_ub = std::min(var_ub, cur_ub);
+      if (new_lb - new_ub > TOLERANCE * Scale(new_lb))
+        continue;
+      con_map_[i] = -1;
+      stack_.push_back(Reduction(Reduction::SINGLETON_CON, var, i, coef));
+      if (var_lb > cur_lb) {
+        cur_lb = var_lb;
+        lb_cons_[var] = i;
+      }
+      if (var_ub < cur_ub) {
+        cur_ub = var_ub;
+        ub_cons_[var] = i;
+      }
+      if (cur_lb >= cur_ub) {
+        cur_lb = cur_ub = cur_lb == cur_ub ? cur_lb : 0.5 * (cur_lb + cur_ub);
+        var_map_[var] = -1;
+        stack_.push_back(Reduction(Reduction::FIX_VAR, var, -1, cur_lb));
+        changed = true;
+      }
+    }
+  }
+}
+
+void mp::Presolver::Build() {
+  for (int i = 0, n = original_.num_vars(); i < n; ++i) {
+    if (var_map_[i] < 0)
+      continue;
+    var_map_[i] = problem_.num_vars();
+    problem_.AddVar(var_lbs_[i], var_ubs_[i], original_.var(i).type());
+  }
+  internal::ExprSimplifier simplifier(problem_, var_map_, var_lbs_);
+  for (int i = 0, n = original_.num_common_exprs(); i < n; ++i) {
+    Problem::CommonExpr ce = original_.common_expr(i);
+    const LinearExpr &linear = ce.linear_expr();
+    double constant = 0;
+    int num_terms = 0;
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      if (var_map_[j->var_index()] >= 0)
+        ++num_terms;
+    }
+    Problem::LinearExprBuilder b = problem_.BeginCommonExpr(num_terms);
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      int index = var_map_[j->var_index()];
+      if (index >= 0)
+        b.AddTerm(index, j->coef());
+      else
+        constant += j->coef() * var_lbs_[j->var_index()];
+    }
+    NumericExpr nonlinear = ce.nonlinear_expr();
+    if (nonlinear)
+      nonlinear = simplifier.Visit(nonlinear);
+    problem_.EndCommonExpr(b, simplifier.AddConstant(nonlinear, constant), i);
+  }
+  for (int i = 0, n = original_.num_objs(); i < n; ++i) {
+    Problem::Objective obj = original_.obj(i);
+    const LinearExpr &linear = obj.linear_expr();
+    double constant = 0;
+    int num_terms = 0;
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      if (var_map_[j->var_index()] >= 0)
+        ++num_terms;
+      else
+        constant += j->coef() * var_lbs_[j->var_index()];
+    }
+    NumericExpr nonlinear = obj.nonlinear_expr();
+    if (nonlinear)
+      nonlinear = simplifier.Visit(nonlinear);
+    Problem::LinearObjBuilder b = problem_.AddObj(
+          obj.type(), simplifier.AddConstant(nonlinear, constant), num_terms);
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      int index = var_map_[j->var_index()];
+      if (index >= 0)
+        b.AddTerm(index, j->coef());
+    }
+  }
+  for (int i = 0, n = original_.num_algebraic_cons(); i < n; ++i) {
+    if (con_map_[i] < 0)
+      continue;
+    Problem::AlgebraicCon con = original_.algebraic_con(i);
+    const LinearExpr &linear = con.linear_expr();
+    double constant = 0;
+    int num_terms = 0;
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      if (var_map_[j->var_index()] >= 0)
+        ++num_terms;
+      else
+        constant += j->coef() * var_lbs_[j->var_index()];
+    }
+    NumericExpr nonlinear = con.nonlinear_expr();
+    if (nonlinear) {
+      nonlinear = simplifier.Visit(nonlinear);
+      if (NumericConstant c = Cast<NumericConstant>(nonlinear)) {
+        constant += c.value();
+        nonlinear = NumericExpr();
+      }
+    }
+    double lb = con.lb() - constant, ub = con.ub() - constant;
+    if (num_terms == 0 && !nonlinear &&
+        lb <= TOLERANCE * Scale(lb) && ub >= -TOLERANCE * Scale(ub)) {
+      con_map_[i] = -1;
+      stack_.push_back(Reduction(Reduction::DROP_CON, -1, i, 0));
+      continue;
+    }
+    con_map_[i] = problem_.num_algebraic_cons();
+    Problem::LinearConBuilder b = problem_.AddCon(lb, ub, nonlinear, num_terms);
+    for (LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      int index = var_map_[j->var_index()];
+      if (index >= 0)
+        b.AddTerm(index, j->coef());
+    }
+  }
+  for (int i = 0, n = original_.num_logical_cons(); i < n; ++i) {
+    LogicalExpr e = simplifier.Visit(original_.logical_con(i).expr());
+    LogicalConstant c = Cast<LogicalConstant>(e);
+    if (c && c.value())
+      ++num_dropped_logical_cons_;
+    else
+      problem_.AddCon(e);
+  }
+}
+
+void mp::Presolver::BuildColumns() {
+  int num_vars = original_.num_vars();
+  col_starts_.assign(num_vars + 1, 0);
+  std::vector<bool> needed(num_vars);
+  bool any_needed = false;
+  for (int i = 0; i < num_vars; ++i) {
+    if ((lb_cons_[i] >= 0 || ub_cons_[i] >= 0) && !nonlinear_vars_[i])
+      needed[i] = any_needed = true;
+  }
+  if (!any_needed)
+    return;
+  obj_coefs_.assign(num_vars, 0);
+  if (original_.num_objs() != 0) {
+    const LinearExpr &linear = original_.obj(0).linear_expr();
+    for (LinearExpr::iterator i = linear.begin(), end = linear.end();
+         i != end; ++i) {
+      obj_coefs_[i->var_index()] += i->coef();
+    }
+  }
+  int num_cons = original_.num_algebraic_cons();
+  for (int i = 0; i < num_cons; ++i) {
+    const LinearExpr &linear = original_.algebraic_con(i).linear_expr();
+    for (LinearExpr::iterator j = linear.begin(), end = linear.end();
+         j != end; ++j) {
+      if (needed[j->var_index()])
+        ++col_starts_[j->var_index() + 1];
+    }
+  }
+  for (int i = 0; i < num_vars; ++i)
+    col_starts_[i + 1] += col_starts_[i];
+  col_cons_.resize(col_starts_.back());
+  col_coefs_.resize(col_starts_.back());
+  std::vector<int> positions(col_starts_.begin(), col_starts_.end() - 1);
+  for (int i = 0; i < num_cons; ++i) {
+    const LinearExpr &linear = original_.algebraic_con(i).linear_expr();
+    for (LinearExpr::iterator j = linear.begin(), end = linear.end();
+         j != end; ++j) {
+      int var = j->var_index();
+      if (!needed[var])
+        continue;
+      int pos = positions[var]++;
+      col_cons_[pos] = i;
+      col_coefs_[pos] = j->coef();
+    }
+  }
+}
+
+const std::vector<int> *mp::Presolver::GetItemMap(int kind) const {
+  switch (kind) {
+  case suf::VAR:
+    return &var_map_;
+  case suf::CON:
+    return &con_map_;
+  }
+  return 0;
+}
+
+void mp::Presolver::CopySuffixes() {
+  for (int kind = 0; kind < suf::NUM_KINDS; ++kind) {
+    const std::vector<int> *map = GetItemMap(kind);
+    int num_items = GetNumItems(original_, kind);
+    const SuffixSet &suffixes = original_.suffixes(kind);
+    for (SuffixSet::iterator
+         i = suffixes.begin(), end = suffixes.end(); i != end; ++i) {
+      if (i->is_dbl()) {
+        Problem::DblSuffixHandler handler =
+            problem_.AddDblSuffix(i->name(), i->kind(), 0);
+        for (int j = 0; j < num_items; ++j) {
+          int index = map ? (*map)[j] : j;
+          if (index >= 0)
+            handler.SetValue(index, i->dbl_value(j));
+        }
+      } else {
+        Problem::IntSuffixHandler handler =
+            problem_.AddIntSuffix(i->name(), i->kind(), 0);
+        for (int j = 0; j < num_items; ++j) {
+          int index = map ? (*map)[j] : j;
+          if (index >= 0)
+            handler.SetValue(index, i->value(j));
+        }
+      }
+    }
+  }
+}
+
+mp::Presolver::Presolver(const Problem &p)
+  : original_(p), num_dropped_logical_cons_(0) {
+  if (p.HasComplementarity())
+    throw Error("presolve doesn't support complementarity conditions");
+  int num_vars = p.num_vars(), num_cons = p.num_algebraic_cons();
+  var_lbs_.resize(num_vars);
+  var_ubs_.resize(num_vars);
+  for (int i = 0; i < num_vars; ++i) {
+    Problem::Variable var = p.var(i);
+    double lb = var.lb(), ub = var.ub();
+    if (var.type() != var::CONTINUOUS) {
+      lb = std::ceil(lb - INT_TOLERANCE);
+      ub = std::floor(ub + INT_TOLERANCE);
+    }
+    var_lbs_[i] = lb;
+    var_ubs_[i] = ub;
+  }
+  var_map_.resize(num_vars);
+  con_map_.resize(num_cons);
+  lb_cons_.assign(num_vars, -1);
+  ub_cons_.assign(num_vars, -1);
+  nonlinear_vars_.resize(num_vars);
+  Reduce();
+  Build();
+  BuildColumns();
+  CopySuffixes();
+}
+
+void mp::Presolver::Postsolve(
+    const double *values, const double *dual_values,
+    std::vector<double> &orig_values,
+    std::vector<double> &orig_dual_values) const {
+  orig_values.clear();
+  orig_dual_values.clear();
+  int num_vars = original_.num_vars();
+  if (values) {
+    orig_values.resize(num_vars);
+    for (int i = 0; i < num_vars; ++i) {
+      int index = var_map_[i];
+      orig_values[i] = index >= 0 ? values[index] : var_lbs_[i];
+    }
+  }
+  if (!dual_values)
+    return;
+  int num_cons = original_.num_algebraic_cons();
+  orig_dual_values.resize(num_cons);
+  for (int i = 0; i < num_cons; ++i) {
+    int index = con_map_[i];
+    orig_dual_values[i] = index >= 0 ? dual_values[index] : 0;
+  }
+  if (!values)
+    return;
+  // Unwind the postsolve stack. The dual of a singleton constraint whose
+  // bound is active is the reduced cost of the variable divided by the
+  // coefficient.
+  double sense = original_.num_objs() != 0 &&
+      original_.obj(0).type() == obj::MAX ? -1 : 1;
+  for (std::vector<Reduction>::const_reverse_iterator
+       r = stack_.rbegin(), end = stack_.rend(); r != end; ++r) {
+    if (r->kind != Reduction::SINGLETON_CON)
+      continue;
+    int var = r->var, con = r->con;
+    bool is_lb = lb_cons_[var] == con, is_ub = ub_cons_[var] == con;
+    if ((!is_lb && !is_ub) || nonlinear_vars_[var])
+      continue;
+    double reduced_cost = obj_coefs_[var];
+    for (int i = col_starts_[var], n = col_starts_[var + 1]; i < n; ++i) {
+      if (col_cons_[i] != con)
+        reduced_cost -= orig_dual_values[col_cons_[i]] * col_coefs_[i];
+    }
+    double x = orig_values[var];
+    double lb = var_lbs_[var], ub = var_ubs_[var];
+    bool at_lb = is_lb && x - lb <= ACTIVE_TOLERANCE * Scale(lb) &&
+        sense * reduced_cost >= 0;
+    bool at_ub = is_ub && ub - x <= ACTIVE_TOLERANCE * Scale(ub) &&
+        sense * reduced_cost <= 0;
+    if (at_lb || at_ub)
+      orig_dual_values[con] = reduced_cost / r->value;
+  }
+}
+
+void mp::Presolver::PostsolveSuffixes(Problem &p) {
+  for (int kind = 0; kind < suf::NUM_KINDS; ++kind) {
+    const std::vector<int> *map = GetItemMap(kind);
+    int num_items = GetNumItems(p, kind);
+    const SuffixSet &suffixes = problem_.suffixes(kind);
+    for (SuffixSet::iterator
+         i = suffixes.begin(), end = suffixes.end(); i != end; ++i) {
+      Suffix *suffix = p.suffixes(kind).Find(i->name());
+      if (!suffix) {
+        if (i->is_dbl())
+          p.AddDblSuffix(i->name(), i->kind(), 0);
+        else
+          p.AddIntSuffix(i->name(), i->kind(), 0);
+        suffix = p.suffixes(kind).Find(i->name());
+      }
+      for (int j = 0; j < num_items; ++j) {
+        int index = map ? (*map)[j] : j;
+        if (index < 0)
+          continue;
+        if (i->is_dbl())
+          suffix->set_value(j, i->dbl_value(index));
+        else
+          suffix->set_value(j, i->value(index));
+      }
+    }
+  }
+}
@@ -0,0 +1,550 @@
+/*
+ Algebraic simplification of problem expressions
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/simplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "expr-simplifier.h"
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+inline bool IsFinite(double x) { return x - x == 0; }
+
+// Returns the value of a piecewise-linear term at x which is the
+// integral of the slope from 0 to x.
+double EvalPLTerm(mp::PLTerm e, double x) {
+  double lb = std::min(x, 0.0), ub = std::max(x, 0.0), result = 0;
+  for (int i = 0, n = e.num_breakpoints(); i <= n; ++i) {
+    double start = std::max(i > 0 ? e.breakpoint(i - 1) : -INF, lb);
+    double end = std::min(i < n ? e.breakpoint(i) : INF, ub);
+    if (start < end)
+      result += e.slope(i) * (end - start);
+  }
+  return x >= 0 ? result : -result;
+}
+
+// Simplifies linear + nonlinear moving the constant and linear terms
+// of the nonlinear part to terms.constant and linear. Returns the
+// remaining nonlinear part.
+mp::NumericExpr Hoist(mp::internal::ExprSimplifier &s,
+                      mp::LinearExpr &linear, mp::NumericExpr nonlinear,
+                      mp::internal::ExprSimplifier::Terms &terms) {
+  terms.constant = 0;
+  terms.linear.clear();
+  terms.nonlinear.clear();
+  for (mp::LinearExpr::iterator
+       i = linear.begin(), end = linear.end(); i != end; ++i) {
+    terms.linear.push_back(std::make_pair(i->var_index(), i->coef()));
+  }
+  s.Collect(nonlinear, 1, terms);
+  mp::NumericExpr result = s.MakeSum(terms, true);
+  linear = mp::LinearExpr();
+  linear.Reserve(static_cast<int>(terms.linear.size()));
+  for (std::size_t i = 0, n = terms.linear.size(); i < n; ++i)
+    linear.AddTerm(terms.linear[i].first, terms.linear[i].second);
+  return result;
+}
+}
+
+bool mp::internal::FoldUnary(expr::Kind kind, double x, double &result) {
+  switch (kind) {
+  case expr::MINUS: result = -x; break;
+  case expr::ABS:   result = std::fabs(x); break;
+  case expr::FLOOR: result = std::floor(x); break;
+  case expr::CEIL:  result = std::ceil(x); break;
+  case expr::SQRT:  result = std::sqrt(x); break;
+  case expr::POW2:  result = x * x; break;
+  case expr::EXP:   result = std::exp(x); break;
+  case expr::LOG:   result = std::log(x); break;
+  case expr::LOG10: result = std::log10(x); break;
+  case expr::SIN:   result = std::sin(x); break;
+  case expr::SINH:  result = std::sinh(x); break;
+  case expr::COS:   result = std::cos(x); break;
+  case expr::COSH:  result = std::cosh(x); break;
+  case expr::TAN:   result = std::tan(x); break;
+  case expr::TANH:  result = std::tanh(x); break;
+  case expr::ASIN:  result = std::asin(x); break;
+  case expr::ASINH: result = std::asinh(x); break;
+  case expr::ACOS:  result = std::acos(x); break;
+  case expr::ACOSH: result = std::acosh(x); break;
+  case expr::ATAN:  result = std::atan(x); break;
+  case expr::ATANH: result = std::atanh(x); break;
+  default:
+    return false;
+  }
+  // Leave domain errors to the solver.
+  return IsFinite(result);
+}
+
+bool mp::internal::FoldBinary(
+    expr::Kind kind, double x, double y, double &result) {
+  switch (kind) {
+  case expr::ADD:  result = x + y; break;
+  case expr::SUB:  result = x - y; break;
+  case expr::LESS: result = std::max(x - y, 0.0); break;
+  case expr::MUL:  result = x * y; break;
+  case expr::DIV:  result = x / y; break;
+  case expr::INT_DIV: {
+    double quotient = x / y;
+    result = quotient >= 0 ? std::floor(quotient) : std::ceil(quotient);
+    break;
+  }
+  case expr::MOD:   result = std::fmod(x, y); break;
+  case expr::ATAN2: result = std::atan2(x, y); break;
+  case expr::POW: case expr::POW_CONST_BASE: case expr::POW_CONST_EXP:
+    result = std::pow(x, y);
+    break;
+  default:
+    return false;
+  }
+  return IsFinite(result);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::Scale(
+    double coef, NumericExpr e) {
+  if (coef == 1)
+    return e;
+  if (coef == -1)
+    return problem_.MakeUnary(expr::MINUS, e);
+  return problem_.MakeBinary(expr::MUL, MakeConst(coef), e);
+}
+
+mp::Function mp::internal::ExprSimplifier::GetFunction(Function f) {
+  if (!var_map_)
+    return f;
+  std::map<std::string, Function>::iterator i = funcs_.find(f.name());
+  if (i != funcs_.end())
+    return i->second;
+  Function result = problem_.AddFunction(f.name(), f.num_args(), f.type());
+  funcs_[f.name()] = result;
+  return result;
+}
+
+mp::Expr mp::internal::ExprSimplifier::CopyArg(Expr e) {
+  if (NumericExpr n = mp::Cast<NumericExpr>(e))
+    return Visit(n);
+  if (StringLiteral s = mp::Cast<StringLiteral>(e))
+    return var_map_ ? problem_.MakeStringLiteral(s.value()) : s;
+  SymbolicIfExpr sym_if = mp::Cast<SymbolicIfExpr>(e);
+  MP_ASSERT(sym_if, "invalid argument");
+  Expr false_expr = sym_if.false_expr();
+  return problem_.MakeSymbolicIf(Visit(sym_if.condition()),
+                                 CopyArg(sym_if.true_expr()),
+                                 false_expr ? CopyArg(false_expr) : Expr());
+}
+
+mp::CountExpr mp::internal::ExprSimplifier::CopyCount(CountExpr e) {
+  Problem::CountExprBuilder b = problem_.BeginCount(e.num_args());
+  for (CountExpr::iterator i = e.begin(), end = e.end(); i != end; ++i)
+    b.AddArg(Visit(*i));
+  return problem_.EndCount(b);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::SimplifyPow(BinaryExpr e) {
+  NumericExpr base = Visit(e.lhs()), exponent = Visit(e.rhs());
+  double x = 0, y = 0, result = 0;
+  bool const_base = GetValue(base, x);
+  if (GetValue(exponent, y)) {
+    if (const_base && FoldBinary(e.kind(), x, y, result))
+      return MakeConst(result);
+    if (y == 0)
+      return MakeConst(1);
+    if (y == 1)
+      return base;
+    if (y == 2)
+      return problem_.MakeUnary(expr::POW2, base);
+    return problem_.MakeBinary(expr::POW_CONST_EXP, base, exponent);
+  }
+  return problem_.MakeBinary(
+        const_base ? expr::POW_CONST_BASE : expr::POW, base, exponent);
+}
+
+void mp::internal::ExprSimplifier::Collect(
+    NumericExpr e, double coef, Terms &terms, bool simplified) {
+  if (coef == 0)
+    return;
+  switch (e.kind()) {
+  case expr::CONSTANT:
+    terms.constant += coef * mp::Cast<NumericConstant>(e).value();
+    return;
+  case expr::VARIABLE:
+    if (!simplified)
+      break;
+    terms.linear.push_back(std::make_pair(mp::Cast<Reference>(e).index(), coef));
+    return;
+  case expr::MINUS:
+    Collect(mp::Cast<UnaryExpr>(e).arg(), -coef, terms, simplified);
+    return;
+  case expr::ADD: case expr::SUB: {
+    BinaryExpr b = mp::Cast<BinaryExpr>(e);
+    Collect(b.lhs(), coef, terms, simplified);
+    Collect(b.rhs(), e.kind() == expr::ADD ? coef : -coef, terms, simplified);
+    return;
+  }
+  case expr::SUM: {
+    SumExpr sum = mp::Cast<SumExpr>(e);
+    for (SumExpr::iterator i = sum.begin(), end = sum.end(); i != end; ++i)
+      Collect(*i, coef, terms, simplified);
+    return;
+  }
+  case expr::MUL: {
+    BinaryExpr b = mp::Cast<BinaryExpr>(e);
+    NumericExpr lhs = Simplify(b.lhs(), simplified);
+    double value = 0;
+    if (GetValue(lhs, value)) {
+      Collect(b.rhs(), coef * value, terms, simplified);
+      return;
+    }
+    NumericExpr rhs = Simplify(b.rhs(), simplified);
+    if (GetValue(rhs, value)) {
+      Collect(lhs, coef * value, terms, true);
+      return;
+    }
+    if (!simplified)
+      e = problem_.MakeBinary(expr::MUL, lhs, rhs);
+    terms.nonlinear.push_back(std::make_pair(coef, e));
+    return;
+  }
+  case expr::DIV: {
+    BinaryExpr b = mp::Cast<BinaryExpr>(e);
+    NumericExpr rhs = Simplify(b.rhs(), simplified);
+    double value = 0;
+    if (GetValue(rhs, value) && value != 0) {
+      Collect(b.lhs(), coef / value, terms, simplified);
+      return;
+    }
+    if (!simplified)
+      e = problem_.MakeBinary(expr::DIV, Visit(b.lhs()), rhs);
+    terms.nonlinear.push_back(std::make_pair(coef, e));
+    return;
+  }
+  default:
+    break;
+  }
+  if (simplified)
+    terms.nonlinear.push_back(std::make_pair(coef, e));
+  else
+    Collect(Visit(e), coef, terms, true);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::MakeSum(
+    Terms &terms, bool hoist) {
+  // Combine linear terms keeping the order of first occurrence.
+  std::vector< std::pair<int, double> > &linear = terms.linear;
+  std::size_t num_merged = 0;
+  for (std::size_t i = 0, n = linear.size(); i < n; ++i) {
+    std::size_t var = linear[i].first;
+    if (positions_.size() <= var)
+      positions_.resize(var + 1, -1);
+    int &pos = positions_[var];
+    if (pos < 0) {
+      pos = static_cast<int>(num_merged);
+      linear[num_merged++] = linear[i];
+    } else {
+      linear[pos].second += linear[i].second;
+    }
+  }
+  linear.resize(num_merged);
+  for (std::size_t i = 0; i < num_merged; ++i)
+    positions_[linear[i].first] = -1;
+  std::vector<NumericExpr> args;
+  if (!hoist) {
+    for (std::size_t i = 0; i < num_merged; ++i) {
+      if (linear[i].second != 0) {
+        args.push_back(Scale(linear[i].second,
+                             problem_.MakeVariable(linear[i].first)));
+      }
+    }
+  }
+  for (std::size_t i = 0, n = terms.nonlinear.size(); i < n; ++i)
+    args.push_back(Scale(terms.nonlinear[i].first, terms.nonlinear[i].second));
+  if (!hoist && terms.constant != 0)
+    args.push_back(MakeConst(terms.constant));
+  switch (args.size()) {
+  case 0:
+    return hoist ? NumericExpr() : MakeConst(terms.constant);
+  case 1:
+    return args[0];
+  case 2:
+    return problem_.MakeBinary(expr::ADD, args[0], args[1]);
+  }
+  Problem::IteratedExprBuilder b =
+      problem_.BeginIterated(expr::SUM, static_cast<int>(args.size()));
+  for (std::size_t i = 0, n = args.size(); i < n; ++i)
+    b.AddArg(args[i]);
+  return problem_.EndIterated(b);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::AddConstant(
+    NumericExpr e, double constant) {
+  double value = 0;
+  if (!e || GetValue(e, value))
+    return constant != 0 || e ? MakeConst(value + constant) : e;
+  if (constant == 0)
+    return e;
+  return problem_.MakeBinary(expr::ADD, e, MakeConst(constant));
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitVariable(Reference v) {
+  if (!var_map_)
+    return v;
+  int index = (*var_map_)[v.index()];
+  if (index < 0)
+    return MakeConst((*var_values_)[v.index()]);
+  return problem_.MakeVariable(index);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitUnary(UnaryExpr e) {
+  if (e.kind() == expr::MINUS)
+    return SimplifySum(e);
+  NumericExpr arg = Visit(e.arg());
+  double x = 0, result = 0;
+  if (GetValue(arg, x) && FoldUnary(e.kind(), x, result))
+    return MakeConst(result);
+  return problem_.MakeUnary(e.kind(), arg);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitBinary(BinaryExpr e) {
+  switch (e.kind()) {
+  case expr::ADD: case expr::SUB: case expr::MUL: case expr::DIV:
+    return SimplifySum(e);
+  case expr::POW: case expr::POW_CONST_BASE: case expr::POW_CONST_EXP:
+    return SimplifyPow(e);
+  default:
+    break;
+  }
+  NumericExpr lhs = Visit(e.lhs()), rhs = Visit(e.rhs());
+  double x = 0, y = 0, result = 0;
+  if (GetValue(lhs, x) && GetValue(rhs, y) &&
+      FoldBinary(e.kind(), x, y, result)) {
+    return MakeConst(result);
+  }
+  return problem_.MakeBinary(e.kind(), lhs, rhs);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitIf(IfExpr e) {
+  LogicalExpr condition = Visit(e.condition());
+  NumericExpr false_expr = e.false_expr();
+  bool value = false;
+  if (GetValue(condition, value)) {
+    if (value)
+      return Visit(e.true_expr());
+    return false_expr ? Visit(false_expr) : MakeConst(0);
+  }
+  return problem_.MakeIf(condition, Visit(e.true_expr()),
+                         false_expr ? Visit(false_expr) : NumericExpr());
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitPLTerm(PLTerm e) {
+  if (!var_map_)
+    return e;
+  Reference arg = e.arg();
+  Reference new_arg;
+  if (arg.kind() == expr::VARIABLE) {
+    int index = (*var_map_)[arg.index()];
+    if (index < 0)
+      return MakeConst(EvalPLTerm(e, (*var_values_)[arg.index()]));
+    new_arg = problem_.MakeVariable(index);
+  } else {
+    new_arg = problem_.MakeCommonExpr(arg.index());
+  }
+  int num_breakpoints = e.num_breakpoints();
+  Problem::PLTermBuilder b = problem_.BeginPLTerm(num_breakpoints);
+  for (int i = 0; i < num_breakpoints; ++i) {
+    b.AddSlope(e.slope(i));
+    b.AddBreakpoint(e.breakpoint(i));
+  }
+  b.AddSlope(e.slope(num_breakpoints));
+  return problem_.EndPLTerm(b, new_arg);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitCall(CallExpr e) {
+  Problem::CallExprBuilder b =
+      problem_.BeginCall(GetFunction(e.function()), e.num_args());
+  for (CallExpr::iterator i = e.begin(), end = e.end(); i != end; ++i)
+    b.AddArg(CopyArg(*i));
+  return problem_.EndCall(b);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitVarArg(VarArgExpr e) {
+  std::vector<NumericExpr> args;
+  args.reserve(e.num_args());
+  bool all_constant = true;
+  double result = 0;
+  for (VarArgExpr::iterator i = e.begin(), end = e.end(); i != end; ++i) {
+    args.push_back(Visit(*i));
+    double value = 0;
+    if (!GetValue(args.back(), value)) {
+      all_constant = false;
+    } else if (args.size() == 1) {
+      result = value;
+    } else {
+      result = e.kind() == expr::MIN ?
+            std::min(result, value) : std::max(result, value);
+    }
+  }
+  if (all_constant && !args.empty())
+    return MakeConst(result);
+  Problem::IteratedExprBuilder b =
+      problem_.BeginIterated(e.kind(), e.num_args());
+  for (std::size_t i = 0, n = args.size(); i < n; ++i)
+    b.AddArg(args[i]);
+  return problem_.EndIterated(b);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitNumberOf(
+    NumberOfExpr e) {
+  NumberOfExpr::iterator i = e.begin(), end = e.end();
+  Problem::NumberOfExprBuilder b =
+      problem_.BeginNumberOf(e.num_args(), Visit(*i));
+  for (++i; i != end; ++i)
+    b.AddArg(Visit(*i));
+  return problem_.EndNumberOf(b);
+}
+
+mp::NumericExpr mp::internal::ExprSimplifier::VisitNumberOfSym(
+    SymbolicNumberOfExpr e) {
+  SymbolicNumberOfExpr::iterator i = e.begin(), end = e.end();
+  Problem::SymbolicNumberOfExprBuilder b =
+      problem_.BeginSymbolicNumberOf(e.num_args(), CopyArg(*i));
+  for (++i; i != end; ++i)
+    b.AddArg(CopyArg(*i));
+  return problem_.EndSymbolicNumberOf(b);
+}
+
+mp::LogicalExpr mp::internal::ExprSimplifier::VisitBinaryLogical(
+    BinaryLogicalExpr e) {
+  LogicalExpr lhs = Visit(e.lhs()), rhs = Visit(e.rhs());
+  bool lhs_value = false, rhs_value = false;
+  bool lhs_const = GetValue(lhs, lhs_value);
+  bool rhs_const = GetValue(rhs, rhs_value);
+  switch (e.kind()) {
+  case expr::OR:
+    if ((lhs_const && lhs_value) || (rhs_const && rhs_value))
+      return MakeBool(true);
+    if (lhs_const)
+      return rhs;
+    if (rhs_const)
+      return lhs;
+    break;
+  case expr::AND:
+    if ((lhs_const && !lhs_value) || (rhs_const && !rhs_value))
+      return MakeBool(false);
+    if (lhs_const)
+      return rhs;
+    if (rhs_const)
+      return lhs;
+    break;
+  case expr::IFF:
+    if (lhs_const && rhs_const)
+      return MakeBool(lhs_value == rhs_value);
+    break;
+  default:
+    break;
+  }
+  return problem_.MakeBinaryLogical(e.kind(), lhs, rhs);
+}
+
+mp::LogicalExpr mp::internal::ExprSimplifier::VisitRelational(
+    RelationalExpr e) {
+  NumericExpr lhs = Visit(e.lhs()), rhs = Visit(e.rhs());
+  double x = 0, y = 0;
+  if (!GetValue(lhs, x) || !GetValue(rhs, y))
+    return problem_.MakeRelational(e.kind(), lhs, rhs);
+  switch (e.kind()) {
+  case expr::LT: return MakeBool(x < y);
+  case expr::LE: return MakeBool(x <= y);
+  case expr::EQ: return MakeBool(x == y);
+  case expr::GE: return MakeBool(x >= y);
+  case expr::GT: return MakeBool(x > y);
+  case expr::NE: return MakeBool(x != y);
+  default:
+    break;
+  }
+  return problem_.MakeRelational(e.kind(), lhs, rhs);
+}
+
+mp::LogicalExpr mp::internal::ExprSimplifier::VisitImplication(
+    ImplicationExpr e) {
+  LogicalExpr condition = Visit(e.condition());
+  LogicalExpr false_expr = e.false_expr();
+  bool value = false;
+  if (GetValue(condition, value)) {
+    if (value)
+      return Visit(e.true_expr());
+    return false_expr ? Visit(false_expr) : MakeBool(true);
+  }
+  return problem_.MakeImplication(
+        condition, Visit(e.true_expr()),
+        false_expr ? Visit(false_expr) : LogicalExpr());
+}
+
+mp::LogicalExpr mp::internal::ExprSimplifier::VisitIteratedLogical(
+    IteratedLogicalExpr e) {
+  Problem::IteratedLogicalExprBuilder b =
+      problem_.BeginIteratedLogical(e.kind(), e.num_args());
+  for (IteratedLogicalExpr::iterator
+       i = e.begin(), end = e.end(); i != end; ++i) {
+    b.AddArg(Visit(*i));
+  }
+  return problem_.EndIteratedLogical(b);
+}
+
+mp::LogicalExpr mp::internal::ExprSimplifier::VisitAllDiff(PairwiseExpr e) {
+  Problem::PairwiseExprBuilder b =
+      problem_.BeginPairwise(e.kind(), e.num_args());
+  for (PairwiseExpr::iterator i = e.begin(), end = e.end(); i != end; ++i)
+    b.AddArg(Visit(*i));
+  return problem_.EndPairwise(b);
+}
+
+void mp::Simplify(Problem &p) {
+  internal::ExprSimplifier s(p);
+  internal::ExprSimplifier::Terms terms;
+  for (int i = 0, n = p.num_common_exprs(); i < n; ++i) {
+    Problem::MutCommonExpr ce = p.common_expr(i);
+    if (NumericExpr e = ce.nonlinear_expr()) {
+      e = Hoist(s, ce.linear_expr(), e, terms);
+      ce.set_nonlinear_expr(s.AddConstant(e, terms.constant));
+    }
+  }
+  for (int i = 0, n = p.num_objs(); i < n; ++i) {
+    Problem::MutObjective obj = p.obj(i);
+    if (NumericExpr e = obj.nonlinear_expr()) {
+      e = Hoist(s, obj.linear_expr(), e, terms);
+      obj.set_nonlinear_expr(s.AddConstant(e, terms.constant));
+    }
+  }
+  for (int i = 0, n = p.num_algebraic_cons(); i < n; ++i) {
+    Problem::MutAlgebraicCon con = p.algebraic_con(i);
+    if (NumericExpr e = con.nonlinear_expr()) {
+      con.set_nonlinear_expr(Hoist(s, con.linear_expr(), e, terms));
+      con.set_lb(con.lb() - terms.constant);
+      con.set_ub(con.ub() - terms.constant);
+    }
+  }
+}
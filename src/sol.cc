@@ -40,3 +40,20 @@ void mp::internal::WriteMessage(fmt::BufferedFile &file, const char *message) {
   }
   std::fputc('\n', file.get());
 }
+
+void mp::internal::WriteMessage(fmt::Writer &w, const char *message) {
+  for (const char *line_start = message;;) {
+    const char *line_end = line_start;
+    while (*line_end && *line_end != '\n')
+      ++line_end;
+    if (line_end == line_start + 1)
+      w << ' ';
+    else if (line_end != line_start)  // StringRef treats size 0 as unknown.
+      w << fmt::StringRef(line_start, line_end - line_start);
+    w << '\n';
+    if (!*line_end)
+      break;
+    line_start = line_end + 1;
+  }
+  w << '\n';
+}
@@ -23,11 +23,17 @@
 #define MP_EXPORT
 #include "solver-c.h"
 
+#include "mp/nl.h"
 #include "mp/solver.h"
+#include "nl-generator.h"
 
+#include <algorithm>
 #include <cstring>
 #include <exception>
+#include <limits>
 #include <memory>
+#include <string>
+#include <vector>
 
 extern "C" {
 
@@ -51,6 +57,77 @@ struct MP_Solver {
     last_error.flags = 0;
   }
 };
+
+// A problem loaded from memory and its solution.
+struct MP_Problem : mp::SolutionHandler, mp::SuffixValueHandler {
+  std::string nl;
+  int num_items[mp::suf::PROBLEM + 1];
+
+  bool solved;
+  int status;
+  double obj_value;
+  std::string message;
+  std::vector<double> values;
+  std::vector<double> dual_values;
+
+  struct Suffix {
+    int kind;
+    std::string name;
+    std::vector<double> values;
+  };
+  std::vector<Suffix> suffixes;
+
+  MP_Problem(int num_vars, int num_cons, int num_objs)
+    : solved(false), status(mp::sol::UNKNOWN), obj_value(0) {
+    num_items[mp::suf::VAR] = num_vars;
+    num_items[mp::suf::CON] = num_cons;
+    num_items[mp::suf::OBJ] = num_objs;
+    num_items[mp::suf::PROBLEM] = 1;
+  }
+
+  void Reset() {
+    solved = false;
+    status = mp::sol::UNKNOWN;
+    obj_value = 0;
+    message.clear();
+    values.clear();
+    dual_values.clear();
+    suffixes.clear();
+  }
+
+  void HandleFeasibleSolution(
+      fmt::StringRef, const double *, const double *, double) {}
+
+  void HandleSolution(int status, fmt::StringRef message,
+                      const double *values, const double *dual_values,
+                      double obj_value) {
+    this->status = status;
+    this->message = message.c_str();
+    this->obj_value = obj_value;
+    if (values)
+      this->values.assign(values, values + num_items[mp::suf::VAR]);
+    if (dual_values) {
+      this->dual_values.assign(
+            dual_values, dual_values + num_items[mp::suf::CON]);
+    }
+  }
+
+  void HandleSuffixValue(int kind, fmt::StringRef name,
+                         int index, double value) {
+    kind &= mp::suf::MASK;
+    if (suffixes.empty() || suffixes.back().kind != kind ||
+        suffixes.back().name != name.c_str()) {
+      Suffix suffix;
+      suffix.kind = kind;
+      suffix.name = name.c_str();
+      suffixes.push_back(suffix);
+      suffixes.back().values.resize(num_items[kind]);
+    }
+    std::vector<double> &suffix_values = suffixes.back().values;
+    if (index >= 0 && static_cast<std::size_t>(index) < suffix_values.size())
+      suffix_values[index] = value;
+  }
+};
 }  // extern "C"
 
 namespace {
@@ -89,6 +166,267 @@ void SetError(MP_Error **e, const char *message) FMT_NOEXCEPT(true) {
 inline void SetError(MP_Solver *s, const char *message) FMT_NOEXCEPT(true) {
   SetErrorMessage(s->last_error, message);
 }
+
+// A linear term.
+struct Term {
+  int var;
+  double coef;
+
+  bool operator<(const Term &other) const { return var < other.var; }
+};
+
+// Rows of a sparse matrix with terms sorted by variable.
+struct SparseRows {
+  std::vector<int> starts;
+  std::vector<Term> terms;
+
+  int num_terms(int row) const { return starts[row + 1] - starts[row]; }
+};
+
+// Checks that starts are nondecreasing and returns the number of elements.
+int CheckStarts(const int *starts, int size, const char *name) {
+  if (starts[0] != 0)
+    throw mp::Error("{}[0] is not zero", name);
+  for (int i = 0; i < size; ++i) {
+    if (starts[i + 1] < starts[i])
+      throw mp::Error("{} is not nondecreasing", name);
+  }
+  return starts[size];
+}
+
+int CheckIndex(int index, int size, const char *name) {
+  if (index < 0 || index >= size)
+    throw mp::Error("{} {} out of bounds", name, index);
+  return index;
+}
+
+// Checks that the arrays of indices and values are given if there are
+// terms.
+void CheckTerms(int num_terms, const int *indices, const double *values,
+                const char *starts_name) {
+  if (num_terms != 0 && (!indices || !values))
+    throw mp::Error("null indices or values with nonempty {}", starts_name);
+}
+
+// Converts a matrix in the compressed sparse row format to SparseRows.
+void ConvertCSR(int num_rows, int num_vars, const int *starts,
+                const int *indices, const double *values, SparseRows &rows,
+                const char *name) {
+  rows.starts.assign(num_rows + 1, 0);
+  if (!starts)
+    return;
+  int num_terms = CheckStarts(starts, num_rows, name);
+  CheckTerms(num_terms, indices, values, name);
+  rows.terms.resize(num_terms);
+  for (int i = 0; i < num_terms; ++i) {
+    Term &t = rows.terms[i];
+    t.var = CheckIndex(indices[i], num_vars, "variable index");
+    t.coef = values[i];
+  }
+  for (int i = 0; i < num_rows; ++i) {
+    rows.starts[i + 1] = starts[i + 1];
+    std::sort(rows.terms.begin() + starts[i],
+              rows.terms.begin() + starts[i + 1]);
+  }
+}
+
+// Converts a matrix in the compressed sparse column format to SparseRows.
+void ConvertCSC(int num_rows, int num_vars, const int *starts,
+                const int *indices, const double *values, SparseRows &rows,
+                const char *name) {
+  rows.starts.assign(num_rows + 1, 0);
+  if (!starts)
+    return;
+  int num_terms = CheckStarts(starts, num_vars, name);
+  CheckTerms(num_terms, indices, values, name);
+  for (int i = 0; i < num_terms; ++i)
+    ++rows.starts[CheckIndex(indices[i], num_rows, "constraint index") + 1];
+  for (int i = 0; i < num_rows; ++i)
+    rows.starts[i + 1] += rows.starts[i];
+  // Columns are traversed in increasing order so terms in each row are
+  // sorted by variable.
+  std::vector<int> next(rows.starts.begin(), rows.starts.end() - 1);
+  rows.terms.resize(num_terms);
+  for (int j = 0; j < num_vars; ++j) {
+    for (int k = starts[j]; k < starts[j + 1]; ++k) {
+      Term &t = rows.terms[next[indices[k]]++];
+      t.var = j;
+      t.coef = values[k];
+    }
+  }
+}
+
+// Checks that rows don't contain duplicate variables.
+void CheckDuplicates(const SparseRows &rows, const char *name) {
+  for (std::size_t i = 0, n = rows.starts.size() - 1; i < n; ++i) {
+    for (int k = rows.starts[i] + 1; k < rows.starts[i + 1]; ++k) {
+      if (rows.terms[k].var == rows.terms[k - 1].var) {
+        throw mp::Error("duplicate variable {} in {} {}",
+                        rows.terms[k].var, name, i);
+      }
+    }
+  }
+}
+
+// Bound types of r and b segments.
+enum BoundType { RANGE, UPPER, LOWER, FREE, CONSTANT };
+
+BoundType GetBoundType(const double *lb, const double *ub, int index) {
+  double inf = std::numeric_limits<double>::infinity();
+  bool has_lb = lb && lb[index] > -inf, has_ub = ub && ub[index] < inf;
+  if (!has_lb)
+    return has_ub ? UPPER : FREE;
+  if (!has_ub)
+    return LOWER;
+  return lb[index] == ub[index] ? CONSTANT : RANGE;
+}
+
+void WriteBounds(mp::NLWriter &w, char segment, int size,
+                 const double *lb, const double *ub) {
+  w.WriteSegment(segment);
+  for (int i = 0; i < size; ++i) {
+    BoundType type = GetBoundType(lb, ub, i);
+    switch (type) {
+    case RANGE:
+      w.WriteBound(type, lb[i], ub[i]);
+      break;
+    case UPPER:
+      w.WriteBound(type, ub[i]);
+      break;
+    case LOWER: case CONSTANT:
+      w.WriteBound(type, lb[i]);
+      break;
+    case FREE:
+      w.WriteBound(type);
+      break;
+    }
+  }
+}
+
+void WriteLinearParts(mp::NLWriter &w, char segment, const SparseRows &rows) {
+  for (std::size_t i = 0, n = rows.starts.size() - 1; i < n; ++i) {
+    int num_terms = rows.num_terms(static_cast<int>(i));
+    if (num_terms == 0)
+      continue;
+    w.WriteSegment(segment, static_cast<int>(i), num_terms);
+    for (int k = rows.starts[i], end = rows.starts[i + 1]; k < end; ++k)
+      w.WritePair(rows.terms[k].var, rows.terms[k].coef);
+  }
+}
+
+void WriteInitialValues(mp::NLWriter &w, char segment,
+                        int size, const double *values) {
+  if (!values || size == 0)
+    return;
+  w.WriteSegment(segment, size);
+  for (int i = 0; i < size; ++i)
+    w.WritePair(i, values[i]);
+}
+
+// Converts problem data into a binary .nl image.
+std::string WriteNL(const MP_ProblemData &d) {
+  if (d.num_vars <= 0)
+    throw mp::Error("invalid number of variables {}", d.num_vars);
+  if (d.num_cons < 0)
+    throw mp::Error("invalid number of constraints {}", d.num_cons);
+  if (d.num_objs < 0)
+    throw mp::Error("invalid number of objectives {}", d.num_objs);
+  if (d.num_nl_cons < 0 || d.num_nl_cons > d.num_cons)
+    throw mp::Error("invalid number of nonlinear constraints {}",
+                    d.num_nl_cons);
+  if (d.num_nl_objs < 0 || d.num_nl_objs > d.num_objs)
+    throw mp::Error("invalid number of nonlinear objectives {}",
+                    d.num_nl_objs);
+  if (d.nl_exprs_size < 0 || (d.nl_exprs_size != 0 && !d.nl_exprs))
+    throw mp::Error("invalid nonlinear expressions");
+  if (d.matrix_format != MP_CSR && d.matrix_format != MP_CSC)
+    throw mp::Error("invalid matrix format {}", d.matrix_format);
+
+  SparseRows cons, objs;
+  if (d.matrix_format == MP_CSR) {
+    ConvertCSR(d.num_cons, d.num_vars, d.matrix_starts, d.matrix_indices,
+               d.matrix_values, cons, "matrix_starts");
+  } else {
+    ConvertCSC(d.num_cons, d.num_vars, d.matrix_starts, d.matrix_indices,
+               d.matrix_values, cons, "matrix_starts");
+  }
+  CheckDuplicates(cons, "constraint");
+  ConvertCSR(d.num_objs, d.num_vars, d.obj_starts, d.obj_indices,
+             d.obj_values, objs, "obj_starts");
+  CheckDuplicates(objs, "objective");
+
+  mp::NLHeader h;
+  h.format = mp::NLHeader::BINARY;
+  h.arith_kind = mp::arith::GetKind();
+  h.flags = 1;  // Want output suffixes.
+  h.num_vars = d.num_vars;
+  h.num_algebraic_cons = d.num_cons;
+  h.num_objs = d.num_objs;
+  h.num_logical_cons = d.num_logical_cons;
+  h.num_nl_cons = d.num_nl_cons;
+  h.num_nl_objs = d.num_nl_objs;
+  h.num_nl_vars_in_cons = d.num_nl_vars_in_cons;
+  h.num_nl_vars_in_objs = d.num_nl_vars_in_objs;
+  h.num_nl_vars_in_both = d.num_nl_vars_in_both;
+  h.num_funcs = d.num_funcs;
+  h.num_linear_binary_vars = d.num_linear_binary_vars;
+  h.num_linear_integer_vars = d.num_linear_integer_vars;
+  h.num_nl_integer_vars_in_both = d.num_nl_integer_vars_in_both;
+  h.num_nl_integer_vars_in_cons = d.num_nl_integer_vars_in_cons;
+  h.num_nl_integer_vars_in_objs = d.num_nl_integer_vars_in_objs;
+  h.num_common_exprs_in_both = d.num_common_exprs_in_both;
+  h.num_common_exprs_in_cons = d.num_common_exprs_in_cons;
+  h.num_common_exprs_in_objs = d.num_common_exprs_in_objs;
+  h.num_common_exprs_in_single_cons = d.num_common_exprs_in_single_cons;
+  h.num_common_exprs_in_single_objs = d.num_common_exprs_in_single_objs;
+  h.num_con_nonzeros = cons.terms.size();
+  h.num_obj_nonzeros = objs.terms.size();
+  h.num_eqns = 0;
+  for (int i = 0; i < d.num_cons; ++i) {
+    BoundType type = GetBoundType(d.con_lb, d.con_ub, i);
+    if (type == RANGE)
+      ++h.num_ranges;
+    else if (type == CONSTANT)
+      ++h.num_eqns;
+  }
+
+  mp::NLWriter w(true);
+  w.WriteHeader(h);
+  // StringRef treats size 0 as unknown, so skip an empty buffer.
+  if (d.nl_exprs_size != 0)
+    w.buffer() << fmt::StringRef(d.nl_exprs, d.nl_exprs_size);
+  for (int i = d.num_nl_cons; i < d.num_cons; ++i) {
+    w.WriteSegment('C', i);
+    w.WriteConstant(0);
+  }
+  for (int i = d.num_nl_objs; i < d.num_objs; ++i) {
+    int sense = d.obj_sense ? d.obj_sense[i] : MP_MINIMIZE;
+    if (sense != MP_MINIMIZE && sense != MP_MAXIMIZE)
+      throw mp::Error("invalid sense of objective {}", i);
+    w.WriteSegment('O', i, sense);
+    w.WriteConstant(0);
+  }
+  if (d.num_cons != 0)
+    WriteBounds(w, 'r', d.num_cons, d.con_lb, d.con_ub);
+  WriteBounds(w, 'b', d.num_vars, d.var_lb, d.var_ub);
+  if (d.num_cons != 0) {
+    // Write cumulative column sizes.
+    std::vector<int> col_sizes(d.num_vars);
+    for (std::size_t i = 0, n = cons.terms.size(); i < n; ++i)
+      ++col_sizes[cons.terms[i].var];
+    w.WriteSegment('k', d.num_vars - 1);
+    int total = 0;
+    for (int j = 0; j < d.num_vars - 1; ++j) {
+      total += col_sizes[j];
+      w.WriteUInt(total);
+    }
+  }
+  WriteLinearParts(w, 'J', cons);
+  WriteLinearParts(w, 'G', objs);
+  WriteInitialValues(w, 'x', d.num_vars, d.initial_values);
+  WriteInitialValues(w, 'd', d.num_cons, d.initial_dual_values);
+  return w.buffer().str();
+}
 }
 
 extern "C" {
@@ -197,4 +535,90 @@ MP_API int MP_SetStrOption(
   }
   return -1;
 }
+
+MP_Problem *MP_LoadProblem(MP_Solver *s, const MP_ProblemData *data) {
+  try {
+    if (!data)
+      throw mp::Error("null problem data");
+    std::string nl = WriteNL(*data);
+    MP_Problem *p =
+        new MP_Problem(data->num_vars, data->num_cons, data->num_objs);
+    p->nl.swap(nl);
+    return p;
+  } catch (const std::exception &e) {
+    SetError(s, e.what());
+  } catch (...) {
+    SetError(s, "unknown error");
+  }
+  return 0;
+}
+
+void MP_DestroyProblem(MP_Problem *p) {
+  delete p;  // Doesn't throw.
+}
+
+int MP_Solve(MP_Solver *s, MP_Problem *p) {
+  try {
+    p->Reset();
+    s->solver->SolveNL(p->nl, *p, p);
+    p->solved = true;
+    return 0;
+  } catch (const std::exception &e) {
+    SetError(s, e.what());
+  } catch (...) {
+    SetError(s, "unknown error");
+  }
+  return -1;
+}
+
+int MP_GetSolution(MP_Solver *s, MP_Problem *p, MP_SolutionInfo *info,
+                   double *values, double *dual_values) {
+  // Doesn't throw.
+  if (!p->solved) {
+    SetError(s, "problem is not solved");
+    return -1;
+  }
+  if (info) {
+    info->status = p->status;
+    info->obj_value = p->obj_value;
+    info->message = p->message.c_str();
+    info->has_values = !p->values.empty();
+    info->has_dual_values = !p->dual_values.empty();
+  }
+  if (values && !p->values.empty())
+    std::copy(p->values.begin(), p->values.end(), values);
+  if (dual_values && !p->dual_values.empty())
+    std::copy(p->dual_values.begin(), p->dual_values.end(), dual_values);
+  return 0;
+}
+
+int MP_GetSuffix(MP_Solver *s, MP_Problem *p, int kind,
+                 const char *name, double *values, int size) {
+  // Doesn't throw.
+  if (!p->solved) {
+    SetError(s, "problem is not solved");
+    return -1;
+  }
+  if (kind < MP_SUF_VAR || kind > MP_SUF_PROBLEM || !name) {
+    SetError(s, "invalid suffix");
+    return -1;
+  }
+  if (size < 0) {
+    SetError(s, "invalid size");
+    return -1;
+  }
+  for (std::size_t i = 0, n = p->suffixes.size(); i < n; ++i) {
+    const MP_Problem::Suffix &suffix = p->suffixes[i];
+    if (suffix.kind != kind || suffix.name != name)
+      continue;
+    int num_values = static_cast<int>(suffix.values.size());
+    if (values) {
+      std::copy(suffix.values.begin(),
+                suffix.values.begin() + std::min(num_values, size), values);
+    }
+    return num_values;
+  }
+  SetError(s, "suffix not found");
+  return -1;
+}
 }  // extern "C"
@@ -172,6 +172,196 @@ MP_API int MP_GetOptionValues(MP_Solver *s,
  */
 MP_API int MP_SetStrOption(MP_Solver *s, const char *option, const char *value);
 
+/**
+ * A problem loaded from memory.
+ */
+typedef struct MP_Problem MP_Problem;
+
+/**
+ * Sparse matrix formats.
+ */
+enum {
+  MP_CSR = 0,  /**< Compressed sparse rows. */
+  MP_CSC = 1   /**< Compressed sparse columns. */
+};
+
+/**
+ * Objective senses.
+ */
+enum {
+  MP_MINIMIZE = 0,
+  MP_MAXIMIZE = 1
+};
+
+/**
+ * Suffix kinds.
+ */
+enum {
+  MP_SUF_VAR     = 0,  /**< Applies to variables. */
+  MP_SUF_CON     = 1,  /**< Applies to algebraic constraints. */
+  MP_SUF_OBJ     = 2,  /**< Applies to objectives. */
+  MP_SUF_PROBLEM = 3   /**< Applies to the problem. */
+};
+
+/**
+ * Problem data passed to MP_LoadProblem.
+ *
+ * Variables, constraints and objectives are ordered as in an .nl file:
+ * nonlinear variables, constraints and objectives precede linear ones and
+ * integer variables follow continuous ones within each group of variables.
+ * Variable types are specified by the numbers of integer variables in
+ * these groups. As in an .nl file, the linear part of a nonlinear
+ * constraint or objective should list all variables it depends on
+ * including those with zero coefficients.
+ *
+ * Fields that are not used should be zero, so initialize the structure
+ * with memset or {0} before filling it in. Infinite bounds are represented
+ * by -HUGE_VAL and HUGE_VAL; null bound arrays mean no bounds.
+ */
+typedef struct MP_ProblemData {
+  int num_vars;          /**< Number of variables. */
+  int num_cons;          /**< Number of algebraic constraints. */
+  int num_objs;          /**< Number of objectives. */
+  int num_logical_cons;  /**< Number of logical constraints. */
+
+  /* Nonlinear problem information as in the .nl header. */
+  int num_nl_cons;
+  int num_nl_objs;
+  int num_nl_vars_in_cons;
+  int num_nl_vars_in_objs;
+  int num_nl_vars_in_both;
+  int num_funcs;
+  int num_common_exprs_in_both;
+  int num_common_exprs_in_cons;
+  int num_common_exprs_in_objs;
+  int num_common_exprs_in_single_cons;
+  int num_common_exprs_in_single_objs;
+
+  /* Numbers of integer variables in groups of variables. */
+  int num_linear_binary_vars;
+  int num_linear_integer_vars;
+  int num_nl_integer_vars_in_both;
+  int num_nl_integer_vars_in_cons;
+  int num_nl_integer_vars_in_objs;
+
+  const double *var_lb;  /**< Variable lower bounds, num_vars values. */
+  const double *var_ub;  /**< Variable upper bounds, num_vars values. */
+  const double *con_lb;  /**< Constraint lower bounds, num_cons values. */
+  const double *con_ub;  /**< Constraint upper bounds, num_cons values. */
+
+  /**
+   * Linear parts of constraints in the format given by matrix_format.
+   * With MP_CSR, matrix_starts has num_cons + 1 elements and
+   * matrix_indices are variable indices; with MP_CSC, matrix_starts
+   * has num_vars + 1 elements and matrix_indices are constraint indices.
+   */
+  int matrix_format;
+  const int *matrix_starts;
+  const int *matrix_indices;
+  const double *matrix_values;
+
+  /**
+   * Linear parts of objectives by rows: objective i has terms
+   * obj_starts[i] .. obj_starts[i + 1] - 1. obj_starts has num_objs + 1
+   * elements. It can be null if all linear parts are empty.
+   */
+  const int *obj_starts;
+  const int *obj_indices;
+  const double *obj_values;
+
+  /**
+   * Senses (MP_MINIMIZE or MP_MAXIMIZE) of linear objectives, i.e. those
+   * with indices greater than or equal to num_nl_objs. Null means that
+   * all linear objectives are minimized.
+   */
+  const int *obj_sense;
+
+  const double *initial_values;       /**< Primal guess or null. */
+  const double *initial_dual_values;  /**< Dual guess or null. */
+
+  /**
+   * Nonlinear parts of the problem: F, V, C, L and O segments exactly
+   * as in a binary .nl file with the native byte order. There should be
+   * a C segment for each nonlinear constraint and an O segment giving
+   * the sense of each nonlinear objective.
+   */
+  const char *nl_exprs;
+  int nl_exprs_size;
+} MP_ProblemData;
+
+/**
+ * Loads a problem from memory. Returns a problem object or a null pointer
+ * in case of an error. The data is copied, so the arrays can be freed
+ * once the function returns. The returned object should be destroyed
+ * with MP_DestroyProblem once it is no longer needed.
+ *
+ * s: The solver object in the context of which the problem is loaded.
+ * data: The problem data.
+ */
+MP_API MP_Problem *MP_LoadProblem(MP_Solver *s, const MP_ProblemData *data);
+
+/**
+ * Destroys the problem object and deallocates memory where it was stored.
+ *
+ * p: The problem object to destroy.
+ */
+MP_API void MP_DestroyProblem(MP_Problem *p);
+
+/**
+ * Solves the problem with the current solver options. Returns 0 if
+ * succeeded, -1 otherwise. A problem can be solved several times,
+ * for example, with different options.
+ *
+ * s: The solver object.
+ * p: The problem to solve.
+ */
+MP_API int MP_Solve(MP_Solver *s, MP_Problem *p);
+
+/**
+ * Information about a solution.
+ */
+typedef struct MP_SolutionInfo {
+  int status;           /**< Solve status code, e.g. 0 for solved. */
+  double obj_value;     /**< Objective value. */
+  const char *message;  /**< Solver message. */
+  int has_values;       /**< Nonzero if primal values are available. */
+  int has_dual_values;  /**< Nonzero if dual values are available. */
+} MP_SolutionInfo;
+
+/**
+ * Retrieves the solution of the last MP_Solve call on the problem.
+ * Returns 0 if succeeded, -1 otherwise. The message pointer is valid
+ * until the problem is solved again or destroyed.
+ *
+ * s: The solver object.
+ * p: The solved problem.
+ * info: A pointer to an object where to store the solution information,
+ *       can be null.
+ * values: An array of num_vars elements where to store primal values,
+ *         can be null. Left unchanged if values are not available.
+ * dual_values: An array of num_cons elements where to store dual values,
+ *              can be null. Left unchanged if values are not available.
+ */
+MP_API int MP_GetSolution(MP_Solver *s, MP_Problem *p, MP_SolutionInfo *info,
+                          double *values, double *dual_values);
+
+/**
+ * Retrieves values of a suffix after solving. Returns the number of
+ * items the suffix applies to, which is 0 for an objective suffix of
+ * a problem without objectives, or -1 in case of an error including
+ * the case when the solver hasn't reported values of the suffix.
+ *
+ * s: The solver object.
+ * p: The solved problem.
+ * kind: The suffix kind, one of MP_SUF_*.
+ * name: The suffix name.
+ * values: An array of the specified size where to store the values,
+ *         can be null. Items without values get zero values.
+ * size: The size of the values array.
+ */
+MP_API int MP_GetSuffix(MP_Solver *s, MP_Problem *p, int kind,
+                        const char *name, double *values, int size);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -33,7 +33,12 @@
 #include <stack>
 
 #ifndef _WIN32
+# include <dirent.h>
+# include <errno.h>
 # include <strings.h>
+# include <sys/socket.h>
+# include <sys/stat.h>
+# include <sys/un.h>
 # include <unistd.h>
 # define MP_WRITE write
 #else
@@ -48,8 +53,22 @@
 #include "mp/clock.h"
 #include "mp/rstparser.h"
 
+#ifndef MSG_NOSIGNAL
+# define MSG_NOSIGNAL 0
+#endif
+
 namespace {
 
+#ifndef _WIN32
+void MakeSocketAddress(const std::string &path, sockaddr_un &addr) {
+  addr = sockaddr_un();
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    throw mp::Error("socket path is too long: {}", path);
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+}
+#endif
+
 const char *SkipSpaces(const char *s) {
   while (*s && isspace(*s))
     ++s;
@@ -236,7 +255,7 @@ std::string OptionHelper<std::string>::Parse(const char *&s) {
 }
 
 SolverAppOptionParser::SolverAppOptionParser(Solver &s)
-  : solver_(s), echo_solver_options_(true) {
+  : solver_(s), echo_solver_options_(true), num_workers_(0) {
   // Add standard command-line options.
   OptionList::Builder<SolverAppOptionParser> app_options(options_, *this);
   app_options.Add<&SolverAppOptionParser::ShowUsage>(
@@ -258,6 +277,12 @@ SolverAppOptionParser::SolverAppOptionParser(Solver &s)
 bool SolverAppOptionParser::ShowUsage() {
   solver_.Print("usage: {} [options] stub [-AMPL] [<assignment> ...]\n",
                 solver_.name());
+#ifndef _WIN32
+  solver_.Print("       {} -server <socket> [-workers <n>] [options] "
+                "[<assignment> ...]\n", solver_.name());
+#endif
+  solver_.Print("       {} -batch <file|dir> [-workers <n>] [options] "
+                "[<assignment> ...]\n", solver_.name());
   solver_.Print("\nOptions:\n");
   for (OptionList::iterator
        i = options_.begin(), end = options_.end(); i != end; ++i) {
@@ -285,10 +310,49 @@ bool SolverAppOptionParser::ShowSolverOptions() {
   return false;
 }
 
+bool SolverAppOptionParser::ParseArgOption(char **&argv) {
+  const char *arg = *argv;
+  if (!arg)
+    return false;
+  std::string *path = 0;
+  if (std::strcmp(arg, "-server") == 0)
+    path = &server_path_;
+  else if (std::strcmp(arg, "-batch") == 0)
+    path = &batch_path_;
+  else if (std::strcmp(arg, "-workers") != 0)
+    return false;
+  const char *value = argv[1];
+  if (!value)
+    throw OptionError(fmt::format("option '{}' requires an argument", arg));
+  argv += 2;
+  if (path) {
+#ifdef _WIN32
+    if (path == &server_path_)
+      throw OptionError("server mode is not supported on this platform");
+#endif
+    *path = value;
+    if (server() && batch())
+      throw OptionError("options '-server' and '-batch' are incompatible");
+    return true;
+  }
+  char *end = 0;
+  long num_workers = std::strtol(value, &end, 10);
+  if (*end || num_workers < 1 || num_workers > 1024)
+    throw OptionError(fmt::format("invalid number of workers '{}'", value));
+  num_workers_ = static_cast<int>(num_workers);
+  return true;
+}
+
 const char *SolverAppOptionParser::Parse(char **&argv) {
   ++argv;
+  while (ParseArgOption(argv))
+    ;
   char opt = ParseOptions(argv, options_);
   if (opt && opt != '-') return 0;
+  if (server())
+    return server_path_.c_str();
+  if (batch())
+    return batch_path_.c_str();
   const char *stub = *argv;
   if (!stub) {
     ShowUsage();
@@ -444,6 +508,58 @@ fmt::StringRef NameProvider::name(std::size_t index) {
   return fmt::StringRef(writer_.c_str(), writer_.size());
 }
 
+void GetBatchStubs(fmt::StringRef path, std::vector<std::string> &stubs) {
+  std::string dir(path.c_str(), path.size());
+  std::size_t num_listed = stubs.size();
+#ifndef _WIN32
+  struct stat st;
+  if (::stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    DIR *d = ::opendir(dir.c_str());
+    if (!d)
+      throw fmt::SystemError(errno, "cannot open directory {}", dir);
+    while (dirent *entry = ::readdir(d)) {
+      std::string name = entry->d_name;
+      if (name.size() > 3 && name.compare(name.size() - 3, 3, ".nl") == 0)
+        stubs.push_back(dir + '/' + GetStub(name.c_str()));
+    }
+    ::closedir(d);
+    std::sort(stubs.begin() + num_listed, stubs.end());
+    return;
+  }
+#else
+  DWORD attrs = GetFileAttributesA(dir.c_str());
+  if (attrs != INVALID_FILE_ATTRIBUTES &&
+      (attrs & FILE_ATTRIBUTE_DIRECTORY) != 0) {
+    WIN32_FIND_DATAA data;
+    HANDLE h = FindFirstFileA((dir + "\\*.nl").c_str(), &data);
+    if (h != INVALID_HANDLE_VALUE) {
+      do {
+        stubs.push_back(dir + '\\' + GetStub(data.cFileName));
+      } while (FindNextFileA(h, &data));
+      FindClose(h);
+    }
+    std::sort(stubs.begin() + num_listed, stubs.end());
+    return;
+  }
+#endif
+  fmt::BufferedFile file(path, "r");
+  std::string line;
+  for (int c = 0; c != EOF; ) {
+    c = std::getc(file.get());
+    if (c != '\n' && c != EOF) {
+      line += static_cast<char>(c);
+      continue;
+    }
+    std::size_t start = line.find_first_not_of(" \t\r");
+    if (start != std::string::npos && line[start] != '#') {
+      std::size_t end = line.find_last_not_of(" \t\r");
+      line = line.substr(start, end - start + 1);
+      stubs.push_back(GetStub(line.c_str()));
+    }
+    line.clear();
+  }
+}
+
 void PrintSolution(const double *values, int num_values, const char *name_col,
                    const char *value_col, NameProvider &np) {
   if (!values || num_values == 0)
@@ -459,6 +575,192 @@ void PrintSolution(const double *values, int num_values, const char *name_col,
     fmt::printf("%-*s%.17g\n", name_field_width, np.name(i), value ? value : 0);
   }
 }
+
+#ifndef _WIN32
+ServerSocket::ServerSocket(fmt::StringRef path)
+  : fd_(-1), path_(path.c_str(), path.size()), stop_(false) {
+  sockaddr_un addr;
+  MakeSocketAddress(path_, addr);
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd_ < 0)
+    throw fmt::SystemError(errno, "cannot create socket");
+  // Remove a socket left by a previous server, but not other files.
+  struct stat st;
+  if (::stat(path_.c_str(), &st) == 0 && S_ISSOCK(st.st_mode))
+    ::unlink(path_.c_str());
+  if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(fd_, SOMAXCONN) != 0) {
+    int error_code = errno;
+    ::close(fd_);
+    throw fmt::SystemError(error_code, "cannot listen at {}", path_);
+  }
+}
+
+ServerSocket::~ServerSocket() {
+  ::close(fd_);
+  ::unlink(path_.c_str());
+}
+
+int ServerSocket::Accept() {
+  for (;;) {
+    int fd = ::accept(fd_, 0, 0);
+    if (stop_) {
+      if (fd >= 0)
+        ::close(fd);
+      return -1;
+    }
+    if (fd >= 0) {
+#ifdef SO_NOSIGPIPE
+      int on = 1;
+      ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+      return fd;
+    }
+    if (errno != EINTR && errno != ECONNABORTED)
+      throw fmt::SystemError(errno, "cannot accept connection");
+  }
+}
+
+void ServerSocket::Stop() {
+  stop_ = true;
+  // Connect to the socket to wake up Accept.
+  sockaddr_un addr;
+  MakeSocketAddress(path_, addr);
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return;
+  ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+  ::close(fd);
+}
+
+ServerConnection::~ServerConnection() { ::close(fd_); }
+
+bool ServerConnection::Fill() {
+  enum {BUFFER_SIZE = 65536};
+  buffer_.erase(buffer_.begin(), buffer_.begin() + pos_);
+  pos_ = 0;
+  std::size_t size = buffer_.size();
+  buffer_.resize(size + BUFFER_SIZE);
+  ssize_t result = 0;
+  do {
+    result = ::read(fd_, &buffer_[size], BUFFER_SIZE);
+  } while (result < 0 && errno == EINTR);
+  if (result < 0) {
+    buffer_.resize(size);
+    throw fmt::SystemError(errno, "cannot read request");
+  }
+  buffer_.resize(size + result);
+  return result != 0;
+}
+
+bool ServerConnection::ReadRequest(ServerRequest &request) {
+  // Read the request line.
+  std::size_t scanned = 0;
+  std::vector<char>::iterator eol;
+  for (;;) {
+    eol = std::find(buffer_.begin() + pos_ + scanned, buffer_.end(), '\n');
+    if (eol != buffer_.end())
+      break;
+    scanned = buffer_.size() - pos_;
+    if (scanned > MAX_LINE_SIZE)
+      break;
+    if (!Fill()) {
+      if (scanned != 0)
+        throw Error("incomplete request");
+      return false;
+    }
+  }
+  if (eol - (buffer_.begin() + pos_) > MAX_LINE_SIZE)
+    throw Error("request line is too long");
+  std::string line(buffer_.begin() + pos_, eol);
+  pos_ = eol - buffer_.begin() + 1;
+  std::string::size_type space = line.find(' ');
+  std::string command = line.substr(0, space);
+  std::string arg = space != std::string::npos ? line.substr(space + 1) : "";
+  if (command == "quit" && space == std::string::npos) {
+    request.kind = ServerRequest::QUIT;
+    request.data.clear();
+    return true;
+  }
+  if (command == "solve" && !arg.empty()) {
+    request.kind = ServerRequest::SOLVE;
+    request.data = arg;
+    return true;
+  }
+  if (command != "nl" || arg.empty())
+    throw Error("invalid request '{}'", line);
+  char *end = 0;
+  unsigned long size = std::strtoul(arg.c_str(), &end, 10);
+  if (*end || !std::isdigit(static_cast<unsigned char>(arg[0])))
+    throw Error("invalid request '{}'", line);
+  if (size > MAX_NL_SIZE)
+    throw Error("nl request of {} bytes exceeds the limit of {} bytes",
+                arg, static_cast<int>(MAX_NL_SIZE));
+  while (buffer_.size() - pos_ < size) {
+    if (!Fill())
+      throw Error("incomplete request");
+  }
+  request.kind = ServerRequest::NL;
+  request.data.assign(&buffer_[pos_], size);
+  pos_ += size;
+  return true;
+}
+
+void ServerConnection::Write(fmt::StringRef data) {
+  const char *ptr = data.c_str();
+  std::size_t size = data.size();
+  while (size != 0) {
+    ssize_t result = ::send(fd_, ptr, size, MSG_NOSIGNAL);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      throw fmt::SystemError(errno, "cannot write reply");
+    }
+    ptr += result;
+    size -= result;
+  }
+}
+
+void ServerConnection::WriteError(fmt::StringRef message) {
+  std::string line(message.c_str(), message.size());
+  std::replace(line.begin(), line.end(), '\n', ' ');
+  Write(fmt::format("error {}\n", line));
+}
+
+# ifdef MP_USE_THREAD
+ConnectionQueue::~ConnectionQueue() {
+  for (std::size_t i = 0, n = fds_.size(); i < n; ++i)
+    ::close(fds_[i]);
+}
+
+void ConnectionQueue::Push(int fd) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fds_.push_back(fd);
+  }
+  cond_.notify_one();
+}
+
+int ConnectionQueue::Pop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (fds_.empty() && !closed_)
+    cond_.wait(lock);
+  if (fds_.empty())
+    return -1;
+  int fd = fds_.front();
+  fds_.pop_front();
+  return fd;
+}
+
+void ConnectionQueue::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+  }
+  cond_.notify_all();
+}
+# endif
+#endif
 }  // namespace internal
 
 bool Solver::OptionNameLess::operator()(
@@ -470,8 +772,9 @@ Solver::Solver(
     fmt::StringRef name, fmt::StringRef long_name, long date, int flags)
 : name_(name), long_name_(long_name.c_str() ? long_name : name), date_(date),
   wantsol_(0), obj_precision_(-1), objno_(-1), bool_options_(0),
-  count_solutions_(false), read_flags_(0), timing_(false), multiobj_(false),
-  has_errors_(false) {
+  count_solutions_(false), read_flags_(0), timing_(false), pipeline_(false),
+  simplify_(false), presolve_(false), expr_stats_(false), multiobj_(false),
+  thread_safe_((flags & NOT_THREAD_SAFE) == 0), has_errors_(false) {
   version_ = long_name_;
   error_handler_ = this;
   output_handler_ = this;
@@ -532,6 +835,44 @@ Solver::Solver(
   AddOption(OptionPtr(new BoolOption(timing_, "timing",
       "0 or 1 (default 0): Whether to display timings for the run.\n")));
 
+#ifdef MP_USE_THREAD
+  AddOption(OptionPtr(new BoolOption(pipeline_, "pipeline",
+      "0 or 1 (default 0): Whether to read the .nl file on a separate "
+      "thread overlapping input with problem construction. With "
+      "``timing=1`` input and build times are reported separately.\n")));
+#endif
+
+  AddOption(OptionPtr(new BoolOption(simplify_, "simplify",
+      "0 or 1 (default 0): Whether to simplify nonlinear expressions "
+      "before passing the problem to the solver folding constants, "
+      "flattening nested sums and moving linear terms to the linear "
+      "parts of objectives and constraints. Applies to solvers that "
+      "build the problem as ``mp::Problem``.\n")));
+
+  if ((flags & PRESOLVE) != 0) {
+    AddOption(OptionPtr(new BoolOption(presolve_, "presolve",
+        "0 or 1 (default 0): Whether to presolve the problem before "
+        "passing it to the solver removing fixed variables, turning "
+        "constraints with a single variable into bounds, dropping "
+        "constraints without variables and folding constant "
+        "subexpressions. Problems with complementarity conditions are "
+        "not presolved.\n")));
+  }
+
+  AddOption(OptionPtr(new BoolOption(expr_stats_, "exprstats",
+      "0 or 1 (default 0): Whether to print statistics of expression "
+      "trees: counts and depth histograms by expression kind and numbers "
+      "of arguments of iterated expressions and breakpoints of "
+      "piecewise-linear terms. Solvers that convert expressions also "
+      "report the conversion time by expression kind. With ``statsfile`` "
+      "the statistics are written to the file too.\n")));
+
+  AddStrOption("statsfile",
+      "Name of a file to write timings of the solution phases and reader "
+      "counters to in JSON format. Default = none (statistics are "
+      "not collected).",
+      &Solver::GetStatsFile, &Solver::SetStatsFile);
+
   if ((flags & MULTIPLE_SOL) != 0) {
     AddSuffix("nsol", 0, suf::PROBLEM | suf::OUTPUT | suf::OUTONLY);
 
@@ -681,6 +1022,30 @@ bool Solver::ParseOptions(char **argv, unsigned flags, const ASLProblem *) {
   return !has_errors_;
 }
 
+void Solver::ReportExprStats(const ExprStats &es) {
+  fmt::MemoryWriter w;
+  es.Write(w);
+  Print("{}", w.c_str());
+  if (Stats *s = stats())
+    es.AddTo(*s);
+}
+
+void Solver::SolveNL(fmt::StringRef, SolutionHandler &,
+                     SuffixValueHandler *) {
+  throw Error("{}: solving problems from memory is not supported", name());
+}
+
+void Solver::ReportExprProfile() {
+  if (expr_profile_.empty())
+    return;
+  fmt::MemoryWriter w;
+  w.write("Expression conversion time by kind:\n");
+  expr_profile_.Write(w);
+  Print("{}", w.c_str());
+  if (Stats *s = stats())
+    expr_profile_.AddTo(*s);
+}
+
 Solver::DoubleFormatter Solver::FormatObjValue(double value) {
   if (obj_precision_ < 0) {
     const char *s =  std::getenv("objective_precision");
@@ -0,0 +1,102 @@
+/*
+ Timers and counters.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/stats.h"
+#include "mp/posix.h"
+
+namespace {
+
+template <typename T>
+int Find(const std::vector<T> &items, fmt::StringRef name) {
+  for (std::size_t i = 0, n = items.size(); i < n; ++i) {
+    const std::string &item_name = items[i].name;
+    if (item_name.size() == name.size() &&
+        item_name.compare(0, name.size(), name.c_str(), name.size()) == 0)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+// Writes a string as a JSON string literal.
+void WriteString(fmt::Writer &w, const std::string &s) {
+  w << '"';
+  for (std::size_t i = 0, n = s.size(); i < n; ++i) {
+    char c = s[i];
+    switch (c) {
+    case '"':  w << "\\\""; break;
+    case '\\': w << "\\\\"; break;
+    case '\n': w << "\\n"; break;
+    case '\t': w << "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20)
+        w.write("\\u{:04x}", static_cast<int>(c));
+      else
+        w << c;
+    }
+  }
+  w << '"';
+}
+}
+
+int mp::Stats::GetTimer(fmt::StringRef name) {
+  int index = Find(timers_, name);
+  if (index >= 0)
+    return index;
+  Timer t = {std::string(name.c_str(), name.size()), 0, 0};
+  timers_.push_back(t);
+  return static_cast<int>(timers_.size() - 1);
+}
+
+int mp::Stats::GetCounter(fmt::StringRef name) {
+  int index = Find(counters_, name);
+  if (index >= 0)
+    return index;
+  Counter c = {std::string(name.c_str(), name.size()), 0};
+  counters_.push_back(c);
+  return static_cast<int>(counters_.size() - 1);
+}
+
+void mp::Stats::WriteJSON(fmt::Writer &w) const {
+  w << "{\n  \"timers\": {";
+  for (std::size_t i = 0, n = timers_.size(); i < n; ++i) {
+    const Timer &t = timers_[i];
+    w << (i != 0 ? ",\n    " : "\n    ");
+    WriteString(w, t.name);
+    w.write(": {{\"time\": {:.9f}, \"count\": {}}}", t.time, t.count);
+  }
+  w << (timers_.empty() ? "},\n" : "\n  },\n");
+  w << "  \"counters\": {";
+  for (std::size_t i = 0, n = counters_.size(); i < n; ++i) {
+    const Counter &c = counters_[i];
+    w << (i != 0 ? ",\n    " : "\n    ");
+    WriteString(w, c.name);
+    w << ": " << c.value;
+  }
+  w << (counters_.empty() ? "}\n}\n" : "\n  }\n}\n");
+}
+
+void mp::Stats::WriteJSON(fmt::StringRef filename) const {
+  fmt::MemoryWriter w;
+  WriteJSON(w);
+  fmt::BufferedFile file(filename, "w");
+  std::fwrite(w.data(), 1, w.size(), file.get());
+}
@@ -0,0 +1,50 @@
+/*
+ Helpers for differentiation of expression tapes
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#ifndef MP_TAPE_DIFF_H_
+#define MP_TAPE_DIFF_H_
+
+#include <vector>
+
+#include "mp/tape.h"
+
+namespace mp {
+namespace internal {
+
+// Pushes all operand registers of the instruction.
+void PushArgs(const Tape &t, const Tape::Instruction &instr,
+              std::vector<int> &regs);
+
+// Pushes operand registers of the instruction through which derivatives
+// propagate. Operands with zero derivatives such as conditions of
+// if-then-else expressions and arguments of logical expressions are
+// skipped.
+void PushDiffArgs(const Tape &t, const Tape::Instruction &instr,
+                  std::vector<int> &regs);
+
+// Returns the slope of the segment of a piecewise-linear term containing
+// x. The slope at a breakpoint is that of the segment to the left.
+double GetPLTermSlope(const double *data, int num_breakpoints, double x);
+}  // namespace internal
+}  // namespace mp
+
+#endif  // MP_TAPE_DIFF_H_
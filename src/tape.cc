@@ -0,0 +1,582 @@
+/*
+ Expression tape
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/tape.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mp/expr-visitor.h"
+#include "batch-kernel.h"
+#include "hyperbolic.h"
+
+namespace mp {
+namespace internal {
+
+// Compiles expressions into a tape. During compilation constants are
+// referred to by negative numbers -1 - index and instruction results by
+// num_vars + index; the final numbers are assigned by Tape::EndCompile.
+// Arguments are compiled before their parents without recursion, so
+// long chains of binary expressions don't exhaust the call stack.
+class TapeCompiler : public PostOrderExprVisitor<TapeCompiler, int, int> {
+ private:
+  Tape &tape_;
+
+  // Registers of arguments of iterated expressions being compiled.
+  std::vector<int> stack_;
+
+  template <typename IteratedExpr>
+  int AddIterated(int opcode, IteratedExpr e) {
+    std::size_t stack_size = stack_.size();
+    for (typename IteratedExpr::iterator
+         i = e.begin(), end = e.end(); i != end; ++i) {
+      stack_.push_back(Visit(*i));
+    }
+    int offset = static_cast<int>(tape_.args_.size());
+    tape_.args_.insert(tape_.args_.end(),
+                       stack_.begin() + stack_size, stack_.end());
+    stack_.resize(stack_size);
+    return AddInstruction(opcode, offset, e.num_args());
+  }
+
+ public:
+  explicit TapeCompiler(Tape &t) : tape_(t) {}
+
+  using PostOrderExprVisitor<TapeCompiler, int, int>::Visit;
+
+  int AddInstruction(int opcode, int arg1, int arg2 = 0, int arg3 = 0) {
+    Tape::Instruction instr = {opcode, arg1, arg2, arg3};
+    tape_.instrs_.push_back(instr);
+    return tape_.num_vars_ + static_cast<int>(tape_.instrs_.size()) - 1;
+  }
+
+  int AddConst(double value) {
+    fmt::ULongLong bits = 0;
+    std::memcpy(&bits, &value, sizeof(value));
+    std::map<fmt::ULongLong, int>::iterator i =
+        tape_.const_indices_.lower_bound(bits);
+    if (i == tape_.const_indices_.end() || i->first != bits) {
+      int index = static_cast<int>(tape_.consts_.size());
+      tape_.consts_.push_back(value);
+      i = tape_.const_indices_.insert(i, std::make_pair(bits, index));
+    }
+    return -1 - i->second;
+  }
+
+  int VisitNumericConstant(NumericConstant c) { return AddConst(c.value()); }
+
+  int AddVariable(int index) {
+    if (index < 0 || index >= tape_.num_vars_)
+      throw Error("invalid variable index {}", index);
+    return index;
+  }
+
+  int VisitVariable(Reference v) { return AddVariable(v.index()); }
+
+  int VisitCommonExpr(Reference e) {
+    // Common expressions are compiled in order so an expression can only
+    // refer to the ones preceding it.
+    int index = e.index();
+    if (index < 0 || index >= tape_.num_common_exprs())
+      throw Error("invalid common expression index {}", index);
+    return tape_.common_expr_regs_[index];
+  }
+
+  int VisitUnary(UnaryExpr e) {
+    return AddInstruction(e.kind(), Visit(e.arg()));
+  }
+
+  int VisitBinary(BinaryExpr e) {
+    int lhs = Visit(e.lhs());
+    return AddInstruction(e.kind(), lhs, Visit(e.rhs()));
+  }
+
+  int VisitIf(IfExpr e) {
+    int condition = Visit(e.condition());
+    int true_expr = Visit(e.true_expr());
+    NumericExpr false_expr = e.false_expr();
+    return AddInstruction(expr::IF, condition, true_expr,
+                          false_expr ? Visit(false_expr) : AddConst(0));
+  }
+
+  int VisitPLTerm(PLTerm e) {
+    int arg = Visit(e.arg());
+    int offset = static_cast<int>(tape_.data_.size());
+    int num_breakpoints = e.num_breakpoints();
+    for (int i = 0; i < num_breakpoints; ++i) {
+      tape_.data_.push_back(e.slope(i));
+      tape_.data_.push_back(e.breakpoint(i));
+    }
+    tape_.data_.push_back(e.slope(num_breakpoints));
+    return AddInstruction(expr::PLTERM, arg, offset, num_breakpoints);
+  }
+
+  int VisitVarArg(IteratedExpr e) { return AddIterated(e.kind(), e); }
+  int VisitSum(IteratedExpr e) { return AddIterated(expr::SUM, e); }
+  int VisitNumberOf(IteratedExpr e) { return AddIterated(expr::NUMBEROF, e); }
+  int VisitCount(CountExpr e) { return AddIterated(expr::COUNT, e); }
+
+  int VisitLogicalConstant(LogicalConstant c) { return AddConst(c.value()); }
+
+  int VisitNot(NotExpr e) { return AddInstruction(expr::NOT, Visit(e.arg())); }
+
+  int VisitBinaryLogical(BinaryLogicalExpr e) {
+    int lhs = Visit(e.lhs());
+    return AddInstruction(e.kind(), lhs, Visit(e.rhs()));
+  }
+
+  int VisitRelational(RelationalExpr e) {
+    int lhs = Visit(e.lhs());
+    return AddInstruction(e.kind(), lhs, Visit(e.rhs()));
+  }
+
+  int VisitLogicalCount(LogicalCountExpr e) {
+    int lhs = Visit(e.lhs());
+    return AddInstruction(e.kind(), lhs, Visit(e.rhs()));
+  }
+
+  int VisitImplication(ImplicationExpr e) {
+    int condition = Visit(e.condition());
+    int true_expr = Visit(e.true_expr());
+    LogicalExpr false_expr = e.false_expr();
+    return AddInstruction(expr::IMPLICATION, condition, true_expr,
+                          false_expr ? Visit(false_expr) : AddConst(1));
+  }
+
+  int VisitIteratedLogical(IteratedLogicalExpr e) {
+    return AddIterated(e.kind(), e);
+  }
+
+  int VisitAllDiff(PairwiseExpr e) { return AddIterated(expr::ALLDIFF, e); }
+
+  int VisitNotAllDiff(PairwiseExpr e) {
+    return AddIterated(expr::NOT_ALLDIFF, e);
+  }
+};
+
+}  // namespace internal
+}  // namespace mp
+
+namespace {
+
+// Computes the value of a piecewise-linear term with the slopes and
+// breakpoints in data interleaved as in mp::PLTerm. The term is zero at 0.
+double EvalPLTerm(const double *data, int num_breakpoints, double x) {
+  double result = 0;
+  if (x >= 0) {
+    // Sum the slopes of segments on [0, x].
+    double lb = 0;
+    int i = 0;
+    for (; i < num_breakpoints && data[2 * i + 1] <= 0; ++i) ;
+    for (; i < num_breakpoints; ++i) {
+      double breakpoint = data[2 * i + 1];
+      if (x <= breakpoint)
+        return result + data[2 * i] * (x - lb);
+      result += data[2 * i] * (breakpoint - lb);
+      lb = breakpoint;
+    }
+    return result + data[2 * num_breakpoints] * (x - lb);
+  }
+  // Sum the slopes of segments on [x, 0].
+  double ub = 0;
+  int i = num_breakpoints;
+  for (; i > 0 && data[2 * i - 1] >= 0; --i) ;
+  for (; i > 0; --i) {
+    double breakpoint = data[2 * i - 1];
+    if (x >= breakpoint)
+      return result - data[2 * i] * (ub - x);
+    result -= data[2 * i] * (ub - breakpoint);
+    ub = breakpoint;
+  }
+  return result - data[0] * (ub - x);
+}
+
+// Rounds x to prec decimal places (prec < 0 means rounding to the left of
+// the decimal point) as the ASL round and trunc functions built without
+// dtoa do.
+double Round(double x, int prec) {
+  if (!x)
+    return x;
+  bool flip = x < 0;
+  if (flip)
+    x = -x;
+  if (prec == 0) {
+    x = std::floor(x + 0.5);
+  } else if (prec > 0) {
+    double scale = std::pow(10.0, prec);
+    x = std::floor(x * scale + 0.5) / scale;
+  } else {
+    double scale = std::pow(10.0, -prec);
+    x = scale * std::floor(x / scale + 0.5);
+  }
+  return flip ? -x : x;
+}
+
+// Returns x rounded to prec significant digits.
+double Precision(double x, double prec) {
+  char buffer[64];
+  std::sprintf(buffer, "%.*g", static_cast<int>(prec), x);
+  return std::strtod(buffer, 0);
+}
+
+double Trunc(double x, double prec) {
+  if (!prec)
+    return x >= 0 ? std::floor(x) : std::ceil(x);
+  int p = static_cast<int>(prec);
+  double result = Round(x, p);
+  if (result != x) {
+    double half = 0.5 * std::pow(10.0, -p);
+    result = Round(x > 0 ? x - half : x + half, p);
+  }
+  return result;
+}
+
+// Converts register numbers used during compilation into final ones.
+// Constants are placed after variables, so results of instructions
+// are shifted by the number of constants.
+struct RegisterRemapper {
+  int num_vars, num_consts;
+
+  void operator()(int &reg) const {
+    if (reg < 0)
+      reg = num_vars - 1 - reg;
+    else if (reg >= num_vars)
+      reg += num_consts;
+  }
+};
+
+template <typename Registers>
+inline bool AllDiff(Registers r, const int *args, int num_args) {
+  for (int i = 0; i < num_args; ++i) {
+    double value = r[args[i]];
+    for (int j = i + 1; j < num_args; ++j) {
+      if (r[args[j]] == value)
+        return false;
+    }
+  }
+  return true;
+}
+}
+
+namespace mp {
+namespace internal {
+
+// Computes the result of an instruction. Registers is a pointer to or an
+// object with operator[] returning register values at a single point.
+template <typename Registers>
+inline double Compute(const Tape::Instruction &instr,
+                      const int *args, const double *data, Registers r) {
+  double value = 0;
+  switch (instr.opcode) {
+  case expr::MINUS: value = -r[instr.arg1]; break;
+  case expr::ABS:   value = std::fabs(r[instr.arg1]); break;
+  case expr::FLOOR: value = std::floor(r[instr.arg1]); break;
+  case expr::CEIL:  value = std::ceil(r[instr.arg1]); break;
+  case expr::SQRT:  value = std::sqrt(r[instr.arg1]); break;
+  case expr::POW2:  value = r[instr.arg1] * r[instr.arg1]; break;
+  case expr::EXP:   value = std::exp(r[instr.arg1]); break;
+  case expr::LOG:   value = std::log(r[instr.arg1]); break;
+  case expr::LOG10: value = std::log10(r[instr.arg1]); break;
+  case expr::SIN:   value = std::sin(r[instr.arg1]); break;
+  case expr::SINH:  value = std::sinh(r[instr.arg1]); break;
+  case expr::COS:   value = std::cos(r[instr.arg1]); break;
+  case expr::COSH:  value = std::cosh(r[instr.arg1]); break;
+  case expr::TAN:   value = std::tan(r[instr.arg1]); break;
+  case expr::TANH:  value = std::tanh(r[instr.arg1]); break;
+  case expr::ASIN:  value = std::asin(r[instr.arg1]); break;
+  case expr::ASINH: value = Asinh(r[instr.arg1]); break;
+  case expr::ACOS:  value = std::acos(r[instr.arg1]); break;
+  case expr::ACOSH: value = Acosh(r[instr.arg1]); break;
+  case expr::ATAN:  value = std::atan(r[instr.arg1]); break;
+  case expr::ATANH: value = Atanh(r[instr.arg1]); break;
+  case expr::ADD:   value = r[instr.arg1] + r[instr.arg2]; break;
+  case expr::SUB:   value = r[instr.arg1] - r[instr.arg2]; break;
+  case expr::LESS:
+    value = std::max(r[instr.arg1] - r[instr.arg2], 0.0);
+    break;
+  case expr::MUL:   value = r[instr.arg1] * r[instr.arg2]; break;
+  case expr::DIV:   value = r[instr.arg1] / r[instr.arg2]; break;
+  case expr::INT_DIV:
+    value = r[instr.arg1] / r[instr.arg2];
+    value = value >= 0 ? std::floor(value) : std::ceil(value);
+    break;
+  case expr::MOD:
+    value = std::fmod(r[instr.arg1], r[instr.arg2]);
+    break;
+  case expr::POW: case expr::POW_CONST_BASE: case expr::POW_CONST_EXP:
+    value = std::pow(r[instr.arg1], r[instr.arg2]);
+    break;
+  case expr::ATAN2:
+    value = std::atan2(r[instr.arg1], r[instr.arg2]);
+    break;
+  case expr::PRECISION:
+    value = Precision(r[instr.arg1], r[instr.arg2]);
+    break;
+  case expr::ROUND:
+    value = Round(r[instr.arg1], static_cast<int>(r[instr.arg2]));
+    break;
+  case expr::TRUNC:
+    value = Trunc(r[instr.arg1], r[instr.arg2]);
+    break;
+  case expr::IF: case expr::IMPLICATION:
+    value = r[instr.arg1] != 0 ? r[instr.arg2] : r[instr.arg3];
+    break;
+  case expr::PLTERM:
+    value = EvalPLTerm(data + instr.arg2, instr.arg3, r[instr.arg1]);
+    break;
+  case expr::MIN: {
+    const int *arg = args + instr.arg1, *end = arg + instr.arg2;
+    value = r[*arg];
+    while (++arg != end)
+      value = std::min(value, r[*arg]);
+    break;
+  }
+  case expr::MAX: {
+    const int *arg = args + instr.arg1, *end = arg + instr.arg2;
+    value = r[*arg];
+    while (++arg != end)
+      value = std::max(value, r[*arg]);
+    break;
+  }
+  case expr::SUM:
+    for (const int *arg = args + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg) {
+      value += r[*arg];
+    }
+    break;
+  case expr::NUMBEROF: {
+    const int *arg = args + instr.arg1, *end = arg + instr.arg2;
+    double target = r[*arg];
+    while (++arg != end) {
+      if (r[*arg] == target)
+        ++value;
+    }
+    break;
+  }
+  case expr::COUNT:
+    for (const int *arg = args + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg) {
+      if (r[*arg] != 0)
+        ++value;
+    }
+    break;
+  case Tape::LINEAR: {
+    const double *coef = data + instr.arg3;
+    for (const int *arg = args + instr.arg1,
+         *end = arg + instr.arg2; arg != end; ++arg, ++coef) {
+      value += *coef * r[*arg];
+    }
+    break;
+  }
+  case expr::NOT: value = r[instr.arg1] == 0; break;
+  case expr::OR:  value = r[instr.arg1] != 0 || r[instr.arg2] != 0; break;
+  case expr::AND: value = r[instr.arg1] != 0 && r[instr.arg2] != 0; break;
+  case expr::IFF: value = (r[instr.arg1] != 0) == (r[instr.arg2] != 0); break;
+  case expr::LT: case expr::NOT_ATMOST:
+    value = r[instr.arg1] < r[instr.arg2];
+    break;
+  case expr::LE: case expr::ATLEAST:
+    value = r[instr.arg1] <= r[instr.arg2];
+    break;
+  case expr::EQ: case expr::EXACTLY:
+    value = r[instr.arg1] == r[instr.arg2];
+    break;
+  case expr::GE: case expr::ATMOST:
+    value = r[instr.arg1] >= r[instr.arg2];
+    break;
+  case expr::GT: case expr::NOT_ATLEAST:
+    value = r[instr.arg1] > r[instr.arg2];
+    break;
+  case expr::NE: case expr::NOT_EXACTLY:
+    value = r[instr.arg1] != r[instr.arg2];
+    break;
+  case expr::EXISTS:
+    for (const int *arg = args + instr.arg1,
+         *end = arg + instr.arg2; arg != end && !value; ++arg) {
+      value = r[*arg] != 0;
+    }
+    break;
+  case expr::FORALL:
+    value = 1;
+    for (const int *arg = args + instr.arg1,
+         *end = arg + instr.arg2; arg != end && value; ++arg) {
+      value = r[*arg] != 0;
+    }
+    break;
+  case expr::ALLDIFF:
+    value = AllDiff(r, args + instr.arg1, instr.arg2);
+    break;
+  case expr::NOT_ALLDIFF:
+    value = !AllDiff(r, args + instr.arg1, instr.arg2);
+    break;
+  default:
+    MP_ASSERT(false, "invalid opcode");
+  }
+  return value;
+}
+}  // namespace internal
+}  // namespace mp
+
+int mp::Tape::GetNumRegisterArgs(int opcode) {
+  if (opcode >= expr::FIRST_UNARY && opcode <= expr::LAST_UNARY)
+    return 1;
+  if (opcode >= expr::FIRST_BINARY && opcode <= expr::LAST_BINARY)
+    return 2;
+  switch (opcode) {
+  case expr::NOT: case expr::PLTERM:
+    return 1;
+  case expr::OR: case expr::AND: case expr::IFF:
+  case expr::LT: case expr::LE: case expr::EQ:
+  case expr::GE: case expr::GT: case expr::NE:
+  case expr::ATLEAST: case expr::ATMOST: case expr::EXACTLY:
+  case expr::NOT_ATLEAST: case expr::NOT_ATMOST: case expr::NOT_EXACTLY:
+    return 2;
+  case expr::IF: case expr::IMPLICATION:
+    return 3;
+  }
+  return 0;
+}
+void mp::Tape::BeginCompile(int num_vars) {
+  num_vars_ = num_vars;
+  consts_.clear();
+  instrs_.clear();
+  args_.clear();
+  data_.clear();
+  common_expr_regs_.clear();
+  obj_regs_.clear();
+  con_regs_.clear();
+  const_indices_.clear();
+}
+
+int mp::Tape::Add(const LinearExpr &linear, NumericExpr nonlinear) {
+  internal::TapeCompiler compiler(*this);
+  int result = 0;
+  bool has_result = false;
+  if (int num_terms = linear.num_terms()) {
+    int offset = static_cast<int>(args_.size());
+    int data_offset = static_cast<int>(data_.size());
+    for (LinearExpr::iterator
+         i = linear.begin(), end = linear.end(); i != end; ++i) {
+      args_.push_back(compiler.AddVariable(i->var_index()));
+      data_.push_back(i->coef());
+    }
+    result = compiler.AddInstruction(LINEAR, offset, num_terms, data_offset);
+    has_result = true;
+  }
+  if (nonlinear) {
+    int nonlinear_result = compiler.Visit(nonlinear);
+    result = has_result ?
+          compiler.AddInstruction(expr::ADD, result, nonlinear_result) :
+          nonlinear_result;
+    has_result = true;
+  }
+  return has_result ? result : compiler.AddConst(0);
+}
+
+void mp::Tape::EndCompile() {
+  RegisterRemapper remap = {num_vars_, num_consts()};
+  for (std::vector<Instruction>::iterator
+       i = instrs_.begin(), end = instrs_.end(); i != end; ++i) {
+    switch (GetNumRegisterArgs(i->opcode)) {
+    case 3:
+      remap(i->arg3);
+      // Fall through.
+    case 2:
+      remap(i->arg2);
+      // Fall through.
+    case 1:
+      remap(i->arg1);
+      break;
+    }
+  }
+  std::for_each(args_.begin(), args_.end(), remap);
+  std::for_each(common_expr_regs_.begin(), common_expr_regs_.end(), remap);
+  std::for_each(obj_regs_.begin(), obj_regs_.end(), remap);
+  std::for_each(con_regs_.begin(), con_regs_.end(), remap);
+  std::map<fmt::ULongLong, int>().swap(const_indices_);
+}
+
+void mp::Tape::InitConsts(double *registers) const {
+  std::copy(consts_.begin(), consts_.end(), registers + num_vars_);
+}
+
+void mp::Tape::Evaluate(double *r) const {
+  double *result = r + first_result();
+  const int *args = this->args();
+  const double *data = this->data();
+  for (int i = 0, n = num_instructions(); i < n; ++i)
+    result[i] = internal::Compute(instrs_[i], args, data, r);
+}
+
+void mp::Tape::Evaluate(
+    double *r, const int *instrs, int num_instrs) const {
+  double *result = r + first_result();
+  const int *args = this->args();
+  const double *data = this->data();
+  for (int i = 0; i < num_instrs; ++i) {
+    int index = instrs[i];
+    result[index] = internal::Compute(instrs_[index], args, data, r);
+  }
+}
+
+namespace {
+// Register values at a single point of a batch.
+class StridedRegisters {
+ private:
+  const double *base_;
+  std::size_t stride_;
+
+ public:
+  StridedRegisters(const double *base, std::size_t stride)
+    : base_(base), stride_(stride) {}
+
+  double operator[](int reg) const { return base_[reg * stride_]; }
+};
+}
+
+void mp::internal::EvaluateStrided(const Tape &t, int index, double *r,
+                                   std::size_t stride, int num_points) {
+  const Tape::Instruction &instr = t.instruction(index);
+  double *result = r + (t.first_result() + index) * stride;
+  for (int p = 0; p < num_points; ++p) {
+    result[p] = Compute(instr, t.args(), t.data(),
+                        StridedRegisters(r + p, stride));
+  }
+}
+
+mp::TapeEvaluator::TapeEvaluator(const Tape &tape)
+  : tape_(tape), registers_(std::max(tape.num_registers(), 1)) {
+  tape.InitConsts(&registers_[0]);
+}
+
+void mp::TapeEvaluator::Evaluate(const double *x) {
+  std::copy(x, x + tape_.num_vars(), registers_.begin());
+  tape_.Evaluate(&registers_[0]);
+}
+
+void mp::TapeEvaluator::GetConValues(double *values) const {
+  for (int i = 0, n = tape_.num_cons(); i < n; ++i)
+    values[i] = registers_[tape_.con_register(i)];
+}
@@ -0,0 +1,117 @@
+/*
+ A pool of worker threads
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include "mp/thread-pool.h"
+
+#include <algorithm>
+
+#ifdef MP_USE_THREAD
+
+mp::ThreadPool::ThreadPool(int num_threads)
+  : task_(0), num_parts_(0), next_part_(0), num_done_(0),
+    generation_(0), stop_(false) {
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    num_threads = std::max(num_threads, 1);
+  }
+  threads_.reserve(num_threads);
+  try {
+    for (int i = 0; i < num_threads; ++i)
+      threads_.push_back(std::thread(&ThreadPool::Work, this, i));
+  } catch (...) {
+    Stop();
+    throw;
+  }
+}
+
+mp::ThreadPool::~ThreadPool() { Stop(); }
+
+void mp::ThreadPool::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cond_.notify_all();
+  for (std::size_t i = 0, n = threads_.size(); i < n; ++i)
+    threads_[i].join();
+  threads_.clear();
+}
+
+void mp::ThreadPool::Work(int thread_index) {
+  unsigned generation = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    while (!stop_ && generation_ == generation)
+      work_cond_.wait(lock);
+    if (stop_)
+      return;
+    generation = generation_;
+    while (next_part_ < num_parts_) {
+      Task *task = task_;
+      int index = next_part_++;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        task->Run(index, thread_index);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error && !error_)
+        error_ = error;
+      if (++num_done_ == num_parts_)
+        done_cond_.notify_all();
+    }
+  }
+}
+
+void mp::ThreadPool::Run(Task &task, int num_parts) {
+  if (num_parts <= 0)
+    return;
+  std::unique_lock<std::mutex> lock(mutex_);
+  task_ = &task;
+  num_parts_ = num_parts;
+  next_part_ = num_done_ = 0;
+  ++generation_;
+  work_cond_.notify_all();
+  while (num_done_ != num_parts_)
+    done_cond_.wait(lock);
+  task_ = 0;
+  num_parts_ = next_part_ = 0;
+  std::exception_ptr error = error_;
+  error_ = std::exception_ptr();
+  if (error)
+    std::rethrow_exception(error);
+}
+
+#else
+
+mp::ThreadPool::ThreadPool(int) {}
+
+mp::ThreadPool::~ThreadPool() {}
+
+void mp::ThreadPool::Run(Task &task, int num_parts) {
+  for (int i = 0; i < num_parts; ++i)
+    task.Run(i, 0);
+}
+
+#endif  // MP_USE_THREAD
@@ -988,6 +988,51 @@ TEST_F(ExprTest, NumberOfMap) {
   EXPECT_TRUE(i == map.end());
 }
 
+TEST_F(ExprTest, NumberOfMapSortsValues) {
+  asl::NumberOfMap<Var, CreateVar> map((CreateVar()));
+  double values[] = {3, -1, 2, 0, 3, -1};
+  for (std::size_t i = 0; i < sizeof(values) / sizeof(*values); ++i) {
+    NumericExpr args[] = {MakeConst(values[i]), MakeVariable(0)};
+    map.Add(values[i], builder.MakeNumberOf(args));
+  }
+  asl::NumberOfMap<Var, CreateVar>::iterator i = map.begin();
+  ASSERT_EQ(4u, i->values.size());
+  asl::NumberOfMap<Var, CreateVar>::ValueMap::const_iterator
+      j = i->values.begin();
+  EXPECT_EQ(-1, j->first);
+  EXPECT_EQ(2, j->second.index);
+  EXPECT_EQ(0, (++j)->first);
+  EXPECT_EQ(4, j->second.index);
+  EXPECT_EQ(2, (++j)->first);
+  EXPECT_EQ(3, j->second.index);
+  EXPECT_EQ(3, (++j)->first);
+  EXPECT_EQ(1, j->second.index);
+  EXPECT_TRUE(i->values.find(1) == i->values.end());
+  EXPECT_TRUE(++i == map.end());
+}
+
+TEST_F(ExprTest, NumberOfMapManyExprs) {
+  // Add enough expressions to rehash several times.
+  asl::NumberOfMap<Var, CreateVar> map((CreateVar()));
+  enum {NUM_EXPRS = 100};
+  for (int pass = 0; pass < 2; ++pass) {
+    for (int i = 0; i < NUM_EXPRS; ++i) {
+      NumericExpr args[] = {MakeConst(pass), MakeConst(i)};
+      EXPECT_EQ(pass * NUM_EXPRS + i + 1,
+                map.Add(pass, builder.MakeNumberOf(args)).index);
+    }
+  }
+  int index = 0;
+  for (asl::NumberOfMap<Var, CreateVar>::iterator
+       i = map.begin(), end = map.end(); i != end; ++i, ++index) {
+    EXPECT_EQ(index, Cast<NumericConstant>(i->expr[1]).value());
+    ASSERT_EQ(2u, i->values.size());
+    EXPECT_EQ(index + 1, i->values.find(0)->second.index);
+    EXPECT_EQ(NUM_EXPRS + index + 1, i->values.find(1)->second.index);
+  }
+  EXPECT_EQ(NUM_EXPRS, index);
+}
+
 TEST_F(ExprTest, IsZero) {
   EXPECT_TRUE(IsZero(MakeConst(0)));
   EXPECT_FALSE(IsZero(MakeConst(1)));
@@ -1155,10 +1200,12 @@ struct TestString {
   const char *str;
 };
 
-namespace std {
+namespace mp {
+namespace asl {
+namespace internal {
 
 template <>
-struct hash<TestString> {
+struct Hash<TestString> {
   std::size_t operator()(TestString ts) const {
     size_t hash = asl::internal::HashCombine<int>(0, ex::STRING);
     for (const char *s = ts.str; *s; ++s)
@@ -1167,6 +1214,8 @@ struct hash<TestString> {
   }
 };
 }
+}
+}
 
 TEST_F(ExprTest, HashStringLiteral) {
   // String literal can only occur as a function argument, so test
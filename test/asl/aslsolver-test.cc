@@ -20,8 +20,16 @@
  Author: Victor Zverovich
  */
 
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "asl/aslsolver.h"
+#include "../gtest-extra.h"
+#include "../util.h"
+
+#ifndef MP_TEST_DATA_DIR
+# define MP_TEST_DATA_DIR "../data"
+#endif
 
 struct TestSolver : mp::ASLSolver {
   TestSolver() : ASLSolver("testsolver") {
@@ -36,3 +44,291 @@ TEST(ASLSolverTest, RegisterSuffixes) {
   mp::ASLProblem p(builder.GetProblem());
   EXPECT_TRUE(p.suffixes(mp::suf::VAR).Find("answer"));
 }
+
+TEST(ASLSolverTest, FuncCacheOption) {
+  TestSolver s;
+  EXPECT_EQ(0, s.GetIntOption("funcache"));
+  s.SetIntOption("funcache", 1000);
+  EXPECT_EQ(1000, s.GetIntOption("funcache"));
+  EXPECT_THROW(s.SetIntOption("funcache", -1), mp::InvalidOptionValue);
+}
+
+namespace {
+
+int num_func_calls;
+
+// f(x, y, ...) = x^2 * y; string arguments are ignored.
+// Negative x is reported as an error via Errmsg.
+double TestFunc(arglist *al) {
+  ++num_func_calls;
+  double x = al->ra[0], y = al->ra[1];
+  if (x < 0) {
+    al->Errmsg = const_cast<char*>("negative x");
+    return 0;
+  }
+  if (double *d = al->derivs) {
+    d[0] = 2 * x * y;
+    d[1] = x * x;
+    if (double *h = al->hes) {
+      h[0] = 2 * y;
+      h[1] = 2 * x;
+      h[2] = 0;
+    }
+  }
+  return x * x * y;
+}
+
+// minimize o0: f(x, y);
+// minimize o1: f(x, y, 's');
+// minimize o2: f(x, y);
+const char FUNCALL_NL[] =
+  "g3 0 1 0\n"
+  " 2 0 3 0 0\n"
+  " 0 3\n"
+  " 0 0\n"
+  " 0 2 0\n"
+  " 0 1 0 1\n"
+  " 0 0 0 0 0\n"
+  " 0 6\n"
+  " 0 0\n"
+  " 0 0 0 0 0\n"
+  "F0 1 -1 f\n"
+  "O0 0\nf0 2\nv0\nv1\n"
+  "O1 0\nf0 3\nv0\nv1\nh1:s\n"
+  "O2 0\nf0 2\nv0\nv1\n"
+  "b\n3\n3\n"
+  "G0 2\n0 0\n1 0\n"
+  "G1 2\n0 0\n1 0\n"
+  "G2 2\n0 0\n1 0\n";
+
+struct EvalResult {
+  double obj;
+  double grad[2];
+  double hes[4];
+};
+
+// An ASL with the function f and an optional function cache.
+class FuncCallASL {
+ private:
+  ASL *asl_;
+
+  FMT_DISALLOW_COPY_AND_ASSIGN(FuncCallASL);
+
+ public:
+  explicit FuncCallASL(int cache_size) : asl_(ASL_alloc(ASL_read_pfgh)) {
+    WriteFile("test.nl", FUNCALL_NL);
+    char stub[] = "test.nl";
+    FILE *nl = jac0dim_ASL(asl_, stub, sizeof(stub) - 1);
+    func_add(asl_);
+    AmplExports *ae = asl_->i.ae;
+    ae->Addfunc("f", TestFunc, FUNCADD_STRING_ARGS, -1, 0, ae);
+    pfgh_read_ASL(asl_, nl, 0);
+    if (cache_size != 0)
+      fcache_ASL(asl_, 0, cache_size);
+  }
+  ~FuncCallASL() { ASL_free(&asl_); }
+
+  // Evaluates objective obj together with its gradient and Hessian.
+  // Returns a nonzero error code if the evaluation failed.
+  fint Eval(int obj, double x, double y, EvalResult &r) {
+    ASL *asl = asl_;
+    double xs[] = {x, y};
+    fint ne = 0;
+    r.obj = objval(obj, xs, &ne);
+    if (ne != 0)
+      return ne;
+    objgrd(obj, xs, r.grad, &ne);
+    hesset(1, obj, 1, 0, 0);
+    fullhes(r.hes, 2, obj, 0, 0);
+    return ne;
+  }
+
+  // Returns the number of cache lookups and hits.
+  unsigned long stats(unsigned long &hits) const {
+    unsigned long calls = 0;
+    fcache_stats_ASL(asl_, 0, &hits, &calls);
+    return calls;
+  }
+};
+
+void CheckEqual(const EvalResult &expected, const EvalResult &actual) {
+  EXPECT_EQ(expected.obj, actual.obj);
+  for (int i = 0; i < 2; ++i)
+    EXPECT_EQ(expected.grad[i], actual.grad[i]);
+  for (int i = 0; i < 4; ++i)
+    EXPECT_EQ(expected.hes[i], actual.hes[i]);
+}
+}  // namespace
+
+TEST(ASLSolverTest, FuncCacheHit) {
+  EvalResult expected = EvalResult();
+  {
+    FuncCallASL asl(0);
+    num_func_calls = 0;
+    EXPECT_EQ(0, asl.Eval(0, 3, 5, expected));
+    EXPECT_GT(num_func_calls, 0);
+    unsigned long hits = 0;
+    EXPECT_EQ(0u, asl.stats(hits));
+  }
+  EXPECT_EQ(45, expected.obj);
+  EXPECT_EQ(30, expected.grad[0]);
+  EXPECT_EQ(9, expected.grad[1]);
+  EXPECT_EQ(10, expected.hes[0]);
+  EXPECT_EQ(6, expected.hes[1]);
+
+  FuncCallASL asl(16);
+  num_func_calls = 0;
+  EvalResult r = EvalResult();
+  EXPECT_EQ(0, asl.Eval(0, 3, 5, r));
+  CheckEqual(expected, r);
+  int num_calls = num_func_calls;
+  unsigned long hits = 0;
+  unsigned long calls = asl.stats(hits);
+  EXPECT_EQ(0u, hits);
+  EXPECT_EQ(static_cast<unsigned long>(num_calls), calls);
+
+  // Objective 2 calls f with the same arguments, so the values are taken
+  // from the cache.
+  r = EvalResult();
+  EXPECT_EQ(0, asl.Eval(2, 3, 5, r));
+  CheckEqual(expected, r);
+  EXPECT_EQ(num_calls, num_func_calls);
+  unsigned long new_hits = 0;
+  unsigned long new_calls = asl.stats(new_hits);
+  EXPECT_GT(new_hits, 0u);
+  EXPECT_EQ(new_calls - calls, new_hits);
+}
+
+TEST(ASLSolverTest, FuncCacheSkipsSymbolicArgs) {
+  FuncCallASL asl(16);
+  EvalResult r = EvalResult();
+  num_func_calls = 0;
+  EXPECT_EQ(0, asl.Eval(1, 3, 5, r));
+  EXPECT_EQ(45, r.obj);
+  int num_calls = num_func_calls;
+  EXPECT_EQ(0, asl.Eval(1, 3, 5, r));
+  EXPECT_EQ(45, r.obj);
+  EXPECT_GT(num_func_calls, num_calls);
+  unsigned long hits = 0;
+  EXPECT_EQ(0u, asl.stats(hits));
+  EXPECT_EQ(0u, hits);
+}
+
+TEST(ASLSolverTest, FuncCacheSkipsErrors) {
+  FuncCallASL asl(16);
+  EvalResult r = EvalResult();
+  num_func_calls = 0;
+  EXPECT_NE(0, asl.Eval(0, -1, 5, r));
+  EXPECT_EQ(1, num_func_calls);
+  EXPECT_NE(0, asl.Eval(2, -1, 5, r));
+  EXPECT_EQ(2, num_func_calls);
+  unsigned long hits = 0;
+  EXPECT_EQ(2u, asl.stats(hits));
+  EXPECT_EQ(0u, hits);
+}
+
+namespace {
+// A solver that reports a solution depending on the problem size.
+struct SizeSolver : mp::ASLSolver {
+  SizeSolver() : ASLSolver("sizesolver") {}
+
+  void DoSolve(mp::ASLProblem &p, mp::SolutionHandler &sh) {
+    int num_vars = p.num_vars(), num_cons = p.num_algebraic_cons();
+    std::vector<double> values(num_vars), dual_values(num_cons);
+    for (int i = 0; i < num_vars; ++i)
+      values[i] = i + num_cons;
+    for (int i = 0; i < num_cons; ++i)
+      dual_values[i] = i + 0.5;
+    sh.HandleSolution(mp::sol::SOLVED,
+                      fmt::format("solved {}x{}", num_vars, num_cons),
+                      values.data(), dual_values.data(), 0);
+  }
+};
+
+typedef mp::SolverApp<SizeSolver> SizeSolverApp;
+
+// Runs the application with the space-separated arguments args.
+int RunApp(SizeSolverApp &app, const std::string &args) {
+  std::vector<std::string> parts = Split("sizesolver " + args, ' ');
+  std::vector<char*> argv;
+  for (std::size_t i = 0, n = parts.size(); i < n; ++i)
+    argv.push_back(&parts[i][0]);
+  argv.push_back(0);
+  return app.Run(argv.data());
+}
+
+// Names of test problems solved in batch mode.
+const char *const BATCH_STUBS[] = {"feasible", "objconst", "simple", "test"};
+const int NUM_BATCH_STUBS = sizeof(BATCH_STUBS) / sizeof(*BATCH_STUBS);
+
+// Creates the directory dir containing copies of the batch test problems.
+void MakeBatchDir(const std::string &dir) {
+  ExecuteShellCommand("rm -rf " + dir);
+  ExecuteShellCommand("mkdir " + dir);
+  for (int i = 0; i < NUM_BATCH_STUBS; ++i) {
+    WriteFile(fmt::format("{}/{}.nl", dir, BATCH_STUBS[i]),
+              ReadFile(fmt::format(MP_TEST_DATA_DIR "/{}.nl", BATCH_STUBS[i])));
+  }
+}
+
+// Solves the batch test problems one at a time and returns their solutions.
+std::vector<std::string> SolveSequentially() {
+  MakeBatchDir("seq");
+  std::vector<std::string> solutions;
+  for (int i = 0; i < NUM_BATCH_STUBS; ++i) {
+    SizeSolverApp app;
+    std::string stub = fmt::format("seq/{}", BATCH_STUBS[i]);
+    OutputRedirect redir(stdout);
+    EXPECT_EQ(0, RunApp(app, "-s " + stub));
+    redir.restore_and_read();
+    solutions.push_back(ReadFile(stub + ".sol"));
+  }
+  return solutions;
+}
+}  // namespace
+
+TEST(ASLSolverTest, RunBatchDir) {
+  std::vector<std::string> solutions = SolveSequentially();
+  const char *const WORKERS[] = {"", "-workers 1 "};
+  for (std::size_t i = 0; i < sizeof(WORKERS) / sizeof(*WORKERS); ++i) {
+    MakeBatchDir("batch");
+    SizeSolverApp app;
+    EXPECT_WRITE(stdout,
+      EXPECT_EQ(0, RunApp(app, fmt::format("-batch batch {}-s", WORKERS[i]))),
+      "");
+    for (int j = 0; j < NUM_BATCH_STUBS; ++j) {
+      EXPECT_EQ(solutions[j],
+                ReadFile(fmt::format("batch/{}.sol", BATCH_STUBS[j])))
+          << BATCH_STUBS[j] << " with workers option '" << WORKERS[i] << "'";
+    }
+  }
+}
+
+// The ASL is not thread safe, so ASL-based solvers reject several workers.
+TEST(ASLSolverTest, RunBatchRejectsWorkers) {
+  EXPECT_FALSE(SizeSolver().thread_safe());
+  MakeBatchDir("batch");
+  SizeSolverApp app;
+  EXPECT_THROW_MSG(RunApp(app, "-batch batch -workers 3 -s"), mp::Error,
+                   "sizesolver can't solve problems concurrently, "
+                   "use -workers 1");
+}
+
+TEST(ASLSolverTest, RunBatchReportsErrorsPerStub) {
+  std::vector<std::string> solutions = SolveSequentially();
+  MakeBatchDir("batch");
+  WriteFile("batch/bad.nl", "garbage");
+  WriteFile("batch/empty.nl", "");
+  SizeSolverApp app;
+  OutputRedirect redir(stderr);
+  EXPECT_EQ(1, RunApp(app, "-batch batch -s"));
+  std::vector<std::string> lines = Split(redir.restore_and_read(), '\n');
+  ASSERT_EQ(3u, lines.size());
+  EXPECT_TRUE(lines[0].find("Error: batch/bad: ") == 0) << lines[0];
+  EXPECT_TRUE(lines[1].find("Error: batch/empty: ") == 0) << lines[1];
+  EXPECT_EQ("", lines[2]);
+  for (int i = 0; i < NUM_BATCH_STUBS; ++i) {
+    EXPECT_EQ(solutions[i],
+              ReadFile(fmt::format("batch/{}.sol", BATCH_STUBS[i])));
+  }
+}
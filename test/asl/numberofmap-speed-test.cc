@@ -1,29 +1,100 @@
+/*
+ Benchmark of NumberOfMap.
+
+ Usage: numberofmap-speed-test [max_num_exprs]
+
+ Adds numberof expressions with distinct argument lists and several
+ values each to NumberOfMap and reports the time per Add for increasing
+ numbers of expressions (up to max_num_exprs, default 100000) both for
+ new and already added expressions. The time per operation should stay
+ roughly constant as the number of expressions grows.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <cstdlib>
+#include <vector>
+
 #include "asl/aslbuilder.h"
 #include "mp/clock.h"
 #include "mp/nl.h"
 
+namespace {
+
 struct CreateVar {
   int operator()() { return 0; }
 };
 
-int main() {
+// Number of distinct values per argument list.
+enum {NUM_VALUES = 4};
+
+typedef mp::asl::NumberOfMap<int, CreateVar> Map;
+
+// Adds numberof expressions to the map and returns the time in seconds.
+double Add(Map &map, const std::vector<mp::asl::NumberOfExpr> &exprs) {
+  mp::steady_clock::time_point start = mp::steady_clock::now();
+  for (std::size_t i = 0, n = exprs.size(); i < n; ++i) {
+    mp::asl::NumberOfExpr e = exprs[i];
+    map.Add(mp::asl::Cast<mp::asl::NumericConstant>(e[0]).value(), e);
+  }
+  return mp::GetTimeAndReset(start);
+}
+}
+
+int main(int argc, char **argv) {
+  int max_num_exprs = argc > 1 ? std::atoi(argv[1]) : 100000;
+  if (max_num_exprs <= 0) {
+    fmt::print(stderr, "usage: numberofmap-speed-test [max_num_exprs]\n");
+    return 1;
+  }
   mp::asl::internal::ASLBuilder b;
-  int num_exprs = 10000;
   mp::ProblemInfo pi = mp::ProblemInfo();
-  pi.num_vars = num_exprs;
+  pi.num_vars = max_num_exprs;
   pi.num_objs = 1;
   b.SetInfo(pi);
-  mp::asl::NumberOfMap<int, CreateVar> map((CreateVar()));
-  mp::asl::NumericConstant n = b.MakeNumericConstant(0);
-  std::vector<mp::asl::NumberOfExpr> exprs(num_exprs);
-  for (int i = 0; i < num_exprs; ++i) {
-    mp::asl::NumericExpr args[] = {n, b.MakeVariable(i)};
-    exprs[i] = b.MakeNumberOf(args);
+
+  // Create expressions with values in the order i, i - 1, ... so that
+  // insertion into value sets is not always at the end.
+  std::vector<mp::asl::NumberOfExpr> exprs;
+  exprs.reserve(static_cast<std::size_t>(max_num_exprs) * NUM_VALUES);
+  for (int i = 0; i < max_num_exprs; ++i) {
+    for (int j = NUM_VALUES; j > 0; --j) {
+      mp::asl::NumericExpr args[] = {
+        b.MakeNumericConstant(j), b.MakeVariable(i)
+      };
+      exprs.push_back(b.MakeNumberOf(args));
+    }
+  }
+
+  fmt::print("{:>10} {:>14} {:>14}\n", "exprs", "new ns/op", "found ns/op");
+  for (int num_exprs = 1000; ; num_exprs *= 10) {
+    if (num_exprs > max_num_exprs)
+      num_exprs = max_num_exprs;
+    std::vector<mp::asl::NumberOfExpr>
+        subset(exprs.begin(), exprs.begin() + num_exprs * NUM_VALUES);
+    Map map((CreateVar()));
+    double new_time = Add(map, subset);
+    double found_time = Add(map, subset);
+    double num_ops = static_cast<double>(subset.size());
+    fmt::print("{:>10} {:>14.1f} {:>14.1f}\n", num_exprs,
+               new_time * 1e9 / num_ops, found_time * 1e9 / num_ops);
+    if (num_exprs == max_num_exprs)
+      break;
   }
-  mp::steady_clock::time_point start = mp::steady_clock::now();
-  for (int i = 0; i < num_exprs; ++i)
-    map.Add(0, exprs[i]);
-  mp::steady_clock::time_point end = mp::steady_clock::now();
-  fmt::print("Executed NumberOfMap.Add {} times in {} s.\n",
-    num_exprs, mp::duration_cast< mp::duration<double> >(end - start).count());
 }
@@ -24,6 +24,10 @@
 #include "solver-c.h"
 
 #include <stdlib.h>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
 
 #ifdef _WIN32
 # define putenv _putenv
@@ -78,31 +82,36 @@ TEST(SolverCTest, GetOptionHeader) {
 TEST(SolverCTest, GetSolverOptions) {
   MP_Solver *s = MP_CreateSolver(0, 0);
   int num_options = MP_GetSolverOptions(s, 0, 0);
-  EXPECT_EQ(6, num_options);
+  EXPECT_EQ(11, num_options);
   std::vector<MP_SolverOptionInfo> options(num_options);
   EXPECT_EQ(num_options, MP_GetSolverOptions(s, &options[0], num_options));
-  EXPECT_STREQ("objno", options[0].name);
-  EXPECT_STREQ("opt1", options[1].name);
-  EXPECT_STREQ("desc1", options[1].description);
-  EXPECT_EQ(0, options[0].flags);
-  EXPECT_STREQ("opt2", options[2].name);
-  EXPECT_STREQ("desc2", options[2].description);
-  EXPECT_EQ(MP_OPT_HAS_VALUES, options[2].flags);
-  EXPECT_STREQ("timing", options[3].name);
-  EXPECT_STREQ("version", options[4].name);
-  EXPECT_STREQ("wantsol", options[5].name);
+  EXPECT_STREQ("exprstats", options[0].name);
+  EXPECT_STREQ("funcache", options[1].name);
+  EXPECT_STREQ("objno", options[2].name);
+  EXPECT_EQ(0, options[2].flags);
+  EXPECT_STREQ("opt1", options[3].name);
+  EXPECT_STREQ("desc1", options[3].description);
+  EXPECT_STREQ("opt2", options[4].name);
+  EXPECT_STREQ("desc2", options[4].description);
+  EXPECT_EQ(MP_OPT_HAS_VALUES, options[4].flags);
+  EXPECT_STREQ("pipeline", options[5].name);
+  EXPECT_STREQ("simplify", options[6].name);
+  EXPECT_STREQ("statsfile", options[7].name);
+  EXPECT_STREQ("timing", options[8].name);
+  EXPECT_STREQ("version", options[9].name);
+  EXPECT_STREQ("wantsol", options[10].name);
   MP_DestroySolver(s);
 }
 
 TEST(SolverCTest, GetPartOfSolverOptions) {
   MP_Solver *s = MP_CreateSolver(0, 0);
   int num_options = MP_GetSolverOptions(s, 0, 0);
-  EXPECT_EQ(6, num_options);
+  EXPECT_EQ(11, num_options);
   std::vector<MP_SolverOptionInfo> options(4);
   EXPECT_EQ(num_options, MP_GetSolverOptions(s, &options[0], 3));
-  EXPECT_STREQ("objno", options[0].name);
-  EXPECT_STREQ("opt1", options[1].name);
-  EXPECT_STREQ("opt2", options[2].name);
+  EXPECT_STREQ("exprstats", options[0].name);
+  EXPECT_STREQ("funcache", options[1].name);
+  EXPECT_STREQ("objno", options[2].name);
   EXPECT_TRUE(!options[3].name);
   EXPECT_TRUE(!options[3].description);
   EXPECT_TRUE(!options[3].flags);
@@ -112,13 +121,13 @@ TEST(SolverCTest, GetPartOfSolverOptions) {
 
 TEST(SolverCTest, GetOptionValues) {
   MP_Solver *s = MP_CreateSolver(0, 0);
-  MP_SolverOptionInfo info[3];
-  MP_GetSolverOptions(s, info, 3);
-  int num_values = MP_GetOptionValues(s, info[2].option, 0, 0);
+  MP_SolverOptionInfo info[5];
+  MP_GetSolverOptions(s, info, 5);
+  int num_values = MP_GetOptionValues(s, info[4].option, 0, 0);
   EXPECT_EQ(3, num_values);
   std::vector<MP_OptionValueInfo> values(num_values);
   EXPECT_EQ(num_values,
-      MP_GetOptionValues(s, info[2].option, &values[0], num_values));
+      MP_GetOptionValues(s, info[4].option, &values[0], num_values));
   EXPECT_STREQ("val1", values[0].value);
   EXPECT_STREQ("valdesc1", values[0].description);
   EXPECT_STREQ("val2", values[1].value);
@@ -130,13 +139,13 @@ TEST(SolverCTest, GetOptionValues) {
 
 TEST(SolverCTest, GetPartOfOptionValues) {
   MP_Solver *s = MP_CreateSolver(0, 0);
-  MP_SolverOptionInfo info[3];
-  MP_GetSolverOptions(s, info, 3);
-  int num_values = MP_GetOptionValues(s, info[2].option, 0, 0);
+  MP_SolverOptionInfo info[5];
+  MP_GetSolverOptions(s, info, 5);
+  int num_values = MP_GetOptionValues(s, info[4].option, 0, 0);
   EXPECT_EQ(3, num_values);
   std::vector<MP_OptionValueInfo> values(num_values);
   EXPECT_EQ(num_values,
-      MP_GetOptionValues(s, info[2].option, &values[0], 2));
+      MP_GetOptionValues(s, info[4].option, &values[0], 2));
   EXPECT_STREQ("val1", values[0].value);
   EXPECT_STREQ("valdesc1", values[0].description);
   EXPECT_STREQ("val2", values[1].value);
@@ -145,4 +154,195 @@ TEST(SolverCTest, GetPartOfOptionValues) {
   EXPECT_TRUE(!values[2].description);
   MP_DestroySolver(s);
 }
+
+// Fills in problem data for
+//   minimize 3 * x0 + 4 * x2 subject to
+//   c0: 1 <= x0 + 2 * x1 <= 5, c1: 5 * x1 + 6 * x2 = 7, x0 >= 1, x2 <= 8.
+struct ProblemData : MP_ProblemData {
+  std::vector<int> starts, indices;
+  std::vector<double> values;
+  double var_lb_[3], var_ub_[3], con_lb_[2], con_ub_[2];
+  int obj_starts_[2], obj_indices_[2];
+  double obj_values_[2];
+  int obj_sense_[1];
+
+  explicit ProblemData(int matrix_format) {
+    std::memset(static_cast<MP_ProblemData*>(this), 0, sizeof(MP_ProblemData));
+    num_vars = 3;
+    num_cons = 2;
+    num_objs = 1;
+    double inf = std::numeric_limits<double>::infinity();
+    var_lb_[0] = 1;
+    var_lb_[1] = var_lb_[2] = -inf;
+    var_ub_[0] = var_ub_[1] = inf;
+    var_ub_[2] = 8;
+    var_lb = var_lb_;
+    var_ub = var_ub_;
+    con_lb_[0] = 1;
+    con_ub_[0] = 5;
+    con_lb_[1] = con_ub_[1] = 7;
+    con_lb = con_lb_;
+    con_ub = con_ub_;
+    this->matrix_format = matrix_format;
+    if (matrix_format == MP_CSR) {
+      int s[] = {0, 2, 4}, ind[] = {1, 0, 1, 2};
+      double val[] = {2, 1, 5, 6};
+      starts.assign(s, s + 3);
+      indices.assign(ind, ind + 4);
+      values.assign(val, val + 4);
+    } else {
+      int s[] = {0, 1, 3, 4}, ind[] = {0, 0, 1, 1};
+      double val[] = {1, 2, 5, 6};
+      starts.assign(s, s + 4);
+      indices.assign(ind, ind + 4);
+      values.assign(val, val + 4);
+    }
+    matrix_starts = &starts[0];
+    matrix_indices = &indices[0];
+    matrix_values = &values[0];
+    obj_starts_[0] = 0;
+    obj_starts_[1] = 2;
+    obj_indices_[0] = 0;
+    obj_indices_[1] = 2;
+    obj_values_[0] = 3;
+    obj_values_[1] = 4;
+    obj_starts = obj_starts_;
+    obj_indices = obj_indices_;
+    obj_values = obj_values_;
+  }
+};
+
+void CheckSolution(MP_Solver *s, MP_Problem *p, double obj_value,
+                   double nl_con_value = 0) {
+  MP_SolutionInfo info = MP_SolutionInfo();
+  double values[3] = {}, dual_values[2] = {};
+  ASSERT_EQ(0, MP_GetSolution(s, p, &info, values, dual_values));
+  EXPECT_EQ(0, info.status);
+  EXPECT_STREQ("test", info.message);
+  EXPECT_EQ(obj_value, info.obj_value);
+  EXPECT_TRUE(info.has_values != 0);
+  EXPECT_TRUE(info.has_dual_values != 0);
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(-std::numeric_limits<double>::infinity(), values[1]);
+  EXPECT_EQ(1 * 1 + 2 * 2 + nl_con_value, dual_values[0]);
+  EXPECT_EQ(5 * 2 + 6 * 3, dual_values[1]);
+}
+
+TEST(SolverCTest, SolveCSR) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  ProblemData data(MP_CSR);
+  data.nl_exprs = "ignored";  // Ignored because nl_exprs_size is 0.
+  MP_Problem *p = MP_LoadProblem(s, &data);
+  ASSERT_TRUE(p != 0);
+  EXPECT_EQ(0, MP_Solve(s, p));
+  CheckSolution(s, p, 3 * 1 + 4 * 3);
+  MP_DestroyProblem(p);
+  MP_DestroySolver(s);
+}
+
+TEST(SolverCTest, SolveCSC) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  ProblemData data(MP_CSC);
+  data.obj_sense = data.obj_sense_;
+  data.obj_sense_[0] = MP_MAXIMIZE;
+  MP_Problem *p = MP_LoadProblem(s, &data);
+  ASSERT_TRUE(p != 0);
+  EXPECT_EQ(0, MP_Solve(s, p));
+  CheckSolution(s, p, -(3 * 1 + 4 * 3));
+  // Solve again.
+  EXPECT_EQ(0, MP_Solve(s, p));
+  CheckSolution(s, p, -(3 * 1 + 4 * 3));
+  MP_DestroyProblem(p);
+  MP_DestroySolver(s);
+}
+
+TEST(SolverCTest, SolveNonlinear) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  ProblemData data(MP_CSR);
+  // c0 has a nonlinear part x0 * x1: "C0" followed by "o2 v0 v1".
+  std::string nl("C");
+  int ints[] = {0};
+  nl.append(reinterpret_cast<const char*>(ints), sizeof(int));
+  const int args[] = {0, 1};
+  nl += 'o';
+  int opcode = 2;
+  nl.append(reinterpret_cast<const char*>(&opcode), sizeof(int));
+  for (int i = 0; i < 2; ++i) {
+    nl += 'v';
+    nl.append(reinterpret_cast<const char*>(&args[i]), sizeof(int));
+  }
+  data.nl_exprs = nl.data();
+  data.nl_exprs_size = static_cast<int>(nl.size());
+  data.num_nl_cons = 1;
+  data.num_nl_vars_in_cons = 2;
+  MP_Problem *p = MP_LoadProblem(s, &data);
+  ASSERT_TRUE(p != 0);
+  EXPECT_EQ(0, MP_Solve(s, p));
+  // The test solver adds x0 * x1 evaluated at x0 = 1, x1 = 2 to the dual
+  // value of c0.
+  CheckSolution(s, p, 3 * 1 + 4 * 3, 1 * 2);
+  MP_DestroyProblem(p);
+  MP_DestroySolver(s);
+}
+
+TEST(SolverCTest, LoadProblemError) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  ProblemData data(MP_CSR);
+  data.num_vars = 0;
+  EXPECT_TRUE(!MP_LoadProblem(s, &data));
+  EXPECT_STREQ("invalid number of variables 0",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  data.num_vars = 3;
+  data.indices[0] = 3;
+  EXPECT_TRUE(!MP_LoadProblem(s, &data));
+  EXPECT_STREQ("variable index 3 out of bounds",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  data.indices[0] = 0;
+  EXPECT_TRUE(!MP_LoadProblem(s, &data));
+  EXPECT_STREQ("duplicate variable 0 in constraint 0",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  MP_DestroySolver(s);
+}
+
+TEST(SolverCTest, LoadProblemNullData) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  EXPECT_TRUE(!MP_LoadProblem(s, 0));
+  EXPECT_STREQ("null problem data", MP_GetErrorMessage(MP_GetLastError(s)));
+  ProblemData data(MP_CSR);
+  data.matrix_indices = 0;
+  EXPECT_TRUE(!MP_LoadProblem(s, &data));
+  EXPECT_STREQ("null indices or values with nonempty matrix_starts",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  ProblemData csc_data(MP_CSC);
+  csc_data.matrix_values = 0;
+  EXPECT_TRUE(!MP_LoadProblem(s, &csc_data));
+  EXPECT_STREQ("null indices or values with nonempty matrix_starts",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  ProblemData obj_data(MP_CSR);
+  obj_data.obj_values = 0;
+  EXPECT_TRUE(!MP_LoadProblem(s, &obj_data));
+  EXPECT_STREQ("null indices or values with nonempty obj_starts",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  MP_DestroySolver(s);
+}
+
+TEST(SolverCTest, GetSolutionBeforeSolve) {
+  MP_Solver *s = MP_CreateSolver(0, 0);
+  ProblemData data(MP_CSR);
+  MP_Problem *p = MP_LoadProblem(s, &data);
+  EXPECT_EQ(-1, MP_GetSolution(s, p, 0, 0, 0));
+  EXPECT_STREQ("problem is not solved",
+               MP_GetErrorMessage(MP_GetLastError(s)));
+  EXPECT_EQ(-1, MP_GetSuffix(s, p, MP_SUF_VAR, "answer", 0, 0));
+  EXPECT_EQ(0, MP_Solve(s, p));
+  EXPECT_EQ(-1, MP_GetSuffix(s, p, MP_SUF_VAR, "answer", 0, 0));
+  EXPECT_STREQ("suffix not found", MP_GetErrorMessage(MP_GetLastError(s)));
+  EXPECT_EQ(-1, MP_GetSuffix(s, p, 4, "answer", 0, 0));
+  EXPECT_STREQ("invalid suffix", MP_GetErrorMessage(MP_GetLastError(s)));
+  double value = 0;
+  EXPECT_EQ(-1, MP_GetSuffix(s, p, MP_SUF_VAR, "answer", &value, -1));
+  EXPECT_STREQ("invalid size", MP_GetErrorMessage(MP_GetLastError(s)));
+  MP_DestroyProblem(p);
+  MP_DestroySolver(s);
+}
 }
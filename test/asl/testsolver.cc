@@ -26,12 +26,69 @@
 
 #include <cstdlib>
 #include <stdexcept>
+#include <vector>
 
 namespace mp {
 
 class TestSolver : public ASLSolver {
+ private:
+  // Evaluates an expression made of constants, variables and binary
+  // arithmetic at the point where each variable equals its index plus one.
+  static double Eval(asl::NumericExpr e) {
+    if (asl::NumericConstant n = asl::Cast<asl::NumericConstant>(e))
+      return n.value();
+    if (e.kind() == expr::VARIABLE)
+      return asl::Cast<asl::Reference>(e).index() + 1;
+    asl::BinaryExpr b = asl::Cast<asl::BinaryExpr>(e);
+    if (!b)
+      throw Error("unsupported expression");
+    double lhs = Eval(b.lhs()), rhs = Eval(b.rhs());
+    switch (b.kind()) {
+    case expr::ADD: return lhs + rhs;
+    case expr::SUB: return lhs - rhs;
+    case expr::MUL: return lhs * rhs;
+    default:
+      throw Error("unsupported expression");
+    }
+  }
+
  protected:
-  void DoSolve(ASLProblem &, SolutionHandler &) {}
+  // Reports the variable lower bounds as the solution, constraints and
+  // the first objective encoded as sums of coefficients times variable
+  // indices plus one as the dual values and the objective value, so that
+  // tests can check what the solver receives. Nonlinear parts are added
+  // evaluated at the same point.
+  void DoSolve(ASLProblem &p, SolutionHandler &sh) {
+    int num_vars = p.num_vars(), num_cons = p.num_algebraic_cons();
+    if (num_vars == 0)
+      return;
+    std::vector<double> values(num_vars);
+    for (int j = 0; j < num_vars; ++j)
+      values[j] = p.var(j).lb();
+    std::vector<double> dual_values(num_cons + 1);
+    for (int i = 0; i < num_cons; ++i) {
+      asl::LinearConExpr expr = p.algebraic_con(i).linear_expr();
+      for (asl::LinearConExpr::iterator
+           j = expr.begin(), end = expr.end(); j != end; ++j) {
+        dual_values[i] += j->coef() * (j->var_index() + 1);
+      }
+      if (asl::NumericExpr e = p.algebraic_con(i).nonlinear_expr())
+        dual_values[i] += Eval(e);
+    }
+    double obj_value = 0;
+    if (p.num_objs() != 0) {
+      asl::LinearObjExpr expr = p.obj(0).linear_expr();
+      for (asl::LinearObjExpr::iterator
+           j = expr.begin(), end = expr.end(); j != end; ++j) {
+        obj_value += j->coef() * (j->var_index() + 1);
+      }
+      if (asl::NumericExpr e = p.obj(0).nonlinear_expr())
+        obj_value += Eval(e);
+      if (p.obj(0).type() == obj::MAX)
+        obj_value = -obj_value;
+    }
+    sh.HandleSolution(0, "test", &values[0], &dual_values[0], obj_value);
+  }
 
   std::string GetOption(const SolverOption &) const { return ""; }
   void SetOption(const SolverOption &, fmt::StringRef ) {
@@ -0,0 +1,237 @@
+/*
+ Batch evaluator tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/batch-eval.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::LogicalExpr;
+using mp::Tape;
+using mp::TapeEvaluator;
+using mp::BatchEvaluator;
+
+namespace ex = mp::expr;
+
+class BatchEvalTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y, z, w;
+
+  enum {NUM_VARS = 4};
+
+  BatchEvalTest() {
+    for (int i = 0; i < NUM_VARS; ++i)
+      p.AddVar(0, 0);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+    z = p.MakeVariable(2);
+    w = p.MakeVariable(3);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  NumericExpr MakeIf(LogicalExpr e) {
+    return p.MakeIf(e, MakeConst(1), MakeConst(0));
+  }
+
+  NumericExpr MakeIterated(ex::Kind kind) {
+    Problem::IteratedExprBuilder b = p.BeginIterated(kind, 3);
+    b.AddArg(x);
+    b.AddArg(p.MakeUnary(ex::MINUS, w));
+    b.AddArg(z);
+    return p.EndIterated(b);
+  }
+
+  LogicalExpr MakeIteratedLogical(ex::Kind kind) {
+    Problem::IteratedLogicalExprBuilder b = p.BeginIteratedLogical(kind, 2);
+    b.AddArg(p.MakeRelational(ex::GT, z, MakeConst(0)));
+    b.AddArg(p.MakeRelational(ex::LT, w, MakeConst(0)));
+    return p.EndIteratedLogical(b);
+  }
+
+  // Adds constraints with expressions of all kinds supported by tapes.
+  void AddCons() {
+    const ex::Kind unary[] = {
+      ex::MINUS, ex::ABS, ex::FLOOR, ex::CEIL, ex::SQRT, ex::POW2, ex::EXP,
+      ex::LOG, ex::LOG10, ex::SIN, ex::SINH, ex::COS, ex::COSH, ex::TAN,
+      ex::TANH, ex::ASIN, ex::ASINH, ex::ACOS, ex::ATAN, ex::ATANH
+    };
+    for (std::size_t i = 0; i < sizeof(unary) / sizeof(*unary); ++i)
+      p.AddCon(0, 0, p.MakeUnary(unary[i], x));
+    p.AddCon(0, 0, p.MakeUnary(ex::ACOSH, y));
+    p.AddCon(0, 0, p.MakeUnary(ex::FLOOR, w));
+    const ex::Kind binary[] = {
+      ex::ADD, ex::SUB, ex::LESS, ex::MUL, ex::DIV, ex::INT_DIV, ex::MOD,
+      ex::POW, ex::ATAN2, ex::PRECISION, ex::ROUND, ex::TRUNC
+    };
+    for (std::size_t i = 0; i < sizeof(binary) / sizeof(*binary); ++i) {
+      p.AddCon(0, 0, p.MakeBinary(binary[i], w, y));
+      p.AddCon(0, 0, p.MakeBinary(binary[i], y, w));
+    }
+    p.AddCon(0, 0, p.MakeBinary(ex::POW_CONST_BASE, MakeConst(2), w));
+    p.AddCon(0, 0, p.MakeBinary(ex::POW_CONST_EXP, y, MakeConst(3)));
+    const ex::Kind iterated[] = {ex::MIN, ex::MAX, ex::SUM};
+    for (std::size_t i = 0; i < sizeof(iterated) / sizeof(*iterated); ++i)
+      p.AddCon(0, 0, MakeIterated(iterated[i]));
+    Problem::NumberOfExprBuilder numberof = p.BeginNumberOf(3, z);
+    numberof.AddArg(x);
+    numberof.AddArg(MakeConst(1));
+    p.AddCon(0, 0, p.EndNumberOf(numberof));
+    Problem::CountExprBuilder count = p.BeginCount(2);
+    count.AddArg(p.MakeRelational(ex::GT, z, MakeConst(0)));
+    count.AddArg(p.MakeRelational(ex::LT, w, MakeConst(0)));
+    mp::CountExpr count_expr = p.EndCount(count);
+    p.AddCon(0, 0, count_expr);
+    Problem::PLTermBuilder plterm = p.BeginPLTerm(1);
+    plterm.AddSlope(-1);
+    plterm.AddBreakpoint(0.5);
+    plterm.AddSlope(2);
+    p.AddCon(0, 0, p.EndPLTerm(plterm, p.MakeVariable(3)));
+    LogicalExpr lt = p.MakeRelational(ex::LT, x, z);
+    LogicalExpr ge = p.MakeRelational(ex::GE, w, MakeConst(0));
+    p.AddCon(0, 0, p.MakeIf(lt, y, p.MakeUnary(ex::EXP, w)));
+    const ex::Kind relational[] = {
+      ex::LT, ex::LE, ex::EQ, ex::GE, ex::GT, ex::NE
+    };
+    for (std::size_t i = 0; i < sizeof(relational) / sizeof(*relational); ++i)
+      p.AddCon(0, 0, MakeIf(p.MakeRelational(relational[i], z, MakeConst(1))));
+    p.AddCon(0, 0, MakeIf(p.MakeNot(lt)));
+    const ex::Kind logical[] = {ex::OR, ex::AND, ex::IFF};
+    for (std::size_t i = 0; i < sizeof(logical) / sizeof(*logical); ++i)
+      p.AddCon(0, 0, MakeIf(p.MakeBinaryLogical(logical[i], lt, ge)));
+    p.AddCon(0, 0, MakeIf(p.MakeImplication(lt, ge, p.MakeNot(ge))));
+    const ex::Kind count_kinds[] = {
+      ex::ATLEAST, ex::ATMOST, ex::EXACTLY,
+      ex::NOT_ATLEAST, ex::NOT_ATMOST, ex::NOT_EXACTLY
+    };
+    for (std::size_t i = 0;
+         i < sizeof(count_kinds) / sizeof(*count_kinds); ++i) {
+      p.AddCon(0, 0, MakeIf(
+                 p.MakeLogicalCount(count_kinds[i], MakeConst(1), count_expr)));
+    }
+    p.AddCon(0, 0, MakeIf(MakeIteratedLogical(ex::EXISTS)));
+    p.AddCon(0, 0, MakeIf(MakeIteratedLogical(ex::FORALL)));
+    const ex::Kind pairwise[] = {ex::ALLDIFF, ex::NOT_ALLDIFF};
+    for (std::size_t i = 0; i < sizeof(pairwise) / sizeof(*pairwise); ++i) {
+      Problem::PairwiseExprBuilder b = p.BeginPairwise(pairwise[i], 3);
+      b.AddArg(z);
+      b.AddArg(MakeConst(1));
+      b.AddArg(p.MakeUnary(ex::FLOOR, w));
+      p.AddCon(0, 0, MakeIf(p.EndPairwise(b)));
+    }
+    Problem::LinearConBuilder con =
+        p.AddCon(0, 0, p.MakeBinary(ex::MUL, x, y), 2);
+    con.AddTerm(2, 3);
+    con.AddTerm(3, -0.5);
+  }
+
+  // Checks that batch evaluation at num_points points gives the same
+  // results as evaluation at each point separately.
+  void CheckBatch(int num_points, BatchEvaluator::InstructionSet isa) {
+    Tape tape(p);
+    BatchEvaluator batch(tape, isa);
+    TapeEvaluator eval(tape);
+    std::vector<double> x(NUM_VARS * num_points);
+    for (int i = 0; i < num_points; ++i) {
+      x[i] = 0.1 + 0.8 * (i % 9) / 9;
+      x[num_points + i] = 1.1 + 0.3 * (i % 7);
+      x[2 * num_points + i] = i % 3;
+      x[3 * num_points + i] = -2 + 0.35 * (i % 13);
+    }
+    int num_cons = tape.num_cons(), num_objs = tape.num_objs();
+    std::vector<double> con_values(num_points * num_cons + 1);
+    std::vector<double> obj_values(num_points * num_objs + 1);
+    batch.Evaluate(num_points, x.data(), con_values.data(), obj_values.data());
+    double point[NUM_VARS];
+    for (int i = 0; i < num_points; ++i) {
+      for (int j = 0; j < NUM_VARS; ++j)
+        point[j] = x[j * num_points + i];
+      eval.Evaluate(point);
+      for (int j = 0; j < num_cons; ++j) {
+        double value = eval.con_value(j);
+        double batch_value = con_values[i * num_cons + j];
+        if (value != value)
+          EXPECT_NE(batch_value, batch_value);
+        else
+          EXPECT_EQ(value, batch_value) << "point " << i << ", con " << j;
+      }
+      for (int j = 0; j < num_objs; ++j)
+        EXPECT_EQ(eval.obj_value(j), obj_values[i * num_objs + j]);
+    }
+  }
+};
+
+TEST_F(BatchEvalTest, InstructionSet) {
+  Tape tape(p);
+  EXPECT_TRUE(BatchEvaluator::IsSupported(BatchEvaluator::AUTO));
+  EXPECT_TRUE(BatchEvaluator::IsSupported(BatchEvaluator::GENERIC));
+  EXPECT_NE(BatchEvaluator::AUTO, BatchEvaluator(tape).instruction_set());
+  EXPECT_EQ(BatchEvaluator::GENERIC,
+            BatchEvaluator(tape, BatchEvaluator::GENERIC).instruction_set());
+  if (!BatchEvaluator::IsSupported(BatchEvaluator::AVX512)) {
+    EXPECT_THROW(BatchEvaluator(tape, BatchEvaluator::AVX512), mp::Error);
+  }
+}
+
+TEST_F(BatchEvalTest, AllKinds) {
+  AddCons();
+  const BatchEvaluator::InstructionSet isas[] = {
+    BatchEvaluator::GENERIC, BatchEvaluator::AVX2, BatchEvaluator::AVX512
+  };
+  const int num_points[] = {
+    1, BatchEvaluator::BLOCK_SIZE - 1, BatchEvaluator::BLOCK_SIZE,
+    3 * BatchEvaluator::BLOCK_SIZE + 5
+  };
+  for (std::size_t i = 0; i < sizeof(isas) / sizeof(*isas); ++i) {
+    if (!BatchEvaluator::IsSupported(isas[i]))
+      continue;
+    for (std::size_t j = 0; j < sizeof(num_points) / sizeof(*num_points); ++j) {
+      SCOPED_TRACE(testing::Message() << "isa " << isas[i]
+                   << ", points " << num_points[j]);
+      CheckBatch(num_points[j], isas[i]);
+    }
+  }
+}
+
+TEST_F(BatchEvalTest, Objectives) {
+  p.AddObj(mp::obj::MIN, p.MakeUnary(ex::POW2, x), 1).AddTerm(1, 2);
+  p.AddObj(mp::obj::MAX, p.MakeUnary(ex::SQRT, y));
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, x, y));
+  Tape tape(p);
+  BatchEvaluator batch(tape);
+  // Two points in structure-of-arrays layout.
+  double values[] = {3, 4, 9, 16, 0, 0, 0, 0};
+  double con_values[2] = {}, obj_values[4] = {};
+  batch.Evaluate(2, values, con_values, obj_values);
+  EXPECT_EQ(27, con_values[0]);
+  EXPECT_EQ(64, con_values[1]);
+  EXPECT_EQ(27, obj_values[0]);
+  EXPECT_EQ(3, obj_values[1]);
+  EXPECT_EQ(48, obj_values[2]);
+  EXPECT_EQ(4, obj_values[3]);
+  batch.Evaluate(0, values, con_values);
+}
@@ -0,0 +1,467 @@
+/*
+ Benchmarks of the .nl reader, expression factory, expression evaluation
+ and solution writer.
+
+ Usage: mp-bench [-n num_cons] [-t min_time] [filter]
+
+ Each benchmark is run repeatedly until it takes at least min_time
+ seconds (default 0.5) and the time per operation, throughput and number
+ of allocations per operation are reported. Synthetic problems have
+ num_cons constraints (default 10000). Only benchmarks with names
+ containing filter are run.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "mp/batch-eval.h"
+#include "mp/clock.h"
+#include "mp/hessian.h"
+#include "mp/jacobian.h"
+#include "mp/nl.h"
+#include "mp/parallel-eval.h"
+#include "mp/posix.h"
+#include "mp/problem.h"
+#include "mp/problem-builder.h"
+#include "mp/sol.h"
+#include "mp/tape.h"
+#include "nl-generator.h"
+
+namespace {
+// The number of allocations done with the global operator new.
+fmt::ULongLong num_allocs;
+}
+
+void *operator new(std::size_t size) {
+  ++num_allocs;
+  if (void *p = std::malloc(size != 0 ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) throw() { std::free(p); }
+
+namespace {
+
+// Generates a synthetic problem with num_cons constraints in the .nl format.
+std::string GenerateNL(int num_cons, bool binary) {
+  mp::NLGeneratorParams params;
+  params.binary = binary;
+  params.num_vars = num_cons + 10;
+  params.num_nl_vars = params.num_vars / 2;
+  params.num_cons = num_cons;
+  params.num_nl_cons = num_cons / 2;
+  params.num_nonzeros = 5 * static_cast<fmt::LongLong>(num_cons);
+  return mp::GenerateNL(params);
+}
+
+// A benchmark.
+class Benchmark {
+ private:
+  const char *name_;
+
+ protected:
+  std::size_t bytes_;  // Number of bytes processed per iteration.
+  int num_ops_;        // Number of operations per iteration.
+
+ public:
+  explicit Benchmark(const char *name)
+    : name_(name), bytes_(0), num_ops_(1) {}
+  virtual ~Benchmark() {}
+
+  const char *name() const { return name_; }
+  std::size_t bytes() const { return bytes_; }
+  int num_ops() const { return num_ops_; }
+
+  // Runs a single iteration of the benchmark.
+  virtual void Run() = 0;
+};
+
+// Inputs shared between benchmarks.
+struct Inputs {
+  std::string text, binary;
+  mp::Problem problem;
+  int num_cons;
+
+  explicit Inputs(int num_cons)
+    : text(GenerateNL(num_cons, false)), binary(GenerateNL(num_cons, true)),
+      num_cons(num_cons) {
+    mp::ProblemBuilderToNLAdapter<mp::Problem> adapter(problem);
+    mp::ReadNLString(text, adapter);
+  }
+};
+
+// Measures reading of .nl input without building a problem.
+// An operation is reading a constraint.
+class ReadBenchmark : public Benchmark {
+ private:
+  const std::string &input_;
+
+ public:
+  ReadBenchmark(const char *name, const std::string &input, int num_cons)
+    : Benchmark(name), input_(input) {
+    bytes_ = input.size();
+    num_ops_ = num_cons;
+  }
+
+  void Run() {
+    mp::NLHandler<int> handler;
+    mp::ReadNLString(input_, handler);
+  }
+};
+
+// Measures reading of .nl input into mp::Problem through
+// ProblemBuilderToNLAdapter. An operation is reading a constraint.
+class BuildBenchmark : public Benchmark {
+ private:
+  const std::string &input_;
+
+ public:
+  BuildBenchmark(const char *name, const std::string &input, int num_cons)
+    : Benchmark(name), input_(input) {
+    bytes_ = input.size();
+    num_ops_ = num_cons;
+  }
+
+  void Run() {
+    mp::Problem problem;
+    mp::ProblemBuilderToNLAdapter<mp::Problem> adapter(problem);
+    mp::ReadNLString(input_, adapter);
+  }
+};
+
+// Measures creation of binary expression nodes with BasicExprFactory.
+// An operation is creating a node.
+class BinaryExprBenchmark : public Benchmark {
+ public:
+  enum {NUM_EXPRS = 10000};
+
+  BinaryExprBenchmark() : Benchmark("expr-factory/binary") {
+    num_ops_ = 3 * NUM_EXPRS;
+  }
+
+  void Run() {
+    mp::ExprFactory factory;
+    for (int i = 0; i < NUM_EXPRS; ++i) {
+      factory.MakeBinary(mp::expr::MUL, factory.MakeVariable(i),
+                         factory.MakeNumericConstant(i));
+    }
+  }
+};
+
+// Measures creation of iterated expressions with BasicExprFactory.
+// An operation is creating a node.
+class IteratedExprBenchmark : public Benchmark {
+ public:
+  enum {NUM_EXPRS = 1000, NUM_ARGS = 10};
+
+  IteratedExprBenchmark() : Benchmark("expr-factory/sum") {
+    num_ops_ = NUM_EXPRS * (NUM_ARGS + 1);
+  }
+
+  void Run() {
+    mp::ExprFactory factory;
+    for (int i = 0; i < NUM_EXPRS; ++i) {
+      mp::ExprFactory::IteratedExprBuilder builder =
+          factory.BeginIterated(mp::expr::SUM, NUM_ARGS);
+      for (int j = 0; j < NUM_ARGS; ++j)
+        builder.AddArg(factory.MakeVariable(j));
+      factory.EndIterated(builder);
+    }
+  }
+};
+
+// Measures formatting of constraint expressions with ExprWriter.
+// An operation is formatting a nonlinear constraint expression.
+class ExprWriterBenchmark : public Benchmark {
+ private:
+  const mp::Problem &problem_;
+
+ public:
+  explicit ExprWriterBenchmark(const mp::Problem &p)
+    : Benchmark("expr-writer"), problem_(p) {
+    num_ops_ = 0;
+    for (int i = 0, n = p.num_algebraic_cons(); i < n; ++i) {
+      if (p.algebraic_con(i).nonlinear_expr())
+        ++num_ops_;
+    }
+    fmt::MemoryWriter w;
+    Write(w);
+    bytes_ = w.size();
+  }
+
+  void Write(fmt::MemoryWriter &w) {
+    for (int i = 0, n = problem_.num_algebraic_cons(); i < n; ++i) {
+      if (mp::NumericExpr e = problem_.algebraic_con(i).nonlinear_expr())
+        w.write("{}\n", e);
+    }
+  }
+
+  void Run() {
+    fmt::MemoryWriter w;
+    Write(w);
+  }
+};
+
+// Measures evaluation of all objectives and constraints with TapeEvaluator.
+// An operation is evaluating a constraint.
+class TapeBenchmark : public Benchmark {
+ private:
+  mp::Tape tape_;
+  mp::TapeEvaluator eval_;
+  std::vector<double> x_;
+
+ public:
+  explicit TapeBenchmark(const mp::Problem &p)
+    : Benchmark("eval/tape"), tape_(p), eval_(tape_), x_(p.num_vars(), 0.5) {
+    num_ops_ = p.num_algebraic_cons();
+  }
+
+  void Run() { eval_.Evaluate(&x_[0]); }
+};
+
+// Measures evaluation of all objectives and constraints at many points
+// with BatchEvaluator. An operation is evaluating a constraint at a point.
+class BatchBenchmark : public Benchmark {
+ private:
+  enum {NUM_POINTS = 4 * mp::BatchEvaluator::BLOCK_SIZE};
+
+  mp::Tape tape_;
+  mp::BatchEvaluator batch_;
+  std::vector<double> x_;
+  std::vector<double> con_values_;
+
+ public:
+  explicit BatchBenchmark(const mp::Problem &p)
+    : Benchmark("eval/batch"), tape_(p), batch_(tape_),
+      x_(p.num_vars() * NUM_POINTS + 1),
+      con_values_(p.num_algebraic_cons() * NUM_POINTS + 1) {
+    num_ops_ = p.num_algebraic_cons() * NUM_POINTS;
+    for (std::size_t i = 0; i < x_.size(); ++i)
+      x_[i] = 0.25 + 0.5 * (i % NUM_POINTS) / NUM_POINTS;
+  }
+
+  void Run() { batch_.Evaluate(NUM_POINTS, &x_[0], &con_values_[0]); }
+};
+
+// Measures computation of the constraint Jacobian with JacobianEvaluator.
+// An operation is computing derivatives of a constraint.
+class JacobianBenchmark : public Benchmark {
+ private:
+  mp::Tape tape_;
+  mp::JacobianEvaluator jac_;
+  std::vector<double> values_;
+
+ public:
+  explicit JacobianBenchmark(const mp::Problem &p)
+    : Benchmark("eval/jacobian"), tape_(p), jac_(tape_),
+      values_(jac_.num_jac_nonzeros() + 1) {
+    num_ops_ = p.num_algebraic_cons();
+    std::vector<double> x(p.num_vars(), 0.5);
+    jac_.Evaluate(&x[0]);
+  }
+
+  void Run() { jac_.GetJacobian(&values_[0]); }
+};
+
+// Measures computation of constraint values and the constraint Jacobian
+// with ParallelEvaluator on all hardware threads. An operation is
+// evaluating a constraint and its derivatives.
+class ParallelJacobianBenchmark : public Benchmark {
+ private:
+  mp::Tape tape_;
+  mp::ThreadPool pool_;
+  mp::ParallelEvaluator eval_;
+  std::vector<double> x_;
+  std::vector<double> values_;
+  std::vector<double> con_values_;
+
+ public:
+  explicit ParallelJacobianBenchmark(const mp::Problem &p)
+    : Benchmark("eval/parallel-jacobian"), tape_(p), eval_(tape_, pool_),
+      x_(p.num_vars() + 1, 0.5),
+      values_(eval_.jacobian().num_jac_nonzeros() + 1),
+      con_values_(p.num_algebraic_cons() + 1) {
+    num_ops_ = p.num_algebraic_cons();
+  }
+
+  void Run() { eval_.GetJacobian(&x_[0], &values_[0], &con_values_[0]); }
+};
+
+// Measures computation of the Hessian of the Lagrangian with
+// HessianEvaluator. An operation is computing the contribution of
+// a constraint.
+class HessianBenchmark : public Benchmark {
+ private:
+  mp::Tape tape_;
+  mp::HessianEvaluator hes_;
+  std::vector<double> obj_weights_;
+  std::vector<double> multipliers_;
+  std::vector<double> values_;
+
+ public:
+  explicit HessianBenchmark(const mp::Problem &p)
+    : Benchmark("eval/hessian"), tape_(p), hes_(tape_),
+      obj_weights_(p.num_objs() + 1, 1),
+      multipliers_(p.num_algebraic_cons() + 1, 1),
+      values_(hes_.num_nonzeros() + 1) {
+    num_ops_ = p.num_algebraic_cons();
+    std::vector<double> x(p.num_vars(), 0.5);
+    hes_.Evaluate(&x[0]);
+  }
+
+  void Run() {
+    hes_.GetHessian(&obj_weights_[0], &multipliers_[0], &values_[0]);
+  }
+};
+
+// A solution with values of all variables and constraints set to 1.
+class Solution {
+ private:
+  int num_values_;
+  int num_dual_values_;
+
+ public:
+  Solution(int num_values, int num_dual_values)
+    : num_values_(num_values), num_dual_values_(num_dual_values) {}
+
+  int status() const { return 0; }
+  const char *message() const { return "mp-bench"; }
+
+  int num_options() const { return 0; }
+  int option(int) const { return 0; }
+
+  int num_values() const { return num_values_; }
+  double value(int) const { return 1; }
+
+  int num_dual_values() const { return num_dual_values_; }
+  double dual_value(int) const { return 1; }
+
+  const mp::SuffixSet *suffixes(int) const { return 0; }
+};
+
+// Measures writing of .sol files. An operation is writing a value.
+class SolWriterBenchmark : public Benchmark {
+ private:
+  Solution sol_;
+
+ public:
+  explicit SolWriterBenchmark(const mp::Problem &p)
+    : Benchmark("sol-writer"),
+      sol_(p.num_vars(), p.num_algebraic_cons()) {
+    num_ops_ = p.num_vars() + p.num_algebraic_cons();
+    Run();
+    bytes_ = fmt::File(filename(), fmt::File::RDONLY).size();
+  }
+
+  ~SolWriterBenchmark() { std::remove(filename()); }
+
+  static const char *filename() { return "mp-bench.sol"; }
+
+  void Run() { mp::WriteSolFile(filename(), sol_); }
+};
+
+void RunBenchmark(Benchmark &b, double min_time) {
+  b.Run();  // Warm up.
+  int num_iterations = 1;
+  double time = 0;
+  fmt::ULongLong allocs = 0;
+  for (;;) {
+    fmt::ULongLong start_allocs = num_allocs;
+    mp::steady_clock::time_point start = mp::steady_clock::now();
+    for (int i = 0; i < num_iterations; ++i)
+      b.Run();
+    time = mp::GetTimeAndReset(start);
+    allocs = num_allocs - start_allocs;
+    if (time >= min_time || num_iterations > INT_MAX / 2)
+      break;
+    num_iterations *= 2;
+  }
+  double num_ops = static_cast<double>(num_iterations) * b.num_ops();
+  fmt::print("{:<24} {:>10} {:>14.1f} ns/op", b.name(), num_iterations,
+             time * 1e9 / num_ops);
+  if (b.bytes() != 0) {
+    double bytes = static_cast<double>(num_iterations) * b.bytes();
+    fmt::print(" {:>10.2f} MB/s", bytes / time / 1e6);
+  } else {
+    fmt::print(" {:>10} MB/s", "-");
+  }
+  fmt::print(" {:>10.3f} allocs/op\n", allocs / num_ops);
+  std::fflush(stdout);
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  int num_cons = 10000;
+  double min_time = 0.5;
+  const char *filter = "";
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (std::strcmp(arg, "-n") == 0 && i + 1 < argc) {
+      num_cons = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "-t") == 0 && i + 1 < argc) {
+      min_time = std::atof(argv[++i]);
+    } else if (arg[0] != '-') {
+      filter = arg;
+    } else {
+      fmt::print(stderr, "usage: mp-bench [-n num_cons] [-t min_time] "
+                 "[filter]\n");
+      return 1;
+    }
+  }
+  if (num_cons <= 0) {
+    fmt::print(stderr, "invalid number of constraints\n");
+    return 1;
+  }
+
+  Inputs inputs(num_cons);
+  fmt::print("Problem: {} constraints, text: {} bytes, binary: {} bytes\n",
+             num_cons, inputs.text.size(), inputs.binary.size());
+
+  ReadBenchmark read_text("read/text", inputs.text, num_cons);
+  ReadBenchmark read_binary("read/binary", inputs.binary, num_cons);
+  BuildBenchmark build_text("build/text", inputs.text, num_cons);
+  BuildBenchmark build_binary("build/binary", inputs.binary, num_cons);
+  BinaryExprBenchmark binary_expr;
+  IteratedExprBenchmark iterated_expr;
+  ExprWriterBenchmark expr_writer(inputs.problem);
+  TapeBenchmark tape(inputs.problem);
+  BatchBenchmark batch(inputs.problem);
+  JacobianBenchmark jacobian(inputs.problem);
+  ParallelJacobianBenchmark parallel_jacobian(inputs.problem);
+  HessianBenchmark hessian(inputs.problem);
+  SolWriterBenchmark sol_writer(inputs.problem);
+  Benchmark *benchmarks[] = {
+    &read_text, &read_binary, &build_text, &build_binary,
+    &binary_expr, &iterated_expr, &expr_writer, &tape, &batch, &jacobian,
+    &parallel_jacobian, &hessian, &sol_writer
+  };
+  for (std::size_t i = 0, n = sizeof(benchmarks) / sizeof(*benchmarks);
+       i < n; ++i) {
+    if (std::strstr(benchmarks[i]->name(), filter))
+      RunBenchmark(*benchmarks[i], min_time);
+  }
+}
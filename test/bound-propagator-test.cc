@@ -0,0 +1,256 @@
+/*
+ Bound propagator tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "mp/bound-propagator.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::LogicalExpr;
+using mp::Interval;
+using mp::IntervalEvaluator;
+using mp::BoundPropagator;
+
+namespace ex = mp::expr;
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+class BoundPropagatorTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y;
+
+  BoundPropagatorTest() {
+    p.AddVar(-INF, INF);
+    p.AddVar(-INF, INF);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  // Propagates constraints of p and returns the bounds on variable var.
+  Interval Propagate(int var = 0) {
+    BoundPropagator bp(p);
+    EXPECT_TRUE(bp.Propagate());
+    return bp.var_bounds(var);
+  }
+};
+
+::testing::AssertionResult Near(Interval expected, Interval actual) {
+  const double EPS = 1e-6;
+  if (std::fabs(expected.lb - actual.lb) <= EPS * (1 + std::fabs(actual.lb)) ||
+      expected.lb == actual.lb) {
+    if (std::fabs(expected.ub - actual.ub) <=
+        EPS * (1 + std::fabs(actual.ub)) || expected.ub == actual.ub)
+      return ::testing::AssertionSuccess();
+  }
+  return ::testing::AssertionFailure()
+      << "expected [" << expected.lb << ", " << expected.ub << "], actual ["
+      << actual.lb << ", " << actual.ub << "]";
+}
+}
+
+TEST_F(BoundPropagatorTest, EvaluateIntervals) {
+  Interval bounds[] = {Interval(1, 2), Interval(-1, 3)};
+  IntervalEvaluator eval(p, bounds);
+  EXPECT_EQ(Interval(-2, 6), eval.Evaluate(p.MakeBinary(ex::MUL, x, y)));
+  ASSERT_EQ(3u, eval.nodes().size());
+  EXPECT_EQ(3, eval.nodes()[0].end);
+  EXPECT_EQ(Interval(1, 2), eval.nodes()[1].value);
+  EXPECT_EQ(Interval(-1, 3), eval.nodes()[2].value);
+  EXPECT_EQ(Interval(0, 9), eval.Evaluate(p.MakeUnary(ex::POW2, y)));
+  EXPECT_EQ(Interval(1),
+            eval.Evaluate(p.MakeRelational(ex::GT, x, MakeConst(0))));
+  EXPECT_EQ(Interval(0, 1),
+            eval.Evaluate(p.MakeRelational(ex::GT, y, MakeConst(0))));
+  LogicalExpr conds[] = {
+    p.MakeRelational(ex::GE, x, MakeConst(1)),
+    p.MakeRelational(ex::GE, y, MakeConst(1)),
+    p.MakeRelational(ex::GE, y, MakeConst(5))
+  };
+  Problem::CountExprBuilder b = p.BeginCount(3);
+  for (int i = 0; i < 3; ++i)
+    b.AddArg(conds[i]);
+  EXPECT_EQ(Interval(1, 2), eval.Evaluate(p.EndCount(b)));
+}
+
+TEST_F(BoundPropagatorTest, EvaluatePLTerm) {
+  Problem::PLTermBuilder b = p.BeginPLTerm(2);
+  b.AddSlope(-1);
+  b.AddBreakpoint(0);
+  b.AddSlope(0.5);
+  b.AddBreakpoint(1);
+  b.AddSlope(2);
+  NumericExpr e = p.EndPLTerm(b, p.MakeVariable(0));
+  Interval bounds[] = {Interval(-3, 2), Interval()};
+  IntervalEvaluator eval(p, bounds);
+  EXPECT_EQ(Interval(0, 3), eval.Evaluate(e));
+  bounds[0] = Interval(0.5, INF);
+  EXPECT_EQ(Interval(0.25, INF), eval.Evaluate(e));
+}
+
+TEST_F(BoundPropagatorTest, Linear) {
+  p.AddVar(0, 10);
+  // 2 * x + y - z <= 4, x >= 0, y >= 1
+  Problem::LinearConBuilder con = p.AddCon(-INF, 4, 3);
+  con.AddTerm(0, 2);
+  con.AddTerm(1, 1);
+  con.AddTerm(2, -1);
+  p.AddCon(0, INF, x);
+  p.AddCon(1, INF, y);
+  BoundPropagator bp(p);
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_TRUE(Near(Interval(0, 6.5), bp.var_bounds(0)));
+  EXPECT_TRUE(Near(Interval(1, 14), bp.var_bounds(1)));
+  EXPECT_TRUE(Near(Interval(0, 10), bp.var_bounds(2)));
+  EXPECT_GT(bp.num_tightenings(), 0);
+}
+
+TEST_F(BoundPropagatorTest, Nonlinear) {
+  // x^2 <= 4, exp(y) <= 1
+  p.AddCon(-INF, 4, p.MakeUnary(ex::POW2, x));
+  p.AddCon(-INF, 1, p.MakeUnary(ex::EXP, y));
+  BoundPropagator bp(p);
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_TRUE(Near(Interval(-2, 2), bp.var_bounds(0)));
+  EXPECT_TRUE(Near(Interval(-INF, 0), bp.var_bounds(1)));
+}
+
+TEST_F(BoundPropagatorTest, Chain) {
+  // x * y == 6, 2 <= x <= 3, 1 <= y
+  p.AddCon(6, 6, p.MakeBinary(ex::MUL, x, y));
+  p.AddCon(2, 3, x);
+  p.AddCon(1, INF, y);
+  BoundPropagator bp(p);
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_TRUE(Near(Interval(2, 3), bp.var_bounds(0)));
+  EXPECT_TRUE(Near(Interval(2, 3), bp.var_bounds(1)));
+}
+
+TEST_F(BoundPropagatorTest, PowConstExp) {
+  // x^3 >= 8, y^4 <= 16
+  p.AddCon(8, INF, p.MakeBinary(ex::POW_CONST_EXP, x, MakeConst(3)));
+  p.AddCon(-INF, 16, p.MakeBinary(ex::POW_CONST_EXP, y, MakeConst(4)));
+  BoundPropagator bp(p);
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_TRUE(Near(Interval(2, INF), bp.var_bounds(0)));
+  EXPECT_TRUE(Near(Interval(-2, 2), bp.var_bounds(1)));
+}
+
+TEST_F(BoundPropagatorTest, IfExpr) {
+  // if y >= 0 then x else x + 10 in [0, 1], y >= 1
+  p.AddCon(0, 1, p.MakeIf(p.MakeRelational(ex::GE, y, MakeConst(0)), x,
+                          p.MakeBinary(ex::ADD, x, MakeConst(10))));
+  p.AddCon(1, INF, y);
+  EXPECT_TRUE(Near(Interval(0, 1), Propagate()));
+}
+
+TEST_F(BoundPropagatorTest, MinMax) {
+  // min(x, y) >= 1, max(x, y) <= 3
+  Problem::IteratedExprBuilder min = p.BeginIterated(ex::MIN, 2);
+  min.AddArg(x);
+  min.AddArg(y);
+  p.AddCon(1, INF, p.EndIterated(min));
+  Problem::IteratedExprBuilder max = p.BeginIterated(ex::MAX, 2);
+  max.AddArg(x);
+  max.AddArg(y);
+  p.AddCon(-INF, 3, p.EndIterated(max));
+  EXPECT_TRUE(Near(Interval(1, 3), Propagate(0)));
+  EXPECT_TRUE(Near(Interval(1, 3), Propagate(1)));
+}
+
+TEST_F(BoundPropagatorTest, PLTerm) {
+  Problem::PLTermBuilder b = p.BeginPLTerm(1);
+  b.AddSlope(-1);
+  b.AddBreakpoint(0);
+  b.AddSlope(2);
+  // |x| with slopes -1 and 2 <= 4
+  p.AddCon(-INF, 4, p.EndPLTerm(b, p.MakeVariable(0)));
+  EXPECT_TRUE(Near(Interval(-4, 2), Propagate()));
+}
+
+TEST_F(BoundPropagatorTest, LogicalCon) {
+  // x >= 1 && (y <= 2 || x <= 0)
+  p.AddCon(p.MakeBinaryLogical(
+      ex::AND, p.MakeRelational(ex::GE, x, MakeConst(1)),
+      p.MakeBinaryLogical(ex::OR, p.MakeRelational(ex::LE, y, MakeConst(2)),
+                          p.MakeRelational(ex::LE, x, MakeConst(0)))));
+  EXPECT_TRUE(Near(Interval(1, INF), Propagate(0)));
+  EXPECT_TRUE(Near(Interval(-INF, 2), Propagate(1)));
+}
+
+TEST_F(BoundPropagatorTest, Count) {
+  // count(x >= 1, y >= 1) >= 2
+  Problem::CountExprBuilder b = p.BeginCount(2);
+  b.AddArg(p.MakeRelational(ex::GE, x, MakeConst(1)));
+  b.AddArg(p.MakeRelational(ex::GE, y, MakeConst(1)));
+  p.AddCon(2, INF, p.EndCount(b));
+  EXPECT_TRUE(Near(Interval(1, INF), Propagate(0)));
+  EXPECT_TRUE(Near(Interval(1, INF), Propagate(1)));
+}
+
+TEST_F(BoundPropagatorTest, CommonExpr) {
+  // e = 2 * y + x^2, e <= 4, y >= 0
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+  linear.AddTerm(1, 2);
+  p.EndCommonExpr(linear, p.MakeUnary(ex::POW2, x), 1);
+  p.AddCon(-INF, 4, p.MakeCommonExpr(0));
+  p.AddCon(0, INF, y);
+  EXPECT_TRUE(Near(Interval(-2, 2), Propagate(0)));
+  EXPECT_TRUE(Near(Interval(0, 2), Propagate(1)));
+}
+
+TEST_F(BoundPropagatorTest, IntegerVars) {
+  p.AddVar(-INF, INF, mp::var::INTEGER);
+  // 3 * z <= 10, z >= 0.5
+  p.AddCon(-INF, 10, 1).AddTerm(2, 3);
+  p.AddCon(0.5, INF, 1).AddTerm(2, 1);
+  EXPECT_EQ(Interval(1, 3), Propagate(2));
+}
+
+TEST_F(BoundPropagatorTest, Infeasible) {
+  // x >= 2, x^2 <= 1
+  p.AddCon(2, INF, x);
+  p.AddCon(-INF, 1, p.MakeUnary(ex::POW2, x));
+  BoundPropagator bp(p);
+  EXPECT_FALSE(bp.Propagate());
+}
+
+TEST_F(BoundPropagatorTest, SetVarBounds) {
+  // x + y == 1
+  Problem::LinearConBuilder con = p.AddCon(1, 1, 2);
+  con.AddTerm(0, 1);
+  con.AddTerm(1, 1);
+  BoundPropagator bp(p);
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_EQ(Interval(), bp.var_bounds(1));
+  bp.SetVarBounds(0, Interval(0, 1));
+  EXPECT_TRUE(bp.Propagate());
+  EXPECT_TRUE(Near(Interval(0, 1), bp.var_bounds(1)));
+}
@@ -68,12 +68,33 @@ TEST_F(CPTest, Element) {
   EXPECT_EQ(33, element(MakeArgs(11, 22, 33, 2)).value());
   EXPECT_STREQ("invalid index -1", element(MakeArgs(11, 22, 33, -1)).error());
   EXPECT_STREQ("invalid index 3", element(MakeArgs(11, 22, 33, 3)).error());
-  for (int i = 0; i < 2; ++i) {
-    double deriv = element(MakeArgs(42, 0), fun::DERIVS).deriv(0);
-    EXPECT_TRUE(deriv != deriv);
-  }
-  EXPECT_STREQ("derivatives are not provided",
-      element(MakeArgs(42, 0), fun::HES).error());
+}
+
+TEST_F(CPTest, ElementDerivs) {
+  Function element = GetFunction("element");
+  Function::Result r = element(MakeArgs(11, 22, 33, 1), fun::HES);
+  EXPECT_EQ(22, r.value());
+  EXPECT_EQ(0, r.deriv(0));
+  EXPECT_EQ(1, r.deriv(1));
+  EXPECT_EQ(0, r.deriv(2));
+  EXPECT_EQ(0, r.deriv(3));
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(0, r.hes(i));
+  EXPECT_EQ(1, element(MakeArgs(42, 0), fun::DERIVS).deriv(0));
+  EXPECT_STREQ("invalid index 3",
+      element(MakeArgs(11, 22, 33, 3), fun::HES).error());
+}
+
+TEST_F(CPTest, ElementConstIndex) {
+  Function element = GetFunction("element");
+  // The index and the first element are constants.
+  Function::Result r = element(MakeArgs(11, 22, 33, 2), fun::HES,
+                               fun::BitSet("0110"));
+  EXPECT_EQ(33, r.value());
+  EXPECT_EQ(0, r.deriv(1));
+  EXPECT_EQ(1, r.deriv(2));
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(0, r.hes(i));
 }
 
 TEST_F(CPTest, InRelation) {
@@ -0,0 +1,211 @@
+/*
+ Expression statistics tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "mp/expr-stats.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::ExprStats;
+using mp::ExprProfile;
+
+namespace ex = mp::expr;
+
+class ExprStatsTest : public ::testing::Test {
+ protected:
+  Problem p;
+  ExprStats stats;
+
+  ExprStatsTest() {
+    for (int i = 0; i < 3; ++i)
+      p.AddVar(0, 1);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  NumericExpr MakeIterated(ex::Kind kind, int num_args) {
+    Problem::IteratedExprBuilder b = p.BeginIterated(kind, num_args);
+    for (int i = 0; i < num_args; ++i)
+      b.AddArg(p.MakeVariable(i % 3));
+    return p.EndIterated(b);
+  }
+};
+
+TEST_F(ExprStatsTest, CountsAndDepths) {
+  // exp(x0 * x1 + 2)
+  p.AddObj(mp::obj::MIN, p.MakeUnary(ex::EXP, p.MakeBinary(
+      ex::ADD, p.MakeBinary(ex::MUL, p.MakeVariable(0), p.MakeVariable(1)),
+      MakeConst(2))));
+  mp::CollectExprStats(p, stats);
+  EXPECT_EQ(1, stats.num_trees());
+  EXPECT_EQ(3, stats.max_depth());
+  EXPECT_EQ(1, stats[ex::EXP].count);
+  EXPECT_EQ(1, stats[ex::EXP].depths[0]);
+  EXPECT_EQ(1, stats[ex::ADD].depths[1]);
+  EXPECT_EQ(1, stats[ex::MUL].depths[2]);
+  EXPECT_EQ(1, stats[ex::CONSTANT].depths[2]);
+  EXPECT_EQ(2, stats[ex::VARIABLE].count);
+  EXPECT_EQ(2, stats[ex::VARIABLE].depths[3]);
+  EXPECT_EQ(0, stats[ex::SIN].count);
+}
+
+TEST_F(ExprStatsTest, DeepExpr) {
+  NumericExpr e = p.MakeVariable(0);
+  enum {DEPTH = ExprStats::MAX_DEPTH + 8};
+  for (int i = 0; i < DEPTH; ++i)
+    e = p.MakeUnary(ex::MINUS, e);
+  p.AddCon(0, 0, e);
+  mp::CollectExprStats(p, stats);
+  EXPECT_EQ(DEPTH, stats.max_depth());
+  EXPECT_EQ(DEPTH, stats[ex::MINUS].count);
+  EXPECT_EQ(DEPTH - ExprStats::MAX_DEPTH + 1,
+            stats[ex::MINUS].depths[ExprStats::MAX_DEPTH - 1]);
+  EXPECT_EQ(1, stats[ex::VARIABLE].depths[ExprStats::MAX_DEPTH - 1]);
+}
+
+TEST_F(ExprStatsTest, FanOut) {
+  p.AddCon(0, 0, MakeIterated(ex::SUM, 5));
+  p.AddCon(0, 0, MakeIterated(ex::SUM, 2));
+  p.AddCon(0, 0, MakeIterated(ex::MAX, 1));
+  mp::CollectExprStats(p, stats);
+  const ExprStats::KindStats &sum = stats[ex::SUM];
+  EXPECT_EQ(2, sum.count);
+  EXPECT_EQ(7, sum.num_args);
+  EXPECT_EQ(5, sum.max_args);
+  EXPECT_EQ(0, sum.args[0]);
+  EXPECT_EQ(1, sum.args[1]);
+  EXPECT_EQ(1, sum.args[2]);
+  EXPECT_EQ(1, stats[ex::MAX].args[0]);
+  EXPECT_EQ(8, stats[ex::VARIABLE].count);
+}
+
+TEST_F(ExprStatsTest, PLTermBreakpoints) {
+  Problem::PLTermBuilder b = p.BeginPLTerm(2);
+  b.AddSlope(-1);
+  b.AddBreakpoint(0);
+  b.AddSlope(0);
+  b.AddBreakpoint(1);
+  b.AddSlope(1);
+  p.AddObj(mp::obj::MIN, p.EndPLTerm(b, p.MakeVariable(0)));
+  mp::CollectExprStats(p, stats);
+  EXPECT_EQ(1, stats[ex::PLTERM].count);
+  EXPECT_EQ(2, stats[ex::PLTERM].num_args);
+  EXPECT_EQ(1, stats[ex::VARIABLE].depths[1]);
+}
+
+TEST_F(ExprStatsTest, CommonExprRefs) {
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(0);
+  p.EndCommonExpr(linear, p.MakeUnary(ex::SIN, p.MakeVariable(0)), 0);
+  NumericExpr e = p.MakeCommonExpr(0);
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, e, e));
+  mp::CollectExprStats(p, stats);
+  EXPECT_EQ(2, stats.num_trees());
+  EXPECT_EQ(2, stats[ex::COMMON_EXPR].count);
+  // The common expression is counted once, not per reference.
+  EXPECT_EQ(1, stats[ex::SIN].count);
+}
+
+TEST_F(ExprStatsTest, LogicalCon) {
+  p.AddCon(p.MakeNot(p.MakeRelational(ex::LT, p.MakeVariable(0),
+                                      MakeConst(1))));
+  mp::CollectExprStats(p, stats);
+  EXPECT_EQ(1, stats[ex::NOT].depths[0]);
+  EXPECT_EQ(1, stats[ex::LT].depths[1]);
+  EXPECT_EQ(1, stats[ex::VARIABLE].depths[2]);
+}
+
+TEST_F(ExprStatsTest, WriteAndAddTo) {
+  p.AddObj(mp::obj::MIN, p.MakeUnary(ex::EXP, MakeIterated(ex::SUM, 3)));
+  mp::CollectExprStats(p, stats);
+  fmt::MemoryWriter w;
+  stats.Write(w);
+  std::string s = w.str();
+  EXPECT_NE(std::string::npos, s.find("exp"));
+  EXPECT_NE(std::string::npos, s.find("sum"));
+  EXPECT_NE(std::string::npos, s.find("2-3:1"));
+  mp::Stats mp_stats;
+  stats.AddTo(mp_stats);
+  EXPECT_EQ(1, mp_stats.counter(mp_stats.GetCounter("expr exp")).value);
+  EXPECT_EQ(3, mp_stats.counter(mp_stats.GetCounter("expr sum args")).value);
+}
+
+// Counts nodes using the profiling visitor.
+class NodeCounter :
+  public mp::BasicProfilingExprVisitor<
+    NodeCounter, int, int, mp::internal::ExprTypes> {
+ public:
+  int VisitNumericConstant(NumericConstant) { return 1; }
+  int VisitVariable(Variable) { return 1; }
+  int VisitUnary(UnaryExpr e) { return Visit(e.arg()) + 1; }
+  int VisitBinary(BinaryExpr e) { return Visit(e.lhs()) + Visit(e.rhs()) + 1; }
+};
+
+TEST(ExprProfileTest, ProfilingVisitor) {
+  Problem p;
+  p.AddVar(0, 1);
+  // sin(x0) * (x0 + 1)
+  NumericExpr x = p.MakeVariable(0);
+  NumericExpr e = p.MakeBinary(
+        ex::MUL, p.MakeUnary(ex::SIN, x),
+        p.MakeBinary(ex::ADD, x, p.MakeNumericConstant(1)));
+  NodeCounter counter;
+  EXPECT_EQ(6, counter.Visit(e));
+  ExprProfile profile;
+  EXPECT_TRUE(profile.empty());
+  counter.set_profile(&profile);
+  EXPECT_EQ(6, counter.Visit(e));
+  EXPECT_FALSE(profile.empty());
+  EXPECT_EQ(1, profile[ex::MUL].count);
+  EXPECT_EQ(1, profile[ex::SIN].count);
+  EXPECT_EQ(1, profile[ex::ADD].count);
+  EXPECT_EQ(2, profile[ex::VARIABLE].count);
+  EXPECT_EQ(1, profile[ex::CONSTANT].count);
+  EXPECT_EQ(0, profile[ex::COS].count);
+  EXPECT_LE(profile[ex::MUL].self_time, profile[ex::MUL].time);
+  EXPECT_GE(profile[ex::MUL].time,
+            profile[ex::SIN].time + profile[ex::ADD].time);
+  fmt::MemoryWriter w;
+  profile.Write(w);
+  EXPECT_NE(std::string::npos, w.str().find("sin"));
+}
+
+TEST(ExprProfileTest, Clear) {
+  Problem p;
+  p.AddVar(0, 1);
+  NumericExpr e = p.MakeUnary(ex::SIN, p.MakeVariable(0));
+  NodeCounter counter;
+  ExprProfile profile;
+  counter.set_profile(&profile);
+  counter.Visit(e);
+  EXPECT_EQ(1, profile[ex::SIN].count);
+  profile.Clear();
+  EXPECT_TRUE(profile.empty());
+  EXPECT_EQ(0, profile[ex::SIN].count);
+  EXPECT_EQ(0, profile[ex::SIN].time);
+  counter.Visit(e);
+  EXPECT_EQ(1, profile[ex::SIN].count);
+  EXPECT_EQ(1, profile[ex::VARIABLE].count);
+}
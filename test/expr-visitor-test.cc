@@ -20,6 +20,8 @@
  Author: Victor Zverovich
  */
 
+#include <string>
+
 #include "gmock/gmock.h"
 #include "mock-allocator.h"
 #include "test-assert.h"
@@ -547,3 +549,99 @@ TEST_F(ExprVisitorTest, InvalidExpr) {
   std::fill(buffer, buffer + sizeof(buffer), 0);
   EXPECT_ASSERT(visitor_.Visit(e2), "invalid logical expression");
 }
+
+// Evaluates expressions recording the kinds of visited expressions.
+struct PostOrderEvaluator :
+    mp::PostOrderExprVisitor<PostOrderEvaluator, double, bool> {
+  std::string kinds;
+
+  void Record(mp::Expr e) {
+    kinds += mp::expr::str(e.kind());
+    kinds += ' ';
+  }
+
+  double VisitNumericConstant(NumericConstant c) {
+    Record(c);
+    return c.value();
+  }
+
+  double VisitVariable(Variable v) {
+    Record(v);
+    return v.index() + 1;
+  }
+
+  double VisitMinus(UnaryExpr e) {
+    Record(e);
+    return -Visit(e.arg());
+  }
+
+  double VisitAdd(BinaryExpr e) {
+    Record(e);
+    return Visit(e.lhs()) + Visit(e.rhs());
+  }
+
+  double VisitSub(BinaryExpr e) {
+    Record(e);
+    // Visit the arguments in reverse order.
+    double rhs = Visit(e.rhs());
+    return Visit(e.lhs()) - rhs;
+  }
+
+  double VisitMul(BinaryExpr e) {
+    Record(e);
+    // Visit an argument of an argument which starts a nested traversal.
+    if (auto minus = mp::Cast<mp::UnaryExpr>(e.lhs()))
+      return -Visit(minus.arg()) * Visit(e.rhs());
+    return Visit(e.lhs()) * Visit(e.rhs());
+  }
+
+  double VisitIf(IfExpr e) {
+    Record(e);
+    return Visit(e.condition()) ? Visit(e.true_expr()) :
+                                  Visit(e.false_expr());
+  }
+
+  bool VisitLT(RelationalExpr e) {
+    Record(e);
+    return Visit(e.lhs()) < Visit(e.rhs());
+  }
+};
+
+TEST(PostOrderExprVisitorTest, VisitArgsBeforeParents) {
+  mp::ExprFactory f;
+  auto x = f.MakeVariable(0), y = f.MakeVariable(1);
+  // if x < y then -x + 3 else y - x
+  auto e = f.MakeIf(f.MakeRelational(mp::expr::LT, x, y),
+                    f.MakeBinary(mp::expr::ADD, f.MakeUnary(mp::expr::MINUS, x),
+                                 f.MakeNumericConstant(3)),
+                    f.MakeBinary(mp::expr::SUB, y, x));
+  PostOrderEvaluator eval;
+  EXPECT_EQ(2, eval.Visit(e));
+  EXPECT_EQ("variable variable < variable unary - constant + variable variable - if ",
+            eval.kinds);
+}
+
+TEST(PostOrderExprVisitorTest, NestedTraversal) {
+  mp::ExprFactory f;
+  // -x * 5
+  auto e = f.MakeBinary(mp::expr::MUL,
+                        f.MakeUnary(mp::expr::MINUS, f.MakeVariable(1)),
+                        f.MakeNumericConstant(5));
+  PostOrderEvaluator eval;
+  EXPECT_EQ(-10, eval.Visit(e));
+  // The variable is visited twice: once as an argument of "-" and once
+  // directly from VisitMul.
+  EXPECT_EQ("variable unary - constant * variable ", eval.kinds);
+}
+
+TEST(PostOrderExprVisitorTest, DeepExpr) {
+  mp::ExprFactory f;
+  enum {DEPTH = 200000};
+  mp::NumericExpr e = f.MakeVariable(0);
+  for (int i = 0; i < DEPTH; ++i) {
+    e = i % 2 == 0 ? f.MakeBinary(mp::expr::ADD, e, f.MakeNumericConstant(1)) :
+                     f.MakeBinary(mp::expr::ADD, f.MakeNumericConstant(1), e);
+  }
+  PostOrderEvaluator eval;
+  EXPECT_EQ(DEPTH + 1, eval.Visit(e));
+}
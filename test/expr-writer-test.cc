@@ -101,6 +101,12 @@ TEST_F(ExprWriterTest, WriteVariable) {
   CHECK_WRITE("x3", MakeVariable(2));
 }
 
+TEST_F(ExprWriterTest, WriteCommonExpr) {
+  CHECK_WRITE("e1", MakeCommonExpr(0));
+  CHECK_WRITE("e3 + x1",
+              MakeBinary(ex::ADD, MakeCommonExpr(2), MakeVariable(0)));
+}
+
 TEST_F(ExprWriterTest, WriteUnaryExpr) {
   auto x1 = MakeVariable(0);
   CHECK_WRITE("-x1", MakeUnary(ex::MINUS, x1));
@@ -37,6 +37,7 @@
 #include "function.h"
 #include "util.h"
 #include "asl/solvers/asl.h"
+#include "gsl/amplgsl.h"
 
 using std::string;
 using std::vector;
@@ -211,6 +212,36 @@ class GSLTest : public ::testing::Test {
     return GetFunction(name, info);
   }
 
+  // Returns the function information passed by amplgsl to addfunc.
+  static void *GetFuncInfo(const char *name) {
+    const func_info *fi = lib_.GetFunction(name);
+    if (!fi)
+      throw std::runtime_error(string("function not found: ") + name);
+    return fi->funcinfo;
+  }
+
+  // Evaluates an amplgsl function at several points with one call
+  // and checks the values against f. All arguments of a point are equal.
+  static void TestVectorEval(
+      const char *name, double (*f)(double), int num_args) {
+    const double x[] = {-1.5, 0, 0.5, 2, 10};
+    enum {NUM_POINTS = sizeof(x) / sizeof(*x)};
+    const double *args[] = {x, x};
+    double ra[2] = {}, y[NUM_POINTS] = {};
+    arglist al = arglist();
+    al.n = al.nr = num_args;
+    al.ra = ra;
+    al.funcinfo = GetFuncInfo(name);
+    const amplgsl_funcinfo *info =
+        static_cast<const amplgsl_funcinfo*>(al.funcinfo);
+    EXPECT_STREQ(name, info->name);
+    ASSERT_TRUE(info->vfunc != 0);
+    EXPECT_EQ(NUM_POINTS, info->vfunc(&al, NUM_POINTS, args, y));
+    EXPECT_TRUE(al.Errmsg == 0);
+    for (int i = 0; i < NUM_POINTS; ++i)
+      EXPECT_EQ(f(x[i]), y[i]);
+  }
+
   static bool CheckDerivative(
       double deriv, double numerical_deriv, double error);
 
@@ -1111,6 +1142,17 @@ TEST_F(GSLTest, Zeta) {
   TEST_EFUNC2(gsl_sf_eta, NoDeriv());
 }
 
+double UGaussianQ(double x) { return gsl_cdf_ugaussian_Q(x); }
+double Zeta(double x) { return gsl_sf_zeta(x); }
+double Hypot(double x) { return gsl_hypot(x, x); }
+
+TEST_F(GSLTest, VectorEval) {
+  // Defined with WRAP, WRAP_CHECKED and without a vector version.
+  TestVectorEval("gsl_cdf_ugaussian_Q", UGaussianQ, 1);
+  TestVectorEval("gsl_sf_zeta", Zeta, 1);
+  TestVectorEval("gsl_hypot", Hypot, 2);
+}
+
 TEST_F(GSLTest, Gaussian) {
   TEST_FUNC2(gsl_ran_gaussian, NoDeriv());
   TEST_FUNC(gsl_ran_gaussian_pdf);
@@ -0,0 +1,272 @@
+/*
+ Hessian evaluator tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/hessian.h"
+#include "mp/jacobian.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::Tape;
+using mp::HessianEvaluator;
+using mp::JacobianEvaluator;
+
+namespace ex = mp::expr;
+
+class HessianTest : public ::testing::Test {
+ protected:
+  Problem p;
+
+  static void AddVars(Problem &p, int num_vars) {
+    for (int i = 0; i < num_vars; ++i)
+      p.AddVar(0, 0);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  // Computes the gradient of the Lagrangian at x.
+  static std::vector<double> GetGradient(
+      JacobianEvaluator &jac, const std::vector<double> &x,
+      const std::vector<double> &obj_weights,
+      const std::vector<double> &multipliers) {
+    const Tape &t = jac.tape();
+    std::vector<double> grad(t.num_vars());
+    jac.Evaluate(x.data());
+    std::vector<double> values(t.num_vars());
+    for (int i = 0; i < t.num_objs(); ++i) {
+      jac.GetObjGradient(i, values.data());
+      mp::ArrayRef<int> vars = jac.obj_grad_vars(i);
+      for (std::size_t j = 0; j < vars.size(); ++j)
+        grad[vars[j]] += obj_weights[i] * values[j];
+    }
+    values.resize(jac.num_jac_nonzeros() + 1);
+    jac.GetJacobian(values.data());
+    for (int i = 0; i < t.num_cons(); ++i) {
+      mp::ArrayRef<int> vars = jac.jac_vars(i);
+      for (std::size_t j = 0; j < vars.size(); ++j)
+        grad[vars[j]] += multipliers[i] * values[jac.jac_start(i) + j];
+    }
+    return grad;
+  }
+
+  // Checks the Hessian of the Lagrangian of p at x against finite
+  // differences of the gradient. Returns the number of colors.
+  static int CheckHessian(
+      const Problem &p, const std::vector<double> &x,
+      std::vector<double> obj_weights = std::vector<double>(),
+      std::vector<double> multipliers = std::vector<double>()) {
+    obj_weights.resize(p.num_objs(), 1);
+    multipliers.resize(p.num_algebraic_cons(), 1);
+    Tape tape(p);
+    int n = tape.num_vars();
+    HessianEvaluator hes(tape);
+    hes.Evaluate(x.data());
+    std::vector<double> values(hes.num_nonzeros() + 1);
+    hes.GetHessian(obj_weights.data(), multipliers.data(), values.data());
+    std::vector<double> dense(n * n);
+    for (int j = 0; j < n; ++j) {
+      mp::ArrayRef<int> rows = hes.col_rows(j);
+      for (std::size_t k = 0; k < rows.size(); ++k) {
+        int i = rows[k];
+        EXPECT_LE(i, j);
+        dense[i * n + j] = dense[j * n + i] = values[hes.col_start(j) + k];
+      }
+    }
+    JacobianEvaluator jac(tape);
+    const double h = 1e-6;
+    for (int j = 0; j < n; ++j) {
+      std::vector<double> point = x;
+      point[j] = x[j] + h;
+      std::vector<double> plus =
+          GetGradient(jac, point, obj_weights, multipliers);
+      point[j] = x[j] - h;
+      std::vector<double> minus =
+          GetGradient(jac, point, obj_weights, multipliers);
+      for (int i = 0; i < n; ++i) {
+        double value = dense[i * n + j];
+        EXPECT_NEAR((plus[i] - minus[i]) / (2 * h), value,
+                    1e-5 * std::max(std::fabs(value), 1.0))
+            << "element (" << i << ", " << j << ")";
+      }
+    }
+    return hes.num_colors();
+  }
+
+  static int CheckHessian(const Problem &p, double x0, double x1) {
+    std::vector<double> x(2);
+    x[0] = x0;
+    x[1] = x1;
+    return CheckHessian(p, x);
+  }
+};
+
+TEST_F(HessianTest, UnaryExpr) {
+  const ex::Kind kinds[] = {
+    ex::MINUS, ex::ABS, ex::SQRT, ex::POW2, ex::EXP, ex::LOG, ex::LOG10,
+    ex::SIN, ex::SINH, ex::COS, ex::COSH, ex::TAN, ex::TANH, ex::ASIN,
+    ex::ASINH, ex::ACOS, ex::ACOSH, ex::ATAN, ex::ATANH
+  };
+  for (std::size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+    SCOPED_TRACE(ex::str(kinds[i]));
+    Problem p;
+    AddVars(p, 2);
+    // Use x0 * x1 + 1 as an argument to get mixed second derivatives
+    // and keep it in the domain of acosh.
+    NumericExpr arg = p.MakeBinary(ex::MUL, p.MakeVariable(0),
+                                   p.MakeVariable(1));
+    if (kinds[i] == ex::ACOSH)
+      arg = p.MakeBinary(ex::ADD, arg, p.MakeNumericConstant(1));
+    p.AddCon(0, 0, p.MakeUnary(kinds[i], arg));
+    CheckHessian(p, 0.3, 0.7);
+  }
+}
+
+TEST_F(HessianTest, BinaryExpr) {
+  const ex::Kind kinds[] = {
+    ex::ADD, ex::SUB, ex::LESS, ex::MUL, ex::DIV, ex::MOD, ex::POW, ex::ATAN2
+  };
+  for (std::size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+    SCOPED_TRACE(ex::str(kinds[i]));
+    Problem p;
+    AddVars(p, 2);
+    NumericExpr sin_x1 = p.MakeUnary(ex::SIN, p.MakeVariable(1));
+    p.AddObj(mp::obj::MIN, p.MakeBinary(kinds[i], p.MakeVariable(0), sin_x1));
+    CheckHessian(p, 2.5, 0.7);
+  }
+  AddVars(p, 2);
+  NumericExpr x = p.MakeVariable(0), y = p.MakeVariable(1);
+  p.AddCon(0, 0, p.MakeBinary(ex::POW_CONST_BASE, MakeConst(2), y));
+  p.AddCon(0, 0, p.MakeBinary(ex::POW_CONST_EXP, x, MakeConst(3)));
+  CheckHessian(p, 0.7, 1.5);
+}
+
+TEST_F(HessianTest, Pattern) {
+  AddVars(p, 3);
+  // x0 * x1 + x2
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, p.MakeVariable(0),
+                              p.MakeVariable(1)), 1).AddTerm(2, 1);
+  Tape tape(p);
+  HessianEvaluator hes(tape);
+  EXPECT_EQ(1, hes.num_nonzeros());
+  EXPECT_EQ(0u, hes.col_rows(0).size());
+  ASSERT_EQ(1u, hes.col_rows(1).size());
+  EXPECT_EQ(0, hes.col_rows(1)[0]);
+  EXPECT_EQ(0u, hes.col_rows(2).size());
+  EXPECT_EQ(2, hes.num_colors());
+  double x[] = {1, 2, 3}, y = 5, value = 0;
+  hes.Evaluate(x);
+  hes.GetHessian(0, &y, &value);
+  EXPECT_EQ(5, value);
+  hes.GetHessian(0, 0, &value);
+  EXPECT_EQ(0, value);
+}
+
+TEST_F(HessianTest, Linear) {
+  AddVars(p, 2);
+  p.AddCon(0, 0, p.MakeBinary(ex::ADD, p.MakeVariable(0),
+                              p.MakeUnary(ex::MINUS, p.MakeVariable(1))));
+  Tape tape(p);
+  HessianEvaluator hes(tape);
+  EXPECT_EQ(0, hes.num_nonzeros());
+  EXPECT_EQ(0, hes.num_colors());
+}
+
+TEST_F(HessianTest, ConditionNotInPattern) {
+  AddVars(p, 2);
+  NumericExpr x = p.MakeVariable(0), y = p.MakeVariable(1);
+  p.AddCon(0, 0, p.MakeIf(
+             p.MakeRelational(ex::LT, p.MakeUnary(ex::POW2, y), MakeConst(1)),
+             p.MakeUnary(ex::POW2, x), x));
+  Tape tape(p);
+  HessianEvaluator hes(tape);
+  EXPECT_EQ(1, hes.num_nonzeros());
+  EXPECT_EQ(1u, hes.col_rows(0).size());
+  CheckHessian(p, 0.5, 0.5);
+  CheckHessian(p, 0.5, 2);
+}
+
+TEST_F(HessianTest, Tridiagonal) {
+  enum {NUM_VARS = 30};
+  AddVars(p, NUM_VARS);
+  std::vector<double> x(NUM_VARS);
+  for (int i = 0; i < NUM_VARS - 1; ++i) {
+    p.AddCon(0, 0, p.MakeBinary(ex::MUL, p.MakeVariable(i),
+                                p.MakeUnary(ex::SIN, p.MakeVariable(i + 1))));
+    x[i] = 0.1 * i;
+  }
+  std::vector<double> multipliers(NUM_VARS - 1);
+  for (int i = 0; i < NUM_VARS - 1; ++i)
+    multipliers[i] = i + 1;
+  EXPECT_LE(CheckHessian(p, x, std::vector<double>(), multipliers), 3);
+}
+
+TEST_F(HessianTest, Arrowhead) {
+  enum {NUM_VARS = 20};
+  AddVars(p, NUM_VARS);
+  std::vector<double> x(NUM_VARS);
+  for (int i = 1; i < NUM_VARS; ++i) {
+    p.AddCon(0, 0, p.MakeBinary(ex::MUL, p.MakeVariable(0),
+                                p.MakeUnary(ex::EXP, p.MakeVariable(i))));
+    x[i] = 0.05 * i;
+  }
+  x[0] = 0.5;
+  EXPECT_LE(CheckHessian(p, x), 3);
+}
+
+TEST_F(HessianTest, DenseSeveralBatches) {
+  enum {NUM_VARS = 2 * HessianEvaluator::BATCH_SIZE + 3};
+  AddVars(p, NUM_VARS);
+  std::vector<double> x(NUM_VARS);
+  Problem::IteratedExprBuilder b = p.BeginIterated(ex::SUM, NUM_VARS);
+  for (int i = 0; i < NUM_VARS; ++i) {
+    b.AddArg(p.MakeBinary(ex::MUL, MakeConst(i + 1), p.MakeVariable(i)));
+    x[i] = 0.001 * i;
+  }
+  std::vector<double> obj_weights(1, 2);
+  p.AddObj(mp::obj::MIN, p.MakeUnary(ex::EXP, p.EndIterated(b)));
+  EXPECT_EQ(NUM_VARS, CheckHessian(p, x, obj_weights));
+}
+
+TEST_F(HessianTest, CommonExpr) {
+  AddVars(p, 3);
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+  linear.AddTerm(2, 3);
+  p.EndCommonExpr(linear, p.MakeBinary(
+        ex::MUL, p.MakeVariable(0), p.MakeVariable(1)), 1);
+  NumericExpr e = p.MakeCommonExpr(0);
+  p.AddCon(0, 0, p.MakeUnary(ex::POW2, e));
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, e, p.MakeVariable(2)));
+  std::vector<double> x(3);
+  x[0] = 0.5;
+  x[1] = 1.5;
+  x[2] = -0.5;
+  std::vector<double> multipliers(2);
+  multipliers[0] = 2;
+  multipliers[1] = -3;
+  CheckHessian(p, x, std::vector<double>(), multipliers);
+}
@@ -0,0 +1,123 @@
+/*
+ Interval arithmetic tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "mp/interval.h"
+
+using mp::Interval;
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+// Checks that the interval computed by f encloses values of g at points
+// sampled from a.
+template <typename IntervalFunc, typename Func>
+void CheckEnclosure(IntervalFunc f, Func g, Interval a) {
+  Interval result = f(a);
+  for (int i = 0; i <= 100; ++i) {
+    double x = a.lb + (a.ub - a.lb) * i / 100;
+    double value = g(x);
+    if (value != value)
+      continue;
+    EXPECT_LE(result.lb, value) << "x = " << x;
+    EXPECT_GE(result.ub, value) << "x = " << x;
+  }
+}
+}
+
+TEST(IntervalTest, Ctor) {
+  Interval whole;
+  EXPECT_EQ(-INF, whole.lb);
+  EXPECT_EQ(INF, whole.ub);
+  Interval point(42);
+  EXPECT_TRUE(point.is_point());
+  EXPECT_TRUE(point.contains(42));
+  EXPECT_TRUE(Interval::Empty().empty());
+  EXPECT_FALSE(Interval(1, 2).empty());
+}
+
+TEST(IntervalTest, IntersectAndHull) {
+  EXPECT_EQ(Interval(2, 3), mp::Intersect(Interval(1, 3), Interval(2, 4)));
+  EXPECT_TRUE(mp::Intersect(Interval(1, 2), Interval(3, 4)).empty());
+  EXPECT_EQ(Interval(1, 4), mp::Hull(Interval(1, 2), Interval(3, 4)));
+  EXPECT_EQ(Interval(3, 4), mp::Hull(Interval::Empty(), Interval(3, 4)));
+}
+
+TEST(IntervalTest, Arithmetic) {
+  EXPECT_EQ(Interval(4, 6), Interval(1, 2) + Interval(3, 4));
+  EXPECT_EQ(Interval(-3, -1), Interval(1, 2) - Interval(3, 4));
+  EXPECT_EQ(Interval(-8, 4), Interval(-2, 1) * Interval(3, 4));
+  EXPECT_EQ(Interval(0, 0), Interval(0) * Interval());
+  EXPECT_EQ(Interval(0.25, 1), Interval(1, 2) / Interval(2, 4));
+  EXPECT_EQ(Interval(), Interval(1, 2) / Interval(-1, 1));
+  EXPECT_EQ(Interval(0.5, INF), Interval(1, 2) / Interval(0, 2));
+  EXPECT_TRUE((Interval(1) / Interval(0)).empty());
+}
+
+TEST(IntervalTest, OutwardRounding) {
+  double third = 1.0 / 3;
+  EXPECT_EQ(Interval(third, std::nextafter(third, INF)),
+            Interval(1) / Interval(3));
+  // The exact product of third and 3 is less than 1.
+  EXPECT_EQ(Interval(std::nextafter(1.0, 0), 1), Interval(third) * Interval(3));
+  Interval sum = Interval(0.1) + Interval(0.2);
+  EXPECT_EQ(std::nextafter(sum.lb, INF), sum.ub);
+  Interval diff = Interval(1) - Interval(1e-20);
+  EXPECT_EQ(Interval(std::nextafter(1.0, 0), 1), diff);
+  double max = std::numeric_limits<double>::max();
+  EXPECT_EQ(Interval(max, INF), Interval(max) + Interval(max));
+  Interval sqrt2 = mp::Sqrt(Interval(2));
+  EXPECT_EQ(std::nextafter(sqrt2.lb, INF), sqrt2.ub);
+  Interval e = mp::Exp(Interval(1));
+  EXPECT_LT(e.lb, std::exp(1.0));
+  EXPECT_GT(e.ub, std::exp(1.0));
+  Interval cube_root = mp::Root(Interval(2), 3);
+  EXPECT_LE(mp::Pow(Interval(cube_root.lb), Interval(3)).lb, 2);
+  EXPECT_GE(mp::Pow(Interval(cube_root.ub), Interval(3)).ub, 2);
+  EXPECT_EQ(Interval(-1, 1), mp::Cos(Interval(-1, 4)));
+}
+
+TEST(IntervalTest, Functions) {
+  EXPECT_EQ(Interval(0, 4), mp::Sqr(Interval(-1, 2)));
+  EXPECT_EQ(Interval(1, 2), mp::Abs(Interval(-2, -1)));
+  EXPECT_EQ(Interval(0, 2), mp::Sqrt(Interval(-1, 4)));
+  EXPECT_TRUE(mp::Log(Interval(-2, -1)).empty());
+  EXPECT_EQ(Interval(-1, 1), mp::Sin(Interval(0, 7)));
+  EXPECT_EQ(Interval(-27, 8), mp::Pow(Interval(-3, 2), Interval(3)));
+  EXPECT_EQ(Interval(0, 9), mp::Pow(Interval(-3, 2), Interval(2)));
+  EXPECT_EQ(Interval(-2, 2), mp::Root(Interval(-1, 4), 2));
+  EXPECT_EQ(Interval(-3, 2), mp::Root(Interval(-27, 8), 3));
+  CheckEnclosure(mp::Sin, static_cast<double (*)(double)>(std::sin),
+                 Interval(-1, 2.5));
+  CheckEnclosure(mp::Cos, static_cast<double (*)(double)>(std::cos),
+                 Interval(2, 8));
+  CheckEnclosure(mp::Cosh, static_cast<double (*)(double)>(std::cosh),
+                 Interval(-1, 2));
+  CheckEnclosure(mp::Tan, static_cast<double (*)(double)>(std::tan),
+                 Interval(-1, 1));
+  CheckEnclosure(mp::Atanh, static_cast<double (*)(double)>(std::atanh),
+                 Interval(-0.5, 0.9));
+}
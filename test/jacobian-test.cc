@@ -0,0 +1,220 @@
+/*
+ Jacobian evaluator tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/jacobian.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::Tape;
+using mp::TapeEvaluator;
+using mp::JacobianEvaluator;
+
+namespace ex = mp::expr;
+
+class JacobianTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y;
+
+  JacobianTest() {
+    p.AddVar(0, 0);
+    p.AddVar(0, 0);
+    p.AddVar(0, 0);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  // Checks the gradient of e at (x0, y0) against central differences.
+  void CheckGradient(NumericExpr e, double x0, double y0) {
+    Problem::LinearObjBuilder obj = p.AddObj(mp::obj::MIN, e, 1);
+    // The linear term with a zero coefficient makes both variables
+    // appear in the pattern.
+    obj.AddTerm(1, 0);
+    Tape tape(p);
+    JacobianEvaluator jac(tape);
+    double point[] = {x0, y0, 0};
+    jac.Evaluate(point);
+    int obj_index = p.num_objs() - 1;
+    mp::ArrayRef<int> vars = jac.obj_grad_vars(obj_index);
+    std::vector<double> grad(vars.size());
+    jac.GetObjGradient(obj_index, grad.data());
+    TapeEvaluator eval(tape);
+    for (std::size_t i = 0; i < vars.size(); ++i) {
+      const double h = 1e-6;
+      double saved = point[vars[i]];
+      point[vars[i]] = saved + h;
+      eval.Evaluate(point);
+      double f_plus = eval.obj_value(obj_index);
+      point[vars[i]] = saved - h;
+      eval.Evaluate(point);
+      double f_minus = eval.obj_value(obj_index);
+      point[vars[i]] = saved;
+      EXPECT_NEAR((f_plus - f_minus) / (2 * h), grad[i], 1e-6)
+          << "var " << vars[i];
+    }
+  }
+};
+
+TEST_F(JacobianTest, UnaryExpr) {
+  const ex::Kind kinds[] = {
+    ex::MINUS, ex::ABS, ex::SQRT, ex::POW2, ex::EXP, ex::LOG, ex::LOG10,
+    ex::SIN, ex::SINH, ex::COS, ex::COSH, ex::TAN, ex::TANH, ex::ASIN,
+    ex::ASINH, ex::ACOS, ex::ATAN, ex::ATANH
+  };
+  for (std::size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+    SCOPED_TRACE(ex::str(kinds[i]));
+    CheckGradient(p.MakeUnary(kinds[i], x), 0.3, 0);
+  }
+  CheckGradient(p.MakeUnary(ex::ABS, x), -0.3, 0);
+  CheckGradient(p.MakeUnary(ex::ACOSH, x), 1.5, 0);
+}
+
+TEST_F(JacobianTest, BinaryExpr) {
+  const ex::Kind kinds[] = {
+    ex::ADD, ex::SUB, ex::LESS, ex::MUL, ex::DIV, ex::MOD, ex::POW, ex::ATAN2
+  };
+  for (std::size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+    SCOPED_TRACE(ex::str(kinds[i]));
+    CheckGradient(p.MakeBinary(kinds[i], x, y), 2.5, 0.7);
+  }
+  CheckGradient(p.MakeBinary(ex::LESS, x, y), 0.7, 2.5);
+  CheckGradient(p.MakeBinary(ex::POW_CONST_BASE, MakeConst(2), y), 0, 0.7);
+  CheckGradient(p.MakeBinary(ex::POW_CONST_EXP, x, MakeConst(3)), 0.7, 0);
+}
+
+TEST_F(JacobianTest, IfExpr) {
+  NumericExpr e = p.MakeIf(p.MakeRelational(ex::LT, x, y),
+                           p.MakeUnary(ex::POW2, x), p.MakeUnary(ex::EXP, y));
+  CheckGradient(e, 1, 2);
+  CheckGradient(e, 2, 1);
+}
+
+TEST_F(JacobianTest, PLTerm) {
+  Problem::PLTermBuilder b = p.BeginPLTerm(2);
+  b.AddSlope(-1);
+  b.AddBreakpoint(0);
+  b.AddSlope(0.5);
+  b.AddBreakpoint(1);
+  b.AddSlope(2);
+  NumericExpr e = p.EndPLTerm(b, p.MakeVariable(0));
+  CheckGradient(e, -3, 0);
+  CheckGradient(e, 0.5, 0);
+  CheckGradient(e, 3, 0);
+}
+
+TEST_F(JacobianTest, IteratedExpr) {
+  const ex::Kind kinds[] = {ex::MIN, ex::MAX, ex::SUM};
+  for (std::size_t i = 0; i < sizeof(kinds) / sizeof(*kinds); ++i) {
+    SCOPED_TRACE(ex::str(kinds[i]));
+    Problem::IteratedExprBuilder b = p.BeginIterated(kinds[i], 3);
+    b.AddArg(x);
+    b.AddArg(p.MakeBinary(ex::MUL, x, y));
+    b.AddArg(p.MakeUnary(ex::SIN, y));
+    CheckGradient(p.EndIterated(b), 0.5, 1.5);
+  }
+}
+
+TEST_F(JacobianTest, CommonExpr) {
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+  linear.AddTerm(1, 3);
+  p.EndCommonExpr(linear, p.MakeUnary(ex::POW2, x), 1);
+  NumericExpr e = p.MakeCommonExpr(0);
+  CheckGradient(p.MakeBinary(ex::MUL, e, e), 0.5, 1.5);
+}
+
+TEST_F(JacobianTest, Jacobian) {
+  // x0 * x1 + 2 * x2
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, x, y), 1).AddTerm(2, 2);
+  // 5
+  p.AddCon(0, 0, MakeConst(5));
+  // x1
+  p.AddCon(0, 0, y);
+  // 3 * x0 + 4 * x1 with terms in reverse order
+  Problem::LinearConBuilder con = p.AddCon(0, 0, 2);
+  con.AddTerm(1, 4);
+  con.AddTerm(0, 3);
+  Tape tape(p);
+  JacobianEvaluator jac(tape);
+  EXPECT_EQ(0, jac.jac_start(0));
+  EXPECT_EQ(3, jac.jac_start(1));
+  EXPECT_EQ(3, jac.jac_start(2));
+  EXPECT_EQ(4, jac.jac_start(3));
+  EXPECT_EQ(6, jac.num_jac_nonzeros());
+  mp::ArrayRef<int> vars = jac.jac_vars(0);
+  ASSERT_EQ(3u, vars.size());
+  EXPECT_EQ(0, vars[0]);
+  EXPECT_EQ(1, vars[1]);
+  EXPECT_EQ(2, vars[2]);
+  EXPECT_EQ(0u, jac.jac_vars(1).size());
+  vars = jac.jac_vars(3);
+  ASSERT_EQ(2u, vars.size());
+  EXPECT_EQ(0, vars[0]);
+  EXPECT_EQ(1, vars[1]);
+  double values[6] = {};
+  double point[] = {10, 20, 30};
+  jac.Evaluate(point);
+  EXPECT_EQ(260, jac.evaluator().con_value(0));
+  // Evaluate twice to check that adjoints are cleared.
+  for (int i = 0; i < 2; ++i) {
+    jac.GetJacobian(values);
+    EXPECT_EQ(20, values[0]);
+    EXPECT_EQ(10, values[1]);
+    EXPECT_EQ(2, values[2]);
+    EXPECT_EQ(1, values[3]);
+    EXPECT_EQ(3, values[4]);
+    EXPECT_EQ(4, values[5]);
+  }
+}
+
+TEST_F(JacobianTest, ConditionNotInPattern) {
+  p.AddCon(0, 0, p.MakeIf(p.MakeRelational(ex::LT, y, MakeConst(0)),
+                          x, MakeConst(1)));
+  Tape tape(p);
+  JacobianEvaluator jac(tape);
+  mp::ArrayRef<int> vars = jac.jac_vars(0);
+  ASSERT_EQ(1u, vars.size());
+  EXPECT_EQ(0, vars[0]);
+  double point[] = {1, 1, 0};
+  jac.Evaluate(point);
+  double value = 42;
+  jac.GetJacobian(&value);
+  EXPECT_EQ(0, value);
+  point[1] = -1;
+  jac.Evaluate(point);
+  jac.GetJacobian(&value);
+  EXPECT_EQ(1, value);
+}
+
+TEST_F(JacobianTest, NonDifferentiableExpr) {
+  p.AddCon(0, 0, p.MakeUnary(ex::FLOOR, x));
+  p.AddCon(0, 0, p.MakeBinary(ex::ROUND, x, MakeConst(1)));
+  Tape tape(p);
+  JacobianEvaluator jac(tape);
+  EXPECT_EQ(0, jac.num_jac_nonzeros());
+}
@@ -0,0 +1,161 @@
+/*
+ Synthetic .nl file generator tests.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <gtest/gtest.h>
+#include "gtest-extra.h"
+#include "util.h"
+
+#include "mp/nl.h"
+#include "mp/problem.h"
+#include "mp/problem-builder.h"
+#include "nl-generator.h"
+
+using mp::NLGeneratorParams;
+
+namespace {
+
+// Reads a problem and returns its text representation.
+std::string ReadProblem(const std::string &nl) {
+  mp::Problem p;
+  mp::ProblemBuilderToNLAdapter<mp::Problem> adapter(p);
+  mp::ReadNLString(nl, adapter);
+  fmt::MemoryWriter w;
+  w.write("vars: {}, cons: {}\n", p.num_vars(), p.num_algebraic_cons());
+  for (int i = 0, n = p.num_vars(); i < n; ++i)
+    w.write("{} <= x{}  <= {}\n", p.var(i).lb(), i, p.var(i).ub());
+  for (int i = 0, n = p.num_algebraic_cons(); i < n; ++i) {
+    mp::Problem::AlgebraicCon con = p.algebraic_con(i);
+    w.write("{} <= ", con.lb());
+    const mp::LinearExpr &linear = con.linear_expr();
+    for (mp::LinearExpr::iterator
+         j = linear.begin(), end = linear.end(); j != end; ++j) {
+      w.write("{} * x{} + ", j->coef(), j->var_index());
+    }
+    if (mp::NumericExpr e = con.nonlinear_expr())
+      w.write("{}", e);
+    w.write(" <= {}\n", con.ub());
+  }
+  return w.str();
+}
+
+NLGeneratorParams MakeParams() {
+  NLGeneratorParams params;
+  // ReadProblem can't format references to common expressions.
+  params.num_common_exprs = 0;
+  return params;
+}
+
+TEST(NLGeneratorTest, Deterministic) {
+  NLGeneratorParams params;
+  EXPECT_EQ(mp::GenerateNL(params), mp::GenerateNL(params));
+  std::string nl = mp::GenerateNL(params);
+  params.seed = 42;
+  EXPECT_NE(nl, mp::GenerateNL(params));
+}
+
+TEST(NLGeneratorTest, TextAndBinary) {
+  NLGeneratorParams params = MakeParams();
+  std::string text = mp::GenerateNL(params);
+  EXPECT_EQ('g', text[0]);
+  params.binary = true;
+  std::string binary = mp::GenerateNL(params);
+  EXPECT_EQ('b', binary[0]);
+  EXPECT_EQ(ReadProblem(text), ReadProblem(binary));
+}
+
+struct CountingHandler : mp::NLHandler<int> {
+  mp::NLHeader header;
+  int num_common_exprs;
+  int num_nonzeros;
+  int num_suffixes;
+
+  CountingHandler() : num_common_exprs(0), num_nonzeros(0), num_suffixes(0) {}
+
+  void OnHeader(const mp::NLHeader &h) { header = h; }
+
+  LinearExprHandler BeginCommonExpr(int, int) {
+    ++num_common_exprs;
+    return LinearExprHandler();
+  }
+
+  LinearConHandler OnLinearConExpr(int, int num_terms) {
+    num_nonzeros += num_terms;
+    return LinearConHandler();
+  }
+
+  IntSuffixHandler OnIntSuffix(fmt::StringRef, int, int) {
+    ++num_suffixes;
+    return IntSuffixHandler();
+  }
+
+  DblSuffixHandler OnDblSuffix(fmt::StringRef, int, int) {
+    ++num_suffixes;
+    return DblSuffixHandler();
+  }
+};
+
+TEST(NLGeneratorTest, Params) {
+  NLGeneratorParams params;
+  params.num_vars = 200;
+  params.num_nl_vars = 20;
+  params.num_cons = 30;
+  params.num_nl_cons = 10;
+  params.num_nonzeros = 1234;
+  params.num_common_exprs = 5;
+  params.num_suffixes = 4;
+  for (int binary = 0; binary <= 1; ++binary) {
+    params.binary = binary != 0;
+    CountingHandler handler;
+    mp::ReadNLString(mp::GenerateNL(params), handler);
+    EXPECT_EQ(200, handler.header.num_vars);
+    EXPECT_EQ(20, handler.header.num_nl_vars_in_cons);
+    EXPECT_EQ(30, handler.header.num_algebraic_cons);
+    EXPECT_EQ(10, handler.header.num_nl_cons);
+    EXPECT_EQ(1234u, handler.header.num_con_nonzeros);
+    EXPECT_EQ(1234, handler.num_nonzeros);
+    EXPECT_EQ(5, handler.num_common_exprs);
+    EXPECT_EQ(4, handler.num_suffixes);
+  }
+}
+
+TEST(NLGeneratorTest, InvalidParams) {
+  NLGeneratorParams params;
+  params.num_vars = 0;
+  EXPECT_THROW_MSG(mp::GenerateNL(params), mp::Error,
+                   "invalid number of variables 0");
+  params = NLGeneratorParams();
+  params.num_nl_cons = params.num_cons + 1;
+  EXPECT_THROW_MSG(mp::GenerateNL(params), mp::Error,
+                   "invalid number of nonlinear constraints 101");
+  params = NLGeneratorParams();
+  params.num_nonzeros = params.num_cons * params.num_vars + 1;
+  EXPECT_THROW_MSG(mp::GenerateNL(params), mp::Error,
+                   "invalid number of nonzeros 10001");
+}
+
+TEST(NLGeneratorTest, WriteFile) {
+  NLGeneratorParams params;
+  params.binary = true;
+  mp::GenerateNLFile("test.nl", params);
+  EXPECT_EQ(mp::GenerateNL(params), ReadFile("test.nl"));
+}
+}  // namespace
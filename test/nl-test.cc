@@ -20,10 +20,12 @@
  Author: Victor Zverovich
  */
 
+#include <algorithm>
 #include <climits>
 #include <cstring>
 
 #include "mp/nl.h"
+#include "mp/nl-pipeline.h"
 #include "gmock/gmock.h"
 #include "gtest-extra.h"
 #include "mock-file.h"
@@ -1442,4 +1444,129 @@ TEST(NLTest, NLHandler) {
   TestNLHandler3 handler;
   ReadNLString(FormatHeader(MakeHeader()) + "C0\nn4.2\n", handler);
 }
+
+// Computes the depth of a constraint expression.
+struct DepthHandler : mp::NLHandler<int> {
+  int depth;
+  int num_binary;
+
+  DepthHandler() : depth(0), num_binary(0) {}
+
+  int OnNumericConstant(double) { return 0; }
+  int OnVariableRef(int) { return 0; }
+  int OnUnary(mp::expr::Kind, int arg) { return arg + 1; }
+
+  int OnBinary(mp::expr::Kind, int lhs, int rhs) {
+    ++num_binary;
+    return std::max(lhs, rhs) + 1;
+  }
+
+  void OnAlgebraicCon(int, int expr) { depth = expr; }
+};
+
+TEST(NLTest, ReadDeepExpr) {
+  enum {DEPTH = 300000};
+  // Left-nested: ((v1 + 1) + 1) ...
+  fmt::MemoryWriter w;
+  w << "C0\n";
+  for (int i = 0; i < DEPTH; ++i)
+    w << "o0\n";
+  w << "v1\n";
+  for (int i = 0; i < DEPTH; ++i)
+    w << "n1\n";
+  DepthHandler handler;
+  ReadNLString(FormatHeader(MakeHeader()) + w.str(), handler);
+  EXPECT_EQ(DEPTH, handler.depth);
+  EXPECT_EQ(DEPTH, handler.num_binary);
+  // Right-nested with unary minus: -(v1 + -(v1 + ...)).
+  w.clear();
+  w << "C0\n";
+  for (int i = 0; i < DEPTH; ++i)
+    w << "o16\no0\nv1\n";
+  w << "n0\n";
+  handler = DepthHandler();
+  ReadNLString(FormatHeader(MakeHeader()) + w.str(), handler);
+  EXPECT_EQ(2 * DEPTH, handler.depth);
+  EXPECT_EQ(DEPTH, handler.num_binary);
+}
+
+#ifdef MP_USE_THREAD
+
+// An .nl reader that reads from a string passed instead of a file name.
+struct NLStringReader {
+  template <typename Handler>
+  void Read(fmt::StringRef str, Handler &handler, int flags) {
+    ReadNLString(str, handler, "(input)", flags);
+  }
+};
+
+template <typename Handler>
+std::string ReadNLPipelined(std::string body, int flags = 0) {
+  Handler handler;
+  NLStringReader reader;
+  mp::internal::ReadNLPipelined(
+        reader, FormatHeader(MakeHeader()) + body, handler, flags);
+  return handler.log.str();
+}
+
+std::string ReadNLPipelined(std::string body, int flags = 0) {
+  return ReadNLPipelined<TestNLHandler>(body, flags);
+}
+
+TEST(NLPipelineTest, Replay) {
+  const char *const bodies[] = {
+    "O0 1\nv0\n", "C0\nn4.2\n", "C0\nn0\n", "C0\nv5\n", "C0\no13\nv3\n",
+    "C0\no0\nv1\nn42\n", "C0\no35\nn1\nv1\nv2\n",
+    "C0\no64\n2\nn-1.0\ns0\nl1\nv1\n", "C0\nf1 2\nv1\nn0\n",
+    "C0\no11\n3\nv4\nn5\nv1\n", "C0\no54\n3\nv4\nn5\nv1\n",
+    "C0\no59\n3\nn1\no24\nv1\nn42\nn0\n", "C0\no60\n3\nv4\nn5\nv1\n",
+    "C0\no61\n3\nh1:a\nh1:b\nn42\n", "C0\nf1 1\no65\nn1\nv1\nh3:abc\n",
+    "L0\nn1\n", "L0\no34\nn0\n", "L0\no20\nn1\nn0\n", "L0\no23\nv1\nn0\n",
+    "L0\no63\nv1\no59\n1\nn1\n", "L0\no72\nn0\nn1\nn1\n",
+    "L0\no71\n3\nn1\nn0\nn1\n", "L0\no74\n2\nv1\nv2\n",
+    "r\n21.1\n1 22\n4 33\n3\n0 44 55\n5 7 2\n5 2 5\n",
+    "G0 2\n1 1.3\n3 5\n", "J0 2\n1 1.3\n3 5\n", "k4\n1\n3\n5\n9\n",
+    "x5\n4 1.1\n3 0\n2 1\n1 2\n0 3\n", "d2\n4 1.1\n3 0\n", "F0 1 2 foo\n",
+    "V5 2 1\n1 2.0\n0 3\no2\nv0\nn42\n",
+    "S0 5 foo\n0 3\n1 2\n2 1\n3 2\n4 3\n", "S4 2 bar\n0 1.5\n3 2.5\n"
+  };
+  for (std::size_t i = 0; i < sizeof(bodies) / sizeof(*bodies); ++i) {
+    EXPECT_EQ(ReadNL(bodies[i]), ReadNLPipelined(bodies[i]));
+    EXPECT_EQ(ReadNL(bodies[i]),
+              ReadNLPipelined(bodies[i], mp::READ_BOUNDS_FIRST));
+  }
+}
+
+TEST(NLPipelineTest, MultipleChunks) {
+  fmt::MemoryWriter body;
+  int num_args = 10000;
+  body << "C0\no54\n" << num_args << "\n";
+  for (int i = 0; i < num_args; ++i)
+    body << "o2\nv" << i % 5 << "\nn" << i << "\n";
+  EXPECT_EQ(ReadNL(body.str()), ReadNLPipelined(body.str()));
+}
+
+TEST(NLPipelineTest, ReadError) {
+  EXPECT_THROW_MSG(ReadNLPipelined("C0\nx\n"), ReadError,
+                   "(input):18:1: expected expression");
+}
+
+struct TestError {};
+
+// A handler that throws an exception when receiving a constraint.
+struct ThrowingNLHandler : TestNLHandler {
+  void OnAlgebraicCon(int, std::string) { throw TestError(); }
+};
+
+TEST(NLPipelineTest, HandlerError) {
+  fmt::MemoryWriter body;
+  // Make the input large enough for the reader to block on a full queue.
+  for (int i = 0; i < 100000; ++i)
+    body << "x1\n0 " << i << "\n";
+  body << "C0\nn1\n";
+  for (int i = 0; i < 100000; ++i)
+    body << "x1\n0 " << i << "\n";
+  EXPECT_THROW(ReadNLPipelined<ThrowingNLHandler>(body.str()), TestError);
+}
+#endif  // MP_USE_THREAD
 }  // namespace
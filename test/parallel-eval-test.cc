@@ -0,0 +1,128 @@
+/*
+ Parallel evaluator tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/parallel-eval.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::Tape;
+using mp::JacobianEvaluator;
+using mp::ParallelEvaluator;
+using mp::ThreadPool;
+
+namespace ex = mp::expr;
+
+class ParallelEvalTest : public ::testing::Test {
+ protected:
+  Problem p;
+
+  enum {NUM_VARS = 10};
+
+  ParallelEvalTest() {
+    for (int i = 0; i < NUM_VARS; ++i)
+      p.AddVar(0, 0);
+  }
+
+  NumericExpr x(int index) { return p.MakeVariable(index % NUM_VARS); }
+
+  // Adds constraints of different structure sharing a common expression.
+  void AddCons(int num_cons) {
+    Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+    linear.AddTerm(0, 2);
+    p.EndCommonExpr(linear, p.MakeUnary(ex::SIN, x(1)), 1);
+    NumericExpr common = p.MakeCommonExpr(0);
+    for (int i = 0; i < num_cons; ++i) {
+      NumericExpr e = p.MakeBinary(ex::MUL, x(i), x(i + 1));
+      switch (i % 3) {
+      case 0:
+        e = p.MakeBinary(ex::ADD, e, common);
+        break;
+      case 1:
+        e = p.MakeIf(p.MakeRelational(ex::LT, x(i + 2),
+                                      p.MakeNumericConstant(0.5)),
+                     p.MakeUnary(ex::EXP, e), common);
+        break;
+      }
+      p.AddCon(0, 0, e, 1).AddTerm((i + 3) % NUM_VARS, i);
+    }
+  }
+
+  // Checks that parallel evaluation gives the same results as sequential.
+  void Check(ThreadPool &pool) {
+    Tape tape(p);
+    ParallelEvaluator eval(tape, pool);
+    JacobianEvaluator jac(tape);
+    int num_cons = tape.num_cons();
+    EXPECT_LE(eval.num_chunks(),
+              ParallelEvaluator::CHUNKS_PER_THREAD * pool.num_threads());
+    EXPECT_EQ(num_cons, eval.chunk_start(eval.num_chunks()));
+    for (int k = 0; k < 2; ++k) {
+      std::vector<double> x(NUM_VARS);
+      for (int i = 0; i < NUM_VARS; ++i)
+        x[i] = 0.1 * (i + 1) + 0.3 * k;
+      jac.Evaluate(x.data());
+      std::vector<double> expected(jac.num_jac_nonzeros() + 1);
+      jac.GetJacobian(expected.data());
+      std::vector<double> values(jac.num_jac_nonzeros() + 1);
+      std::vector<double> con_values(num_cons + 1);
+      eval.GetJacobian(x.data(), values.data(), con_values.data());
+      for (int i = 0; i < jac.num_jac_nonzeros(); ++i)
+        EXPECT_EQ(expected[i], values[i]);
+      std::vector<double> con_values2(num_cons + 1);
+      eval.GetConValues(x.data(), con_values2.data());
+      for (int i = 0; i < num_cons; ++i) {
+        EXPECT_EQ(jac.evaluator().con_value(i), con_values[i]);
+        EXPECT_EQ(jac.evaluator().con_value(i), con_values2[i]);
+      }
+    }
+  }
+};
+
+TEST_F(ParallelEvalTest, Evaluate) {
+  AddCons(100);
+  ThreadPool pool(4);
+  Check(pool);
+}
+
+TEST_F(ParallelEvalTest, FewerConsThanThreads) {
+  AddCons(3);
+  ThreadPool pool(4);
+  Check(pool);
+}
+
+TEST_F(ParallelEvalTest, NoCons) {
+  ThreadPool pool(2);
+  Tape tape(p);
+  ParallelEvaluator eval(tape, pool);
+  EXPECT_EQ(0, eval.num_chunks());
+  double x[NUM_VARS] = {};
+  eval.GetConValues(x, 0);
+}
+
+TEST_F(ParallelEvalTest, SingleThread) {
+  AddCons(20);
+  ThreadPool pool(1);
+  Check(pool);
+}
@@ -0,0 +1,414 @@
+/*
+ Presolve tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <limits>
+#include <vector>
+
+#include "gtest-extra.h"
+#include "mp/solver.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::Presolver;
+
+namespace ex = mp::expr;
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+class PresolveTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y;
+
+  // Adds variables x and y with the specified bounds.
+  void AddVars(double x_lb = -INF, double x_ub = INF,
+               double y_lb = -INF, double y_ub = INF) {
+    p.AddVar(x_lb, x_ub);
+    p.AddVar(y_lb, y_ub);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+};
+}
+
+TEST_F(PresolveTest, NoReductions) {
+  AddVars();
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(2, reduced.num_vars());
+  EXPECT_EQ(1, reduced.num_algebraic_cons());
+  EXPECT_EQ(0u, presolver.reductions().size());
+  EXPECT_EQ(ex::MUL, reduced.algebraic_con(0).nonlinear_expr().kind());
+}
+
+TEST_F(PresolveTest, RemoveFixedVar) {
+  AddVars(2, 2);
+  // x + y + y^2 <= 5
+  Problem::LinearConBuilder con =
+      p.AddCon(-INF, 5, p.MakeUnary(ex::POW2, y), 2);
+  con.AddTerm(0, 1);
+  con.AddTerm(1, 1);
+  // minimize x * y + 3 * x
+  p.AddObj(mp::obj::MIN, p.MakeBinary(ex::MUL, x, y), 1).AddTerm(0, 3);
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(-1, presolver.var_index(0));
+  EXPECT_EQ(0, presolver.var_index(1));
+  ASSERT_EQ(1, reduced.num_vars());
+  ASSERT_EQ(1, reduced.num_algebraic_cons());
+  Problem::AlgebraicCon c = reduced.algebraic_con(0);
+  EXPECT_EQ(-INF, c.lb());
+  EXPECT_EQ(3, c.ub());
+  ASSERT_EQ(1, c.linear_expr().num_terms());
+  EXPECT_EQ(0, c.linear_expr().begin()->var_index());
+  // The objective becomes 2 * y + 6.
+  NumericExpr obj = reduced.obj(0).nonlinear_expr();
+  ASSERT_EQ(ex::ADD, obj.kind());
+  mp::BinaryExpr sum = mp::Cast<mp::BinaryExpr>(obj);
+  EXPECT_EQ(6, mp::Cast<mp::NumericConstant>(sum.rhs()).value());
+  EXPECT_EQ(0, reduced.obj(0).linear_expr().num_terms());
+  EXPECT_EQ(1, presolver.num_removed_vars());
+}
+
+TEST_F(PresolveTest, SingletonCon) {
+  AddVars();
+  // 3 <= -2 * x <= 6
+  p.AddCon(3, 6, 1).AddTerm(0, -2);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(-1, presolver.con_index(0));
+  EXPECT_EQ(0, presolver.con_index(1));
+  EXPECT_EQ(1, reduced.num_algebraic_cons());
+  EXPECT_EQ(-3, reduced.var(0).lb());
+  EXPECT_EQ(-1.5, reduced.var(0).ub());
+  ASSERT_EQ(1u, presolver.reductions().size());
+  Presolver::Reduction r = presolver.reductions()[0];
+  EXPECT_EQ(Presolver::Reduction::SINGLETON_CON, r.kind);
+  EXPECT_EQ(0, r.var);
+  EXPECT_EQ(0, r.con);
+  EXPECT_EQ(-2, r.value);
+}
+
+TEST_F(PresolveTest, IntegerSingletonCon) {
+  AddVars();
+  p.AddVar(-INF, INF, mp::var::INTEGER);
+  // 0.5 <= 2 * z <= 7
+  p.AddCon(0.5, 7, 1).AddTerm(2, 2);
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(1, reduced.var(2).lb());
+  EXPECT_EQ(3, reduced.var(2).ub());
+}
+
+TEST_F(PresolveTest, ChainOfSingletons) {
+  AddVars();
+  // x == 1, x + y == 3, x * y <= 10
+  p.AddCon(1, 1, 1).AddTerm(0, 1);
+  Problem::LinearConBuilder con = p.AddCon(3, 3, 2);
+  con.AddTerm(0, 1);
+  con.AddTerm(1, 1);
+  p.AddCon(-INF, 10, p.MakeBinary(ex::MUL, x, y));
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(0, reduced.num_vars());
+  EXPECT_EQ(0, reduced.num_algebraic_cons());
+  EXPECT_EQ(3, presolver.num_removed_cons());
+  std::vector<double> values, duals;
+  presolver.Postsolve(0, 0, values, duals);
+  EXPECT_TRUE(values.empty());
+  double dummy = 0;
+  presolver.Postsolve(&dummy, 0, values, duals);
+  ASSERT_EQ(2u, values.size());
+  EXPECT_EQ(1, values[0]);
+  EXPECT_EQ(2, values[1]);
+}
+
+TEST_F(PresolveTest, EmptyCon) {
+  AddVars(1, 1);
+  // 0 <= x - 1 <= 0 is dropped, x >= 2 is infeasible and kept.
+  p.AddCon(1, 1, 1).AddTerm(0, 1);
+  p.AddCon(2, INF, 1).AddTerm(0, 1);
+  Presolver presolver(p);
+  EXPECT_EQ(-1, presolver.con_index(0));
+  EXPECT_EQ(0, presolver.con_index(1));
+  Problem::AlgebraicCon c = presolver.problem().algebraic_con(0);
+  EXPECT_EQ(1, c.lb());
+  EXPECT_EQ(0, c.linear_expr().num_terms());
+}
+
+TEST_F(PresolveTest, FoldConstants) {
+  AddVars(0, 0);
+  // exp(x) + y^2 <= 5
+  p.AddCon(-INF, 5, p.MakeBinary(
+             ex::ADD, p.MakeUnary(ex::EXP, x), p.MakeUnary(ex::POW2, y)));
+  // x + 1 >= 0 is always true.
+  p.AddCon(p.MakeRelational(ex::GE, p.MakeBinary(ex::ADD, x, MakeConst(1)),
+                            MakeConst(0)));
+  // if x == 0 then y else -y
+  p.AddCon(0, 1, p.MakeIf(p.MakeRelational(ex::EQ, x, MakeConst(0)),
+                          y, p.MakeUnary(ex::MINUS, y)));
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  EXPECT_EQ(0, reduced.num_logical_cons());
+  ASSERT_EQ(2, reduced.num_algebraic_cons());
+  NumericExpr e = reduced.algebraic_con(0).nonlinear_expr();
+  ASSERT_EQ(ex::ADD, e.kind());
+  mp::BinaryExpr sum = mp::Cast<mp::BinaryExpr>(e);
+  EXPECT_EQ(ex::POW2, sum.lhs().kind());
+  EXPECT_EQ(1, mp::Cast<mp::NumericConstant>(sum.rhs()).value());
+  EXPECT_EQ(ex::VARIABLE, reduced.algebraic_con(1).nonlinear_expr().kind());
+}
+
+TEST_F(PresolveTest, ConstantNonlinearPartMovesToBounds) {
+  AddVars(0, 0);
+  // y + sin(x) + 2 in [0, 4]
+  p.AddCon(0, 4, p.MakeBinary(ex::ADD, p.MakeUnary(ex::SIN, x),
+                              MakeConst(2)), 1).AddTerm(1, 1);
+  Presolver presolver(p);
+  Problem::AlgebraicCon c = presolver.problem().algebraic_con(0);
+  EXPECT_FALSE(c.nonlinear_expr());
+  EXPECT_EQ(-2, c.lb());
+  EXPECT_EQ(2, c.ub());
+}
+
+TEST_F(PresolveTest, CommonExpr) {
+  AddVars(2, 2);
+  // e = x + y^2
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+  linear.AddTerm(0, 1);
+  p.EndCommonExpr(linear, p.MakeUnary(ex::POW2, y), 1);
+  p.AddCon(0, 1, p.MakeCommonExpr(0));
+  Presolver presolver(p);
+  const Problem &reduced = presolver.problem();
+  ASSERT_EQ(1, reduced.num_common_exprs());
+  EXPECT_EQ(0, reduced.common_expr(0).linear_expr().num_terms());
+  EXPECT_EQ(ex::ADD, reduced.common_expr(0).nonlinear_expr().kind());
+  EXPECT_EQ(ex::COMMON_EXPR, reduced.algebraic_con(0).nonlinear_expr().kind());
+}
+
+TEST_F(PresolveTest, PostsolveDuals) {
+  // minimize 2 * x + y subject to x + y >= 2, 2 * x >= 3, y >= 0
+  AddVars(-INF, INF, 0, INF);
+  p.AddObj(mp::obj::MIN, 2).AddTerm(0, 2);
+  p.obj(0).linear_expr().AddTerm(1, 1);
+  Problem::LinearConBuilder con = p.AddCon(2, INF, 2);
+  con.AddTerm(0, 1);
+  con.AddTerm(1, 1);
+  p.AddCon(3, INF, 1).AddTerm(0, 2);
+  Presolver presolver(p);
+  EXPECT_EQ(1.5, presolver.problem().var(0).lb());
+  // The optimal solution of the reduced problem is x = 1.5, y = 0.5 with
+  // the dual 1 of the first constraint.
+  double values[] = {1.5, 0.5}, dual_values[] = {1};
+  std::vector<double> orig_values, orig_duals;
+  presolver.Postsolve(values, dual_values, orig_values, orig_duals);
+  ASSERT_EQ(2u, orig_values.size());
+  EXPECT_EQ(1.5, orig_values[0]);
+  EXPECT_EQ(0.5, orig_values[1]);
+  ASSERT_EQ(2u, orig_duals.size());
+  EXPECT_EQ(1, orig_duals[0]);
+  EXPECT_EQ(0.5, orig_duals[1]);
+  // The bound is inactive at x = 2, y = 0.
+  values[0] = 2;
+  values[1] = 0;
+  dual_values[0] = 2;
+  presolver.Postsolve(values, dual_values, orig_values, orig_duals);
+  EXPECT_EQ(0, orig_duals[1]);
+}
+
+TEST_F(PresolveTest, Complementarity) {
+  AddVars();
+  p.AddCon(0, 1, 1).AddTerm(0, 1);
+  p.SetComplement(0, 1, 0);
+  EXPECT_THROW(Presolver presolver(p), mp::Error);
+}
+
+TEST_F(PresolveTest, CopySuffixes) {
+  AddVars(1, 1);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  p.AddCon(0, 1, 1).AddTerm(0, 1);
+  Problem::IntSuffixHandler priority =
+      p.AddIntSuffix("priority", mp::suf::VAR, 0);
+  priority.SetValue(0, 5);
+  priority.SetValue(1, 3);
+  Problem::DblSuffixHandler scale =
+      p.AddDblSuffix("scale", mp::suf::CON | mp::suf::FLOAT, 0);
+  scale.SetValue(0, 1.5);
+  scale.SetValue(1, 2.5);
+  Presolver presolver(p);
+  EXPECT_EQ(-1, presolver.var_index(0));
+  EXPECT_EQ(-1, presolver.con_index(1));
+  Problem &reduced = presolver.problem();
+  const mp::Suffix *suffix = reduced.suffixes(mp::suf::VAR).Find("priority");
+  ASSERT_TRUE(suffix != 0);
+  EXPECT_EQ(mp::suf::VAR, suffix->kind());
+  EXPECT_FALSE(suffix->is_dbl());
+  EXPECT_EQ(3, suffix->value(0));
+  suffix = reduced.suffixes(mp::suf::CON).Find("scale");
+  ASSERT_TRUE(suffix != 0);
+  EXPECT_TRUE(suffix->is_dbl());
+  EXPECT_EQ(1.5, suffix->dbl_value(0));
+}
+
+TEST_F(PresolveTest, PostsolveDblSuffixes) {
+  AddVars(1, 1);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  Problem::IntSuffixHandler priority =
+      p.AddIntSuffix("priority", mp::suf::VAR, 0);
+  priority.SetValue(0, 5);
+  priority.SetValue(1, 3);
+  Presolver presolver(p);
+  Problem &reduced = presolver.problem();
+  reduced.suffixes(mp::suf::VAR).Find("priority")->set_value(0, 7);
+  reduced.AddDblSuffix("ratio", mp::suf::VAR | mp::suf::OUTPUT, 0).
+      SetValue(0, 0.25);
+  presolver.PostsolveSuffixes(p);
+  // Values of removed variables are kept.
+  const mp::Suffix *suffix = p.suffixes(mp::suf::VAR).Find("priority");
+  EXPECT_EQ(5, suffix->value(0));
+  EXPECT_EQ(7, suffix->value(1));
+  suffix = p.suffixes(mp::suf::VAR).Find("ratio");
+  ASSERT_TRUE(suffix != 0);
+  EXPECT_TRUE(suffix->is_dbl());
+  EXPECT_EQ(0, suffix->dbl_value(0));
+  EXPECT_EQ(0.25, suffix->dbl_value(1));
+}
+
+namespace {
+
+// A solver that checks that it receives the reduced problem and returns
+// its solution.
+class PresolveSolver : public mp::SolverImpl<Problem> {
+ public:
+  int num_vars;
+  int priority;
+  bool set_sstatus;
+
+  PresolveSolver()
+    : mp::SolverImpl<Problem>("test"), num_vars(-1), priority(-1),
+      set_sstatus(false) {}
+
+  // Records the number of variables and the "priority" suffix value of
+  // the first variable if there is one. If set_sstatus is true, sets
+  // the output suffix "sstatus" of variable i to i + 1.
+  void Solve(Problem &p, mp::SolutionHandler &sh) {
+    num_vars = p.num_vars();
+    if (const mp::Suffix *s = p.suffixes(mp::suf::VAR).Find("priority"))
+      priority = s->value(0);
+    if (set_sstatus) {
+      Problem::IntSuffixHandler sstatus =
+          p.AddIntSuffix("sstatus", mp::suf::VAR | mp::suf::OUTPUT, 0);
+      for (int i = 0; i < num_vars; ++i)
+        sstatus.SetValue(i, i + 1);
+    }
+    std::vector<double> values(num_vars, 42), duals(p.num_algebraic_cons());
+    sh.HandleSolution(0, "done", values.empty() ? 0 : &values[0],
+                      duals.empty() ? 0 : &duals[0], 0);
+  }
+};
+
+struct TestSolutionHandler : mp::BasicSolutionHandler {
+  std::vector<double> values;
+  std::vector<double> dual_values;
+
+  void HandleSolution(int, fmt::StringRef, const double *values,
+                      const double *dual_values, double) {
+    this->values.assign(values, values + 2);
+    this->dual_values.assign(dual_values, dual_values + 1);
+  }
+};
+}
+
+TEST_F(PresolveTest, SolveWithPresolve) {
+  AddVars(1, 1);
+  Problem::LinearConBuilder con = p.AddCon(-INF, 5, 2);
+  con.AddTerm(0, 1);
+  con.AddTerm(1, 1);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  PresolveSolver solver;
+  TestSolutionHandler handler;
+  mp::internal::Solve(solver, p, handler);
+  EXPECT_EQ(2, solver.num_vars);
+  solver.SetIntOption("presolve", 1);
+  mp::internal::Solve(solver, p, handler);
+  EXPECT_EQ(1, solver.num_vars);
+  ASSERT_EQ(2u, handler.values.size());
+  EXPECT_EQ(1, handler.values[0]);
+  EXPECT_EQ(42, handler.values[1]);
+}
+
+TEST_F(PresolveTest, PostsolveSuffixes) {
+  AddVars(1, 1);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  PresolveSolver solver;
+  solver.SetIntOption("presolve", 1);
+  solver.set_sstatus = true;
+  TestSolutionHandler handler;
+  mp::internal::Solve(solver, p, handler);
+  EXPECT_EQ(1, solver.num_vars);
+  const mp::Suffix *sstatus = p.suffixes(mp::suf::VAR).Find("sstatus");
+  ASSERT_TRUE(sstatus != 0);
+  EXPECT_EQ(mp::suf::VAR | mp::suf::OUTPUT, sstatus->kind());
+  EXPECT_EQ(0, sstatus->value(0));
+  EXPECT_EQ(1, sstatus->value(1));
+}
+
+TEST_F(PresolveTest, PresolveWithSuffixes) {
+  AddVars(1, 1);
+  p.AddCon(0, 1, p.MakeBinary(ex::MUL, x, y));
+  p.AddIntSuffix("priority", mp::suf::VAR, 0).SetValue(1, 3);
+  PresolveSolver solver;
+  solver.SetIntOption("presolve", 1);
+  TestSolutionHandler handler;
+  mp::internal::Solve(solver, p, handler);
+  EXPECT_EQ(1, solver.num_vars);
+  EXPECT_EQ(3, solver.priority);
+}
+
+TEST_F(PresolveTest, SkipPresolveWithComplementarity) {
+  AddVars();
+  p.AddCon(0, 1, 1).AddTerm(0, 1);
+  p.SetComplement(0, 1, 0);
+  PresolveSolver solver;
+  solver.SetIntOption("presolve", 1);
+  TestSolutionHandler handler;
+  EXPECT_WRITE(stdout, mp::internal::Solve(solver, p, handler),
+               "Presolve skipped: complementarity conditions "
+               "are not supported\n");
+  EXPECT_EQ(2, solver.num_vars);
+}
+
+struct OtherProblemBuilder {};
+
+TEST(PresolveOptionTest, OnlyForProblemSolvers) {
+  EXPECT_TRUE(PresolveSolver().FindOption("presolve") != 0);
+  mp::SolverImpl<OtherProblemBuilder> solver("test");
+  EXPECT_EQ(0, solver.FindOption("presolve"));
+}
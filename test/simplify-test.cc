@@ -0,0 +1,258 @@
+/*
+ Expression simplification tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/simplify.h"
+#include "mp/tape.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::Cast;
+
+namespace ex = mp::expr;
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+
+class SimplifyTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y;
+
+  SimplifyTest() {
+    p.AddVar(-INF, INF);
+    p.AddVar(-INF, INF);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  NumericExpr MakeBinary(ex::Kind kind, NumericExpr lhs, NumericExpr rhs) {
+    return p.MakeBinary(kind, lhs, rhs);
+  }
+
+  // Adds a constraint with the nonlinear part e, simplifies the problem
+  // and returns the nonlinear part of the simplified constraint.
+  NumericExpr SimplifyCon(NumericExpr e) {
+    int index = p.num_algebraic_cons();
+    p.AddCon(0, 0, e);
+    mp::Simplify(p);
+    return p.algebraic_con(index).nonlinear_expr();
+  }
+
+  // Returns the argument of a unary expression checking its kind.
+  static NumericExpr GetArg(NumericExpr e, ex::Kind kind) {
+    EXPECT_EQ(kind, e.kind());
+    return Cast<mp::UnaryExpr>(e).arg();
+  }
+
+  static double GetValue(NumericExpr e) {
+    mp::NumericConstant c = Cast<mp::NumericConstant>(e);
+    EXPECT_TRUE(c != 0);
+    return c ? c.value() : 0;
+  }
+};
+}
+
+TEST_F(SimplifyTest, FoldConstants) {
+  NumericExpr e = p.MakeUnary(
+        ex::EXP, MakeBinary(ex::MUL, MakeConst(2), MakeConst(3)));
+  p.AddObj(mp::obj::MIN, e);
+  mp::Simplify(p);
+  EXPECT_EQ(std::exp(6.0), GetValue(p.obj(0).nonlinear_expr()));
+}
+
+TEST_F(SimplifyTest, DontFoldDomainErrors) {
+  NumericExpr e = SimplifyCon(p.MakeUnary(ex::LOG, MakeConst(-1)));
+  EXPECT_EQ(ex::LOG, e.kind());
+}
+
+TEST_F(SimplifyTest, RemoveIdentities) {
+  // sin(x * 1 + 0) -> sin(x)
+  NumericExpr sum = MakeBinary(
+        ex::ADD, MakeBinary(ex::MUL, x, MakeConst(1)), MakeConst(0));
+  NumericExpr e = SimplifyCon(p.MakeUnary(ex::SIN, sum));
+  EXPECT_EQ(ex::VARIABLE, GetArg(e, ex::SIN).kind());
+  // sin(-(-x) / 1) -> sin(x)
+  NumericExpr neg = p.MakeUnary(ex::MINUS, p.MakeUnary(ex::MINUS, x));
+  e = SimplifyCon(p.MakeUnary(ex::SIN, MakeBinary(ex::DIV, neg, MakeConst(1))));
+  EXPECT_EQ(ex::VARIABLE, GetArg(e, ex::SIN).kind());
+  // sin(x ^ 1 + 0 * cos(y)) -> sin(x)
+  e = SimplifyCon(p.MakeUnary(ex::SIN, MakeBinary(
+      ex::ADD, MakeBinary(ex::POW, x, MakeConst(1)),
+      MakeBinary(ex::MUL, MakeConst(0), p.MakeUnary(ex::COS, y)))));
+  EXPECT_EQ(ex::VARIABLE, GetArg(e, ex::SIN).kind());
+  // x ^ 0 -> 1
+  p.AddObj(mp::obj::MIN, MakeBinary(ex::POW, x, MakeConst(0)));
+  mp::Simplify(p);
+  EXPECT_EQ(1, GetValue(p.obj(0).nonlinear_expr()));
+}
+
+TEST_F(SimplifyTest, Pow) {
+  NumericExpr e = SimplifyCon(MakeBinary(ex::POW, x, MakeConst(2)));
+  EXPECT_EQ(ex::VARIABLE, GetArg(e, ex::POW2).kind());
+  e = SimplifyCon(MakeBinary(ex::POW_CONST_EXP, x, MakeConst(2)));
+  EXPECT_EQ(ex::POW2, e.kind());
+  e = SimplifyCon(MakeBinary(ex::POW, x, MakeConst(3)));
+  EXPECT_EQ(ex::POW_CONST_EXP, e.kind());
+  e = SimplifyCon(MakeBinary(ex::POW, MakeConst(2), x));
+  EXPECT_EQ(ex::POW_CONST_BASE, e.kind());
+  e = SimplifyCon(MakeBinary(ex::POW, x, y));
+  EXPECT_EQ(ex::POW, e.kind());
+}
+
+TEST_F(SimplifyTest, FlattenSums) {
+  // cos((x + (y - sin(x))) + x * y)
+  NumericExpr sin_x = p.MakeUnary(ex::SIN, x);
+  NumericExpr xy = MakeBinary(ex::MUL, x, y);
+  NumericExpr sum = MakeBinary(
+        ex::ADD, MakeBinary(ex::ADD, x, MakeBinary(ex::SUB, y, sin_x)), xy);
+  NumericExpr e = GetArg(SimplifyCon(p.MakeUnary(ex::COS, sum)), ex::COS);
+  ASSERT_EQ(ex::SUM, e.kind());
+  mp::IteratedExpr flat = Cast<mp::IteratedExpr>(e);
+  ASSERT_EQ(4, flat.num_args());
+  mp::IteratedExpr::iterator i = flat.begin();
+  EXPECT_EQ(0, Cast<mp::Reference>(*i).index());
+  EXPECT_EQ(1, Cast<mp::Reference>(*++i).index());
+  EXPECT_EQ(ex::SIN, GetArg(*++i, ex::MINUS).kind());
+  EXPECT_EQ(ex::MUL, (*++i).kind());
+}
+
+TEST_F(SimplifyTest, CombineLikeTerms) {
+  // sin(2 * x + (y - x) * 3 + 1 + 2) -> sin(-x + 3 * y + 3)
+  NumericExpr sum = MakeBinary(ex::ADD, MakeBinary(ex::MUL, MakeConst(2), x),
+      MakeBinary(ex::MUL, MakeBinary(ex::SUB, y, x), MakeConst(3)));
+  Problem::IteratedExprBuilder b = p.BeginIterated(ex::SUM, 3);
+  b.AddArg(sum);
+  b.AddArg(MakeConst(1));
+  b.AddArg(MakeConst(2));
+  NumericExpr e = GetArg(SimplifyCon(p.MakeUnary(ex::SIN, p.EndIterated(b))),
+                         ex::SIN);
+  ASSERT_EQ(ex::SUM, e.kind());
+  mp::IteratedExpr flat = Cast<mp::IteratedExpr>(e);
+  ASSERT_EQ(3, flat.num_args());
+  mp::IteratedExpr::iterator i = flat.begin();
+  EXPECT_EQ(ex::VARIABLE, GetArg(*i, ex::MINUS).kind());
+  mp::BinaryExpr term = Cast<mp::BinaryExpr>(*++i);
+  EXPECT_EQ(3, GetValue(term.lhs()));
+  EXPECT_EQ(1, Cast<mp::Reference>(term.rhs()).index());
+  EXPECT_EQ(3, GetValue(*++i));
+}
+
+TEST_F(SimplifyTest, HoistLinearTerms) {
+  // 0 <= x + (x * y + 2 * x + 3 - y) <= 10
+  NumericExpr e = MakeBinary(ex::SUB, MakeBinary(ex::ADD, MakeBinary(
+      ex::ADD, MakeBinary(ex::MUL, x, y), MakeBinary(ex::MUL, MakeConst(2), x)),
+      MakeConst(3)), y);
+  p.AddCon(0, 10, e, 1).AddTerm(0, 1);
+  mp::Simplify(p);
+  Problem::AlgebraicCon con = p.algebraic_con(0);
+  EXPECT_EQ(-3, con.lb());
+  EXPECT_EQ(7, con.ub());
+  EXPECT_EQ(ex::MUL, con.nonlinear_expr().kind());
+  const mp::LinearExpr &linear = con.linear_expr();
+  ASSERT_EQ(2, linear.num_terms());
+  mp::LinearExpr::iterator i = linear.begin();
+  EXPECT_EQ(0, i->var_index());
+  EXPECT_EQ(3, i->coef());
+  ++i;
+  EXPECT_EQ(1, i->var_index());
+  EXPECT_EQ(-1, i->coef());
+}
+
+TEST_F(SimplifyTest, LinearConstraint) {
+  p.AddCon(-INF, 1, MakeBinary(ex::SUB, x, MakeConst(2)));
+  mp::Simplify(p);
+  Problem::AlgebraicCon con = p.algebraic_con(0);
+  EXPECT_FALSE(con.nonlinear_expr());
+  EXPECT_EQ(-INF, con.lb());
+  EXPECT_EQ(3, con.ub());
+  EXPECT_EQ(1, con.linear_expr().num_terms());
+}
+
+TEST_F(SimplifyTest, ObjConstant) {
+  p.AddObj(mp::obj::MIN, MakeBinary(
+             ex::ADD, MakeBinary(ex::MUL, x, MakeConst(2)), MakeConst(5)));
+  mp::Simplify(p);
+  Problem::Objective obj = p.obj(0);
+  EXPECT_EQ(5, GetValue(obj.nonlinear_expr()));
+  ASSERT_EQ(1, obj.linear_expr().num_terms());
+  EXPECT_EQ(2, obj.linear_expr().begin()->coef());
+}
+
+TEST_F(SimplifyTest, CommonExpr) {
+  // x * y + 2 * y
+  NumericExpr e = MakeBinary(ex::ADD, MakeBinary(ex::MUL, x, y),
+                             MakeBinary(ex::MUL, MakeConst(2), y));
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(0);
+  p.EndCommonExpr(linear, e, 0);
+  mp::Simplify(p);
+  Problem::CommonExpr ce = p.common_expr(0);
+  EXPECT_EQ(ex::MUL, ce.nonlinear_expr().kind());
+  ASSERT_EQ(1, ce.linear_expr().num_terms());
+  EXPECT_EQ(1, ce.linear_expr().begin()->var_index());
+  EXPECT_EQ(2, ce.linear_expr().begin()->coef());
+}
+
+TEST_F(SimplifyTest, PreserveValues) {
+  p.AddVar(-INF, INF);
+  NumericExpr z = p.MakeVariable(2);
+  // exp(x / 4 - (y - 2 * z)) * (x + y) ^ 2 + 3 - z
+  NumericExpr e = MakeBinary(ex::SUB, MakeBinary(ex::ADD, MakeBinary(
+      ex::MUL, p.MakeUnary(ex::EXP, MakeBinary(
+          ex::SUB, MakeBinary(ex::DIV, x, MakeConst(4)),
+          MakeBinary(ex::SUB, y, MakeBinary(ex::MUL, MakeConst(2), z)))),
+      MakeBinary(ex::POW, MakeBinary(ex::ADD, x, y), MakeConst(2))),
+      MakeConst(3)), z);
+  p.AddObj(mp::obj::MIN, e, 1).AddTerm(0, 1.5);
+  p.AddCon(1, 5, e, 1).AddTerm(2, -1);
+  p.AddCon(1, 5, p.MakeUnary(ex::SIN, e));
+  const double point[] = {0.3, -0.2, 0.4};
+  std::vector<double> before;
+  {
+    mp::Tape tape(p);
+    mp::TapeEvaluator eval(tape);
+    eval.Evaluate(point);
+    before.push_back(eval.obj_value(0));
+    for (int i = 0; i < p.num_algebraic_cons(); ++i)
+      before.push_back(eval.con_value(i) - p.algebraic_con(i).lb());
+  }
+  mp::Simplify(p);
+  mp::Tape tape(p);
+  mp::TapeEvaluator eval(tape);
+  eval.Evaluate(point);
+  EXPECT_NEAR(before[0], eval.obj_value(0), 1e-12);
+  for (int i = 0; i < p.num_algebraic_cons(); ++i) {
+    EXPECT_NEAR(before[i + 1],
+                eval.con_value(i) - p.algebraic_con(i).lb(), 1e-12);
+  }
+  EXPECT_EQ(ex::POW2, Cast<mp::BinaryExpr>(
+              p.algebraic_con(0).nonlinear_expr()).rhs().kind());
+}
@@ -32,6 +32,13 @@
 
 #ifdef _WIN32
 # define putenv _putenv
+#else
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#ifdef MP_USE_THREAD
+# include <thread>
 #endif
 
 #ifndef MP_TEST_DATA_DIR
@@ -292,6 +299,12 @@ TEST(SolverTest, BasicSolverCtor) {
   EXPECT_STREQ("testsolver", s.version());
   EXPECT_EQ(0, s.date());
   EXPECT_EQ(0, s.wantsol());
+  EXPECT_TRUE(s.thread_safe());
+}
+
+TEST(SolverTest, NotThreadSafe) {
+  TestSolver s("testsolver", 0, 0, Solver::NOT_THREAD_SAFE);
+  EXPECT_FALSE(s.thread_safe());
 }
 
 TEST(SolverTest, BasicSolverVirtualDtor) {
@@ -1183,7 +1196,7 @@ TEST_F(SolverAppOptionParserTest, VOption) {
 // Test -= option.
 TEST_F(SolverAppOptionParserTest, EQOption) {
   EXPECT_EQ(0, parser_.Parse(Args("unused", "-=", "whatever")));
-  EXPECT_THAT(handler_.output, StartsWith("Options:\n\nobjno\n"));
+  EXPECT_THAT(handler_.output, StartsWith("Options:\n\nexprstats\n"));
 }
 
 // Test -e option.
@@ -1228,6 +1241,217 @@ TEST_F(SolverAppOptionParserTest, InvalidOption) {
                    OptionError, "invalid option '-w'");
 }
 
+#ifndef _WIN32
+// Test -server and -workers options.
+TEST_F(SolverAppOptionParserTest, ServerOption) {
+  EXPECT_FALSE(parser_.server());
+  EXPECT_EQ(0, parser_.num_workers());
+  Args args("unused", "-server", "sock", "-workers", "4", "-e");
+  char **argp = args, **argp_copy = argp;
+  EXPECT_STREQ("sock", parser_.Parse(argp_copy));
+  EXPECT_EQ(argp + 6, argp_copy);
+  EXPECT_TRUE(parser_.server());
+  EXPECT_EQ(4, parser_.num_workers());
+  EXPECT_FALSE(parser_.echo_solver_options());
+}
+
+TEST_F(SolverAppOptionParserTest, InvalidServerOption) {
+  EXPECT_THROW_MSG(parser_.Parse(Args("unused", "-server")),
+                   OptionError, "option '-server' requires an argument");
+  EXPECT_THROW_MSG(parser_.Parse(Args("unused", "-workers", "0")),
+                   OptionError, "invalid number of workers '0'");
+  EXPECT_THROW_MSG(parser_.Parse(Args("unused", "-workers", "2x")),
+                   OptionError, "invalid number of workers '2x'");
+  EXPECT_THROW_MSG(parser_.Parse(Args("unused", "-batch", "dir",
+                                      "-server", "sock")),
+                   OptionError,
+                   "options '-server' and '-batch' are incompatible");
+}
+#endif
+
+// Test -batch option.
+TEST_F(SolverAppOptionParserTest, BatchOption) {
+  EXPECT_FALSE(parser_.batch());
+  Args args("unused", "-batch", "stubs", "-workers", "3");
+  char **argp = args, **argp_copy = argp;
+  EXPECT_STREQ("stubs", parser_.Parse(argp_copy));
+  EXPECT_EQ(argp + 5, argp_copy);
+  EXPECT_TRUE(parser_.batch());
+  EXPECT_FALSE(parser_.server());
+  EXPECT_EQ(3, parser_.num_workers());
+}
+
+TEST(GetBatchStubsTest, ListFile) {
+  WriteFile("test.stubs", "a\n  b.nl \n\n# c\nd.x\n");
+  std::vector<std::string> stubs;
+  mp::internal::GetBatchStubs("test.stubs", stubs);
+  ASSERT_EQ(3u, stubs.size());
+  EXPECT_EQ("a", stubs[0]);
+  EXPECT_EQ("b", stubs[1]);
+  EXPECT_EQ("d.x", stubs[2]);
+}
+
+#ifndef _WIN32
+using mp::internal::ServerConnection;
+using mp::internal::ServerRequest;
+
+// Test of ServerConnection with the client end of a socket pair.
+class ServerConnectionTest : public ::testing::Test {
+ protected:
+  int client_;
+  ServerConnection *conn_;
+
+  void SetUp() {
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    client_ = fds[0];
+    conn_ = new ServerConnection(fds[1]);
+  }
+
+  void TearDown() {
+    delete conn_;
+    close(client_);
+  }
+
+  // Sends data to the server and, if end is true, shuts down the client's
+  // sending side so that the server reaches the end of input.
+  void Send(fmt::StringRef data, bool end = true) {
+    const char *ptr = data.c_str();
+    for (std::size_t size = data.size(); size != 0; ) {
+      ssize_t result = write(client_, ptr, size);
+      ASSERT_GT(result, 0);
+      ptr += result;
+      size -= result;
+    }
+    if (end)
+      shutdown(client_, SHUT_WR);
+  }
+
+  // Closes the server end and returns everything sent to the client.
+  std::string Receive() {
+    delete conn_;
+    conn_ = 0;
+    std::string data;
+    char buffer[256];
+    for (ssize_t n; (n = read(client_, buffer, sizeof(buffer))) > 0; )
+      data.append(buffer, n);
+    return data;
+  }
+};
+
+TEST_F(ServerConnectionTest, ReadSolveRequest) {
+  Send("solve dir/test\n");
+  ServerRequest request;
+  ASSERT_TRUE(conn_->ReadRequest(request));
+  EXPECT_EQ(ServerRequest::SOLVE, request.kind);
+  EXPECT_EQ("dir/test", request.data);
+  EXPECT_FALSE(conn_->ReadRequest(request));
+}
+
+TEST_F(ServerConnectionTest, ReadQuitRequest) {
+  Send("quit\n");
+  ServerRequest request;
+  request.data = "test";
+  ASSERT_TRUE(conn_->ReadRequest(request));
+  EXPECT_EQ(ServerRequest::QUIT, request.kind);
+  EXPECT_EQ("", request.data);
+  EXPECT_FALSE(conn_->ReadRequest(request));
+}
+
+TEST_F(ServerConnectionTest, ReadNLRequest) {
+  Send("nl 5\nab\ncdsolve test\n");
+  ServerRequest request;
+  ASSERT_TRUE(conn_->ReadRequest(request));
+  EXPECT_EQ(ServerRequest::NL, request.kind);
+  EXPECT_EQ("ab\ncd", request.data);
+  ASSERT_TRUE(conn_->ReadRequest(request));
+  EXPECT_EQ(ServerRequest::SOLVE, request.kind);
+  EXPECT_EQ("test", request.data);
+  EXPECT_FALSE(conn_->ReadRequest(request));
+}
+
+#ifdef MP_USE_THREAD
+// Test reading an .nl payload that is larger than the connection buffer
+// and arrives in several parts.
+TEST_F(ServerConnectionTest, ReadSplitNLRequest) {
+  std::string nl(200000, 'x');
+  for (std::size_t i = 0; i < nl.size(); i += 1000)
+    nl[i] = '\n';
+  Send("nl 200000\n", false);
+  std::thread sender([&]() {
+    Send(nl.substr(0, 100000), false);
+    Send(nl.substr(100000) + "quit\n");
+  });
+  ServerRequest request;
+  bool has_request = conn_->ReadRequest(request);
+  sender.join();
+  ASSERT_TRUE(has_request);
+  EXPECT_EQ(ServerRequest::NL, request.kind);
+  EXPECT_TRUE(nl == request.data);
+  ASSERT_TRUE(conn_->ReadRequest(request));
+  EXPECT_EQ(ServerRequest::QUIT, request.kind);
+  EXPECT_FALSE(conn_->ReadRequest(request));
+}
+#endif
+
+TEST_F(ServerConnectionTest, IncompleteNLRequest) {
+  Send("nl 10\nabc");
+  ServerRequest request;
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "incomplete request");
+}
+
+TEST_F(ServerConnectionTest, IncompleteRequestLine) {
+  Send("solve test");
+  ServerRequest request;
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "incomplete request");
+}
+
+TEST_F(ServerConnectionTest, InvalidRequest) {
+  Send("foo\nsolve\nquit now\nnl\nnl 1x\nnl -1\n");
+  ServerRequest request;
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'foo'");
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'solve'");
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'quit now'");
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'nl'");
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'nl 1x'");
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "invalid request 'nl -1'");
+}
+
+TEST_F(ServerConnectionTest, RequestLimits) {
+  int max_size = ServerConnection::MAX_NL_SIZE;
+  Send(fmt::format("nl {}\n", max_size + 1ul));
+  ServerRequest request;
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   fmt::format("nl request of {} bytes exceeds the limit "
+                               "of {} bytes", max_size + 1ul, max_size));
+}
+
+TEST_F(ServerConnectionTest, LongRequestLine) {
+  Send("solve " + std::string(ServerConnection::MAX_LINE_SIZE, 'x'));
+  ServerRequest request;
+  EXPECT_THROW_MSG(conn_->ReadRequest(request), mp::Error,
+                   "request line is too long");
+}
+
+TEST_F(ServerConnectionTest, Write) {
+  conn_->Write("done\n");
+  conn_->Write(fmt::StringRef("sol 4\na\0b\n", 10));
+  conn_->WriteError("no\nway");
+  std::string expected = "done\nsol 4\na";
+  expected += '\0';
+  expected += "b\nerror no way\n";
+  EXPECT_EQ(expected, Receive());
+}
+#endif
+
 template <typename ProblemBuilder = StrictMockProblemBuilder >
 struct MockSolWriter {
   MOCK_METHOD2_T(Write,
@@ -1276,6 +1500,54 @@ TEST(SolutionWriterTest, WriteSolution) {
   writer.HandleSolution(0, "test message", values, dual_values, 42);
 }
 
+TEST(WriteMessageTest, MatchesFileOutput) {
+  const char *messages[] = {"", "test", "line 1\nline 2", "a\n\nb\n"};
+  for (std::size_t i = 0; i < sizeof(messages) / sizeof(*messages); ++i) {
+    {
+      fmt::BufferedFile file("test.sol", "w");
+      mp::internal::WriteMessage(file, messages[i]);
+    }
+    fmt::MemoryWriter w;
+    mp::internal::WriteMessage(w, messages[i]);
+    EXPECT_EQ(ReadFile("test.sol"), w.str());
+  }
+}
+
+// Test that MemorySolWriter keeps the .sol file with the name set by
+// set_filename in memory writing the same content as WriteSolFile.
+TEST(MemorySolWriterTest, WriteSol) {
+  Problem p;
+  p.AddVar(0, 1);
+  p.AddVar(0, 1);
+  p.AddIntSuffix("answer", mp::suf::VAR | mp::suf::OUTPUT, 0).SetValue(1, 42);
+  const int options[] = {3, 1, 4};
+  const double values[] = {1.5, 2.5}, dual_values[] = {3.5};
+  mp::SolutionAdapter<Problem> sol(
+        7, &p, "solved\nin memory", mp::MakeArrayRef(options, 3),
+        mp::MakeArrayRef(values, 2), mp::MakeArrayRef(dual_values, 1));
+  mp::WriteSolFile("test.sol", sol);
+  std::string expected = ReadFile("test.sol");
+  EXPECT_NE(std::string::npos, expected.find("answer"));
+
+  std::remove("test-memory.sol");
+  mp::MemorySolWriter writer;
+  EXPECT_EQ(0u, writer.sol().size());
+  writer.set_filename("test-memory.sol");
+  writer.Write("test-memory.sol", sol);
+  EXPECT_EQ(expected, std::string(writer.sol().c_str(), writer.sol().size()));
+  EXPECT_EQ("", ReadFile("test-memory.sol"));
+
+  // Writing again replaces the content.
+  writer.Write("test-memory.sol", sol);
+  EXPECT_EQ(expected, std::string(writer.sol().c_str(), writer.sol().size()));
+
+  // Other files are written to disk.
+  std::remove("test-disk.sol");
+  writer.Write("test-disk.sol", sol);
+  EXPECT_EQ(expected, ReadFile("test-disk.sol"));
+  EXPECT_EQ(expected, std::string(writer.sol().c_str(), writer.sol().size()));
+}
+
 // Test that AppSolutionHandler::HandleSolution writes .sol file and doesn't
 // print anything if -AMPL option is specified.
 TEST(AppSolutionHandlerTest, WriteSolution) {
@@ -1702,3 +1974,18 @@ TEST(ObjNoTest, InvalidObjNo) {
   OutputRedirect redir(stdout);
   EXPECT_THROW(app.Run(Args("test", "testproblem")), mp::InvalidOptionValue);
 }
+
+TEST(WorkerReaderTest, CopyAppReader) {
+  TestNLReader app_reader;
+  app_reader.obj_index = 1;
+  mp::internal::WorkerReader<TestNLReader> worker_reader(app_reader);
+  EXPECT_NE(&app_reader, &worker_reader.get());
+  EXPECT_EQ(1, worker_reader.get().obj_index);
+}
+
+TEST(WorkerReaderTest, NonCopyableReader) {
+  typedef StrictMock<MockNLReader<> > Reader;
+  Reader app_reader;
+  mp::internal::WorkerReader<Reader> worker_reader(app_reader);
+  EXPECT_NE(&app_reader, &worker_reader.get());
+}
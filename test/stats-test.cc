@@ -0,0 +1,153 @@
+/*
+ Stats tests.
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <gtest/gtest.h>
+#include "mp/nl.h"
+#include "mp/stats.h"
+
+using mp::Stats;
+
+namespace {
+
+TEST(StatsTest, EmptyStats) {
+  Stats stats;
+  EXPECT_EQ(0, stats.num_timers());
+  EXPECT_EQ(0, stats.num_counters());
+  fmt::MemoryWriter w;
+  stats.WriteJSON(w);
+  EXPECT_EQ("{\n  \"timers\": {},\n  \"counters\": {}\n}\n", w.str());
+}
+
+TEST(StatsTest, GetTimer) {
+  Stats stats;
+  EXPECT_EQ(0, stats.GetTimer("foo"));
+  EXPECT_EQ(1, stats.GetTimer("bar"));
+  EXPECT_EQ(0, stats.GetTimer("foo"));
+  EXPECT_EQ(2, stats.num_timers());
+  EXPECT_EQ("bar", stats.timer(1).name);
+  EXPECT_EQ(0, stats.timer(1).time);
+  EXPECT_EQ(0, stats.timer(1).count);
+}
+
+TEST(StatsTest, GetCounter) {
+  Stats stats;
+  EXPECT_EQ(0, stats.GetCounter("foo"));
+  EXPECT_EQ(0, stats.GetCounter(fmt::StringRef("foobar", 3)));
+  EXPECT_EQ(1, stats.GetCounter("foobar"));
+  EXPECT_EQ(2, stats.num_counters());
+  EXPECT_EQ(0, stats.num_timers());
+}
+
+TEST(StatsTest, AddTime) {
+  Stats stats;
+  int timer = stats.GetTimer("foo");
+  stats.AddTime(timer, 1.5);
+  stats.AddTime("foo", 2);
+  EXPECT_EQ(3.5, stats.timer(timer).time);
+  EXPECT_EQ(2, stats.timer(timer).count);
+}
+
+TEST(StatsTest, Add) {
+  Stats stats;
+  int counter = stats.GetCounter("foo");
+  stats.Add(counter, 10);
+  stats.Add("foo", 1LL << 40);
+  EXPECT_EQ((1LL << 40) + 10, stats.counter(counter).value);
+}
+
+TEST(StatsTest, WriteJSON) {
+  Stats stats;
+  stats.AddTime("a\"b\\c\n", 0.25);
+  stats.AddTime("t", 1);
+  stats.Add("n", 42);
+  fmt::MemoryWriter w;
+  stats.WriteJSON(w);
+  EXPECT_EQ(
+        "{\n"
+        "  \"timers\": {\n"
+        "    \"a\\\"b\\\\c\\n\": {\"time\": 0.250000000, \"count\": 1},\n"
+        "    \"t\": {\"time\": 1.000000000, \"count\": 1}\n"
+        "  },\n"
+        "  \"counters\": {\n"
+        "    \"n\": 42\n"
+        "  }\n"
+        "}\n", w.str());
+}
+
+TEST(StatsTest, ScopedTimer) {
+  Stats stats;
+  {
+    mp::ScopedTimer timer(&stats, "foo");
+  }
+  EXPECT_EQ(1, stats.num_timers());
+  EXPECT_EQ(1, stats.timer(0).count);
+  EXPECT_GE(stats.timer(0).time, 0);
+  mp::ScopedTimer timer(0, "foo");
+}
+
+TEST(StatsTest, ReadNLString) {
+  Stats stats;
+  mp::NLHandler<int> handler;
+  mp::ReadNLString(
+        "g3 1 1 0\n"
+        " 2 1 1 0 0\n"
+        " 1 0\n"
+        " 0 0\n"
+        " 0 0 0\n"
+        " 0 0 0 1\n"
+        " 0 0 0 0 0\n"
+        " 2 1\n"
+        " 0 0\n"
+        " 0 0 0 0 0\n"
+        "C0\n"
+        "o2\n"
+        "v0\n"
+        "v1\n"
+        "O0 0\n"
+        "n0\n"
+        "S0 1 foo\n"
+        "0 1\n"
+        "r\n"
+        "4 0\n"
+        "b\n"
+        "3\n"
+        "3\n"
+        "k1\n"
+        "1\n"
+        "J0 2\n"
+        "0 1\n"
+        "1 1\n"
+        "G0 1\n"
+        "0 1\n",
+        handler, "(input)", 0, &stats);
+  fmt::MemoryWriter w;
+  stats.WriteJSON(w);
+  std::string json = w.str();
+  EXPECT_NE(std::string::npos, json.find("\"header\""));
+  EXPECT_NE(std::string::npos, json.find("\"segment C\""));
+  EXPECT_NE(std::string::npos, json.find("\"segment J\""));
+  EXPECT_NE(std::string::npos, json.find("\"bytes read\": "));
+  EXPECT_NE(std::string::npos, json.find("\"expressions\": 4"));
+  EXPECT_NE(std::string::npos, json.find("\"linear terms\": 3"));
+  EXPECT_NE(std::string::npos, json.find("\"suffix values\": 1"));
+}
+}  // namespace
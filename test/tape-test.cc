@@ -0,0 +1,351 @@
+/*
+ Expression tape tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <cmath>
+#include <limits>
+
+#include "gtest/gtest.h"
+#include "mp/tape.h"
+
+using mp::Problem;
+using mp::NumericExpr;
+using mp::LogicalExpr;
+using mp::Tape;
+using mp::TapeEvaluator;
+
+namespace ex = mp::expr;
+
+class TapeTest : public ::testing::Test {
+ protected:
+  Problem p;
+  NumericExpr x, y, z;
+
+  enum {NUM_VARS = 3};
+
+  TapeTest() {
+    for (int i = 0; i < NUM_VARS; ++i)
+      p.AddVar(0, 0);
+    x = p.MakeVariable(0);
+    y = p.MakeVariable(1);
+    z = p.MakeVariable(2);
+  }
+
+  // Adds a constraint with the body e, compiles the problem and returns
+  // the value of e at (x, y, z).
+  double Eval(NumericExpr e, double x = 0, double y = 0, double z = 0) {
+    p.AddCon(0, 0, e);
+    Tape tape(p);
+    TapeEvaluator eval(tape);
+    double values[] = {x, y, z};
+    eval.Evaluate(values);
+    return eval.con_value(p.num_algebraic_cons() - 1);
+  }
+
+  double Eval(LogicalExpr e, double x = 0, double y = 0, double z = 0) {
+    return Eval(p.MakeIf(e, p.MakeNumericConstant(1),
+                         p.MakeNumericConstant(0)), x, y, z);
+  }
+
+  NumericExpr MakeConst(double value) {
+    return p.MakeNumericConstant(value);
+  }
+
+  template <typename Builder>
+  void AddArgs(Builder &b, NumericExpr e1, NumericExpr e2, NumericExpr e3) {
+    b.AddArg(e1);
+    b.AddArg(e2);
+    b.AddArg(e3);
+  }
+
+  NumericExpr MakeIterated(ex::Kind kind, NumericExpr e1, NumericExpr e2,
+                           NumericExpr e3) {
+    Problem::IteratedExprBuilder b = p.BeginIterated(kind, 3);
+    AddArgs(b, e1, e2, e3);
+    return p.EndIterated(b);
+  }
+};
+
+TEST_F(TapeTest, Empty) {
+  Tape tape;
+  EXPECT_EQ(0, tape.num_vars());
+  EXPECT_EQ(0, tape.num_consts());
+  EXPECT_EQ(0, tape.num_instructions());
+  EXPECT_EQ(0, tape.num_registers());
+  EXPECT_EQ(0, tape.num_objs());
+  EXPECT_EQ(0, tape.num_cons());
+  EXPECT_EQ(0, tape.num_common_exprs());
+}
+
+TEST_F(TapeTest, Variable) {
+  EXPECT_EQ(42, Eval(y, 1, 42));
+}
+
+TEST_F(TapeTest, Constant) {
+  EXPECT_EQ(4.2, Eval(MakeConst(4.2)));
+}
+
+TEST_F(TapeTest, DeduplicateConstants) {
+  p.AddCon(0, 0, p.MakeBinary(ex::ADD, MakeConst(2), x));
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, MakeConst(2), y));
+  Tape tape(p);
+  EXPECT_EQ(1, tape.num_consts());
+  EXPECT_EQ(NUM_VARS + 1, tape.first_result());
+  EXPECT_EQ(2, tape.constant(0));
+}
+
+TEST_F(TapeTest, SignedZeroAndNaNConstants) {
+  // 0.0 and -0.0 compare equal but give different results of division.
+  double zero = 0, nan = std::numeric_limits<double>::quiet_NaN();
+  p.AddCon(0, 0, p.MakeBinary(ex::DIV, MakeConst(1), MakeConst(zero)));
+  p.AddCon(0, 0, p.MakeBinary(ex::DIV, MakeConst(1), MakeConst(-zero)));
+  p.AddCon(0, 0, p.MakeBinary(ex::ADD, MakeConst(nan), x));
+  p.AddCon(0, 0, p.MakeBinary(ex::ADD, MakeConst(nan), MakeConst(2)));
+  Tape tape(p);
+  EXPECT_EQ(5, tape.num_consts());
+  TapeEvaluator eval(tape);
+  double values[NUM_VARS] = {};
+  eval.Evaluate(values);
+  double inf = std::numeric_limits<double>::infinity();
+  EXPECT_EQ(inf, eval.con_value(0));
+  EXPECT_EQ(-inf, eval.con_value(1));
+  EXPECT_NE(eval.con_value(2), eval.con_value(2));
+  EXPECT_NE(eval.con_value(3), eval.con_value(3));
+}
+
+TEST_F(TapeTest, UnaryExpr) {
+  EXPECT_EQ(-3, Eval(p.MakeUnary(ex::MINUS, x), 3));
+  EXPECT_EQ(3, Eval(p.MakeUnary(ex::ABS, x), -3));
+  EXPECT_EQ(1, Eval(p.MakeUnary(ex::FLOOR, x), 1.5));
+  EXPECT_EQ(2, Eval(p.MakeUnary(ex::CEIL, x), 1.5));
+  EXPECT_EQ(3, Eval(p.MakeUnary(ex::SQRT, x), 9));
+  EXPECT_EQ(9, Eval(p.MakeUnary(ex::POW2, x), 3));
+  EXPECT_DOUBLE_EQ(std::exp(2.0), Eval(p.MakeUnary(ex::EXP, x), 2));
+  EXPECT_DOUBLE_EQ(std::log(2.0), Eval(p.MakeUnary(ex::LOG, x), 2));
+  EXPECT_EQ(2, Eval(p.MakeUnary(ex::LOG10, x), 100));
+  EXPECT_DOUBLE_EQ(std::sin(2.0), Eval(p.MakeUnary(ex::SIN, x), 2));
+  EXPECT_DOUBLE_EQ(std::sinh(2.0), Eval(p.MakeUnary(ex::SINH, x), 2));
+  EXPECT_DOUBLE_EQ(std::cos(2.0), Eval(p.MakeUnary(ex::COS, x), 2));
+  EXPECT_DOUBLE_EQ(std::cosh(2.0), Eval(p.MakeUnary(ex::COSH, x), 2));
+  EXPECT_DOUBLE_EQ(std::tan(2.0), Eval(p.MakeUnary(ex::TAN, x), 2));
+  EXPECT_DOUBLE_EQ(std::tanh(2.0), Eval(p.MakeUnary(ex::TANH, x), 2));
+  EXPECT_DOUBLE_EQ(std::asin(0.5), Eval(p.MakeUnary(ex::ASIN, x), 0.5));
+  EXPECT_DOUBLE_EQ(std::acos(0.5), Eval(p.MakeUnary(ex::ACOS, x), 0.5));
+  EXPECT_DOUBLE_EQ(std::atan(2.0), Eval(p.MakeUnary(ex::ATAN, x), 2));
+  EXPECT_NEAR(0.5, Eval(p.MakeUnary(ex::ASINH, x), std::sinh(0.5)), 1e-15);
+  EXPECT_NEAR(2, Eval(p.MakeUnary(ex::ACOSH, x), std::cosh(2.0)), 1e-15);
+  EXPECT_NEAR(0.5, Eval(p.MakeUnary(ex::ATANH, x), std::tanh(0.5)), 1e-15);
+}
+
+TEST_F(TapeTest, BinaryExpr) {
+  EXPECT_EQ(5, Eval(p.MakeBinary(ex::ADD, x, y), 2, 3));
+  EXPECT_EQ(-1, Eval(p.MakeBinary(ex::SUB, x, y), 2, 3));
+  EXPECT_EQ(6, Eval(p.MakeBinary(ex::MUL, x, y), 2, 3));
+  EXPECT_EQ(1.5, Eval(p.MakeBinary(ex::DIV, x, y), 3, 2));
+  EXPECT_EQ(3, Eval(p.MakeBinary(ex::INT_DIV, x, y), 7, 2));
+  EXPECT_EQ(-3, Eval(p.MakeBinary(ex::INT_DIV, x, y), -7, 2));
+  EXPECT_EQ(1, Eval(p.MakeBinary(ex::MOD, x, y), 7, 2));
+  EXPECT_EQ(8, Eval(p.MakeBinary(ex::POW, x, y), 2, 3));
+  EXPECT_EQ(8, Eval(p.MakeBinary(ex::POW_CONST_BASE, MakeConst(2), y), 0, 3));
+  EXPECT_EQ(8, Eval(p.MakeBinary(ex::POW_CONST_EXP, x, MakeConst(3)), 2));
+  EXPECT_DOUBLE_EQ(std::atan2(1.0, 2.0),
+                   Eval(p.MakeBinary(ex::ATAN2, x, y), 1, 2));
+  EXPECT_EQ(1, Eval(p.MakeBinary(ex::LESS, x, y), 3, 2));
+  EXPECT_EQ(0, Eval(p.MakeBinary(ex::LESS, x, y), 2, 3));
+  EXPECT_EQ(1.23, Eval(p.MakeBinary(ex::PRECISION, x, y), 1.234, 3));
+  EXPECT_EQ(1.23, Eval(p.MakeBinary(ex::ROUND, x, y), 1.234, 2));
+  EXPECT_EQ(1.2, Eval(p.MakeBinary(ex::TRUNC, x, y), 1.29, 1));
+}
+
+TEST_F(TapeTest, IfExpr) {
+  NumericExpr e = p.MakeIf(
+        p.MakeRelational(ex::LT, x, y), MakeConst(10), MakeConst(20));
+  EXPECT_EQ(10, Eval(e, 1, 2));
+  EXPECT_EQ(20, Eval(e, 2, 1));
+  EXPECT_EQ(0, Eval(p.MakeIf(p.MakeLogicalConstant(false), x,
+                             NumericExpr()), 5));
+}
+
+TEST_F(TapeTest, PLTerm) {
+  Problem::PLTermBuilder b = p.BeginPLTerm(2);
+  b.AddSlope(-1);
+  b.AddBreakpoint(0);
+  b.AddSlope(0);
+  b.AddBreakpoint(1);
+  b.AddSlope(2);
+  NumericExpr e = p.EndPLTerm(b, p.MakeVariable(0));
+  EXPECT_EQ(3, Eval(e, -3));
+  EXPECT_EQ(0, Eval(e, 0.5));
+  EXPECT_EQ(4, Eval(e, 3));
+}
+
+TEST_F(TapeTest, IteratedExpr) {
+  EXPECT_EQ(1, Eval(MakeIterated(ex::MIN, x, y, z), 3, 1, 2));
+  EXPECT_EQ(3, Eval(MakeIterated(ex::MAX, x, y, z), 3, 1, 2));
+  EXPECT_EQ(6, Eval(MakeIterated(ex::SUM, x, y, z), 3, 1, 2));
+}
+
+TEST_F(TapeTest, NumberOfExpr) {
+  Problem::NumberOfExprBuilder b = p.BeginNumberOf(3, x);
+  b.AddArg(y);
+  b.AddArg(z);
+  NumericExpr e = p.EndNumberOf(b);
+  EXPECT_EQ(2, Eval(e, 1, 1, 1));
+  EXPECT_EQ(1, Eval(e, 1, 0, 1));
+}
+
+TEST_F(TapeTest, CountExpr) {
+  Problem::CountExprBuilder b = p.BeginCount(2);
+  b.AddArg(p.MakeRelational(ex::GT, x, MakeConst(0)));
+  b.AddArg(p.MakeRelational(ex::GT, y, MakeConst(0)));
+  NumericExpr e = p.EndCount(b);
+  EXPECT_EQ(2, Eval(e, 1, 1));
+  EXPECT_EQ(1, Eval(e, 0, 1));
+}
+
+TEST_F(TapeTest, LogicalExpr) {
+  LogicalExpr t = p.MakeLogicalConstant(true);
+  LogicalExpr f = p.MakeLogicalConstant(false);
+  EXPECT_EQ(1, Eval(t));
+  EXPECT_EQ(0, Eval(p.MakeNot(t)));
+  EXPECT_EQ(1, Eval(p.MakeBinaryLogical(ex::OR, f, t)));
+  EXPECT_EQ(0, Eval(p.MakeBinaryLogical(ex::AND, f, t)));
+  EXPECT_EQ(1, Eval(p.MakeBinaryLogical(ex::IFF, f, f)));
+  EXPECT_EQ(0, Eval(p.MakeBinaryLogical(ex::IFF, t, f)));
+  EXPECT_EQ(0, Eval(p.MakeImplication(t, f, t)));
+  EXPECT_EQ(1, Eval(p.MakeImplication(f, f, t)));
+  EXPECT_EQ(1, Eval(p.MakeImplication(f, f, LogicalExpr())));
+}
+
+TEST_F(TapeTest, RelationalExpr) {
+  EXPECT_EQ(1, Eval(p.MakeRelational(ex::LT, x, y), 1, 2));
+  EXPECT_EQ(0, Eval(p.MakeRelational(ex::LT, x, y), 2, 2));
+  EXPECT_EQ(1, Eval(p.MakeRelational(ex::LE, x, y), 2, 2));
+  EXPECT_EQ(1, Eval(p.MakeRelational(ex::EQ, x, y), 2, 2));
+  EXPECT_EQ(0, Eval(p.MakeRelational(ex::NE, x, y), 2, 2));
+  EXPECT_EQ(1, Eval(p.MakeRelational(ex::GE, x, y), 2, 2));
+  EXPECT_EQ(0, Eval(p.MakeRelational(ex::GT, x, y), 2, 2));
+}
+
+TEST_F(TapeTest, LogicalCountExpr) {
+  Problem::CountExprBuilder b = p.BeginCount(2);
+  b.AddArg(p.MakeRelational(ex::GT, x, MakeConst(0)));
+  b.AddArg(p.MakeRelational(ex::GT, y, MakeConst(0)));
+  mp::CountExpr count = p.EndCount(b);
+  NumericExpr one = MakeConst(1);
+  EXPECT_EQ(1, Eval(p.MakeLogicalCount(ex::ATLEAST, one, count), 1, 0));
+  EXPECT_EQ(0, Eval(p.MakeLogicalCount(ex::ATLEAST, one, count), 0, 0));
+  EXPECT_EQ(1, Eval(p.MakeLogicalCount(ex::ATMOST, one, count), 1, 0));
+  EXPECT_EQ(0, Eval(p.MakeLogicalCount(ex::ATMOST, one, count), 1, 1));
+  EXPECT_EQ(1, Eval(p.MakeLogicalCount(ex::EXACTLY, one, count), 1, 0));
+  EXPECT_EQ(0, Eval(p.MakeLogicalCount(ex::NOT_ATLEAST, one, count), 1, 0));
+  EXPECT_EQ(1, Eval(p.MakeLogicalCount(ex::NOT_ATMOST, one, count), 1, 1));
+  EXPECT_EQ(0, Eval(p.MakeLogicalCount(ex::NOT_EXACTLY, one, count), 1, 0));
+}
+
+TEST_F(TapeTest, IteratedLogicalExpr) {
+  Problem::IteratedLogicalExprBuilder b = p.BeginIteratedLogical(ex::EXISTS, 2);
+  b.AddArg(p.MakeRelational(ex::GT, x, MakeConst(0)));
+  b.AddArg(p.MakeRelational(ex::GT, y, MakeConst(0)));
+  LogicalExpr exists = p.EndIteratedLogical(b);
+  EXPECT_EQ(1, Eval(exists, 0, 1));
+  EXPECT_EQ(0, Eval(exists, 0, 0));
+  b = p.BeginIteratedLogical(ex::FORALL, 2);
+  b.AddArg(p.MakeRelational(ex::GT, x, MakeConst(0)));
+  b.AddArg(p.MakeRelational(ex::GT, y, MakeConst(0)));
+  LogicalExpr forall = p.EndIteratedLogical(b);
+  EXPECT_EQ(1, Eval(forall, 1, 1));
+  EXPECT_EQ(0, Eval(forall, 0, 1));
+}
+
+TEST_F(TapeTest, PairwiseExpr) {
+  Problem::PairwiseExprBuilder b = p.BeginPairwise(ex::ALLDIFF, 3);
+  AddArgs(b, x, y, z);
+  LogicalExpr alldiff = p.EndPairwise(b);
+  EXPECT_EQ(1, Eval(alldiff, 1, 2, 3));
+  EXPECT_EQ(0, Eval(alldiff, 1, 2, 1));
+  b = p.BeginPairwise(ex::NOT_ALLDIFF, 3);
+  AddArgs(b, x, y, z);
+  LogicalExpr not_alldiff = p.EndPairwise(b);
+  EXPECT_EQ(0, Eval(not_alldiff, 1, 2, 3));
+  EXPECT_EQ(1, Eval(not_alldiff, 1, 2, 1));
+}
+
+TEST_F(TapeTest, LinearAndNonlinearParts) {
+  Problem::LinearObjBuilder obj =
+      p.AddObj(mp::obj::MIN, p.MakeUnary(ex::POW2, x), 2);
+  obj.AddTerm(1, 2);
+  obj.AddTerm(2, 3);
+  Problem::LinearConBuilder con = p.AddCon(0, 0, 1);
+  con.AddTerm(0, 5);
+  Tape tape(p);
+  EXPECT_EQ(1, tape.num_objs());
+  EXPECT_EQ(1, tape.num_cons());
+  TapeEvaluator eval(tape);
+  double values[] = {3, 10, 100};
+  eval.Evaluate(values);
+  EXPECT_EQ(9 + 20 + 300, eval.obj_value(0));
+  EXPECT_EQ(15, eval.con_value(0));
+}
+
+TEST_F(TapeTest, CommonExpr) {
+  Problem::LinearExprBuilder linear = p.BeginCommonExpr(1);
+  linear.AddTerm(1, 2);
+  p.EndCommonExpr(linear, p.MakeUnary(ex::POW2, x), 1);
+  NumericExpr e = p.MakeCommonExpr(0);
+  p.AddCon(0, 0, p.MakeBinary(ex::ADD, e, MakeConst(1)));
+  p.AddCon(0, 0, p.MakeBinary(ex::MUL, e, y));
+  Tape tape(p);
+  EXPECT_EQ(1, tape.num_common_exprs());
+  TapeEvaluator eval(tape);
+  double values[] = {3, 10, 0};
+  eval.Evaluate(values);
+  EXPECT_EQ(29, eval.registers()[tape.common_expr_register(0)]);
+  double con_values[2] = {};
+  eval.GetConValues(con_values);
+  EXPECT_EQ(30, con_values[0]);
+  EXPECT_EQ(290, con_values[1]);
+  // Evaluate again at a different point reusing the registers.
+  values[0] = 1;
+  eval.Evaluate(values);
+  EXPECT_EQ(22, eval.con_value(0));
+}
+
+TEST_F(TapeTest, DeepExpr) {
+  // An expression too deep to compile recursively.
+  enum {DEPTH = 200000};
+  NumericExpr e = x;
+  for (int i = 0; i < DEPTH; ++i)
+    e = p.MakeBinary(ex::ADD, e, MakeConst(1));
+  EXPECT_EQ(DEPTH + 0.5, Eval(e, 0.5));
+}
+
+TEST_F(TapeTest, InvalidCommonExpr) {
+  p.AddCon(0, 0, p.MakeCommonExpr(0));
+  EXPECT_THROW(Tape tape(p), mp::Error);
+}
+
+TEST_F(TapeTest, UnsupportedExpr) {
+  Problem::CallExprBuilder b = p.BeginCall(p.AddFunction("f", 1), 1);
+  b.AddArg(x);
+  p.AddCon(0, 0, p.EndCall(b));
+  EXPECT_THROW(Tape tape(p), mp::UnsupportedError);
+}
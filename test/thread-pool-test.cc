@@ -0,0 +1,86 @@
+/*
+ Thread pool tests
+
+ Copyright (C) 2015 AMPL Optimization Inc
+
+ Permission to use, copy, modify, and distribute this software and its
+ documentation for any purpose and without fee is hereby granted,
+ provided that the above copyright notice appear in all copies and that
+ both that the copyright notice and this permission notice and warranty
+ disclaimer appear in supporting documentation.
+
+ The author and AMPL Optimization Inc disclaim all warranties with
+ regard to this software, including all implied warranties of
+ merchantability and fitness.  In no event shall the author be liable
+ for any special, indirect or consequential damages or any damages
+ whatsoever resulting from loss of use, data or profits, whether in an
+ action of contract, negligence or other tortious action, arising out
+ of or in connection with the use or performance of this software.
+
+ Author: Victor Zverovich
+ */
+
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mp/thread-pool.h"
+
+using mp::ThreadPool;
+
+namespace {
+
+// Records the part indices and threads that ran them.
+class RecordingTask : public ThreadPool::Task {
+ public:
+  std::vector<int> counts;
+  std::vector<int> threads;
+
+  explicit RecordingTask(int num_parts)
+    : counts(num_parts), threads(num_parts, -1) {}
+
+  void Run(int index, int thread_index) {
+    ++counts[index];
+    threads[index] = thread_index;
+  }
+};
+
+class ThrowingTask : public ThreadPool::Task {
+ public:
+  void Run(int index, int) {
+    if (index == 3)
+      throw std::runtime_error("test");
+  }
+};
+}
+
+TEST(ThreadPoolTest, NumThreads) {
+  EXPECT_GE(ThreadPool().num_threads(), 1);
+#ifdef MP_USE_THREAD
+  EXPECT_EQ(3, ThreadPool(3).num_threads());
+#endif
+}
+
+TEST(ThreadPoolTest, RunsEachPartOnce) {
+  ThreadPool pool(4);
+  for (int num_parts = 0; num_parts < 50; num_parts += 7) {
+    RecordingTask task(num_parts);
+    pool.Run(task, num_parts);
+    for (int i = 0; i < num_parts; ++i) {
+      EXPECT_EQ(1, task.counts[i]);
+      EXPECT_GE(task.threads[i], 0);
+      EXPECT_LT(task.threads[i], pool.num_threads());
+    }
+  }
+}
+
+TEST(ThreadPoolTest, PropagatesException) {
+  ThreadPool pool(2);
+  ThrowingTask throwing_task;
+  EXPECT_THROW(pool.Run(throwing_task, 10), std::runtime_error);
+  // Check that the pool is usable after an exception.
+  RecordingTask task(5);
+  pool.Run(task, 5);
+  for (int i = 0; i < 5; ++i)
+    EXPECT_EQ(1, task.counts[i]);
+}